@@ -141,6 +141,29 @@ KexiCommandLineOptions::KexiCommandLineOptions( QCommandLineParser *parser)
                "table", "query"),
         "[object_type:]object_name"),
 
+    // Options related to transferring data without GUI:
+    exportCsv("export-csv",
+        xi18nc("'export-csv' command line option",
+               "Export data of object of type 'object_type' and name 'object_name' from "
+               "specified project to a CSV file specified with --to and exit without showing "
+               "the GUI. 'object_type' is optional, if omitted - %1 type is assumed. "
+               "Object type can also be %2.\n"
+               "Example: --export-csv %2:\"My query\" --to data.csv",
+               "table", "query"),
+        "[object_type:]object_name"),
+    importCsv("import-csv",
+        xi18nc("'import-csv' command line option",
+               "Import data from a CSV file into an existing table specified with --to "
+               "and exit without showing the GUI. Columns of the file are assigned to "
+               "fields of the table in order. The first row is skipped if it contains "
+               "names of the fields.\n"
+               "Example: --import-csv data.csv --to MyTable"),
+        "filename"),
+    to("to",
+        xi18nc("'to' command line option",
+               "Destination of --export-csv (a filename) or --import-csv (a table name)."),
+        "destination"),
+
     // Options related to database servers:
     user(QStringList() << "u" << "user",
         xi18nc("'user' command line option",
@@ -55,6 +55,9 @@ public:
     QCommandLineOption newObject;
     QCommandLineOption print;
     QCommandLineOption printPreview;
+    QCommandLineOption exportCsv;
+    QCommandLineOption importCsv;
+    QCommandLineOption to;
     QCommandLineOption user;
     QCommandLineOption host;
     QCommandLineOption port;
@@ -31,13 +31,57 @@
 #include <QMimeType>
 #include <QDebug>
 #include <QImageReader>
+#include <QCache>
+#include <QCryptographicHash>
+#include <QSet>
+#include <QImage>
+#include <QRunnable>
+#include <QThreadPool>
 
 #include <KDbConnection>
+#include <KDbCursor>
+#include <KDbExpression>
 #include <KDbQuerySchema>
 #include <KDbRecordData>
+#include <KDbTableSchema>
 
 Q_GLOBAL_STATIC(KexiBLOBBuffer, _buffer)
 
+//! Default maximum size of decoded pixmaps kept in memory, in kilobytes
+#define DEFAULT_PIXMAP_CACHE_SIZE (64 * 1024)
+
+//! Maximum number of objects loaded by a single query in KexiBLOBBuffer::prefetchObjects()
+#define PREFETCH_CHUNK_SIZE 256
+
+namespace {
+
+//! Decodes image data in a thread of the global thread pool
+class DecodeImageTask : public QRunnable
+{
+public:
+    DecodeImageTask(const QByteArray &hash, const QByteArray &data, const QByteArray &format)
+        : m_hash(hash), m_data(data), m_format(format)
+    {
+    }
+
+    void run() override {
+        QImage image;
+        if (!image.loadFromData(m_data, m_format.constData())) {
+            image = QImage();
+        }
+        QMetaObject::invokeMethod(KexiBLOBBuffer::self(), "backgroundDecodingFinished",
+                                  Qt::QueuedConnection,
+                                  Q_ARG(QByteArray, m_hash), Q_ARG(QImage, image));
+    }
+
+private:
+    const QByteArray m_hash;
+    const QByteArray m_data;
+    const QByteArray m_format;
+};
+
+} // namespace
+
 //-----------------
 
 class Q_DECL_HIDDEN KexiBLOBBuffer::Private
@@ -47,6 +91,7 @@ public:
             : maxId(0)
             , conn(0)
     {
+        pixmapCache.setMaxCost(DEFAULT_PIXMAP_CACHE_SIZE);
     }
     ~Private() {
         foreach(Item* item, inMemoryItems) {
@@ -57,16 +102,129 @@ public:
             delete item;
         }
         storedItems.clear();
+        delete objectQuery;
     }
+
+    //! Inserts @a pixmap decoded from data with hash @a hash into pixmapCache,
+    //! or keeps it as largePixmap if it does not fit there
+    void insertPixmap(const QByteArray &hash, const QPixmap &pixmap);
+
+    //! @return decoded pixmap for data with hash @a hash, nullptr if it is not kept
+    const QPixmap* pixmap(const QByteArray &hash);
+
+    //! @return query for loading stored objects, with object's identifier as parameter;
+    //! nullptr on failure. The query is reused for all objects as long as the connection,
+    //! its current database and schema of the kexi__blobs table are the same.
+    KDbQuerySchema* objectQueryForConnection();
+
+    //! Deletes the query returned by objectQueryForConnection()
+    void clearObjectQuery();
+
+    //! Data shared by items of the same contents
+    struct SharedData {
+        QByteArray data;
+        int refs = 0;
+    };
+
     Id_t maxId; //!< Used to compute maximal recently used identifier for unstored BLOB
 //! @todo will be changed to QHash<quint64, Item>
     QHash<Id_t, Item*> inMemoryItems; //!< for unstored BLOBs
     QHash<Id_t, Item*> storedItems; //!< for stored items
     QHash<QString, Item*> itemsByURL;
+    QHash<QByteArray, SharedData> dataByHash; //!< data of items by hash of contents
+    QCache<QByteArray, QPixmap> pixmapCache; //!< decoded pixmaps by hash of contents, cost in KB
+    //! The most recently decoded pixmap too large for pixmapCache and hash of its contents,
+    //! kept so it is not decoded again on every use
+    QByteArray largePixmapHash;
+    QPixmap largePixmap;
+    QSet<QByteArray> undecodableData; //!< hashes of contents that could not be decoded
+    QSet<QByteArray> dataBeingDecoded; //!< hashes of contents being decoded in background
+    KexiBLOBBuffer::Statistics statistics;
     //! @todo KEXI3 use equivalent of QPointer<KDbConnection>
     KDbConnection *conn;
+    KDbQuerySchema *objectQuery = nullptr;
+    //! Connection, database and table schema for which objectQuery has been created
+    KDbConnection *objectQueryConnection = nullptr;
+    QString objectQueryDatabase;
+    const KDbTableSchema *objectQueryTable = nullptr;
 };
 
+void KexiBLOBBuffer::Private::clearObjectQuery()
+{
+    delete objectQuery;
+    objectQuery = nullptr;
+    objectQueryConnection = nullptr;
+    objectQueryDatabase.clear();
+    objectQueryTable = nullptr;
+}
+
+//! @return size of @a pixmap in memory in kilobytes
+static int pixmapCost(const QPixmap &pixmap)
+{
+    return qMax(1, int(qint64(pixmap.width()) * pixmap.height() * pixmap.depth() / 8 / 1024));
+}
+
+void KexiBLOBBuffer::Private::insertPixmap(const QByteArray &hash, const QPixmap &pixmap)
+{
+    const int cost = pixmapCost(pixmap);
+    if (cost > pixmapCache.maxCost()) {
+        // QCache would drop it immediately
+        largePixmapHash = hash;
+        largePixmap = pixmap;
+        return;
+    }
+    pixmapCache.insert(hash, new QPixmap(pixmap), cost);
+}
+
+const QPixmap* KexiBLOBBuffer::Private::pixmap(const QByteArray &hash)
+{
+    const QPixmap *cached = pixmapCache.object(hash);
+    if (!cached && !hash.isEmpty() && hash == largePixmapHash) {
+        cached = &largePixmap;
+    }
+    return cached;
+}
+
+KDbQuerySchema* KexiBLOBBuffer::Private::objectQueryForConnection()
+{
+    KDbTableSchema *blobsTable = conn->tableSchema("kexi__blobs");
+    if (objectQuery && objectQueryConnection == conn && objectQueryTable == blobsTable
+        && objectQueryDatabase == conn->currentDatabase())
+    {
+        return objectQuery;
+    }
+    // the query refers to fields of a table schema that is no longer used
+    clearObjectQuery();
+    if (!blobsTable) {
+        //! @todo err msg
+        return nullptr;
+    }
+    // SELECT o_data, o_name, o_caption, o_mime, o_folder_id FROM kexi__blobs WHERE o_id = [o_id]
+    QScopedPointer<KDbQuerySchema> query(new KDbQuerySchema);
+    query->addField(blobsTable->field("o_data"));
+    query->addField(blobsTable->field("o_name"));
+    query->addField(blobsTable->field("o_caption"));
+    query->addField(blobsTable->field("o_mime"));
+    query->addField(blobsTable->field("o_folder_id"));
+    KDbQueryParameterExpression idParameter(QLatin1String("o_id"));
+    idParameter.setType(blobsTable->field("o_id")->type());
+    QString errorMessage;
+    QString errorDescription;
+    if (!query->setWhereExpression(
+            KDbBinaryExpression(KDbVariableExpression(QLatin1String("kexi__blobs.o_id")), '=', idParameter),
+            &errorMessage, &errorDescription))
+    {
+        qWarning() << "message=" << errorMessage
+                   << "description=" << errorDescription;
+        return nullptr;
+    }
+    objectQuery = query.take();
+    objectQueryConnection = conn;
+    objectQueryDatabase = conn->currentDatabase();
+    objectQueryTable = blobsTable;
+    return objectQuery;
+}
+
 //-----------------
 
 KexiBLOBBuffer::Handle::Handle(Item* item)
@@ -126,8 +284,7 @@ KexiBLOBBuffer::Item::Item(const QByteArray& data, KexiBLOBBuffer::Id_t ident, b
                            const QString& _name, const QString& _caption, const QString& _mimeType,
                            Id_t _folderId, const QPixmap& pixmap)
         : name(_name), caption(_caption), mimeType(_mimeType), refs(0),
-        id(ident), folderId(_folderId), stored(_stored),
-        m_pixmapLoaded(new bool(false)/*workaround for pixmap() const*/)
+        id(ident), folderId(_folderId), stored(_stored)
 {
     if (pixmap.isNull())
         m_pixmap = new QPixmap();
@@ -146,24 +303,19 @@ KexiBLOBBuffer::Item::~Item()
     m_pixmap = 0;
     delete m_data;
     m_data = 0;
-    delete m_pixmapLoaded;
 }
 
-QPixmap KexiBLOBBuffer::Item::pixmap() const
+QPixmap KexiBLOBBuffer::Item::pixmap(PixmapDecoding decoding) const
 {
-//! @todo ...
-    if (!*m_pixmapLoaded && m_pixmap->isNull() && !m_data->isEmpty()) {
-        const QMimeDatabase db;
-        const QMimeType mime(db.mimeTypeForName(mimeType));
-        if (!mime.isValid()
-            || !QImageReader::supportedMimeTypes().contains(mimeType.toLatin1())
-            || !KexiUtils::loadPixmapFromData(m_pixmap, *m_data, mime.preferredSuffix().toLatin1()))
-        {
-            //! @todo inform about error?
-        }
-        *m_pixmapLoaded = true;
-    }
-    return *m_pixmap;
+    if (!m_pixmap->isNull() || m_data->isEmpty())
+        return *m_pixmap;
+    return KexiBLOBBuffer::self()->cachedPixmap(this, *m_data, decoding);
+}
+
+bool KexiBLOBBuffer::Item::isPixmapBeingDecoded() const
+{
+    return !m_hash.isEmpty() && m_pixmap->isNull()
+           && KexiBLOBBuffer::self()->d->dataBeingDecoded.contains(m_hash);
 }
 
 /*! @return Extension for QPixmap::save() from @a mimeType.
@@ -216,6 +368,136 @@ KexiBLOBBuffer::~KexiBLOBBuffer()
     delete d;
 }
 
+/*! @return format for decoding images of @a mimeType; @a ok is set to false
+    if images of this type cannot be decoded. */
+static QByteArray imageFormat(const QString &mimeType, bool *ok)
+{
+    const QMimeDatabase db;
+    const QMimeType mime(db.mimeTypeForName(mimeType));
+    *ok = mime.isValid() && QImageReader::supportedMimeTypes().contains(mimeType.toLatin1());
+    return *ok ? mime.preferredSuffix().toLatin1() : QByteArray();
+}
+
+QPixmap KexiBLOBBuffer::cachedPixmap(const Item* item, const QByteArray& data,
+                                     PixmapDecoding decoding)
+{
+    const QByteArray hash(item->m_hash.isEmpty()
+                          ? QCryptographicHash::hash(data, QCryptographicHash::Sha1) : item->m_hash);
+    const QPixmap *cached = d->pixmap(hash);
+    if (cached) {
+        ++d->statistics.pixmapHits;
+        return *cached;
+    }
+    if (d->undecodableData.contains(hash)) {
+        return QPixmap();
+    }
+    if (decoding == PixmapDecoding::InBackground && !item->m_hash.isEmpty()) {
+        decodeInBackground(item);
+        return QPixmap(); // pixmapDecoded() will be emitted
+    }
+    // decode now, even if the data is being decoded in background
+    ++d->statistics.pixmapMisses;
+    QPixmap pixmap;
+    bool ok;
+    const QByteArray format(imageFormat(item->mimeType, &ok));
+    if (!ok || !KexiUtils::loadPixmapFromData(&pixmap, data, format.constData())) {
+        //! @todo inform about error?
+        d->undecodableData.insert(hash); // avoid decoding again
+        return QPixmap();
+    }
+    d->insertPixmap(hash, pixmap);
+    return pixmap;
+}
+
+void KexiBLOBBuffer::decodeInBackground(const Item* item)
+{
+    if (item->m_hash.isEmpty() || !item->m_pixmap->isNull()
+        || d->pixmap(item->m_hash)
+        || d->undecodableData.contains(item->m_hash)
+        || d->dataBeingDecoded.contains(item->m_hash))
+    {
+        return;
+    }
+    bool ok;
+    const QByteArray format(imageFormat(item->mimeType, &ok));
+    if (!ok) {
+        d->undecodableData.insert(item->m_hash);
+        return;
+    }
+    ++d->statistics.pixmapMisses;
+    d->dataBeingDecoded.insert(item->m_hash);
+    QThreadPool::globalInstance()->start(new DecodeImageTask(item->m_hash, *item->m_data, format));
+}
+
+void KexiBLOBBuffer::backgroundDecodingFinished(const QByteArray& hash, const QImage& image)
+{
+    d->dataBeingDecoded.remove(hash);
+    if (!d->dataByHash.contains(hash)) {
+        return; // objects with this data have been removed meanwhile
+    }
+    if (image.isNull()) {
+        //! @todo inform about error?
+        d->undecodableData.insert(hash);
+        return;
+    }
+    d->insertPixmap(hash, QPixmap::fromImage(image));
+    const QList<Item*> items(d->storedItems.values() + d->inMemoryItems.values());
+    for (const Item *item : items) {
+        if (item->m_hash == hash) {
+            emit pixmapDecoded(item->id, item->stored);
+        }
+    }
+}
+
+void KexiBLOBBuffer::shareData(Item* item)
+{
+    if (item->m_data->isEmpty())
+        return;
+    item->m_hash = QCryptographicHash::hash(*item->m_data, QCryptographicHash::Sha1);
+    Private::SharedData &shared = d->dataByHash[item->m_hash];
+    if (shared.refs == 0) {
+        shared.data = *item->m_data;
+    } else {
+        *item->m_data = shared.data; // the duplicate is freed
+        ++d->statistics.sharedObjects;
+    }
+    ++shared.refs;
+}
+
+void KexiBLOBBuffer::releaseData(Item* item)
+{
+    if (item->m_hash.isEmpty())
+        return;
+    QHash<QByteArray, Private::SharedData>::Iterator it = d->dataByHash.find(item->m_hash);
+    if (it == d->dataByHash.end())
+        return;
+    if (--it->refs <= 0) {
+        d->dataByHash.erase(it);
+        d->pixmapCache.remove(item->m_hash);
+        if (d->largePixmapHash == item->m_hash) {
+            d->largePixmapHash.clear();
+            d->largePixmap = QPixmap();
+        }
+        d->undecodableData.remove(item->m_hash);
+        // result of background decoding, if any, is ignored
+    }
+}
+
+KexiBLOBBuffer::Statistics KexiBLOBBuffer::statistics() const
+{
+    return d->statistics;
+}
+
+void KexiBLOBBuffer::setPixmapCacheSize(int kilobytes)
+{
+    d->pixmapCache.setMaxCost(qMax(0, kilobytes));
+}
+
+int KexiBLOBBuffer::pixmapCacheSize() const
+{
+    return d->pixmapCache.maxCost();
+}
+
 KexiBLOBBuffer::Handle KexiBLOBBuffer::insertPixmap(const QUrl &url)
 {
     if (url.isEmpty())
@@ -247,6 +529,7 @@ KexiBLOBBuffer::Handle KexiBLOBBuffer::insertPixmap(const QUrl &url)
     const QMimeType mimeType(db.mimeTypeForFileNameAndData(fileName, data));
 
     item = new Item(data, ++d->maxId, /*!stored*/false, url.fileName(), caption, mimeType.name());
+    shareData(item);
     insertItem(item);
 
     //cache
@@ -265,6 +548,7 @@ KexiBLOBBuffer::Handle KexiBLOBBuffer::insertObject(const QByteArray& data,
         newIdentifier = ++d->maxId;
 
     Item *item = new Item(data, newIdentifier, identifier > 0, name, caption, mimeType);
+    shareData(item);
     insertItem(item);
     return KexiBLOBBuffer::Handle(item);
 }
@@ -294,37 +578,21 @@ KexiBLOBBuffer::Handle KexiBLOBBuffer::objectForId(Id_t id, bool stored)
         return KexiBLOBBuffer::Handle();
     if (stored) {
         Item *item = d->storedItems.value(id);
-        if (item || !d->conn)
+        if (item || !d->conn) {
+            if (item)
+                ++d->statistics.objectHits;
             return KexiBLOBBuffer::Handle(item);
+        }
         //retrieve stored BLOB:
         Q_ASSERT(d->conn);
-        KDbTableSchema *blobsTable = d->conn->tableSchema("kexi__blobs");
-        if (!blobsTable) {
-            //! @todo err msg
-            return KexiBLOBBuffer::Handle();
-        }
-        /*  QStringList where;
-            where << "o_id";
-            KDbPreparedStatement::Ptr st = d->conn->prepareStatement(
-              KDbPreparedStatement::SelectStatement, *blobsTable, where);*/
-//! @todo use KDbPreparedStatement
-        KDbQuerySchema schema;
-        schema.addField(blobsTable->field("o_data"));
-        schema.addField(blobsTable->field("o_name"));
-        schema.addField(blobsTable->field("o_caption"));
-        schema.addField(blobsTable->field("o_mime"));
-        schema.addField(blobsTable->field("o_folder_id"));
-        QString errorMessage;
-        QString errorDescription;
-        if (!schema.addToWhereExpression(blobsTable->field("o_id"), QVariant((qint64)id),
-                                         '=', &errorMessage, &errorDescription))
-        {
-            qWarning() << "message=" << errorMessage
-                       << "description=" << errorDescription;
+        ++d->statistics.objectMisses;
+        KDbQuerySchema *query = d->objectQueryForConnection();
+        if (!query) {
             return KexiBLOBBuffer::Handle();
         }
         KDbRecordData recordData;
-        tristate res = d->conn->querySingleRecord(&schema, &recordData);
+        tristate res = d->conn->querySingleRecord(query, &recordData,
+                                                  QList<QVariant>() << QVariant(qint64(id)));
         if (res != true || recordData.size() < 4) {
             //! @todo err msg
             qWarning() << "id=" << id << "stored=" << stored
@@ -343,12 +611,97 @@ KexiBLOBBuffer::Handle KexiBLOBBuffer::objectForId(Id_t id, bool stored)
             (Id_t)recordData.at(4).toInt() //!< @todo folder id: fix Id_t for Qt4
         );
 
+        shareData(item);
         insertItem(item);
         return KexiBLOBBuffer::Handle(item);
     }
     return KexiBLOBBuffer::Handle(d->inMemoryItems.value(id));
 }
 
+QList<KexiBLOBBuffer::Handle> KexiBLOBBuffer::prefetchObjects(const QList<Id_t>& ids)
+{
+    QList<Handle> handles;
+    QList<Id_t> idsToLoad;
+    QSet<Id_t> uniqueIds;
+    for (Id_t id : ids) {
+        if (id <= 0 || uniqueIds.contains(id)) {
+            continue;
+        }
+        uniqueIds.insert(id);
+        Item *item = d->storedItems.value(id);
+        if (item) {
+            ++d->statistics.objectHits;
+            handles.append(Handle(item));
+            decodeInBackground(item);
+        } else {
+            idsToLoad.append(id);
+        }
+    }
+    if (idsToLoad.isEmpty() || !d->conn) {
+        return handles;
+    }
+    KDbTableSchema *blobsTable = d->conn->tableSchema("kexi__blobs");
+    if (!blobsTable) {
+        //! @todo err msg
+        return handles;
+    }
+    for (int chunkStart = 0; chunkStart < idsToLoad.count(); chunkStart += PREFETCH_CHUNK_SIZE) {
+        // SELECT o_id, o_data, o_name, o_caption, o_mime, o_folder_id FROM kexi__blobs
+        //   WHERE o_id IN (...)
+        KDbQuerySchema query;
+        query.addField(blobsTable->field("o_id"));
+        query.addField(blobsTable->field("o_data"));
+        query.addField(blobsTable->field("o_name"));
+        query.addField(blobsTable->field("o_caption"));
+        query.addField(blobsTable->field("o_mime"));
+        query.addField(blobsTable->field("o_folder_id"));
+        KDbNArgExpression idList(KDb::ArgumentListExpression, ',');
+        const int chunkEnd = qMin(chunkStart + PREFETCH_CHUNK_SIZE, idsToLoad.count());
+        for (int i = chunkStart; i < chunkEnd; ++i) {
+            idList.append(KDbConstExpression(KDbToken::INTEGER_CONST, qint64(idsToLoad[i])));
+        }
+        QString errorMessage;
+        QString errorDescription;
+        if (!query.setWhereExpression(
+                KDbBinaryExpression(KDbVariableExpression(QLatin1String("kexi__blobs.o_id")),
+                                    KDbToken::SQL_IN, idList),
+                &errorMessage, &errorDescription))
+        {
+            qWarning() << "message=" << errorMessage
+                       << "description=" << errorDescription;
+            return handles;
+        }
+        KDbCursor *cursor = d->conn->executeQuery(&query);
+        if (!cursor) {
+            //! @todo err msg
+            qWarning() << d->conn->result();
+            return handles;
+        }
+        for (cursor->moveFirst(); !cursor->eof(); cursor->moveNext()) {
+            const Id_t id = cursor->value(0).toLongLong();
+            if (d->storedItems.contains(id)) {
+                continue;
+            }
+            ++d->statistics.objectMisses;
+            Item *item = new Item(
+                cursor->value(1).toByteArray(),
+                id,
+                true, //stored
+                cursor->value(2).toString(),
+                cursor->value(3).toString(),
+                cursor->value(4).toString(),
+                (Id_t)cursor->value(5).toInt() //!< @todo folder id: fix Id_t for Qt4
+            );
+            shareData(item);
+            insertItem(item);
+            handles.append(Handle(item));
+            decodeInBackground(item);
+        }
+        d->conn->deleteCursor(cursor);
+    }
+    return handles;
+}
+
 KexiBLOBBuffer::Handle KexiBLOBBuffer::objectForId(Id_t id)
 {
     KexiBLOBBuffer::Handle h(objectForId(id, false/* !stored */));
@@ -368,6 +721,8 @@ void KexiBLOBBuffer::removeItem(Id_t id, bool stored)
     if (item && !item->prettyURL.isEmpty()) {
         d->itemsByURL.remove(item->prettyURL);
     }
+    if (item)
+        releaseData(item);
     delete item;
 }
 
@@ -391,7 +746,11 @@ void KexiBLOBBuffer::insertItem(Item *item)
 
 void KexiBLOBBuffer::setConnection(KDbConnection *conn)
 {
-    KexiBLOBBuffer::self()->d->conn = conn;
+    Private *d = KexiBLOBBuffer::self()->d;
+    d->conn = conn;
+    // the query refers to table schema of the previous connection or database,
+    // even if the same connection object is set again
+    d->clearObjectQuery();
 }
 
 KexiBLOBBuffer* KexiBLOBBuffer::self()
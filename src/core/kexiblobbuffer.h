@@ -21,12 +21,14 @@
 #define KEXIBLOBBUFFER_H
 
 #include <QObject>
+#include <QList>
 #include <QPixmap>
 #include <QUrl>
 
 #include "kexicore_export.h"
 
 class KDbConnection;
+class QImage;
 
 //! Application-wide buffer for local BLOB data like pixmaps.
 /*! For now only pixmaps are supported
@@ -87,8 +89,17 @@ public:
     //! Access to KexiBLOBBuffer singleton
     static KexiBLOBBuffer* self();
 
+    //! Sets connection used to load stored objects; nullptr should be set before
+    //! the connection is closed. Cached queries of the previous connection are deleted.
     static void setConnection(KDbConnection *conn);
 
+    //! Modes of decoding pixmaps, see Handle::pixmap()
+    enum class PixmapDecoding {
+        Now,         //!< decode in the calling thread if the pixmap is not decoded yet
+        InBackground //!< return null pixmap if the pixmap is not decoded yet, decode it
+                     //!< in background and emit pixmapDecoded() when it is ready
+    };
+
     //! Object handle used by KexiBLOBBuffer
     class KEXICORE_EXPORT Handle
     {
@@ -123,8 +134,15 @@ public:
             return m_item ? m_item->data() : QByteArray();
         }
 
-        QPixmap pixmap() const {
-            return m_item ? m_item->pixmap() : QPixmap();
+        QPixmap pixmap(PixmapDecoding decoding = PixmapDecoding::Now) const {
+            return m_item ? m_item->pixmap(decoding) : QPixmap();
+        }
+
+        /*! \return true if pixmap of this object is being decoded in background,
+         i.e. pixmap(PixmapDecoding::InBackground) returned null pixmap and pixmapDecoded()
+         will be emitted. False is returned for undecodable data. */
+        bool isPixmapBeingDecoded() const {
+            return m_item ? m_item->isPixmapBeingDecoded() : false;
         }
 
         /*! Sets "stored" flag to true by setting non-temporary identifier.
@@ -187,6 +205,39 @@ public:
      if stored was not found. */
     Handle objectForId(Id_t id);
 
+    /*! Loads stored objects for identifiers \a ids that are not buffered yet using
+     a few queries instead of one query per object, and starts decoding of their pixmaps
+     in background. pixmapDecoded() is emitted for every decoded pixmap.
+     \return handles to the objects found, these keep the objects buffered
+     for as long as they exist. */
+    QList<Handle> prefetchObjects(const QList<Id_t>& ids);
+
+    //! Counters of buffer use, see statistics()
+    struct Statistics {
+        qint64 pixmapHits = 0;    //!< pixmaps found decoded in the cache
+        qint64 pixmapMisses = 0;  //!< pixmaps decoded from data
+        qint64 objectHits = 0;    //!< stored objects found in the buffer
+        qint64 objectMisses = 0;  //!< stored objects loaded from the database
+        qint64 sharedObjects = 0; //!< objects sharing data with other objects of the same contents
+    };
+
+    //! \return counters of buffer use since the application started
+    Statistics statistics() const;
+
+    /*! Sets maximum size of decoded pixmaps kept in memory to \a kilobytes.
+     Least recently used pixmaps are released first; they are decoded again from data
+     when needed. The most recently decoded pixmap larger than the cache is kept as well.
+     64 MB is used by default. */
+    void setPixmapCacheSize(int kilobytes);
+
+    //! \return maximum size of decoded pixmaps kept in memory in kilobytes
+    int pixmapCacheSize() const;
+
+Q_SIGNALS:
+    /*! Emitted after pixmap of object \a id has been decoded in background.
+     Until then pixmap of the object is null. */
+    void pixmapDecoded(KexiBLOBBuffer::Id_t id, bool stored);
+
 protected:
     /*! Removes an object for a given \a id. If \a stored is true, stored BLOB is removed,
      otherwise unstored (in memory) BLOB is removed. */
@@ -198,6 +249,27 @@ protected:
     /*! Inserts an object for a given \a id into the buffer. */
     void insertItem(Item* item);
 
+    /*! Makes data of \a item shared with other items of the same contents,
+     so the data and its decoded pixmap are kept in memory once. */
+    void shareData(Item* item);
+
+    /*! Releases data of \a item shared using shareData(). */
+    void releaseData(Item* item);
+
+    /*! \return pixmap decoded from \a data of \a item, cached by contents.
+     If \a decoding is PixmapDecoding::InBackground and the pixmap is not cached,
+     null pixmap is returned and decoding is started using decodeInBackground(). */
+    QPixmap cachedPixmap(const Item* item, const QByteArray& data, PixmapDecoding decoding);
+
+    /*! Starts decoding of pixmap of \a item in background unless it is already decoded
+     or being decoded. */
+    void decodeInBackground(const Item* item);
+
+private Q_SLOTS:
+    /*! Inserts \a image decoded in background for data with hash \a hash into the cache
+     and emits pixmapDecoded() for objects having this data. */
+    void backgroundDecodingFinished(const QByteArray& hash, const QImage& image);
+
 private:
     class KEXICORE_EXPORT Item
     {
@@ -210,7 +282,8 @@ private:
              Id_t folderId = 0,
              const QPixmap& pixmap = QPixmap());
         ~Item();
-        QPixmap pixmap() const;
+        QPixmap pixmap(PixmapDecoding decoding) const;
+        bool isPixmapBeingDecoded() const;
         QByteArray data() const;
         QString name;
         QString caption; //!< @todo for future use within image gallery
@@ -222,9 +295,8 @@ private:
         QString prettyURL; //!< helper
     private:
         QByteArray *m_data;
-        QPixmap *m_pixmap;
-        bool *m_pixmapLoaded; //!< *m_pixmapLoaded will be set in Info::pixmap(),
-        //!< to avoid multiple pixmap decoding when it previously failed
+        QPixmap *m_pixmap; //!< set for pixmaps inserted directly, these are not cached
+        QByteArray m_hash; //!< hash of contents of m_data, set by shareData()
         friend class KexiBLOBBuffer;
     };
     class Private;
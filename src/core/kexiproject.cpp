@@ -684,13 +684,12 @@ KexiProject::createConnection()
     if (!d->connection->connect()) {
         m_result = d->connection->result();
         qWarning() << "error connecting:" << m_result;
-        delete d->connection; //this will also clear connection for BLOB buffer
+        delete d->connection;
         d->connection = 0;
         return false;
     }
 
     //re-init BLOB buffer
-//! @todo won't work for subsequent connection
     KexiBLOBBuffer::setConnection(d->connection);
     return true;
 }
@@ -710,7 +709,8 @@ bool KexiProject::closeConnectionInternal()
         return false;
     }
 
-    delete d->connection; //this will also clear connection for BLOB buffer
+    KexiBLOBBuffer::setConnection(nullptr);
+    delete d->connection;
     d->connection = 0;
     return true;
 }
@@ -727,7 +727,8 @@ bool KexiProject::closeConnection()
         return false;
     }
 
-    delete d->connection; //this will also clear connection for BLOB buffer
+    KexiBLOBBuffer::setConnection(nullptr);
+    delete d->connection;
     d->connection = 0;
     return true;
 }
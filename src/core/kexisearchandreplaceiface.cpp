@@ -36,6 +36,12 @@ KexiSearchAndReplaceViewInterface::Options::Options()
         , caseSensitive(false)
         , wholeWordsOnly(false)
         , promptOnReplace(true)
+        , searchInDatabase(false)
+        , progressHandler(nullptr)
+{
+}
+
+KexiSearchAndReplaceViewInterface::Options::ProgressHandler::~ProgressHandler()
 {
 }
 
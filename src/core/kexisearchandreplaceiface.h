@@ -81,6 +81,24 @@ public:
 
         //! True if question should be displayed before every replacement made (true by default)
         bool promptOnReplace;
+
+        //! True if the database should be queried for values in records that are not
+        //! fetched yet, instead of fetching and searching all records (false by default)
+        bool searchInDatabase;
+
+        //! @short Receives progress of long find and replace operations
+        class KEXICORE_EXPORT ProgressHandler
+        {
+        public:
+            virtual ~ProgressHandler();
+
+            /*! Called periodically from the GUI thread while searching, with @a percent
+             of data searched so far. @return false to cancel the operation. */
+            virtual bool updateProgress(int percent) = 0;
+        };
+
+        //! Handler informed about progress of the operation, not owned (nullptr by default)
+        ProgressHandler *progressHandler;
     };
 
     /*! Sets up data for find/replace dialog, based on view's data model.
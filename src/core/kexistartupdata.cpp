@@ -214,6 +214,9 @@ tristate KexiStartupData::parseOptions(const QStringList &arguments,
     ADD_OPTION(print)
     ADD_OPTION(printPreview)
 #endif
+    ADD_OPTION(exportCsv)
+    ADD_OPTION(importCsv)
+    ADD_OPTION(to)
     ADD_OPTION(user)
     ADD_OPTION(host)
     ADD_OPTION(port)
@@ -21,6 +21,7 @@
 #include "kformdesigner_export.h"
 
 #include <QDomDocument>
+#include <QXmlStreamReader>
 #include <QFile>
 #include <QTextStream>
 #include <QCursor>
@@ -69,6 +70,19 @@ static QString nameAttribute(const QDomElement& el)
     return res;
 }
 
+//! @return name of widget saved in element @a el, i.e. value of its "name" property
+static QString widgetName(const QDomElement &el)
+{
+    for (QDomNode n = el.firstChild(); !n.isNull(); n = n.nextSibling()) {
+        if (   n.toElement().tagName() == "property"
+            && nameAttribute(n.toElement()) == "name" /* compat with 1.x */)
+        {
+            return n.toElement().text();
+        }
+    }
+    return QString();
+}
+
 //! A blank widget used when the class name is not supported
 CustomWidget::CustomWidget(const QByteArray &className, QWidget *parent)
         : QWidget(parent), m_className(className)
@@ -92,6 +106,195 @@ CustomWidget::paintEvent(QPaintEvent *)
 
 using namespace KFormDesigner;
 
+//! @return "image" element named @a name of the "images" section of @a ui
+static QDomElement imageElement(const QDomElement &ui, const QString &name)
+{
+    const QDomElement imagesEl(ui.firstChildElement("images"));
+    for (QDomElement image = imagesEl.firstChildElement("image"); !image.isNull();
+         image = image.nextSiblingElement("image"))
+    {
+        if (image.attribute("name") == name) {
+            return image;
+        }
+    }
+    return QDomElement();
+}
+
+//! @return pixmap decoded from @a data of an "image" element
+//! saved in @a format with @a encoding, @a length is the length of uncompressed data.
+static QPixmap decodeImage(const QByteArray &data, const QString &format, const QString &encoding,
+                           int length)
+{
+    QPixmap pix;
+    if (encoding == QLatin1String("base64")) {
+        KexiUtils::loadPixmapFromData(&pix, QByteArray::fromBase64(data), format.toLatin1());
+        return pix;
+    }
+    // hex-encoded image saved by older versions
+    const QByteArray ba(QByteArray::fromHex(data));
+    if ((format == "XPM.GZ") || (format == "XBM.GZ")) {
+        int len = length;
+        if (len < data.length() * 5)
+            len = data.length() * 5;
+        // qUncompress() expects the first 4 bytes to be the expected length of
+        // the uncompressed data
+        QByteArray bazip(4, '\0');
+        bazip[0] = char((len & 0xff000000) >> 24);
+        bazip[1] = char((len & 0x00ff0000) >> 16);
+        bazip[2] = char((len & 0x0000ff00) >> 8);
+        bazip[3] = char(len & 0x000000ff);
+        bazip += ba;
+        const QByteArray baunzip = qUncompress(bazip);
+        KexiUtils::loadPixmapFromData(&pix, baunzip, format.left(format.indexOf('.')).toLatin1());
+    } else {
+        KexiUtils::loadPixmapFromData(&pix, ba, format.toLatin1());
+    }
+    return pix;
+}
+
+namespace {
+
+//! Contents of an element describing a property value, e.g. "rect" or "string"
+struct PropertyValueElement
+{
+    //! @return integer value of the child element @a name
+    int field(const char *name) const {
+        return fields.value(QLatin1String(name)).toInt();
+    }
+
+    QString type; //!< tag name of the element
+    QString text; //!< text of the element including text of child elements
+    QHash<QString, QString> fields; //!< text of the first child element of each name
+};
+
+}
+
+//! Contents of the "data" element of an image
+struct FormIO::ImageData
+{
+    //! @return the pixmap, decoded on first use only
+    QPixmap pixmap() {
+        if (!decoded) {
+            decodedPixmap = decodeImage(data, format, encoding, length);
+            decoded = true;
+            data.clear();
+        }
+        return decodedPixmap;
+    }
+
+    QByteArray data;
+    QString format;
+    QString encoding;
+    int length = 0;
+    QPixmap decodedPixmap;
+    bool decoded = false;
+};
+
+QHash<QString, FormIO::ImageData> *FormIO::m_images = nullptr;
+
+//! @internal Single pass loader of .ui data
+/*! Widgets and the object tree are created while reading the data, without building
+ a DOM tree. It supports the structure of .ui data saved by FormIO:
+ each "widget" element starts with the "name" property. Elements that do not follow it
+ and elements handled by widget factories are read into DOM fragments and loaded
+ by the DOM-based FormIO functions.
+
+ Images are saved after widgets so pixmap properties are set after all the data is read. */
+class Q_DECL_HIDDEN FormIO::StreamLoader
+{
+public:
+    StreamLoader(Form *form, QWidget *container, QXmlStreamReader *xml);
+
+    //! Loads the form, @return false if the data is not well-formed
+    bool load();
+
+private:
+    //! Loads the form while m_images is used by FormIO::loadImage(), see load()
+    bool loadInternal();
+
+    //! Reads the "widget" element of the toplevel widget
+    void readToplevelWidget();
+
+    //! Reads a "widget" or "spacer" element of a child widget, see FormIO::loadWidget()
+    void readWidget(Container *container, QWidget *parent);
+
+    //! Reads child elements of the current element, see FormIO::readChildNodes()
+    void readChildNodes(ObjectTreeItem *item, Container *container, QWidget *w,
+                        const QString &eltag);
+
+    //! Reads the current child element, @see readChildNodes()
+    void readChildNode(ObjectTreeItem *item, Container *container, QWidget *w,
+                       const QString &eltag);
+
+    //! Reads the current "property" or "attribute" element
+    void readProperty(ObjectTreeItem *item, Container *container, QWidget *w,
+                      const QString &eltag);
+
+    //! Reads the current "grid" element
+    void readGrid(ObjectTreeItem *item, Container *container, QWidget *w, const QString &eltag);
+
+    //! Reads value of the current "property" element
+    PropertyValueElement readPropertyValue();
+
+    //! @return true if the current element is the "name" property
+    bool isNameProperty() const;
+
+    //! Reads the "images" section
+    void readImages();
+
+    //! Reads the "tabstops" section
+    void readTabStops();
+
+    //! Sets properties of the tabstops section, pixmaps and buddies after all data is read
+    void finish();
+
+    //! Deletes widgets created before an error has been found in the data
+    void deleteCreatedWidgets();
+
+    //! Queues pixmap properties of widget @a item and its child widgets loaded from @a el
+    //! by the DOM-based code since images are not read yet, see finish()
+    void queueDomPixmaps(ObjectTreeItem *item, const QDomElement &el);
+
+    //! Reads the current element into a DOM fragment
+    QDomElement readElementAsDom();
+
+    //! Reads the rest of the current element named @a tagName into a DOM fragment.
+    //! If @a childStarted is true, the first child element has been already started.
+    QDomElement readRestAsDom(const QString &tagName, const QXmlStreamAttributes &attributes,
+                              bool childStarted);
+
+    //! Reads child nodes of the current element into @a el
+    void readDomChildren(QDomElement *el);
+
+    //! @return new DOM element @a tagName with @a attributes
+    QDomElement createDomElement(const QString &tagName, const QXmlStreamAttributes &attributes);
+
+    //! A pixmap property to set after the "images" section is read
+    struct PendingPixmap {
+        ObjectTreeItem *item;
+        QWidget *widget;
+        QString name;
+        QString imageName;
+    };
+
+    Form * const m_form;
+    QWidget * const m_container;
+    QXmlStreamReader * const m_xml;
+    QDomDocument m_fragments; //!< Owner of DOM fragments
+    QHash<QString, QLabel*> m_buddies;
+    QHash<QString, ImageData> m_images;
+    QList<PendingPixmap> m_pixmaps;
+    QStringList m_tabStops;
+    bool m_toplevelWidgetRead = false;
+    bool m_headerRead = false;
+    bool m_tabStopsRead = false;
+    bool m_pixmapInProject = false;
+    bool m_imagesRead = false;
+#ifdef KFD_SIGSLOTS
+    QDomElement m_connections;
+#endif
+};
+
 // FormIO itself
 
 KFORMDESIGNER_EXPORT QString KFormDesigner::version()
@@ -236,20 +439,8 @@ FormIO::saveFormToDom(Form *form, QDomDocument &domDoc)
 bool
 FormIO::loadFormFromByteArray(Form *form, QWidget *container, QByteArray &src, bool preview)
 {
-    QString errMsg;
-    int errLine;
-    int errCol;
-
-    QDomDocument domDoc;
-    bool parsed = domDoc.setContent(src, false, &errMsg, &errLine, &errCol);
-
-    if (!parsed) {
-        qDebug() << errMsg;
-        qDebug() << "line:" << errLine << "col:" << errCol;
-        return false;
-    }
-
-    if (!loadFormFromDom(form, container, domDoc)) {
+    QXmlStreamReader xml(src);
+    if (!StreamLoader(form, container, &xml).load()) {
         return false;
     }
     if (preview) {
@@ -261,25 +452,13 @@ FormIO::loadFormFromByteArray(Form *form, QWidget *container, QByteArray &src, b
 bool
 FormIO::loadFormFromString(Form *form, QWidget *container, const QString &src, bool preview)
 {
-    QString errMsg;
-    int errLine;
-    int errCol;
-
 #ifdef KEXI_DEBUG_GUI
     form->m_recentlyLoadedUICode = src;
 #endif
 
-    QDomDocument domDoc;
     //qDebug() << qPrintable(src);
-    bool parsed = domDoc.setContent(src, false, &errMsg, &errLine, &errCol);
-
-    if (!parsed) {
-        qWarning() << errMsg;
-        qWarning() << "line:" << errLine << "col:" << errCol;
-        return false;
-    }
-
-    if (!loadFormFromDom(form, container, domDoc)) {
+    QXmlStreamReader xml(src);
+    if (!StreamLoader(form, container, &xml).load()) {
         return false;
     }
     if (preview) {
@@ -291,9 +470,6 @@ FormIO::loadFormFromString(Form *form, QWidget *container, const QString &src, b
 bool
 FormIO::loadFormFromFile(Form *form, QWidget *container, const QString &filename)
 {
-    QString errMsg;
-    int errLine;
-    int errCol;
     QString _filename;
 
     if (filename.isEmpty()) {
@@ -314,34 +490,21 @@ FormIO::loadFormFromFile(Form *form, QWidget *container, const QString &filename
         qWarning() << "Cannot open the file" << _filename;
         return false;
     }
-    QDomDocument doc;
-    if (!doc.setContent(&file, false/* !namespaceProcessing*/,
-                        &errMsg, &errLine, &errCol)) {
+    QXmlStreamReader xml(&file);
 //! @todo show err msg to the user
-        qWarning() << errMsg;
-        qWarning() << errLine << "col:" << errCol;
-        return false;
-    }
-
-    return loadFormFromDom(form, container, doc);
+    return StreamLoader(form, container, &xml).load();
 }
 
 bool FormIO::loadFormFromDom(Form *form, QWidget *container, const QDomDocument &domDoc)
 {
-    QDomElement ui = domDoc.firstChildElement("UI");
+    const QByteArray src(domDoc.toByteArray());
+    QXmlStreamReader xml(src);
+    return StreamLoader(form, container, &xml).load();
+}
 
-    //custom properties
-    form->headerProperties()->clear();
-    QDomElement headerPropertiesEl = ui.firstChildElement("kfd:customHeader");
-    QDomAttr attr = headerPropertiesEl.firstChild().toAttr();
-    QDomNamedNodeMap attrs(headerPropertiesEl.attributes());
-    for(int i = 0; i < attrs.count(); ++i) {
-        const QDomAttr attr(attrs.item(i).toAttr());
-        if (!attr.isNull()) {
-            form->headerProperties()->insert(attr.name().toLatin1(), attr.value());
-        }
-    }
-    //update format version information
+//! Updates format version information of @a form using its header properties
+static void updateFormatVersion(Form *form)
+{
     const QString ver = form->headerProperties()->value("version");
     //qDebug() << "Original format version:" << ver;
     form->setOriginalFormatVersion(ver);
@@ -364,49 +527,6 @@ bool FormIO::loadFormFromDom(Form *form, QWidget *container, const QDomDocument
         qDebug() << "The original format is version" << ver
                  << "is newer than current version:" << KFormDesigner::version();
     }
-
-    // Load the pixmap collection
-    form->setPixmapsStoredInline(ui.firstChildElement("pixmapinproject").isNull()
-                                 || !ui.firstChildElement("images").isNull());
-//! @todo pixmapcollection
-#ifdef KEXI_PIXMAP_COLLECTIONS_SUPPORT
-    form->pixmapCollection()->load(ui.namedItem("collection"));
-#endif
-
-    QDomElement element = ui.firstChildElement("widget");
-    createToplevelWidget(form, container, element);
-
-    // Loading the tabstops
-    QDomElement tabStops = ui.firstChildElement("tabstops");
-    if (!tabStops.isNull()) {
-        int i = 0;
-        int itemsNotFound = 0;
-        for (QDomNode n = tabStops.firstChild(); !n.isNull(); n = n.nextSibling(), i++) {
-            QString name = n.toElement().text();
-            ObjectTreeItem *item = form->objectTree()->lookup(name);
-            if (!item) {
-                qWarning() << "Tabstops loading: no item" << name;
-                continue;
-            }
-            const int index = form->tabStops()->indexOf(item);
-            /* Compute a real destination index: "a number of not found items so far". */
-            const int realIndex = i - itemsNotFound;
-            if ((index != -1) && (index != realIndex)) { // the widget is not in the same place, so we move it
-                form->tabStops()->removeOne(item);
-                form->tabStops()->insert(realIndex, item);
-            }
-            if (index == -1) {
-                itemsNotFound++;
-                qDebug() << "Tabstops loading: item" << name << "not on the list";
-            }
-        }
-    }
-
-#ifdef KFD_SIGSLOTS
-    // Load the form connections
-    form->connectionBuffer()->load(ui.namedItem("connections"));
-#endif
-    return true;
 }
 
 /////////////////////////////////////////////////////////////////////////////
@@ -742,32 +862,34 @@ FormIO::savePropertyElement(QDomElement &parentNode, QDomDocument &domDoc, const
     parentNode.appendChild(propertyE);
 }
 
-QVariant FormIO::readPropertyValue(Form *form, QDomNode node, QObject *obj, const QString &name)
+//! @return contents of @a tag describing a property value
+static PropertyValueElement propertyValueElement(const QDomElement &tag)
 {
-    QDomElement tag = node.toElement();
-    QString text = tag.text();
-    QString type = tag.tagName();
+    PropertyValueElement el;
+    el.type = tag.tagName();
+    el.text = tag.text();
+    for (QDomElement field = tag.firstChildElement(); !field.isNull();
+         field = field.nextSiblingElement())
+    {
+        if (!el.fields.contains(field.tagName())) {
+            el.fields.insert(field.tagName(), field.text());
+        }
+    }
+    return el;
+}
+
+//! @return value of property @a name of @a obj described by @a el. Pixmaps are not handled here.
+static QVariant propertyValue(const PropertyValueElement &el, QObject *obj, const QString &name)
+{
+    const QString &type = el.type;
+    const QString &text = el.text;
 
     if (type == "string" || type == "cstring")
         return text;
     else if (type == "rect") {
-        QDomElement x = node.firstChildElement("x");
-        QDomElement y = node.firstChildElement("y");
-        QDomElement w = node.firstChildElement("width");
-        QDomElement h = node.firstChildElement("height");
-
-        int rx = x.text().toInt();
-        int ry = y.text().toInt();
-        int rw = w.text().toInt();
-        int rh = h.text().toInt();
-
-        return QRect(rx, ry, rw, rh);
+        return QRect(el.field("x"), el.field("y"), el.field("width"), el.field("height"));
     } else if (type == "color") {
-        const QDomElement r(node.firstChildElement("red"));
-        const QDomElement g(node.firstChildElement("green"));
-        const QDomElement b(node.firstChildElement("blue"));
-
-        return QColor(r.text().toInt(), g.text().toInt(), b.text().toInt());
+        return QColor(el.field("red"), el.field("green"), el.field("blue"));
     } else if (type == "bool") {
         if (text == "true")
             return true;
@@ -777,85 +899,38 @@ QVariant FormIO::readPropertyValue(Form *form, QDomNode node, QObject *obj, cons
     } else if (type == "number") {
         return text.toInt();
     } else if (type == "size") {
-        QDomElement w = node.firstChildElement("width");
-        QDomElement h = node.firstChildElement("height");
-
-        return QSize(w.text().toInt(), h.text().toInt());
+        return QSize(el.field("width"), el.field("height"));
     } else if (type == "point") {
-        QDomElement x = node.firstChildElement("x");
-        QDomElement y = node.firstChildElement("y");
-
-        return QPoint(x.text().toInt(), y.text().toInt());
+        return QPoint(el.field("x"), el.field("y"));
     } else if (type == "font") {
-        QDomElement fa = node.firstChildElement("family");
-        QDomElement p = node.firstChildElement("pointsize");
-        QDomElement w = node.firstChildElement("weight");
-        QDomElement b = node.firstChildElement("bold");
-        QDomElement i = node.firstChildElement("italic");
-        QDomElement u = node.firstChildElement("underline");
-        QDomElement s = node.firstChildElement("strikeout");
-
         QFont f;
-        f.setFamily(fa.text());
-        f.setPointSize(p.text().toInt());
-        f.setWeight(w.text().toInt());
-        f.setBold(b.text().toInt());
-        f.setItalic(i.text().toInt());
-        f.setUnderline(u.text().toInt());
-        f.setStrikeOut(s.text().toInt());
+        f.setFamily(el.fields.value("family"));
+        f.setPointSize(el.field("pointsize"));
+        f.setWeight(el.field("weight"));
+        f.setBold(el.field("bold"));
+        f.setItalic(el.field("italic"));
+        f.setUnderline(el.field("underline"));
+        f.setStrikeOut(el.field("strikeout"));
 
         return f;
     } else if (type == "cursor") {
         return QCursor((Qt::CursorShape) text.toInt());
     } else if (type == "time") {
-        QDomElement h = node.firstChildElement("hour");
-        QDomElement m = node.firstChildElement("minute");
-        QDomElement s = node.firstChildElement("second");
-
-        return QTime(h.text().toInt(), m.text().toInt(), s.text().toInt());
+        return QTime(el.field("hour"), el.field("minute"), el.field("second"));
     } else if (type == "date") {
-        QDomElement y = node.firstChildElement("year");
-        QDomElement m = node.firstChildElement("month");
-        QDomElement d = node.firstChildElement("day");
-
-        return QDate(y.text().toInt(), m.text().toInt(), d.text().toInt());
+        return QDate(el.field("year"), el.field("month"), el.field("day"));
     } else if (type == "datetime") {
-        QDomElement h = node.firstChildElement("hour");
-        QDomElement m = node.firstChildElement("minute");
-        QDomElement s = node.firstChildElement("second");
-        QDomElement y = node.firstChildElement("year");
-        QDomElement mo = node.firstChildElement("month");
-        QDomElement d = node.firstChildElement("day");
-
-        QTime t(h.text().toInt(), m.text().toInt(), s.text().toInt());
-        QDate da(y.text().toInt(), mo.text().toInt(), d.text().toInt());
+        QTime t(el.field("hour"), el.field("minute"), el.field("second"));
+        QDate da(el.field("year"), el.field("month"), el.field("day"));
 
         return QDateTime(da, t);
     } else if (type == "sizepolicy") {
-        QDomElement h = node.firstChildElement("hsizetype");
-        QDomElement v = node.firstChildElement("vsizetype");
-        QDomElement hs = node.firstChildElement("horstretch");
-        QDomElement vs = node.firstChildElement("verstretch");
-
         QSizePolicy s;
-        s.setHorizontalPolicy((QSizePolicy::Policy)h.text().toInt());
-        s.setVerticalPolicy((QSizePolicy::Policy)v.text().toInt());
-        s.setHorizontalStretch(hs.text().toInt());
-        s.setVerticalStretch(vs.text().toInt());
+        s.setHorizontalPolicy((QSizePolicy::Policy)el.field("hsizetype"));
+        s.setVerticalPolicy((QSizePolicy::Policy)el.field("vsizetype"));
+        s.setHorizontalStretch(el.field("horstretch"));
+        s.setVerticalStretch(el.field("verstretch"));
         return s;
-    } else if (type == "pixmap") {
-//! @todo pixmapcollection
-#ifdef KEXI_PIXMAP_COLLECTIONS_SUPPORT
-        if (form->pixmapsStoredInline() || !m_currentForm || !m_currentRecord || !m_currentForm->pixmapCollection()->contains(text))
-            return loadImage(tag.ownerDocument(), text);
-        else {
-            m_currentRecord->setPixmapName(name.toLatin1(), text);
-            return form->pixmapCollection()->getPixmap(text);
-        }
-#else
-        Q_UNUSED(form);
-#endif
-        return QPixmap();
     }
     else if (type == "enum") {
         return text;
@@ -881,6 +956,26 @@ QVariant FormIO::readPropertyValue(Form *form, QDomNode node, QObject *obj, cons
     return QVariant();
 }
 
+QVariant FormIO::readPropertyValue(Form *form, QDomNode node, QObject *obj, const QString &name)
+{
+    QDomElement tag = node.toElement();
+
+    if (tag.tagName() == "pixmap") {
+        const QString text(tag.text());
+//! @todo pixmapcollection
+#ifdef KEXI_PIXMAP_COLLECTIONS_SUPPORT
+        if (!form->pixmapsStoredInline() && m_currentForm && m_currentRecord && m_currentForm->pixmapCollection()->contains(text)) {
+            m_currentRecord->setPixmapName(name.toLatin1(), text);
+            return form->pixmapCollection()->getPixmap(text);
+        }
+#else
+        Q_UNUSED(form);
+#endif
+        return loadImage(tag.ownerDocument(), text);
+    }
+    return propertyValue(propertyValueElement(tag), obj, name);
+}
+
 /////////////////////////////////////////////////////////////////////////////
 ///////////// Functions to save/load widgets ////////////////////////////////
 /////////////////////////////////////////////////////////////////////////////
@@ -1070,31 +1165,29 @@ FormIO::cleanClipboard(QDomElement &uiElement)
         uiElement.insertAfter(uiElement.firstChildElement("images"), QDomNode());
 }
 
-void FormIO::loadWidget(Container *container, const QDomElement &el, QWidget *parent,
-                        QHash<QString, QLabel*> *buddies)
+//! @return true if @a tag is name of an element describing a layout
+static bool isLayoutElement(const QString &tag)
 {
-    Form *form = container->form();
+    return tag == "grid" || tag == "hbox" || tag == "vbox";
+}
 
-    // We first look for the widget's name
-    QString wname;
-    for (QDomNode n = el.firstChild(); !n.isNull(); n = n.nextSibling()) {
-        if (   n.toElement().tagName() == "property"
-            && nameAttribute(n.toElement()) == "name" /* compat with 1.x */)
-        {
-            wname = n.toElement().text();
-            break;
-        }
-    }
-    ObjectTreeItem *item = container->form()->objectTree()->lookup(wname);
-    if (item) {
-        qWarning() << "Widget" << wname << "already exists! Skipping...";
-        return;
-    }
+//! @return subwidget of @a w if there is one, @a w otherwise
+static QWidget* subwidgetOf(QWidget *w)
+{
+    WidgetWithSubpropertiesInterface* subpropIface = dynamic_cast<WidgetWithSubpropertiesInterface*>(w);
+    return (subpropIface && subpropIface->subwidget()) ? subpropIface->subwidget() : w;
+}
+
+//! Creates widget of class @a classname named @a wname for @a container,
+//! with @a parent as parent widget, and inserts its item to the ObjectTree.
+//! @return the widget or nullptr on failure. @a itemPtr is set to the item.
+static QWidget* createWidget(Container *container, QByteArray classname, const QString &wname,
+                             QWidget *parent, ObjectTreeItem **itemPtr)
+{
+    Form *form = container->form();
 
-    QByteArray classname, alternate;
     // check if this classname is an alternate one, and replace it if necessary
-    classname = el.attribute("class").toLatin1();
-    alternate = container->form()->library()->classNameForAlternate(classname);
+    const QByteArray alternate = form->library()->classNameForAlternate(classname);
 
     QWidget *w;
     if (alternate == "CustomWidget") {
@@ -1106,20 +1199,20 @@ void FormIO::loadWidget(Container *container, const QDomElement &el, QWidget *pa
         }
 
         WidgetFactory::CreateWidgetOptions widgetOptions = WidgetFactory::DefaultOptions;
-        if (container->form()->mode() != Form::DesignMode) {
+        if (form->mode() != Form::DesignMode) {
             widgetOptions ^= WidgetFactory::DesignViewMode;
         }
 
         if (!parent)
-            w = container->form()->library()->createWidget(classname, container->widget(),
+            w = form->library()->createWidget(classname, container->widget(),
                     wname.toLatin1(), container, widgetOptions);
         else
-            w = container->form()->library()->createWidget(classname, parent, wname.toLatin1(),
+            w = form->library()->createWidget(classname, parent, wname.toLatin1(),
                     container, widgetOptions);
     }
 
     if (!w)
-        return;
+        return nullptr;
 //! @todo allow setting this for data view mode as well
     if (form->mode() == Form::DesignMode) {
         //don't generate accelerators for widgets in design mode
@@ -1128,62 +1221,66 @@ void FormIO::loadWidget(Container *container, const QDomElement &el, QWidget *pa
     w->show();
 
     // We create and insert the ObjectTreeItem at the good place in the ObjectTree
-    item = container->form()->objectTree()->lookup(wname);
+    ObjectTreeItem *item = form->objectTree()->lookup(wname);
     //qDebug() << wname << item << classname << (parent ? parent->objectName() : QString());
     if (!item)  {
         // not yet created
         //qDebug() << "Creating ObjectTreeItem:";
-        item =  new ObjectTreeItem(container->form()->library()->displayName(classname),
+        item =  new ObjectTreeItem(form->library()->displayName(classname),
                                    wname, w, container);
         if (parent)  {
-            ObjectTreeItem *titem = container->form()->objectTree()->lookup(parent->objectName());
+            ObjectTreeItem *titem = form->objectTree()->lookup(parent->objectName());
             if (titem)
-                container->form()->objectTree()->addItem(titem, item);
+                form->objectTree()->addItem(titem, item);
             else
                 qWarning() << "ERROR no parent widget";
         } else
-            container->form()->objectTree()->addItem(container->objectTree(), item);
+            form->objectTree()->addItem(container->objectTree(), item);
     }
     //assign item for its widget if it supports DesignTimeDynamicChildWidgetHandler interface
     //(e.g. KexiDBAutoField)
     DesignTimeDynamicChildWidgetHandler *childHandler = dynamic_cast<DesignTimeDynamicChildWidgetHandler*>(w);
-    if (container->form()->mode() == Form::DesignMode && childHandler) {
+    if (form->mode() == Form::DesignMode && childHandler) {
         childHandler->assignItem(item);
     }
+    *itemPtr = item;
+    return w;
+}
 
+//! Adds widget @a w of @a item to layout of @a container. Inside a grid the widget is placed
+//! at @a row and @a column and spans multiple cells if @a rowSpan or @a colSpan is positive.
+static void addToLayout(Container *container, ObjectTreeItem *item, QWidget *w,
+                        int row, int column, int rowSpan, int colSpan)
+{
     // if we are inside a Grid, we need to insert the widget in the good cell
     if (container->layoutType() == Form::Grid)  {
         QGridLayout *layout = (QGridLayout*)container->layout();
-        if (el.hasAttribute("rowspan")) { // widget spans multiple cells
+        if (rowSpan > 0 || colSpan > 0) { // widget spans multiple cells
             if (layout) {
-                layout->addWidget(
-                    w,
-                    el.attribute("row").toInt(), el.attribute("column").toInt(),
-                    el.attribute("rowspan").toInt(), el.attribute("colspan").toInt());
+                layout->addWidget(w, row, column, rowSpan, colSpan);
 //! @todo alignment attribute?
             }
-            item->setGridPos(el.attribute("row").toInt(),  el.attribute("column").toInt(), el.attribute("rowspan").toInt(),
-                             el.attribute("colspan").toInt());
+            item->setGridPos(row, column, rowSpan, colSpan);
         } else  {
             if (layout) {
-                layout->addWidget(w, el.attribute("row").toInt(), el.attribute("column").toInt());
+                layout->addWidget(w, row, column);
             }
-            item->setGridPos(el.attribute("row").toInt(),  el.attribute("column").toInt(), 0, 0);
+            item->setGridPos(row, column, 0, 0);
         }
     } else if (container->layout())
         container->layout()->addWidget(w);
+}
 
-    readChildNodes(item, container, el, w, buddies);
-
+//! Finishes loading of widget @a w of @a item after its child nodes are read
+static void finishWidget(Container *container, ObjectTreeItem *item, QWidget *w)
+{
     if (item->container() && item->container()->layout())
         item->container()->layout()->activate();
 
     // add the autoSaveProperties in the modifProp list of the ObjectTreeItem, so that they are saved later
     const QList<QByteArray> autoSaveProperties(
         container->form()->library()->autoSaveProperties(w->metaObject()->className()) );
-    KFormDesigner::WidgetWithSubpropertiesInterface* subpropIface
-        = dynamic_cast<KFormDesigner::WidgetWithSubpropertiesInterface*>(w);
-    QWidget *subwidget = (subpropIface && subpropIface->subwidget()) ? subpropIface->subwidget() : w;
+    QWidget *subwidget = subwidgetOf(w);
     foreach (const QByteArray &propName, autoSaveProperties) {
         if (subwidget && -1 != subwidget->metaObject()->indexOfProperty(propName)) {
             item->addModifiedProperty(propName, subwidget->property(propName));
@@ -1198,19 +1295,146 @@ void FormIO::loadWidget(Container *container, const QDomElement &el, QWidget *pa
     }
 }
 
+//! Sets a new layout of @a type for container of @a item
+static void createLayout(ObjectTreeItem *item, Form::LayoutType type)
+{
+    item->container()->setLayoutType(type);
+    QLayout *layout;
+    if (type == Form::Grid) {
+        layout = new QGridLayout(item->widget());
+    } else if (type == Form::VBox) {
+        layout = new QVBoxLayout(item->widget());
+    } else {
+        layout = new QHBoxLayout(item->widget());
+    }
+    item->container()->setLayout(layout);
+}
+
+//! Sets subwidget's property @a name of @a item to @a value
+static void setSubproperty(ObjectTreeItem *item, const QString &name, const QVariant &value)
+{
+    //this is property for subwidget: remember it for delayed setting
+    //because now the subwidget could be not created yet (true e.g. for KexiDBAutoField)
+    item->addSubproperty(name.toLatin1(), value);
+    item->addModifiedProperty(name.toLatin1(), value);
+}
+
+//! Sets property @a name of layout of the container of @a item to @a value
+static void setLayoutProperty(ObjectTreeItem *item, const QString &name, const QVariant &value)
+{
+    // We load the margin of a Layout
+    if (name == "margin")  {
+        int margin = value.toInt();
+        item->container()->setLayoutMargin(margin);
+        item->container()->layout()->setMargin(margin);
+    }
+    // We load the spacing of a Layout
+    else if (name == "spacing")  {
+        int spacing = value.toInt();
+        item->container()->setLayoutSpacing(spacing);
+        item->container()->layout()->setSpacing(spacing);
+    }
+}
+
+//! Sets color of palette property @a name of widget @a w of @a item to @a value
+static void setPaletteProperty(ObjectTreeItem *item, QWidget *w, const QString &name,
+                               const QVariant &val)
+{
+    QPalette widgetPalette(w->palette());
+    if (!val.isNull())
+        widgetPalette.setColor(
+            name == "paletteBackgroundColor" ? w->backgroundRole() : w->foregroundRole(),
+            val.value<QColor>());
+    w->setPalette(widgetPalette);
+    if (name == "paletteBackgroundColor") {
+        w->setAutoFillBackground(val.value<QColor>().isValid());
+    }
+    item->addModifiedProperty(name.toLatin1(), val);
+}
+
+//! Sets normal property @a name of widget @a w of @a item to @a val.
+//! The property belongs to @a subwidget, which is @a w for widgets without subwidgets.
+static void setNormalProperty(ObjectTreeItem *item, QWidget *w, QWidget *subwidget,
+                              const QString &name, QVariant val)
+{
+    if (name == "geometry" && dynamic_cast<FormWidget*>(w)) {
+        //fix geometry if needed - this is top level form widget
+        QRect r(val.toRect());
+        if (r.left() < 0) //negative X!
+            r.moveLeft(0);
+        if (r.top() < 0) //negative Y!
+            r.moveTop(0);
+        val = r;
+    }
+    QByteArray realName;
+    if (name == QLatin1String("name")) {
+        realName = "objectName";
+    }
+    else {
+        realName = name.toLatin1();
+    }
+    subwidget->setProperty(realName, val);
+//    int count = w->metaObject()->findProperty(name, true);
+//    const QMetaProperty *meta = w->metaObject()->property(count, true);
+//    if(meta && meta->isEnumType()) {
+//     val = w->property(name.toLatin1()); //update: we want a numeric value of enum
+//    }
+    item->addModifiedProperty(realName, val);
+}
+
+//! Lets the factory handle element @a node of widget @a w of @a item,
+//! e.g. a special property; stores it as unknown property if it is not supported.
+static void readSpecialElement(ObjectTreeItem *item, Container *container, QWidget *w,
+                               QDomElement &node)
+{
+    if (w->metaObject()->className() == QString::fromLatin1("CustomWidget"))
+        item->storeUnknownProperty(node);
+    else {
+        bool read = container->form()->library()->readSpecialProperty(
+                        w->metaObject()->className(), node, w, item);
+        if (!read) // the factory doesn't support this property neither
+            item->storeUnknownProperty(node);
+    }
+}
+
+void FormIO::loadWidget(Container *container, const QDomElement &el, QWidget *parent,
+                        QHash<QString, QLabel*> *buddies)
+{
+    // We first look for the widget's name
+    const QString wname(widgetName(el));
+    ObjectTreeItem *item = container->form()->objectTree()->lookup(wname);
+    if (item) {
+        qWarning() << "Widget" << wname << "already exists! Skipping...";
+        return;
+    }
+
+    QWidget *w = createWidget(container, el.attribute("class").toLatin1(), wname, parent, &item);
+    if (!w)
+        return;
+
+    addToLayout(container, item, w, el.attribute("row").toInt(), el.attribute("column").toInt(),
+                el.attribute("rowspan").toInt(), el.attribute("colspan").toInt());
+
+    // Index of images for loadImage() unless a form is being loaded, e.g. when pasting
+    QHash<QString, ImageData> images;
+    const bool indexImages = !m_images;
+    if (indexImages) {
+        images = imagesByName(el.ownerDocument());
+        m_images = &images;
+    }
+    readChildNodes(item, container, el, w, buddies);
+    if (indexImages) {
+        m_images = nullptr;
+    }
+
+    finishWidget(container, item, w);
+}
+
 void
 FormIO::createToplevelWidget(Form *form, QWidget *container, QDomElement &el)
 {
     // We first look for the widget's name
-    QString wname;
-    for (QDomNode n = el.firstChild(); !n.isNull(); n = n.nextSibling()) {
-        if (    n.toElement().tagName() == "property"
-             && nameAttribute(n.toElement()) == "name" /* compat with 1.x */)
-        {
-            wname = n.toElement().text();
-            break;
-        }
-    }
+    const QString wname(widgetName(el));
     // And rename the widget and its ObjectTreeItem
     container->setObjectName(wname);
     if (form->objectTree())
@@ -1240,8 +1464,7 @@ void FormIO::readChildNodes(ObjectTreeItem *item, Container *container, const QD
 {
     QString eltag = el.tagName();
 
-    WidgetWithSubpropertiesInterface* subpropIface = dynamic_cast<WidgetWithSubpropertiesInterface*>(w);
-    QWidget *subwidget = (subpropIface && subpropIface->subwidget()) ? subpropIface->subwidget() : w;
+    QWidget *subwidget = subwidgetOf(w);
 
     for (QDomNode n = el.firstChild(); !n.isNull(); n = n.nextSibling()) {
         QString tag = n.toElement().tagName();
@@ -1252,24 +1475,14 @@ void FormIO::readChildNodes(ObjectTreeItem *item, Container *container, const QD
             const bool isQt3NameProperty = name == QLatin1String("name");
             //if(name == "geometry")
             // hasGeometryProp = true;
-            if (   (eltag == "grid" || eltag == "hbox" || eltag == "vbox")
-                && (isQt3NameProperty || name == "objectName")
-               )
-            {
+            if (isLayoutElement(eltag) && (isQt3NameProperty || name == "objectName")) {
                 // we don't care about layout names
                 continue;
             }
 
             if (node.attribute("subwidget") == "true") {
-                //this is property for subwidget: remember it for delayed setting
-                //because now the subwidget could be not created yet (true e.g. for KexiDBAutoField)
-                item->addSubproperty(name.toLatin1(),
-                                     readPropertyValue(container->form(), node.firstChild(), w, name));
-                const QVariant val(readPropertyValue(container->form(), node.firstChild(), w, name));
-                //qDebug() << val.toStringList();
-                item->addSubproperty(name.toLatin1(), val);
-                //subwidget->setProperty(name.toLatin1(), val);
-                item->addModifiedProperty(name.toLatin1(), val);
+                setSubproperty(item, name,
+                               readPropertyValue(container->form(), node.firstChild(), w, name));
                 continue;
             }
 
@@ -1281,73 +1494,22 @@ void FormIO::readChildNodes(ObjectTreeItem *item, Container *container, const QD
                                     qobject_cast<QLabel*>(w));
                 }
             }
-            else if (    (eltag == "grid" || eltag == "hbox" || eltag == "vbox")
-                      && item->container()
-                      && item->container()->layout() )
-            {
-                // We load the margin of a Layout
-                if (name == "margin")  {
-                    int margin = readPropertyValue(container->form(), node.firstChild(), w, name).toInt();
-                    item->container()->setLayoutMargin(margin);
-                    item->container()->layout()->setMargin(margin);
-                }
-                // We load the spacing of a Layout
-                else if (name == "spacing")  {
-                    int spacing = readPropertyValue(container->form(), node.firstChild(), w, name).toInt();
-                    item->container()->setLayoutSpacing(spacing);
-                    item->container()->layout()->setSpacing(spacing);
-                }
+            else if (isLayoutElement(eltag) && item->container() && item->container()->layout()) {
+                setLayoutProperty(item, name,
+                                  readPropertyValue(container->form(), node.firstChild(), w, name));
             }
             else if (name == "paletteBackgroundColor" || name == "paletteForegroundColor") {
-                QPalette widgetPalette(w->palette());
-                QVariant val(readPropertyValue(container->form(), node.firstChild(), w, name));
-                if (!val.isNull())
-                    widgetPalette.setColor(
-                        name == "paletteBackgroundColor" ? w->backgroundRole() : w->foregroundRole(),
-                        val.value<QColor>());
-                w->setPalette(widgetPalette);
-                if (name == "paletteBackgroundColor") {
-                    w->setAutoFillBackground(val.value<QColor>().isValid());
-                }
-                item->addModifiedProperty(name.toLatin1(), val);
+                setPaletteProperty(item, w, name,
+                                   readPropertyValue(container->form(), node.firstChild(), w, name));
             }
             else if (!isQt3NameProperty && -1 == subwidget->metaObject()->indexOfProperty(name.toLatin1()))
             {
                 // If the object doesn't have this property, we let the Factory handle it (maybe a special property)
-                if (w->metaObject()->className() == QString::fromLatin1("CustomWidget"))
-                    item->storeUnknownProperty(node);
-                else {
-                    bool read = container->form()->library()->readSpecialProperty(
-                                    w->metaObject()->className(), node, w, item);
-                    if (!read) // the factory doesn't support this property neither
-                        item->storeUnknownProperty(node);
-                }
+                readSpecialElement(item, container, w, node);
             }
             else { // we have a normal property, let's load it
-                QVariant val(readPropertyValue(container->form(), node.firstChild(), w, name));
-                if (name == "geometry" && dynamic_cast<FormWidget*>(w)) {
-                    //fix geometry if needed - this is top level form widget
-                    QRect r(val.toRect());
-                    if (r.left() < 0) //negative X!
-                        r.moveLeft(0);
-                    if (r.top() < 0) //negative Y!
-                        r.moveTop(0);
-                    val = r;
-                }
-                QByteArray realName;
-                if (isQt3NameProperty) {
-                    realName = "objectName";
-                }
-                else {
-                    realName = name.toLatin1();
-                }
-                subwidget->setProperty(realName, val);
-//    int count = w->metaObject()->findProperty(name, true);
-//    const QMetaProperty *meta = w->metaObject()->property(count, true);
-//    if(meta && meta->isEnumType()) {
-//     val = w->property(name.toLatin1()); //update: we want a numeric value of enum
-//    }
-                item->addModifiedProperty(realName, val);
+                setNormalProperty(item, w, subwidget, name,
+                            readPropertyValue(container->form(), node.firstChild(), w, name));
             }
         }
         else if (tag == "widget") { // a child widget
@@ -1374,30 +1536,498 @@ void FormIO::readChildNodes(ObjectTreeItem *item, Container *container, const QD
             if (layoutName == "HFlow") {
             } else if (layoutName == "VFlow") {
             } else { // grid layout
-                item->container()->setLayoutType(Form::Grid);
-                QGridLayout *layout = new QGridLayout(item->widget());
-                item->container()->setLayout(static_cast<QLayout*>(layout));
+                createLayout(item, Form::Grid);
             }
             readChildNodes(item, container, node, w, buddies);
         } else if (tag == "vbox")  {
-            item->container()->setLayoutType(Form::VBox);
-            QVBoxLayout *layout = new QVBoxLayout(item->widget());
-            item->container()->setLayout(static_cast<QLayout*>(layout));
+            createLayout(item, Form::VBox);
             readChildNodes(item, container, node, w, buddies);
         } else if (tag == "hbox") {
-            item->container()->setLayoutType(Form::HBox);
-            QHBoxLayout *layout = new QHBoxLayout(item->widget());
-            item->container()->setLayout(static_cast<QLayout*>(layout));
+            createLayout(item, Form::HBox);
             readChildNodes(item, container, node, w, buddies);
         } else {// unknown tag, we let the Factory handle it
-            if (w->metaObject()->className() == QString::fromLatin1("CustomWidget"))
-                item->storeUnknownProperty(node);
-            else {
-                bool read = container->form()->library()->readSpecialProperty(
-                                w->metaObject()->className(), node, w, item);
-                if (!read) // the factory doesn't suport this property neither
-                    item->storeUnknownProperty(node);
+            readSpecialElement(item, container, w, node);
+        }
+    }
+}
+
+/////////////////////////////////////////////////////////////////////////////
+///////////// Single pass loading of forms //////////////////////////////////
+/////////////////////////////////////////////////////////////////////////////
+
+FormIO::StreamLoader::StreamLoader(Form *form, QWidget *container, QXmlStreamReader *xml)
+    : m_form(form)
+    , m_container(container)
+    , m_xml(xml)
+{
+    // the "kfd" prefix of custom header is not declared
+    m_xml->setNamespaceProcessing(false);
+}
+
+bool FormIO::StreamLoader::load()
+{
+    // images are looked up in m_images also by widgets loaded from DOM fragments
+    QHash<QString, ImageData> *const images = FormIO::m_images;
+    FormIO::m_images = &m_images;
+    const bool ok = loadInternal();
+    FormIO::m_images = images;
+    return ok;
+}
+
+bool FormIO::StreamLoader::loadInternal()
+{
+    m_form->headerProperties()->clear();
+    m_form->setInteractiveMode(false);
+    if (m_xml->readNextStartElement()) {
+        if (m_xml->qualifiedName() == QLatin1String("UI")) {
+            while (m_xml->readNextStartElement()) {
+                const QString tag(m_xml->qualifiedName().toString());
+                if (tag == "kfd:customHeader" && !m_headerRead) {
+                    //custom properties
+                    m_headerRead = true;
+                    foreach (const QXmlStreamAttribute &attr, m_xml->attributes()) {
+                        m_form->headerProperties()->insert(attr.qualifiedName().toLatin1(),
+                                                           attr.value().toString());
+                    }
+                    m_xml->skipCurrentElement();
+                } else if (tag == "pixmapinproject") {
+                    m_pixmapInProject = true;
+                    m_xml->skipCurrentElement();
+                } else if (tag == "widget" && !m_toplevelWidgetRead) {
+                    readToplevelWidget();
+                } else if (tag == "tabstops" && !m_tabStopsRead) {
+                    readTabStops();
+                } else if (tag == "images" && !m_imagesRead) {
+                    readImages();
+                }
+//! @todo pixmapcollection
+#ifdef KEXI_PIXMAP_COLLECTIONS_SUPPORT
+                else if (tag == "collection") {
+                    m_form->pixmapCollection()->load(readElementAsDom());
+                }
+#endif
+#ifdef KFD_SIGSLOTS
+                else if (tag == "connections" && m_connections.isNull()) {
+                    m_connections = readElementAsDom();
+                }
+#endif
+                else {
+                    m_xml->skipCurrentElement();
+                }
             }
+        } else {
+            m_xml->skipCurrentElement();
+        }
+    }
+    if (m_xml->hasError()) {
+        qWarning() << m_xml->errorString();
+        qWarning() << "line:" << m_xml->lineNumber() << "col:" << m_xml->columnNumber();
+        deleteCreatedWidgets();
+        m_form->setInteractiveMode(true);
+        return false;
+    }
+    finish();
+    return true;
+}
+
+void FormIO::StreamLoader::deleteCreatedWidgets()
+{
+    ObjectTree *tree = m_form->objectTree();
+    if (!tree) {
+        return;
+    }
+    const ObjectTreeList children(*tree->children());
+    foreach (ObjectTreeItem *item, children) {
+        QWidget *w = item->widget();
+        tree->removeItem(item); // child items are removed too
+        delete w;
+    }
+    m_form->tabStops()->clear();
+    m_buddies.clear();
+    m_pixmaps.clear();
+}
+
+void FormIO::StreamLoader::queueDomPixmaps(ObjectTreeItem *item, const QDomElement &el)
+{
+    QWidget *w = item ? item->widget() : nullptr;
+    if (!w) {
+        return;
+    }
+    for (QDomElement node = el.firstChildElement(); !node.isNull();
+         node = node.nextSiblingElement())
+    {
+        const QString tag(node.tagName());
+        if (tag == "property") {
+            const QString name(node.attribute("name"));
+            const QDomElement value(node.firstChildElement());
+            if (   value.tagName() == "pixmap" && node.attribute("subwidget") != "true"
+                && -1 != subwidgetOf(w)->metaObject()->indexOfProperty(name.toLatin1()))
+            {
+//! @todo pixmapcollection
+                const PendingPixmap pixmap = { item, w, name, value.text() };
+                m_pixmaps.append(pixmap);
+            }
+        }
+        else if (tag == "widget" || tag == "spacer") {
+            queueDomPixmaps(m_form->objectTree()->lookup(widgetName(node)), node);
+        }
+        else if (tag == "grid" || tag == "vbox" || tag == "hbox") {
+            queueDomPixmaps(item, node);
+        }
+    }
+}
+
+void FormIO::StreamLoader::finish()
+{
+    //update format version information
+    updateFormatVersion(m_form);
+    m_form->setPixmapsStoredInline(!m_pixmapInProject || m_imagesRead);
+
+    foreach (const PendingPixmap &pixmap, m_pixmaps) {
+        const QHash<QString, ImageData>::Iterator it(m_images.find(pixmap.imageName));
+        const QPixmap pix(it == m_images.end() ? QPixmap() : it->pixmap());
+        setNormalProperty(pixmap.item, pixmap.widget, subwidgetOf(pixmap.widget), pixmap.name, pix);
+    }
+
+    // Now the Form is fully loaded, we can assign the buddies
+    for (QHash<QString, QLabel*>::ConstIterator it(m_buddies.constBegin());
+        it!=m_buddies.constEnd(); ++it)
+    {
+        ObjectTreeItem *item = m_form->objectTree()->lookup(it.key());
+        if (!item || !item->widget()) {
+            qDebug() << "Cannot assign buddy for widget"
+                     << it.value()->objectName() << "to" << it.key();
+            continue;
+        }
+        it.value()->setBuddy(item->widget());
+    }
+    m_form->setInteractiveMode(true);
+
+    // Loading the tabstops
+    int itemsNotFound = 0;
+    for (int i = 0; i < m_tabStops.count(); ++i) {
+        const QString name(m_tabStops.at(i));
+        ObjectTreeItem *item = m_form->objectTree()->lookup(name);
+        if (!item) {
+            qWarning() << "Tabstops loading: no item" << name;
+            continue;
+        }
+        const int index = m_form->tabStops()->indexOf(item);
+        /* Compute a real destination index: "a number of not found items so far". */
+        const int realIndex = i - itemsNotFound;
+        if ((index != -1) && (index != realIndex)) { // the widget is not in the same place, so we move it
+            m_form->tabStops()->removeOne(item);
+            m_form->tabStops()->insert(realIndex, item);
+        }
+        if (index == -1) {
+            itemsNotFound++;
+            qDebug() << "Tabstops loading: item" << name << "not on the list";
+        }
+    }
+
+#ifdef KFD_SIGSLOTS
+    // Load the form connections
+    m_form->connectionBuffer()->load(m_connections);
+#endif
+}
+
+bool FormIO::StreamLoader::isNameProperty() const
+{
+    if (m_xml->qualifiedName() != QLatin1String("property")) {
+        return false;
+    }
+    const QXmlStreamAttributes attributes(m_xml->attributes());
+    return attributes.value("name") == QLatin1String("name")
+        && attributes.value("subwidget") != QLatin1String("true");
+}
+
+void FormIO::StreamLoader::readToplevelWidget()
+{
+    m_toplevelWidgetRead = true;
+    const QString tagName(m_xml->qualifiedName().toString());
+    const QXmlStreamAttributes attributes(m_xml->attributes());
+    const bool childStarted = m_xml->readNextStartElement();
+    if (!childStarted || !isNameProperty()) {
+        // The name is not known before child nodes are read, use the DOM.
+        // Pixmaps are set in finish() as images are not read yet.
+        QDomElement el(readRestAsDom(tagName, attributes, childStarted));
+        FormIO::createToplevelWidget(m_form, m_container, el);
+        m_form->setInteractiveMode(false);
+        queueDomPixmaps(m_form->objectTree(), el);
+        return;
+    }
+    const PropertyValueElement nameValue(readPropertyValue());
+    const QString wname(nameValue.text);
+    // And rename the widget and its ObjectTreeItem
+    m_container->setObjectName(wname);
+    if (m_form->objectTree())
+        m_form->objectTree()->rename(m_form->objectTree()->name(), wname);
+
+    ObjectTreeItem *item = m_form->objectTree();
+    setNormalProperty(item, m_container, subwidgetOf(m_container), "name",
+                propertyValue(nameValue, m_container, "name"));
+    readChildNodes(item, m_form->toplevelContainer(), m_container, tagName);
+}
+
+void FormIO::StreamLoader::readWidget(Container *container, QWidget *parent)
+{
+    const QString tagName(m_xml->qualifiedName().toString());
+    const QXmlStreamAttributes attributes(m_xml->attributes());
+    const bool childStarted = m_xml->readNextStartElement();
+    if (!childStarted || !isNameProperty()) {
+        // The name is needed to create the widget but it is not the first child, use the DOM.
+        // Pixmaps are set in finish() as images are not read yet.
+        const QDomElement el(readRestAsDom(tagName, attributes, childStarted));
+        const bool exists = container->form()->objectTree()->lookup(widgetName(el));
+        FormIO::loadWidget(container, el, parent, &m_buddies);
+        if (!exists) {
+            queueDomPixmaps(container->form()->objectTree()->lookup(widgetName(el)), el);
+        }
+        return;
+    }
+    const PropertyValueElement nameValue(readPropertyValue());
+    const QString wname(nameValue.text);
+    ObjectTreeItem *item = container->form()->objectTree()->lookup(wname);
+    if (item) {
+        qWarning() << "Widget" << wname << "already exists! Skipping...";
+        m_xml->skipCurrentElement();
+        return;
+    }
+
+    QWidget *w = createWidget(container, attributes.value("class").toLatin1(), wname, parent, &item);
+    if (!w) {
+        m_xml->skipCurrentElement();
+        return;
+    }
+
+    addToLayout(container, item, w, attributes.value("row").toInt(),
+                attributes.value("column").toInt(), attributes.value("rowspan").toInt(),
+                attributes.value("colspan").toInt());
+
+    setNormalProperty(item, w, subwidgetOf(w), "name", propertyValue(nameValue, w, "name"));
+    readChildNodes(item, container, w, tagName);
+
+    finishWidget(container, item, w);
+}
+
+void FormIO::StreamLoader::readChildNodes(ObjectTreeItem *item, Container *container, QWidget *w,
+                                          const QString &eltag)
+{
+    while (m_xml->readNextStartElement()) {
+        readChildNode(item, container, w, eltag);
+    }
+}
+
+void FormIO::StreamLoader::readChildNode(ObjectTreeItem *item, Container *container, QWidget *w,
+                                         const QString &eltag)
+{
+    const QString tag(m_xml->qualifiedName().toString());
+    if ((tag == "property") || (tag == "attribute")) {
+        readProperty(item, container, w, eltag);
+    }
+    else if (tag == "widget") { // a child widget
+        if (item->container()) // we are a Container
+            readWidget(item->container(), nullptr);
+        else
+            readWidget(container, w);
+    }
+    else if (tag == "spacer")  {
+        readWidget(container, w);
+    }
+    else if (tag == "grid") {
+        readGrid(item, container, w, eltag);
+    } else if (tag == "vbox")  {
+        createLayout(item, Form::VBox);
+        readChildNodes(item, container, w, tag);
+    } else if (tag == "hbox") {
+        createLayout(item, Form::HBox);
+        readChildNodes(item, container, w, tag);
+    } else {// unknown tag, we let the Factory handle it
+        QDomElement node(readElementAsDom());
+        readSpecialElement(item, container, w, node);
+    }
+}
+
+void FormIO::StreamLoader::readGrid(ObjectTreeItem *item, Container *container, QWidget *w,
+                                    const QString &eltag)
+{
+    const QXmlStreamAttributes attributes(m_xml->attributes());
+    const bool childStarted = m_xml->readNextStartElement();
+    if (   childStarted && m_xml->qualifiedName() == QLatin1String("property")
+        && m_xml->attributes().value("name") == QLatin1String("customLayout"))
+    {
+        // Flow layouts are never saved by FormIO, let the DOM-based code handle them
+        QDomElement parentEl(m_fragments.createElement(eltag));
+        parentEl.appendChild(readRestAsDom("grid", attributes, true));
+        FormIO::readChildNodes(item, container, parentEl, w, &m_buddies);
+        queueDomPixmaps(item, parentEl);
+        return;
+    }
+    createLayout(item, Form::Grid);
+    if (childStarted) {
+        readChildNode(item, container, w, "grid");
+        readChildNodes(item, container, w, "grid");
+    }
+}
+
+void FormIO::StreamLoader::readProperty(ObjectTreeItem *item, Container *container, QWidget *w,
+                                        const QString &eltag)
+{
+    const QXmlStreamAttributes attributes(m_xml->attributes());
+    const QString name(attributes.value("name").toString());
+    const bool isQt3NameProperty = name == QLatin1String("name");
+    if (isLayoutElement(eltag) && (isQt3NameProperty || name == "objectName")) {
+        // we don't care about layout names
+        m_xml->skipCurrentElement();
+        return;
+    }
+
+    if (attributes.value("subwidget") == QLatin1String("true")) {
+        setSubproperty(item, name, propertyValue(readPropertyValue(), w, name));
+        return;
+    }
+
+    // We cannot assign the buddy now as the buddy widget may not be created yet
+    if (name == "buddy") {
+        const QString buddy(propertyValue(readPropertyValue(), w, name).toString());
+        if (qobject_cast<QLabel*>(w)) {
+            m_buddies.insert(buddy, qobject_cast<QLabel*>(w));
+        }
+    }
+    else if (isLayoutElement(eltag) && item->container() && item->container()->layout()) {
+        setLayoutProperty(item, name, propertyValue(readPropertyValue(), w, name));
+    }
+    else if (name == "paletteBackgroundColor" || name == "paletteForegroundColor") {
+        setPaletteProperty(item, w, name, propertyValue(readPropertyValue(), w, name));
+    }
+    else {
+        QWidget *subwidget = subwidgetOf(w);
+        if (!isQt3NameProperty && -1 == subwidget->metaObject()->indexOfProperty(name.toLatin1())) {
+            // If the object doesn't have this property, we let the Factory handle it (maybe a special property)
+            QDomElement node(readElementAsDom());
+            readSpecialElement(item, container, w, node);
+            return;
+        }
+        // we have a normal property, let's load it
+        const PropertyValueElement value(readPropertyValue());
+        if (value.type == QLatin1String("pixmap")) {
+//! @todo pixmapcollection
+            const PendingPixmap pixmap = { item, w, name, value.text };
+            m_pixmaps.append(pixmap);
+        } else {
+            setNormalProperty(item, w, subwidget, name, propertyValue(value, w, name));
+        }
+    }
+}
+
+PropertyValueElement FormIO::StreamLoader::readPropertyValue()
+{
+    PropertyValueElement value;
+    if (!m_xml->readNextStartElement()) { // no value
+        return value;
+    }
+    value.type = m_xml->qualifiedName().toString();
+    while (!m_xml->atEnd()) {
+        m_xml->readNext();
+        if (m_xml->isEndElement()) {
+            break;
+        }
+        if (m_xml->isStartElement()) {
+            const QString field(m_xml->qualifiedName().toString());
+            const QString fieldText(m_xml->readElementText(QXmlStreamReader::IncludeChildElements));
+            value.text += fieldText;
+            if (!value.fields.contains(field)) {
+                value.fields.insert(field, fieldText);
+            }
+        } else if (m_xml->isCharacters() && !m_xml->isWhitespace()) {
+            value.text += m_xml->text();
+        }
+    }
+    m_xml->skipCurrentElement(); // the rest of "property"
+    return value;
+}
+
+void FormIO::StreamLoader::readImages()
+{
+    m_imagesRead = true;
+    while (m_xml->readNextStartElement()) {
+        if (m_xml->qualifiedName() != QLatin1String("image")) {
+            m_xml->skipCurrentElement();
+            continue;
+        }
+        const QString name(m_xml->attributes().value("name").toString());
+        while (m_xml->readNextStartElement()) {
+            if (m_xml->qualifiedName() != QLatin1String("data") || m_images.contains(name)) {
+                m_xml->skipCurrentElement();
+                continue;
+            }
+            const QXmlStreamAttributes attributes(m_xml->attributes());
+            ImageData image;
+            image.format = attributes.hasAttribute("format")
+                ? attributes.value("format").toString() : QString::fromLatin1("PNG");
+            image.encoding = attributes.value("encoding").toString();
+            image.length = attributes.value("length").toInt();
+            image.data = m_xml->readElementText(QXmlStreamReader::IncludeChildElements).toLatin1();
+            m_images.insert(name, image);
+        }
+    }
+}
+
+void FormIO::StreamLoader::readTabStops()
+{
+    m_tabStopsRead = true;
+    while (m_xml->readNextStartElement()) {
+        m_tabStops.append(m_xml->readElementText(QXmlStreamReader::IncludeChildElements));
+    }
+}
+
+QDomElement FormIO::StreamLoader::createDomElement(const QString &tagName,
+                                                   const QXmlStreamAttributes &attributes)
+{
+    QDomElement el(m_fragments.createElement(tagName));
+    foreach (const QXmlStreamAttribute &attr, attributes) {
+        el.setAttribute(attr.qualifiedName().toString(), attr.value().toString());
+    }
+    return el;
+}
+
+QDomElement FormIO::StreamLoader::readElementAsDom()
+{
+    QDomElement el(createDomElement(m_xml->qualifiedName().toString(), m_xml->attributes()));
+    readDomChildren(&el);
+    return el;
+}
+
+QDomElement FormIO::StreamLoader::readRestAsDom(const QString &tagName,
+                                                const QXmlStreamAttributes &attributes,
+                                                bool childStarted)
+{
+    QDomElement el(createDomElement(tagName, attributes));
+    if (childStarted) {
+        el.appendChild(readElementAsDom());
+        readDomChildren(&el);
+    }
+    return el;
+}
+
+void FormIO::StreamLoader::readDomChildren(QDomElement *el)
+{
+    while (!m_xml->atEnd()) {
+        switch (m_xml->readNext()) {
+        case QXmlStreamReader::StartElement:
+            el->appendChild(readElementAsDom());
+            break;
+        case QXmlStreamReader::EndElement:
+            return;
+        case QXmlStreamReader::Characters:
+            if (m_xml->isCDATA()) {
+                el->appendChild(m_fragments.createCDATASection(m_xml->text().toString()));
+            } else if (!m_xml->isWhitespace()) {
+                el->appendChild(m_fragments.createTextNode(m_xml->text().toString()));
+            }
+            break;
+        default:
+            break;
         }
     }
 }
@@ -1436,41 +2066,38 @@ FormIO::addIncludeFileName(const QString &include, QDomDocument &domDoc)
 QString
 FormIO::saveImage(QDomDocument &domDoc, const QPixmap &pixmap)
 {
-    QDomElement images = domDoc.firstChildElement("images");
+    QDomElement ui = domDoc.firstChildElement("UI");
+    QDomElement images = ui.firstChildElement("images");
     if (images.isNull()) {
         images = domDoc.createElement("images");
-        QDomElement ui = domDoc.firstChildElement("UI");
         ui.appendChild(images);
     }
 
-    int count = images.childNodes().count();
-    QDomElement image = domDoc.createElement("image");
-    QString name = "image" + QString::number(count);
-    image.setAttribute("name", name);
-
-    const QImage img(pixmap.toImage());
     QByteArray ba;
     QBuffer buf(&ba);
-    buf.open(QIODevice::WriteOnly | QIODevice::Text);
-    const QByteArray format(img.depth() > 1 ? "XPM" : "XBM");
-    QImageWriter imageWriter(&buf, format);
-    imageWriter.write(img);
+    buf.open(QIODevice::WriteOnly);
+    pixmap.save(&buf, "PNG");
     buf.close();
-    const QByteArray bazip = qCompress(ba);
-    const int len = bazip.size();
-
-    QDomElement data = domDoc.createElement("data");
-    data.setAttribute("format", QString(format + ".GZ"));
-    data.setAttribute("length", ba.size());
+    const QString content(QString::fromLatin1(ba.toBase64()));
 
-    static const char hexchars[] = "0123456789abcdef";
-    QString content;
-    for (int i = 4; i < len; i++) {
-        uchar s = (uchar) bazip[i];
-        content += hexchars[s >> 4];
-        content += hexchars[s & 0x0f];
+    // the same pixmap is often used by many widgets, save it once
+    int count = 0;
+    for (QDomElement image = images.firstChildElement("image"); !image.isNull();
+         image = image.nextSiblingElement("image"), ++count)
+    {
+        if (image.firstChildElement("data").text() == content) {
+            return image.attribute("name");
+        }
     }
 
+    QDomElement image = domDoc.createElement("image");
+    const QString name = "image" + QString::number(count);
+    image.setAttribute("name", name);
+
+    QDomElement data = domDoc.createElement("data");
+    data.setAttribute("format", "PNG");
+    data.setAttribute("encoding", "base64");
+    data.setAttribute("length", ba.size());
     data.appendChild(domDoc.createTextNode(content));
     image.appendChild(data);
     images.appendChild(image);
@@ -1478,62 +2105,42 @@ FormIO::saveImage(QDomDocument &domDoc, const QPixmap &pixmap)
     return name;
 }
 
-QPixmap
-FormIO::loadImage(QDomDocument domDoc, const QString& name)
+FormIO::ImageData FormIO::imageData(const QDomElement &dataEl)
 {
-    QDomElement images = domDoc.firstChildElement("UI").firstChildElement("images");
-    if (images.isNull())
-        return QPixmap();
+    ImageData image;
+    image.format = dataEl.attribute("format", "PNG");
+    image.encoding = dataEl.attribute("encoding");
+    image.length = dataEl.attribute("length").toInt();
+    image.data = dataEl.text().toLatin1();
+    return image;
+}
 
-    QDomElement image;
-    for (QDomNode n = images.firstChild(); !n.isNull(); n = n.nextSibling()) {
-        if ((n.toElement().tagName() == "image") && (n.toElement().attribute("name") == name)) {
-            image = n.toElement();
-            break;
+QHash<QString, FormIO::ImageData> FormIO::imagesByName(const QDomDocument &domDoc)
+{
+    QHash<QString, ImageData> images;
+    const QDomElement imagesEl(domDoc.firstChildElement("UI").firstChildElement("images"));
+    for (QDomElement image = imagesEl.firstChildElement("image"); !image.isNull();
+         image = image.nextSiblingElement("image"))
+    {
+        const QString name(image.attribute("name"));
+        const QDomElement dataEl(image.firstChildElement("data"));
+        if (!dataEl.isNull() && !images.contains(name)) {
+            images.insert(name, imageData(dataEl));
         }
     }
+    return images;
+}
 
-    QPixmap pix;
-    QString data(image.firstChildElement("data").text());
-    const int lengthOffset = 4;
-    int baSize = data.length() / 2 + lengthOffset;
-    uchar *ba = new uchar[baSize];
-    for (int i = lengthOffset; i < baSize; ++i) {
-        char h = data[2 * (i-lengthOffset)].toLatin1();
-        char l = data[2 * (i-lengthOffset) + 1].toLatin1();
-        uchar r = 0;
-        if (h <= '9')
-            r += h - '0';
-        else
-            r += h - 'a' + 10;
-        r = r << 4;
-        if (l <= '9')
-            r += l - '0';
-        else
-            r += l - 'a' + 10;
-        ba[i] = r;
-    }
-
-    QString format = image.firstChildElement("data").attribute("format", "PNG");
-    if ((format == "XPM.GZ") || (format == "XBM.GZ")) {
-        int len = image.attribute("length").toInt();
-        if (len < data.length() * 5)
-            len = data.length() * 5;
-        // qUncompress() expects the first 4 bytes to be the expected length of
-        // the uncompressed data
-        ba[0] = (len & 0xff000000) >> 24;
-        ba[1] = (len & 0x00ff0000) >> 16;
-        ba[2] = (len & 0x0000ff00) >> 8;
-        ba[3] = (len & 0x000000ff);
-        QByteArray baunzip = qUncompress(ba, baSize);
-        KexiUtils::loadPixmapFromData(&pix, baunzip, format.left(format.indexOf('.')).toLatin1());
-    } else {
-        QByteArray b(QByteArray::fromRawData((const char*)ba + lengthOffset, baSize - lengthOffset));
-        KexiUtils::loadPixmapFromData(&pix, b, format.toLatin1());
+QPixmap
+FormIO::loadImage(QDomDocument domDoc, const QString& name)
+{
+    if (m_images) {
+        const QHash<QString, ImageData>::Iterator it(m_images->find(name));
+        return it == m_images->end() ? QPixmap() : it->pixmap();
     }
-
-    delete[] ba;
-
-    return pix;
+    const QDomElement image(imageElement(domDoc.firstChildElement("UI"), name));
+    const QDomElement dataEl(image.firstChildElement("data"));
+    if (dataEl.isNull())
+        return QPixmap();
+    return imageData(dataEl).pixmap();
 }
-
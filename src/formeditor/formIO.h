@@ -107,22 +107,28 @@ public:
     static bool saveFormToByteArray(Form *form, QByteArray &dest);
 
     /*! Loads a form from the \a domDoc QDomDocument. Called by loadForm() and loadFormData().
+        The document is serialized and loaded like by loadFormFromByteArray().
         \return true if loading succeeded. */
     static bool loadFormFromDom(Form *form, QWidget *container, const QDomDocument &domDoc);
 
     /*! Loads a form from the \a src QByteArray.
+        The .ui data is read in a single pass using QXmlStreamReader, widgets are created
+        while reading without building a DOM tree. If the data is not well-formed, the widgets
+        read before the error are deleted and false is returned.
         \sa loadFormFromDom(), loadForm().
         \return true if loading succeeded.
      */
     static bool loadFormFromByteArray(Form *form, QWidget *container, QByteArray &src,
                                       bool preview = false);
 
+    /*! Loads a form from the \a src string like loadFormFromByteArray() does.
+        \return true if loading succeeded. */
     static bool loadFormFromString(Form *form, QWidget *container, const QString &src,
                                    bool preview = false);
 
     /*! Loads the .ui file \a filename in the Form \a form. If \a filename is null or not given,
         a Open File dialog will be shown to select the file to open.
-        createToplevelWidget() is used to load the Form's toplevel widget.
+        The file is read like by loadFormFromByteArray().
         \return true if loading succeeded.
         \todo Add errors code and error dialog
     */
@@ -189,19 +195,21 @@ protected:
     /*! Creates a toplevel widget from the QDomElement \a element in the Form \a form,
      with \a parent as parent widget.
      It calls readPropertyValue() and loadWidget() to load child widgets.
+     Used only for toplevel widgets not starting with their name, see loadFormFromByteArray().
     */
     static void createToplevelWidget(Form *form, QWidget *container, QDomElement &element);
 
     /*! \return the name of the pixmap saved, to use to access it
         This function save the QPixmap \a pixmap into the DOM document \a domDoc.
-        The pixmap is converted to XPM and compressed for compatibility with Qt Designer.
-        Encoding code is taken from Designer.
+        The pixmap is saved in PNG format as base64-encoded contents of an "image" element
+        of the "images" section. Equal pixmaps are saved once.
     */
     static QString saveImage(QDomDocument &domDoc, const QPixmap &pixmap);
 
     /*! \return the loaded pixmap
         This function loads the pixmap named \a name in the DOM document \a domDoc.
-        Decoding code is taken from QT Designer.
+        Images saved by older versions as hex-encoded compressed XPM/XBM
+        are supported too; they are saved in the current format when the form is saved.
     */
     //! @todo handle result of loading
     static QPixmap loadImage(QDomDocument domDoc, const QString& name);
@@ -216,8 +224,24 @@ protected:
     static void addIncludeFileName(const QString &include, QDomDocument &domDoc);
 
 private:
+    //! Loads forms using QXmlStreamReader, used by loadFormFromByteArray() and similar methods.
+    class StreamLoader;
+
     //! This hash stores buddies associations until the Form is completely loaded.
     static QHash<QString, QLabel*> *m_buddies;
+
+    //! Contents of an image of the "images" section, decoded on first use
+    struct ImageData;
+
+    //! @return contents of the "data" element @a dataEl of an image
+    static ImageData imageData(const QDomElement &dataEl);
+
+    //! @return images of the "images" section of @a domDoc by name
+    static QHash<QString, ImageData> imagesByName(const QDomDocument &domDoc);
+
+    /*! This hash stores images by name while a Form or widget is being loaded,
+     so loadImage() finds and decodes each image once. */
+    static QHash<QString, ImageData> *m_images;
 };
 
 }
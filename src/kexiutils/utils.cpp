@@ -861,6 +861,16 @@ void KexiUtils::addDirtyFlag(QString *text)
     *text = xi18nc("'Dirty (modified) object' flag", "%1*", *text);
 }
 
+bool KexiUtils::hasNonAsciiCasedLetters(const QString &text)
+{
+    for (const QChar &c : text) {
+        if (c.unicode() > 127 && c.toLower() != c.toUpper()) {
+            return true;
+        }
+    }
+    return false;
+}
+
 //! From klocale_kde.cpp
 //! @todo KEXI3 support other OS-es (use from klocale_*.cpp)
 static QByteArray systemCodeset()
@@ -556,6 +556,10 @@ KEXIUTILS_EXPORT QSize comboBoxArrowSize(QStyle *style = 0);
 //! It is usually "*" character appended.
 KEXIUTILS_EXPORT void addDirtyFlag(QString *text);
 
+//! @return true if @a text has a letter that changes case not only in the ASCII range.
+//! LOWER() and UPPER() SQL functions of some databases do not convert such letters.
+KEXIUTILS_EXPORT bool hasNonAsciiCasedLetters(const QString &text);
+
 //! @return The name of the user's preferred encoding
 //! Based on KLocale::encoding()
 KEXIUTILS_EXPORT QByteArray encoding();
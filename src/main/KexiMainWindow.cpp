@@ -4268,6 +4268,7 @@ void KexiMainWindow::slotEditFind(bool next)
         return;
     tristate res = iface->find(
                        d->findDialog()->valueToFind(), d->findDialog()->options(), next);
+    d->findDialog()->finishProgress();
     if (~res)
         return;
     d->findDialog()->updateMessage(true == res);
@@ -4306,11 +4307,10 @@ void KexiMainWindow::slotEditReplace(bool all)
     KexiSearchAndReplaceViewInterface* iface = d->currentViewSupportingSearchAndReplaceInterface();
     if (!iface)
         return;
-//! @todo add question: "Do you want to replace every occurrence of \"%1\" with \"%2\"?
-//!       You won't be able to undo this." + "Do not ask again".
     tristate res = iface->findNextAndReplace(
                        d->findDialog()->valueToFind(), d->findDialog()->valueToReplaceWith(),
                        d->findDialog()->options(), all);
+    d->findDialog()->finishProgress();
     d->findDialog()->updateMessage(true == res);
 //! @todo result
 }
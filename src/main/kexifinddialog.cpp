@@ -37,14 +37,17 @@
 #include <QAction>
 #include <QDesktopWidget>
 #include <QKeyEvent>
+#include <QApplication>
 
 #include <kexi_global.h>
 
 //! @internal
-class Q_DECL_HIDDEN KexiFindDialog::Private
+class Q_DECL_HIDDEN KexiFindDialog::Private : public QObject,
+                                             public KexiSearchAndReplaceViewInterface::Options::ProgressHandler
 {
 public:
-    Private() :
+    explicit Private(KexiFindDialog *dialog) :
+        q(dialog),
         confGroup(KSharedConfig::openConfig()->group("FindDialog"))
     {
     }
@@ -52,6 +55,50 @@ public:
         qDeleteAll(shortcuts);
         shortcuts.clear();
     }
+
+    //! Shows progress of searching, buttons are disabled until finishProgress() is called.
+    bool updateProgress(int percent) override {
+        if (!searching) {
+            searching = true;
+            buttonsEnabled = q->m_btnFind->isEnabled();
+            q->m_btnFind->setEnabled(false);
+            q->m_btnReplace->setEnabled(false);
+            q->m_btnReplaceAll->setEnabled(false);
+            qApp->installEventFilter(this);
+        }
+        q->setMessage(xi18nc("@info", "Searching... %1% (press Esc to stop)", percent));
+        QCoreApplication::processEvents();
+        return !cancelRequested;
+    }
+
+    //! Blocks user input outside of the dialog while searching because it could modify
+    //! the data being searched. Esc key stops searching.
+    bool eventFilter(QObject *watched, QEvent *e) override {
+        switch (e->type()) {
+        case QEvent::KeyPress:
+            if (static_cast<QKeyEvent*>(e)->key() == Qt::Key_Escape) {
+                cancelRequested = true;
+                return true;
+            }
+            Q_FALLTHROUGH();
+        case QEvent::KeyRelease:
+        case QEvent::ShortcutOverride:
+        case QEvent::Shortcut:
+        case QEvent::MouseButtonPress:
+        case QEvent::MouseButtonRelease:
+        case QEvent::MouseButtonDblClick:
+        case QEvent::Wheel:
+        case QEvent::ContextMenu:
+        case QEvent::Close: {
+            QWidget *widget = qobject_cast<QWidget*>(watched);
+            return !widget || widget->window() != q;
+        }
+        default:;
+        }
+        return false;
+    }
+
+    KexiFindDialog * const q;
     //! Connects action \a action with appropriate signal \a member
     //! and optionally adds shortcut that will receive shortcut for \a action
     //! at global scope of the dialog \a parent.
@@ -79,6 +126,9 @@ public:
     QList<QShortcut*> shortcuts;
     KConfigGroup confGroup;
     bool replaceMode;
+    bool searching = false; //!< true if progress of searching is displayed
+    bool buttonsEnabled = true; //!< state of the buttons before searching
+    bool cancelRequested = false;
 };
 
 //------------------------------------------
@@ -87,7 +137,7 @@ KexiFindDialog::KexiFindDialog(QWidget* parent)
         : QDialog(parent,
                   Qt::Dialog | Qt::WindowTitleHint | Qt::WindowSystemMenuHint | Qt::Tool
                   | Qt::WindowCloseButtonHint)
-        , d(new Private())
+        , d(new Private(this))
 {
     setObjectName("KexiFindDialog");
     setupUi(this);
@@ -259,6 +309,18 @@ void KexiFindDialog::setButtonsEnabled(bool enable)
         setObjectNameForCaption(QString());
 }
 
+void KexiFindDialog::finishProgress()
+{
+    if (!d->searching)
+        return;
+    qApp->removeEventFilter(d);
+    d->searching = false;
+    m_btnFind->setEnabled(d->buttonsEnabled);
+    m_btnReplace->setEnabled(d->buttonsEnabled);
+    m_btnReplaceAll->setEnabled(d->buttonsEnabled);
+    setMessage(d->cancelRequested ? xi18n("Searching has been stopped") : QString());
+}
+
 void KexiFindDialog::setMessage(const QString& message)
 {
     m_messageLabel->setText(message);
@@ -304,6 +366,9 @@ KexiSearchAndReplaceViewInterface::Options KexiFindDialog::options() const
     options.caseSensitive = m_caseSensitive->isChecked();
     options.wholeWordsOnly = m_wholeWords->isChecked();
     options.promptOnReplace = m_promptOnReplace->isChecked();
+    options.searchInDatabase = m_searchInDatabase->isChecked();
+    d->cancelRequested = false;
+    options.progressHandler = d;
     return options;
 }
 
@@ -312,6 +377,10 @@ bool KexiFindDialog::event(QEvent *e)
     if (e->type() == QEvent::ShortcutOverride && static_cast<QKeyEvent*>(e)->key() == Qt::Key_Escape
         && static_cast<QKeyEvent*>(e)->modifiers() == Qt::NoModifier)
     {
+        if (d->searching) {
+            d->cancelRequested = true;
+            return true;
+        }
         reject();
         return true;
     }
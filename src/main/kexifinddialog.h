@@ -100,6 +100,10 @@ public Q_SLOTS:
      using setObjectNameForCaption() too. */
     void setButtonsEnabled(bool enable);
 
+    /*! Restores state of the dialog after searching that displayed progress
+     through handler of options(). Should be called after every find or replace operation. */
+    void finishProgress();
+
     /*! Sets message at the bottom to \a message. */
     void setMessage(const QString& message);
 
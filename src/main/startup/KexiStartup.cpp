@@ -23,6 +23,8 @@
 #include "kexiprojectdata.h"
 #include "kexiprojectset.h"
 #include "kexiguimsghandler.h"
+#include "kexiinternalpart.h"
+#include "kexitextmsghandler.h"
 #include <core/kexipartmanager.h>
 #include <core/kexipartinfo.h>
 #include <core/KexiCommandLineOptions.h>
@@ -44,9 +46,11 @@
 
 #include <QDebug>
 #include <QApplication>
+#include <QElapsedTimer>
 #include <QMimeDatabase>
 #include <QMimeType>
 #include <QProgressDialog>
+#include <QTextDocumentFragment>
 
 static void destroyStartupHandler()
 {
@@ -77,6 +81,7 @@ public:
     Private(KexiStartupHandler *handler)
         : q(handler)
     {
+        startupTimer.start();
     }
 
     ~Private() {
@@ -167,6 +172,7 @@ public:
     KexiDBConnShortcutFile *connShortcutFile = nullptr;
     KexiDBConnectionDialog *connDialog = nullptr;
     QString shortcutFileGroupKey;
+    QElapsedTimer startupTimer; //!< Used to report time to the first record of data transfer
 private:
     KexiStartupHandler* const q;
 };
@@ -292,6 +298,103 @@ tristate KexiStartupHandler::handleHighPriorityOptions()
     return cancelled;
 }
 
+//! @return @a message, which can contain rich text, converted for the console
+static QString plainText(const QString &message)
+{
+    return QTextDocumentFragment::fromHtml(message).toPlainText();
+}
+
+tristate KexiStartupHandler::handleDataTransferOptions()
+{
+    const bool exportCsv = isSet(options().exportCsv);
+    const bool importCsv = isSet(options().importCsv);
+    if (!exportCsv && !importCsv) {
+        return cancelled;
+    }
+    QTextStream err(stderr);
+    if (exportCsv && importCsv) {
+        err << i18n("Both --export-csv and --import-csv used in startup options.") << endl;
+        return false;
+    }
+    if (!isSet(options().to)) {
+        err << i18n("No destination specified using --to option.") << endl;
+        return false;
+    }
+    if (!KexiStartupData::projectData()) {
+        err << i18n("No project specified.") << endl;
+        return false;
+    }
+    const QString destination(value(options().to));
+    if (exportCsv) {
+        KexiStartupData::projectData()->setReadOnly(true);
+    }
+    QString message, details;
+    KexiTextMessageHandler handler(&message, &details);
+    KexiProject project(*KexiStartupData::projectData(), &handler);
+    if (true != project.open()) {
+        err << i18n("Could not open project.") << ' ' << plainText(message) << endl;
+        if (!details.isEmpty()) {
+            err << plainText(details) << endl;
+        }
+        return false;
+    }
+
+    QMap<QString, QString> args;
+    args.insert("connection", KDbUtils::pointerToString(project.dbConnection()));
+    const char *command;
+    if (exportCsv) {
+        QString typeName("table");
+        QString objectName;
+        const QString object(value(options().exportCsv));
+        const int idx = object.indexOf(':');
+        if (!stripQuotes(object, &objectName) && idx != -1) {
+            typeName = object.left(idx).toLower();
+            (void)stripQuotes(object.mid(idx + 1), &objectName);
+        }
+        if (typeName != "table" && typeName != "query") {
+            err << i18n("Could not export data of %1 type. Only tables and queries can be exported.",
+                        typeName) << endl;
+            return false;
+        }
+        KexiPart::Item *item = project.itemForPluginId("org.kexi-project." + typeName, objectName);
+        if (!item) {
+            err << i18n("Object \"%1\" of %2 type not found.", objectName, typeName) << endl;
+            return false;
+        }
+        command = "KexiCSVExportFile";
+        args.insert("destinationType", "file");
+        args.insert("itemId", QString::number(item->identifier()));
+        args.insert("fileName", destination);
+    } else {
+        command = "KexiCSVImportFile";
+        args.insert("fileName", value(options().importCsv));
+        args.insert("tableName", destination);
+    }
+    const qint64 commandStarted = d->startupTimer.elapsed();
+    const bool ok = KexiInternalPart::executeCommand("org.kexi-project.importexport.csv", command, &args);
+    const qint64 finished = d->startupTimer.elapsed();
+    if (!ok) {
+        err << (exportCsv ? i18n("Could not export data.") : i18n("Could not import data."));
+        if (!args.value("errorMessage").isEmpty()) {
+            err << ' ' << plainText(args.value("errorMessage"));
+        }
+        err << endl;
+        if (!args.value("errorDetails").isEmpty()) {
+            err << plainText(args.value("errorDetails")) << endl;
+        }
+        return false;
+    }
+    const qint64 firstRecordElapsed = args.value("firstRecordElapsed").toLongLong();
+    err << (exportCsv ? i18n("Exported %1 records in %2 ms.", args.value("recordCount"), finished)
+                      : i18n("Imported %1 records in %2 ms.", args.value("recordCount"), finished))
+        << endl;
+    if (firstRecordElapsed >= 0) {
+        err << i18n("First record transferred %1 ms after start.", commandStarted + firstRecordElapsed)
+            << endl;
+    }
+    return true;
+}
+
 tristate KexiStartupHandler::init(const QStringList &arguments,
                                   const QList<QCommandLineOption> &extraOptions)
 {
@@ -697,6 +800,12 @@ tristate KexiStartupHandler::init(const QStringList &arguments,
         return false;
     }
 
+    res = handleDataTransferOptions();
+    if (res == true || res == false) {
+        setAction(Exit);
+        return res;
+    }
+
     if (!KexiStartupData::projectData()) {
         cdata = KDbConnectionData(); //clear
 
@@ -104,6 +104,13 @@ private:
              should continue) */
     tristate handleHighPriorityOptions();
 
+    //! Handle options transferring data without GUI, i.e. --export-csv and --import-csv.
+    /*! The project is opened, data is transferred and KEXI exits without constructing
+     the main window. Errors and statistics are written to the standard error output.
+     @return true on success, false on failure and cancelled if no such option has been
+             found (in this case processing of other options should continue) */
+    tristate handleDataTransferOptions();
+
     class Private;
     Private * const d;
     friend class KexiMainWindow;
@@ -125,8 +125,13 @@ bool KexiSqlMigrate::drv_copyTable(const QString& srcTable, KDbConnection *destC
     if (!result) {
         return false;
     }
-    const KDbQueryColumnInfo::Vector fieldsExpanded(dstTable->query()->fieldsExpanded(destConn));
-    const int numFields = qMin(fieldsExpanded.count(), result->fieldsCount());
+    RecordInserter inserter(this, destConn, dstTable);
+    if (!inserter.isValid()) {
+        return false;
+    }
+    // fields of the table are used instead of expanded fields of its query because
+    // the latter are cached by destConn that can be in use by another thread
+    const int numFields = qMin(dstTable->fieldCount(), result->fieldsCount());
     Q_FOREVER {
         QSharedPointer<KDbSqlRecord> record = result->fetchRecord();
         if (!record) {
@@ -144,7 +149,7 @@ bool KexiSqlMigrate::drv_copyTable(const QString& srcTable, KDbConnection *destC
         for(int i = 0; i < numFields; ++i) {
             const KDbSqlString s(record->cstringValue(i));
             vals.append(KDb::cstringToVariant(
-                            s.string, fieldsExpanded.at(i)->field()->type(), 0, s.length));
+                            s.string, dstTable->field(i)->type(), 0, s.length));
         }
         updateProgress();
         if (recordFilter) {
@@ -152,12 +157,12 @@ bool KexiSqlMigrate::drv_copyTable(const QString& srcTable, KDbConnection *destC
                 continue;
             }
         }
-        if (!destConn->insertRecord(dstTable, vals)) {
+        if (!inserter.insert(vals)) {
             return false;
         }
     }
     /*! @todo Check that wasn't an error, rather than end of result set */
-    return true;
+    return inserter.finish();
 }
 
 bool KexiSqlMigrate::drv_getTableSize(const QString& table, quint64 *size)
@@ -66,6 +66,11 @@ protected:
         return true;
     }
 
+    //! Each reader thread uses own connection to the server
+    bool drv_parallelCopySupported() override {
+        return true;
+    }
+
     bool drv_getTableSize(const QString& table, quint64* size) override;
 
 //! @todo move this somewhere to low level class (MIGRATION?) virtual bool drv_getTablesList( QStringList &list );
@@ -45,6 +45,8 @@
 #include <KDbIdentifierValidator>
 
 #include <KMessageBox>
+#include <KConfigGroup>
+#include <KSharedConfig>
 
 #include <QGroupBox>
 #include <QLabel>
@@ -679,6 +681,18 @@ void ImportWizard::progressUpdated(int percent)
     qApp->processEvents();
 }
 
+void ImportWizard::tableProgressUpdated(const QString &tableName, int percent)
+{
+    if (percent < 100) {
+        d->lblImportingTxt->setText(
+            xi18nc("@info", "Importing in progress...<nl/>"
+                            "Copying data of table <resource>%1</resource> (%2%)",
+                   tableName, percent));
+    } else {
+        d->lblImportingTxt->setText(xi18n("Importing in progress..."));
+    }
+}
+
 QString ImportWizard::driverIdForMimeType(const QMimeType &mime) const
 {
     if (!mime.isValid()) {
@@ -805,6 +819,10 @@ KexiMigrate* ImportWizard::prepareImport(Kexi::ObjectStatus& result)
                        this, SLOT(progressUpdated(int)));
             connect(sourceDriver, SIGNAL(progressPercent(int)),
                     this, SLOT(progressUpdated(int)));
+            disconnect(sourceDriver, SIGNAL(tableProgressPercent(QString,int)),
+                       this, SLOT(tableProgressUpdated(QString,int)));
+            connect(sourceDriver, SIGNAL(tableProgressPercent(QString,int)),
+                    this, SLOT(tableProgressUpdated(QString,int)));
             progressUpdated(0);
         }
 
@@ -840,6 +858,8 @@ KexiMigrate* ImportWizard::prepareImport(Kexi::ObjectStatus& result)
             //! @todo Aah, this is so C-like. Move to performImport().
         }
         md->setShouldCopyData(keepData);
+        KConfigGroup importExportGroup(KSharedConfig::openConfig()->group("ImportExport"));
+        md->setReaderThreadCount(importExportGroup.readEntry("ReaderThreadsForImportingDatabases", 0));
         sourceDriver->setData(md);
         return sourceDriver;
     }
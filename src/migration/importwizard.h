@@ -59,6 +59,9 @@ public:
 public Q_SLOTS:
     void progressUpdated(int percent);
 
+    //! Shows name of the table which data is being copied
+    void tableProgressUpdated(const QString &tableName, int percent);
+
 protected Q_SLOTS:
     virtual void next() override;
     virtual void back() override;
@@ -26,16 +26,130 @@
 #include <KDbConnectionProxy>
 #include <KDbDriverManager>
 #include <KDbDriverMetaData>
+#include <KDbPreparedStatement>
 #include <KDbProperties>
 #include <KDbRecordData>
 #include <KDbSqlResult>
+#include <KDbTransaction>
 #include <KDbVersionInfo>
 
 #include <QInputDialog>
 #include <QMutableListIterator>
+#include <QMutex>
+#include <QQueue>
+#include <QRunnable>
+#include <QThread>
+#include <QThreadPool>
+#include <QThreadStorage>
+#include <QWaitCondition>
+
+#include <functional>
 
 using namespace KexiMigration;
 
+namespace {
+
+//! A table to copy by reader threads
+class TableCopyJob
+{
+public:
+    TableCopyJob(const QString &name, KDbTableSchema *t) : sourceName(name), table(t) {}
+    const QString sourceName;
+    KDbTableSchema * const table;
+    quint64 size = 0; //!< Size reported by drv_getTableSize(), 0 if unknown
+    QAtomicInteger<quint64> progressDone; //!< Updated by updateProgress() called by reader
+    int lastPercent = -1; //!< Used by the writer to avoid repeated signals
+    //! Error of the reader, set before the last batch is queued and read by the writer
+    //! only after popping the batch, so no locking is needed
+    KDbResult result;
+};
+
+//! Records read by a reader thread
+class RecordBatch
+{
+public:
+    TableCopyJob *job = nullptr;
+    QVector<QList<QVariant>> records;
+    bool last = false; //!< true if all records of the table have been read
+    bool ok = true; //!< For the last batch: false if reading failed
+};
+
+//! Queue of record batches passed from reader threads to the writer.
+//! Its size is bounded so fast readers do not exhaust memory.
+class RecordBatchQueue
+{
+public:
+    //! Waits while the queue is full. @return false if the queue has been aborted.
+    bool push(RecordBatch &&batch)
+    {
+        QMutexLocker locker(&mutex);
+        while (!aborted && batches.count() >= MAXIMUM_BATCHES) {
+            notFull.wait(&mutex);
+        }
+        if (aborted) {
+            return false;
+        }
+        batches.enqueue(std::move(batch));
+        notEmpty.wakeOne();
+        return true;
+    }
+
+    //! Waits while the queue is empty.
+    RecordBatch pop()
+    {
+        QMutexLocker locker(&mutex);
+        while (batches.isEmpty()) {
+            notEmpty.wait(&mutex);
+        }
+        RecordBatch batch(batches.dequeue());
+        notFull.wakeOne();
+        return batch;
+    }
+
+    //! Makes pending and future push() calls fail
+    void abort()
+    {
+        QMutexLocker locker(&mutex);
+        aborted = true;
+        batches.clear();
+        notFull.wakeAll();
+    }
+
+    bool isAborted() const
+    {
+        QMutexLocker locker(&mutex);
+        return aborted;
+    }
+
+private:
+    static const int MAXIMUM_BATCHES = 16;
+    mutable QMutex mutex;
+    QWaitCondition notEmpty;
+    QWaitCondition notFull;
+    QQueue<RecordBatch> batches;
+    bool aborted = false;
+};
+
+//! Data of a reader thread, see KexiMigrate::readTables()
+class ReaderContext
+{
+public:
+    KDbConnectionProxy *sourceConnection = nullptr;
+    TableCopyJob *job = nullptr;
+};
+
+//! Runs a function in a thread pool
+class FunctionRunnable : public QRunnable
+{
+public:
+    explicit FunctionRunnable(const std::function<void()> &f) : m_function(f) {}
+    void run() override { m_function(); }
+private:
+    const std::function<void()> m_function;
+};
+
+}
+
 class Q_DECL_HIDDEN KexiMigrate::Private
 {
 public:
@@ -97,6 +211,73 @@ public:
     //! Don't recalculate progress done until this value is reached.
     quint64 progressNextReport = 0;
 
+    //! Sizes of source tables found by progressInitialise()
+    QHash<QString, quint64> tableSizes;
+
+    //! Progress reported by reader threads, not yet reported by the writer
+    QAtomicInteger<quint64> pendingProgress;
+
+    //! Tables to copy by copyTables() and index of the next table to read
+    QList<TableCopyJob*> copyJobs;
+    QAtomicInt nextCopyJob;
+
+    RecordBatchQueue *recordBatchQueue = nullptr;
+
+    //! True while copyTables() writes records within its own transactions,
+    //! record inserters of the writer thread do not start transactions then
+    bool copyingTables = false;
+
+    //! Set for reader threads only
+    QThreadStorage<ReaderContext> readerContext;
+
+    //! @return context of the current thread if it is a reader thread, nullptr otherwise
+    ReaderContext* currentReaderContext()
+    {
+        return readerContext.hasLocalData() && readerContext.localData().job
+            ? &readerContext.localData() : nullptr;
+    }
+
+    //! Values of SQLite pragmas modified by relaxPragmas(), to be restored by restorePragmas()
+    QList<QPair<QString, QString>> savedPragmas;
+
+    //! Makes SQLite destination database faster for bulk inserts. Durability is not needed
+    //! while copying data because the destination database is dropped if import fails.
+    //! Has to be called outside of transaction.
+    void relaxPragmas(KDbConnection *conn)
+    {
+        if (migrateData->destinationProjectData()->connectionData()->driverId()
+            != QLatin1String("org.kde.kdb.sqlite"))
+        {
+            return;
+        }
+        static const char* const pragmas[][2] = {
+            { "synchronous", "OFF" },
+            { "journal_mode", "MEMORY" },
+            { "temp_store", "MEMORY" },
+            { "cache_size", "-65536" } // 64 MiB
+        };
+        for (const auto &pragma : pragmas) {
+            const QString name(QLatin1String(pragma[0]));
+            QString oldValue;
+            if (true != conn->querySingleString(KDbEscapedString("PRAGMA %1").arg(name), &oldValue)
+                || !conn->executeSql(KDbEscapedString("PRAGMA %1=%2").arg(name).arg(QLatin1String(pragma[1]))))
+            {
+                qWarning() << "Could not set pragma" << name << conn->result();
+                continue;
+            }
+            savedPragmas.append(qMakePair(name, oldValue));
+        }
+    }
+
+    void restorePragmas(KDbConnection *conn)
+    {
+        for (const QPair<QString, QString> &pragma : savedPragmas) {
+            if (!conn->executeSql(KDbEscapedString("PRAGMA %1=%2").arg(pragma.first).arg(pragma.second))) {
+                qWarning() << "Could not restore pragma" << pragma.first << conn->result();
+            }
+        }
+        savedPragmas.clear();
+    }
 };
 
 KexiMigrate::KexiMigrate(QObject *parent, const QVariantList&)
@@ -110,6 +291,16 @@ KexiMigrate::KexiMigrate(QObject *parent, const QVariantList&)
 //! let's assume that each table creation costs the same as inserting 20 rows
 #define NUM_OF_ROWS_PER_CREATE_TABLE 20
 
+//! Number of records inserted by KexiMigrate::RecordInserter before commit
+#define NUM_OF_ROWS_PER_COMMIT 50000
+
+//! Number of records passed at once from a reader thread to the writer
+#define NUM_OF_ROWS_PER_BATCH 1000
+
+//! Maximum number of reader threads if the number is selected automatically,
+//! see KexiMigration::Data::readerThreadCount()
+#define MAX_AUTOMATIC_READER_THREADS 4
+
 
 //=============================================================================
 // Migration parameters
@@ -147,6 +338,9 @@ void KexiMigrate::setMetaData(const KexiMigratePluginMetaData *metaData)
 
 KDbConnectionProxy* KexiMigrate::sourceConnection()
 {
+    if (d->readerContext.hasLocalData() && d->readerContext.localData().sourceConnection) {
+        return d->readerContext.localData().sourceConnection;
+    }
     return d->sourceConnection;
 }
 
@@ -559,10 +753,11 @@ bool KexiMigrate::performImportInternal(Kexi::ObjectStatus* result)
     }
 
     // Step 8 - Copy data if asked to
-    if (ok) {
-        trans = destConn->beginTransaction();
-        ok = !trans.isNull();
+    if (ok && d->migrateData->shouldCopyData()) {
+        d->relaxPragmas(destConn->parentConnection());
     }
+    // No transaction is started here: RecordInserter commits copied records
+    // in its own transactions
     if (ok) {
         if (d->migrateData->shouldCopyData()) {
 //! @todo check detailed "copy forms/blobs/tables" flags here when we add them
@@ -575,9 +770,8 @@ bool KexiMigrate::performImportInternal(Kexi::ObjectStatus* result)
                 d->tableSchemas.append(destConn->tableSchema("kexi__blobs"));
         }
 
+        QList<QPair<QString, KDbTableSchema*>> tablesToCopy;
         foreach(KDbTableSchema *ts, d->tableSchemas) {
-            if (!ok)
-                break;
             if ((destConn->driver()->isSystemObjectName(ts->name())
                  || KDbDriver::isKDbSystemObjectName(ts->name()))
 //! @todo what if these two tables are not compatible with tables created in destination db
@@ -596,21 +790,23 @@ bool KexiMigrate::performImportInternal(Kexi::ObjectStatus* result)
             if (tsName.isEmpty()) {
                 tsName = ts->name();
             }
-            ok = drv_copyTable(tsName, destConn->parentConnection(), ts);
-            if (!ok) {
-                qWarning() << "Failed to copy table " << tsName;
-                if (result)
-                    result->setStatus(destConn->parentConnection()->result(), nullptr,
-                                      xi18nc("@info",
-                                             "Could not copy table <resource>%1</resource> to destination database.", tsName));
-                break;
-            }
+            tablesToCopy.append(qMakePair(tsName, ts));
         }//for
+        clearResult();
+        QString failedTableName;
+        ok = copyTables(tablesToCopy, destConn->parentConnection(), &failedTableName);
+        if (!ok) {
+            qWarning() << "Failed to copy table " << failedTableName;
+            if (result)
+                result->setStatus(m_result.isError() ? m_result : destConn->parentConnection()->result(), nullptr,
+                                  xi18nc("@info",
+                                         "Could not copy table <resource>%1</resource> to destination database.", failedTableName));
+        }
     }
 
     // Done.
     if (ok)
-        ok = destConn->commitTransaction(trans);
+        d->restorePragmas(destConn->parentConnection());
 
     d->kexiDBCompatibleTableSchemasToRemoveFromMemoryAfterImport.clear();
 
@@ -633,6 +829,175 @@ bool KexiMigrate::performImportInternal(Kexi::ObjectStatus* result)
     }
     return false;
 }
+
+bool KexiMigrate::copyTables(const QList<QPair<QString, KDbTableSchema*>> &tables,
+                             KDbConnection *destConn, QString *failedTableName)
+{
+    if (tables.isEmpty()) {
+        return true;
+    }
+    for (const QPair<QString, KDbTableSchema*> &table : tables) {
+        TableCopyJob *job = new TableCopyJob(table.first, table.second);
+        job->size = d->tableSizes.value(table.first);
+        d->copyJobs.append(job);
+    }
+    d->nextCopyJob = 0;
+
+    // One source connection per reader thread
+    QList<KDbConnectionProxy*> readerConnections;
+    readerConnections.append(d->sourceConnection); // can be nullptr for custom types of sources
+    if (drv_parallelCopySupported() && d->sourceConnection) {
+        int readerCount = d->migrateData->readerThreadCount();
+        if (readerCount == 0) {
+            readerCount = qMin(QThread::idealThreadCount(), MAX_AUTOMATIC_READER_THREADS);
+        }
+        readerCount = qMin(readerCount, tables.count());
+        while (readerConnections.count() < readerCount) {
+            KDbConnection *conn = drv_createConnection();
+            if (!conn) {
+                break;
+            }
+            KDbConnectionProxy *proxy = new KDbConnectionProxy(conn);
+            if (!proxy->drv_connect() || !proxy->drv_useDatabase(d->migrateData->sourceName)) {
+                qWarning() << "Could not create connection for reader thread" << proxy->result();
+                delete proxy;
+                break;
+            }
+            readerConnections.append(proxy);
+        }
+        clearResult();
+    }
+
+    RecordBatchQueue queue;
+    d->recordBatchQueue = &queue;
+    QThreadPool pool;
+    pool.setMaxThreadCount(readerConnections.count());
+    for (KDbConnectionProxy *sourceConnection : readerConnections) {
+        pool.start(new FunctionRunnable([this, sourceConnection, destConn]() {
+            readTables(sourceConnection, destConn);
+        }));
+    }
+
+    // Write records in this thread. Records of tables read in parallel are interleaved,
+    // so a single transaction is used for all of them; it is committed (and a new one
+    // is started) every NUM_OF_ROWS_PER_COMMIT records.
+    QHash<TableCopyJob*, RecordInserter*> inserters;
+    KDbTransaction transaction = destConn->beginTransaction();
+    bool ok = !transaction.isNull();
+    if (!ok) {
+        m_result = destConn->result();
+        *failedTableName = d->copyJobs.first()->sourceName;
+    }
+    int recordsInTransaction = 0;
+    d->copyingTables = true;
+    int finishedJobs = 0;
+    while (ok && finishedJobs < d->copyJobs.count()) {
+        RecordBatch batch(queue.pop());
+        TableCopyJob *job = batch.job;
+        RecordInserter *inserter = inserters.value(job);
+        if (!inserter) {
+            inserter = new RecordInserter(this, destConn, job->table);
+            inserters.insert(job, inserter);
+            ok = inserter->isValid();
+        }
+        for (int i = 0; ok && i < batch.records.count(); ++i) {
+            ok = inserter->insert(batch.records.at(i));
+        }
+        recordsInTransaction += batch.records.count();
+        if (ok && recordsInTransaction >= NUM_OF_ROWS_PER_COMMIT) {
+            recordsInTransaction = 0;
+            ok = destConn->commitTransaction(transaction);
+            if (ok) {
+                transaction = destConn->beginTransaction();
+                ok = !transaction.isNull();
+            }
+            if (!ok) {
+                m_result = destConn->result();
+            }
+        }
+        if (ok && batch.last) {
+            if (batch.ok) {
+                ok = inserter->finish();
+            } else {
+                ok = false;
+                m_result = job->result; // merge error of the reader
+            }
+            ++finishedJobs;
+        }
+        if (!ok) {
+            *failedTableName = job->sourceName;
+            break;
+        }
+        const quint64 step = d->pendingProgress.fetchAndStoreRelaxed(0);
+        if (step > 0) {
+            updateProgress(step);
+        }
+        if (job->size > 0) {
+            const int percent = batch.last
+                ? 100 : int(qMin(job->progressDone.loadAcquire() * 100 / job->size, quint64(99)));
+            if (percent != job->lastPercent) {
+                job->lastPercent = percent;
+                emit tableProgressPercent(job->sourceName, percent);
+            }
+        }
+    }
+    // Stop readers on failure, wait for them in any case
+    queue.abort();
+    pool.waitForDone();
+    d->recordBatchQueue = nullptr;
+
+    qDeleteAll(inserters);
+    d->copyingTables = false;
+    if (ok) {
+        ok = destConn->commitTransaction(transaction);
+        if (!ok) {
+            m_result = destConn->result();
+            *failedTableName = d->copyJobs.last()->sourceName;
+        }
+    } else if (transaction.isActive()) {
+        destConn->rollbackTransaction(transaction);
+    }
+    qDeleteAll(d->copyJobs);
+    d->copyJobs.clear();
+    for (KDbConnectionProxy *proxy : readerConnections) {
+        if (proxy && proxy != d->sourceConnection) {
+            proxy->drv_disconnect();
+            delete proxy;
+        }
+    }
+    return ok;
+}
+
+void KexiMigrate::readTables(KDbConnectionProxy *sourceConnection, KDbConnection *destConn)
+{
+    ReaderContext context;
+    context.sourceConnection = sourceConnection;
+    Q_FOREVER {
+        const int index = d->nextCopyJob.fetchAndAddOrdered(1);
+        if (index >= d->copyJobs.count() || d->recordBatchQueue->isAborted()) {
+            break;
+        }
+        context.job = d->copyJobs.at(index);
+        d->readerContext.setLocalData(context);
+        RecordBatch last;
+        last.job = context.job;
+        last.last = true;
+        last.ok = drv_copyTable(context.job->sourceName, destConn, context.job->table);
+        if (!last.ok) {
+            // m_result belongs to the writer thread, keep the error with the job
+            if (sourceConnection) {
+                context.job->result = sourceConnection->result();
+            }
+            qWarning() << "Failed to read table" << context.job->sourceName
+                       << context.job->result;
+        }
+        if (!d->recordBatchQueue->push(std::move(last))) {
+            break;
+        }
+    }
+    d->readerContext.setLocalData(ReaderContext());
+}
+
 //=============================================================================
 
 bool KexiMigrate::performExport(Kexi::ObjectStatus* result)
@@ -657,12 +1022,14 @@ bool KexiMigrate::progressInitialise()
         return false;
 
     // 1) Get the number of rows/bytes to import
+    d->tableSizes.clear();
     int tableNumber = 1;
     quint64 sum = 0;
     foreach(const QString& tableName, tables) {
         quint64 size;
         if (drv_getTableSize(tableName, &size)) {
             //qDebug() << "table:" << tableName << "size:" << (ulong)size;
+            d->tableSizes.insert(tableName, size);
             sum += size;
             emit progressPercent(tableNumber * 5 /* 5% */ / tables.count());
             tableNumber++;
@@ -683,6 +1050,12 @@ bool KexiMigrate::progressInitialise()
 
 void KexiMigrate::updateProgress(qulonglong step)
 {
+    ReaderContext *context = d->currentReaderContext();
+    if (context) { // reported by the writer
+        context->job->progressDone.fetchAndAddRelaxed(step);
+        d->pendingProgress.fetchAndAddRelaxed(step);
+        return;
+    }
     d->progressDone += step;
     if (d->progressTotal > 0 && d->progressDone >= d->progressNextReport) {
         int percent = (d->progressDone + 1) * 100 / d->progressTotal;
@@ -860,6 +1233,133 @@ QVariant KexiMigrate::value(int i)
 
 //------------------------
 
+class Q_DECL_HIDDEN KexiMigrate::RecordInserter::Private
+{
+public:
+    Private(KexiMigrate *m, KDbConnection *c)
+        : migrate(m), conn(c)
+    {
+    }
+    KexiMigrate * const migrate;
+    KDbConnection * const conn;
+    KDbPreparedStatement statement;
+    //! Transaction of the inserter, null if transactions are managed by copyTables()
+    KDbTransaction transaction;
+    quint64 insertedRecordCount = 0;
+    int recordsInTransaction = 0;
+    //! Set if the inserter has been created by a reader thread, records are queued then
+    RecordBatchQueue *queue = nullptr;
+    RecordBatch batch;
+
+    bool pushBatch()
+    {
+        if (batch.records.isEmpty()) {
+            return true;
+        }
+        RecordBatch next;
+        next.job = batch.job;
+        next.records.reserve(NUM_OF_ROWS_PER_BATCH);
+        std::swap(batch, next);
+        return queue->push(std::move(next));
+    }
+};
+
+KexiMigrate::RecordInserter::RecordInserter(KexiMigrate *migrate, KDbConnection *destConn,
+                                            KDbTableSchema *dstTable)
+    : d(new Private(migrate, destConn))
+{
+    const ReaderContext *context = migrate->d->currentReaderContext();
+    if (context) {
+        d->queue = migrate->d->recordBatchQueue;
+        d->batch.job = context->job;
+        d->batch.records.reserve(NUM_OF_ROWS_PER_BATCH);
+        return;
+    }
+    d->statement = destConn->prepareStatement(KDbPreparedStatement::InsertStatement, dstTable);
+    if (!d->statement.isValid()) {
+        migrate->m_result = destConn->result();
+        return;
+    }
+    if (!migrate->d->copyingTables) {
+        d->transaction = destConn->beginTransaction();
+        if (d->transaction.isNull()) {
+            migrate->m_result = destConn->result();
+            d->statement = KDbPreparedStatement();
+        }
+    }
+}
+
+KexiMigrate::RecordInserter::~RecordInserter()
+{
+    if (d->transaction.isActive()) {
+        d->conn->rollbackTransaction(d->transaction);
+    }
+    delete d;
+}
+
+bool KexiMigrate::RecordInserter::isValid() const
+{
+    return d->queue || d->statement.isValid();
+}
+
+bool KexiMigrate::RecordInserter::insert(const QList<QVariant> &values)
+{
+    if (d->queue) {
+        d->batch.records.append(values);
+        ++d->insertedRecordCount;
+        // false if the writer has failed
+        return d->batch.records.count() < NUM_OF_ROWS_PER_BATCH || d->pushBatch();
+    }
+    if (!d->statement.execute(values)) {
+        d->migrate->m_result = d->statement.result();
+        return false;
+    }
+    ++d->insertedRecordCount;
+    if (d->transaction.isNull()) {
+        return true; // copyTables() commits its transaction
+    }
+    if (++d->recordsInTransaction >= NUM_OF_ROWS_PER_COMMIT) {
+        if (!commit()) {
+            return false;
+        }
+        d->transaction = d->conn->beginTransaction();
+        if (d->transaction.isNull()) {
+            d->migrate->m_result = d->conn->result();
+            return false;
+        }
+    }
+    return true;
+}
+
+bool KexiMigrate::RecordInserter::commit()
+{
+    d->recordsInTransaction = 0;
+    const bool ok = d->conn->commitTransaction(d->transaction);
+    if (!ok) {
+        d->migrate->m_result = d->conn->result();
+    }
+    d->transaction = KDbTransaction();
+    return ok;
+}
+
+bool KexiMigrate::RecordInserter::finish()
+{
+    if (d->queue) {
+        return d->pushBatch();
+    }
+    if (d->transaction.isNull()) {
+        return true; // copyTables() commits its transaction
+    }
+    return commit();
+}
+
+quint64 KexiMigrate::RecordInserter::insertedRecordCount() const
+{
+    return d->insertedRecordCount;
+}
+
+//------------------------
+
 KDbVersionInfo KexiMigration::version()
 {
     return KDbVersionInfo(KEXI_MIGRATION_VERSION_MAJOR, KEXI_MIGRATION_VERSION_MINOR, 0);
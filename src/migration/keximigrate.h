@@ -175,6 +175,10 @@ public:
 Q_SIGNALS:
     void progressPercent(int percent);
 
+    //! Emitted while data of table @a tableName is copied, only if progress is supported
+    //! by the driver. @a percent is 100 when the table has been copied.
+    void tableProgressPercent(const QString &tableName, int percent);
+
 protected:
     //! Used by MigrateManager.
     explicit KexiMigrate(QObject *parent, const QVariantList &args = QVariantList());
@@ -284,9 +288,55 @@ protected:
         virtual bool operator() (const QList<QVariant> &record) const = 0;
     };
 
+    //! @short Inserts records copied by drv_copyTable() into a destination table
+    /*! Use it instead of KDbConnection::insertRecord() which prepares a new statement
+     for every record. A single prepared statement is reused for all records.
+     The inserter starts its own transaction, commits it (and starts a new one) every
+     few tens of thousands of records, so the database engine does not have to keep track
+     of changes made to a huge table within a single transaction, and commits it
+     in finish(). Transactions of the caller are never used. On failure result()
+     of the migration object is set.
+
+     If the inserter is created within drv_copyTable() called by a reader thread
+     of performImport(), records are passed in batches to the thread writing
+     to the destination database instead. The writer inserts records of all tables
+     within its own transactions then. */
+    class KEXIMIGRATE_EXPORT RecordInserter
+    {
+    public:
+        RecordInserter(KexiMigrate *migrate, KDbConnection *destConn, KDbTableSchema *dstTable);
+
+        //! Rolls back the transaction if it has been started by the inserter
+        //! and finish() has not been called.
+        ~RecordInserter();
+
+        //! @return true if the insert statement has been prepared successfully
+        bool isValid() const;
+
+        //! Inserts a single record. @return false on failure.
+        bool insert(const QList<QVariant> &values);
+
+        //! Commits records inserted so far. @return false on failure.
+        bool finish();
+
+        //! @return number of records inserted so far
+        quint64 insertedRecordCount() const;
+
+    private:
+        bool commit();
+
+        class Private;
+        Private * const d;
+        Q_DISABLE_COPY(RecordInserter)
+    };
+
     //! Copy a table from source DB to target DB (driver specific)
     //! - create copies of KDb tables
     //! - create copies of non-KDb tables
+    //! Implementations should insert records using RecordInserter.
+    //! @note performImport() calls this method from a reader thread, so implementations
+    //! should not use @a destConn directly, should not set m_result and should not process
+    //! events. Result of the source connection is reported on failure.
     virtual bool drv_copyTable(const QString& srcTable, KDbConnection *destConn,
                                KDbTableSchema* dstTable,
                                const RecordFilter *recordFilter = nullptr) = 0;
@@ -295,6 +345,16 @@ protected:
         return false;
     }
 
+    /*! @return true if drv_copyTable() can be called for different tables from multiple
+     threads at the same time. For such drivers performImport() creates an additional
+     source connection for each reader thread using drv_createConnection() and
+     sourceConnection() returns the connection of the current reader thread.
+     Default implementation returns false, in this case tables are read one by one
+     by a single thread, still in parallel with writing to the destination database. */
+    virtual bool drv_parallelCopySupported() {
+        return false;
+    }
+
     /*! \return the size of a table to be imported, or 0 if not supported
       Finds the size of the named table, in order to provide feedback on
       migration progress.
@@ -371,6 +431,16 @@ private:
     //!   database's table kexi__fields
     bool importTable(const QString& tableName, KDbConnectionProxy *destConn);
 
+    //! Copies data of tables using reader threads that call drv_copyTable() and
+    //! a single writer, the calling thread, inserting records into @a destConn.
+    //! @a tables are pairs of source table names and destination tables.
+    //! On failure @a failedTableName is set to name of the table that could not be copied.
+    bool copyTables(const QList<QPair<QString, KDbTableSchema*>> &tables,
+                    KDbConnection *destConn, QString *failedTableName);
+
+    //! Body of a reader thread, reads tables until there is no more tables to read
+    void readTables(KDbConnectionProxy *sourceConnection, KDbConnection *destConn);
+
     class Private;
     Private * const d;
 
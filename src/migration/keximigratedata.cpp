@@ -32,6 +32,8 @@ public:
 
     //! @c true if not only structure should be migrated but also data
     bool shouldCopyData = true;
+
+    int readerThreadCount = 0;
 };
 
 Data::Data()
@@ -78,3 +80,13 @@ void Data::setShouldCopyData(bool set)
 {
     d->shouldCopyData = set;
 }
+
+int Data::readerThreadCount() const
+{
+    return d->readerThreadCount;
+}
+
+void Data::setReaderThreadCount(int count)
+{
+    d->readerThreadCount = qMax(0, count);
+}
@@ -62,6 +62,15 @@ public:
     //! Sets flag that determines if not only structure should be migrated but also data
     void setShouldCopyData(bool set);
 
+    //! @return maximum number of threads reading data of source tables at the same time,
+    //! 0 (the default) means the number is selected automatically.
+    //! Used only by migration drivers that support parallel copying of tables.
+    int readerThreadCount() const;
+
+    //! Sets maximum number of threads reading data of source tables at the same time,
+    //! 0 means the number is selected automatically
+    void setReaderThreadCount(int count);
+
 private:
     class Private;
     Private * const d;
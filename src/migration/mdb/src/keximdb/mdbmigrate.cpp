@@ -30,9 +30,12 @@
 #include <QDateTime>
 #include <QList>
 #include <QDebug>
+#include <QVector>
 
 #include <KPluginFactory>
 
+#include <cstring>
+
 using namespace KexiMigration;
 
 /* This is the implementation for the MDB file import routines. */
@@ -244,6 +247,186 @@ QVariant MDBMigrate::toQVariant(const char* data, unsigned int len, int type)
     }
 }
 
+//! Number of records fetched before their values are converted, column by column
+#define MDB_RECORDS_PER_BATCH 256
+
+//! Size of chunks of OLE values read from the file
+#define MDB_OLE_CHUNK_SIZE MDB_BIND_SIZE
+
+namespace {
+
+//! Raw values of a single column for a batch of records, stored contiguously.
+//! Each value is followed by a null byte so it can be parsed in place.
+class ColumnArena
+{
+public:
+    ColumnArena()
+    {
+        data.reserve(MDB_RECORDS_PER_BATCH * 16); // keeps capacity between batches
+    }
+
+    void clear()
+    {
+        data.resize(0);
+        offsets.resize(0);
+        lengths.resize(0);
+    }
+
+    void appendNull()
+    {
+        offsets.append(-1);
+        lengths.append(0);
+    }
+
+    void append(const char *value, int length)
+    {
+        offsets.append(data.size());
+        lengths.append(length);
+        data.append(value, length);
+        data.append('\0');
+    }
+
+    //! Appends a value which has been started by begin() and then appended in chunks
+    void begin()
+    {
+        offsets.append(data.size());
+        lengths.append(0);
+    }
+
+    void appendChunk(const char *chunk, int length)
+    {
+        data.append(chunk, length);
+        lengths.last() += length;
+    }
+
+    void end()
+    {
+        data.append('\0');
+    }
+
+    bool isNull(int record) const { return offsets.at(record) < 0; }
+    const char* value(int record) const { return data.constData() + offsets.at(record); }
+    int length(int record) const { return lengths.at(record); }
+
+    QByteArray data;
+    QVector<int> offsets; //!< -1 for null values
+    QVector<int> lengths;
+};
+
+//! Parses decimal integer without allocating memory, 0 is returned for invalid values
+//! as QString::toLongLong() does
+qlonglong toLongLong(const char *s, int length)
+{
+    int i = 0;
+    while (i < length && s[i] == ' ') {
+        ++i;
+    }
+    const bool negative = i < length && s[i] == '-';
+    if (negative || (i < length && s[i] == '+')) {
+        ++i;
+    }
+    if (i == length) {
+        return 0;
+    }
+    qulonglong result = 0;
+    for (; i < length; ++i) {
+        const int digit = s[i] - '0';
+        if (digit < 0 || digit > 9) {
+            return 0;
+        }
+        result = result * 10 + digit;
+    }
+    return negative ? -qlonglong(result) : qlonglong(result);
+}
+
+//! Parses two digits, -1 is returned for invalid values
+inline int twoDigits(const char *s)
+{
+    return (s[0] >= '0' && s[0] <= '9' && s[1] >= '0' && s[1] <= '9')
+        ? (s[0] - '0') * 10 + (s[1] - '0') : -1;
+}
+
+//! Parses date/time in YYYY-MM-DDTHH:MM:SS format set by mdb_set_date_fmt()
+QDateTime toDateTime(const char *s, int length)
+{
+    if (length == 19 && s[4] == '-' && s[7] == '-' && s[10] == 'T' && s[13] == ':' && s[16] == ':') {
+        const int century = twoDigits(s);
+        const int year = twoDigits(s + 2);
+        const QDate date(century * 100 + year, twoDigits(s + 5), twoDigits(s + 8));
+        const QTime time(twoDigits(s + 11), twoDigits(s + 14), twoDigits(s + 17));
+        if (century >= 0 && year >= 0 && date.isValid() && time.isValid()) {
+            return QDateTime(date, time);
+        }
+    }
+    return QDateTime::fromString(QString::fromLatin1(s, length), Qt::ISODate);
+}
+
+}
+
+//! Converts values of column @a column from @a arena to values of @a records.
+//! The type is checked once per column, not per value.
+static void convertColumn(MDBMigrate *migrate, const ColumnArena &arena, int mdbType, int column,
+                          QVector<QList<QVariant>> *records)
+{
+    const int count = arena.offsets.count();
+    switch (mdbType) {
+    case MDB_TEXT:
+    case MDB_MEMO:
+        for (int r = 0; r < count; ++r) {
+            (*records)[r][column] = (arena.isNull(r) || arena.length(r) == 0)
+                ? QVariant() : QVariant(QString::fromUtf8(arena.value(r), arena.length(r)));
+        }
+        break;
+    case MDB_BOOL: //! @todo use &bool!
+    case MDB_BYTE:
+        for (int r = 0; r < count; ++r) {
+            (*records)[r][column] = (arena.isNull(r) || arena.length(r) == 0)
+                ? QVariant() : QVariant(short(toLongLong(arena.value(r), arena.length(r))));
+        }
+        break;
+    case MDB_INT:
+    case MDB_LONGINT:
+        for (int r = 0; r < count; ++r) {
+            (*records)[r][column] = (arena.isNull(r) || arena.length(r) == 0)
+                ? QVariant() : QVariant(toLongLong(arena.value(r), arena.length(r)));
+        }
+        break;
+    case MDB_DATETIME:
+        for (int r = 0; r < count; ++r) {
+            (*records)[r][column] = (arena.isNull(r) || arena.length(r) == 0)
+                ? QVariant() : QVariant(toDateTime(arena.value(r), arena.length(r)));
+        }
+        break;
+    case MDB_FLOAT:
+        for (int r = 0; r < count; ++r) {
+            (*records)[r][column] = (arena.isNull(r) || arena.length(r) == 0)
+                ? QVariant()
+                : QVariant(QByteArray::fromRawData(arena.value(r), arena.length(r)).toFloat());
+        }
+        break;
+    case MDB_DOUBLE:
+    case MDB_MONEY:   //! @todo
+    case MDB_NUMERIC: //! @todo
+        for (int r = 0; r < count; ++r) {
+            (*records)[r][column] = (arena.isNull(r) || arena.length(r) == 0)
+                ? QVariant()
+                : QVariant(QByteArray::fromRawData(arena.value(r), arena.length(r)).toDouble());
+        }
+        break;
+    case MDB_OLE:
+        for (int r = 0; r < count; ++r) {
+            (*records)[r][column] = (arena.isNull(r) || arena.length(r) == 0)
+                ? QVariant() : QVariant(QByteArray(arena.value(r), arena.length(r)));
+        }
+        break;
+    default:
+        for (int r = 0; r < count; ++r) {
+            (*records)[r][column] = arena.isNull(r)
+                ? QVariant() : migrate->toQVariant(arena.value(r), arena.length(r), mdbType);
+        }
+    }
+}
+
 bool MDBMigrate::drv_copyTable(const QString& srcTable,
                                KDbConnection *destConn, KDbTableSchema* dstTable,
                                const RecordFilter *recordFilter)
@@ -253,29 +436,36 @@ bool MDBMigrate::drv_copyTable(const QString& srcTable,
         qWarning() << srcTable;
         return false;
     }
+    RecordInserter inserter(this, destConn, dstTable);
+    if (!inserter.isValid()) {
+        return false;
+    }
 
-    char *columnData[256];
-    int columnDataLength[256];
-
-    //! Bind + allocate the DB columns to columnData and columnDataLength arrays
+    //! Bind the DB columns to buffers which are copied to column arenas after each fetch
     mdb_read_columns(tableDef); // mdb_bind_column dies without this
-    for (unsigned int i = 0; i < tableDef->num_cols; i++) {
+    const int columnCount = int(tableDef->num_cols);
+    QVector<QByteArray> columnData(columnCount);
+    QVector<int> columnDataLength(columnCount);
+    QVector<int> columnTypes(columnCount);
+    QVector<ColumnArena> arenas(columnCount);
+    for (int i = 0; i < columnCount; i++) {
         MdbColumn *col = (MdbColumn*) g_ptr_array_index(tableDef->columns, i);
+        columnTypes[i] = col->col_type;
         if (col->col_type == MDB_MEMO) {
-//! @todo supporting 1GB (possible to insert programmatically) of MEMO field needs changes in mdbtools API;
-//!       for now 65,535 is supported (maximum when entering data through the user interface)
-            columnData[i] = (char*) g_malloc(0x10000);
+//! @todo mdbtools converts whole MEMO values into the bound buffer and has no API for reading
+//!       them in chunks; 65,535 is supported (maximum when entering data through the user interface)
+            columnData[i].resize(0x10000);
         }
         else {
-            columnData[i] = (char*) g_malloc(MDB_BIND_SIZE);
+            // OLE values are read in chunks of this size, see below
+            columnData[i].resize(MDB_BIND_SIZE);
         }
 
         // Columns are numbered from 1
         // and why aren't these unsigned ints?
-        mdb_bind_column(tableDef, i + 1, columnData[i], &columnDataLength[i]);
+        mdb_bind_column(tableDef, i + 1, columnData[i].data(), &columnDataLength[i]);
     }
 
-    //! Copy each row into vals
     mdb_rewind_table(tableDef);
     //qDebug() << "Fetching" << tableDef->num_rows << "records";
 
@@ -283,40 +473,84 @@ bool MDBMigrate::drv_copyTable(const QString& srcTable,
     qulonglong rows = 0;
 #endif
 
+    QVector<QList<QVariant>> records(MDB_RECORDS_PER_BATCH);
+    for (QList<QVariant> &record : records) {
+        for (int i = 0; i < columnCount; i++) {
+            record.append(QVariant());
+        }
+    }
     bool ok = true;
-    while (mdb_fetch_row(tableDef)) {
-        QList<QVariant> vals;
-//    qDebug() << kdLoc << "Copying" << tableDef->num_cols << "cols";
-        for (unsigned int i = 0; i < tableDef->num_cols; i++) {
-            MdbColumn *col = (MdbColumn*) g_ptr_array_index(tableDef->columns, i);
-
-            if (col->col_type == MDB_OLE && col->cur_value_len) {
-                mdb_ole_read(m_mdb, col, columnData[i], MDB_BIND_SIZE);
-            }
-
-            //! @todo: How to import binary data?
-            QVariant var = toQVariant(columnData[i], columnDataLength[i], col->col_type);
-            vals << var;
+    bool eof = false;
+    while (ok && !eof) {
+        //! Fetch a batch of records into the column arenas
+        for (ColumnArena &arena : arenas) {
+            arena.clear();
         }
-        updateProgress();
-        if (recordFilter && !(*recordFilter)(vals)) {
-            continue;
+        int count = 0;
+        while (count < MDB_RECORDS_PER_BATCH) {
+#ifdef KEXI_MIGRATION_MAX_ROWS_TO_IMPORT
+//! @todo this is risky when there are references between tables
+            if (rows++ == KEXI_MIGRATION_MAX_ROWS_TO_IMPORT) {
+                eof = true;
+                break;
+            }
+#endif
+            if (!mdb_fetch_row(tableDef)) {
+                eof = true;
+                break;
+            }
+            for (int i = 0; i < columnCount; i++) {
+                MdbColumn *col = (MdbColumn*) g_ptr_array_index(tableDef->columns, i);
+                ColumnArena *arena = &arenas[i];
+                if (columnTypes[i] == MDB_OLE && col->cur_value_len) {
+                    // Stream the whole value; the bound buffer initially contains a pointer
+                    // to the value that is overwritten by the first chunk
+                    char olePtr[MDB_MEMO_OVERHEAD];
+                    memcpy(olePtr, columnData[i].constData(), MDB_MEMO_OVERHEAD);
+                    arena->begin();
+                    size_t length = mdb_ole_read(m_mdb, col, olePtr, MDB_OLE_CHUNK_SIZE);
+                    while (length > 0) {
+                        arena->appendChunk(columnData[i].constData(), int(length));
+                        length = mdb_ole_read_next(m_mdb, col, olePtr);
+                    }
+                    arena->end();
+                } else if (columnDataLength[i] == 0) {
+                    arena->appendNull();
+                } else {
+                    arena->append(columnData[i].constData(), columnDataLength[i]);
+                }
+            }
+            ++count;
         }
-        if (!destConn->insertRecord(dstTable, vals)) {
-            ok = false;
+        if (count == 0) {
             break;
         }
 
-#ifdef KEXI_MIGRATION_MAX_ROWS_TO_IMPORT
-//! @todo this is risky when there are references between tables
-        if (++rows == KEXI_MIGRATION_MAX_ROWS_TO_IMPORT)
-            break;
-#endif
+        //! Convert values column by column
+        for (int i = 0; i < columnCount; i++) {
+            convertColumn(this, arenas[i], columnTypes[i], i, &records);
+        }
+        updateProgress(count);
+        for (int r = 0; r < count; ++r) {
+            if (recordFilter && !(*recordFilter)(records[r])) {
+                continue;
+            }
+            if (!inserter.insert(records[r])) {
+                ok = false;
+                break;
+            }
+        }
+    }
+    if (ok) {
+        ok = inserter.finish();
     }
 
-    // Deallocate (unbind) the DB columns arrays and column meta-data
-    for (unsigned int i = 0; i < tableDef->num_cols; i++) {
-        g_free(columnData[i]);
+    // Unbind the DB columns before their buffers are deallocated; mdb_bind_column()
+    // cannot be used for that as it ignores null pointers
+    for (int i = 0; i < columnCount; i++) {
+        MdbColumn *col = (MdbColumn*) g_ptr_array_index(tableDef->columns, i);
+        col->bind_ptr = nullptr;
+        col->len_ptr = nullptr;
     }
 
     // When memory leaks are better than seg. faults...
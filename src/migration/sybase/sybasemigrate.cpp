@@ -228,6 +228,10 @@ bool SybaseMigrate::drv_copyTable(const QString& srcTable, KDbConnection *destCo
         return false;
     }
 
+    RecordInserter inserter(this, destConn, dstTable);
+    if (!inserter.isValid()) {
+        return false;
+    }
     const KDbQueryColumnInfo::Vector fieldsExpanded(dstTable->query()->fieldsExpanded());
     RETCODE returnCode;
     while ((returnCode = dbnextrow(d->dbProcess)) != NO_MORE_ROWS) {
@@ -241,7 +245,7 @@ bool SybaseMigrate::drv_copyTable(const QString& srcTable, KDbConnection *destCo
         if (recordFilter && !(*recordFilter)(vals)) {
             continue;
         }
-        if (!destConn->insertRecord(*dstTable, vals)) {
+        if (!inserter.insert(vals)) {
             return false;
         }
     }
@@ -249,7 +253,7 @@ bool SybaseMigrate::drv_copyTable(const QString& srcTable, KDbConnection *destCo
     if (returnCode == FAIL) {
         return false;
     }
-    return true;
+    return inserter.finish();
 }
 
 bool SybaseMigrate::drv_getTableSize(const QString& table, quint64 *size)
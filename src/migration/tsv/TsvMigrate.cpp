@@ -121,6 +121,10 @@ bool TsvMigrate::drv_copyTable(const QString& srcTable, KDbConnection *destConn,
     if (!openFile(&info)) {
         return false;
     }
+    RecordInserter inserter(this, destConn, dstTable);
+    if (!inserter.isValid()) {
+        return false;
+    }
     Q_FOREVER {
         bool eof;
         QVector<QByteArray> line = readLine(&info, &eof);
@@ -134,11 +138,11 @@ bool TsvMigrate::drv_copyTable(const QString& srcTable, KDbConnection *destConn,
         if (recordFilter && !(*recordFilter)(vals)) {
             continue;
         }
-        if (!destConn->insertRecord(dstTable, vals)) {
+        if (!inserter.insert(vals)) {
             return false;
         }
     }
-    return true;
+    return inserter.finish();
 }
 
 bool TsvMigrate::drv_readTableSchema(const QString& originalName, KDbTableSchema *tableSchema)
@@ -213,6 +213,10 @@ bool xBaseMigrate::drv_copyTable(const QString& srcTable, KDbConnection *destCon
 
   xbLong numRecords = tableDbf->NoOfRecords();
 
+  RecordInserter inserter(this, destConn, dstTable);
+  if (!inserter.isValid()) {
+    return false;
+  }
   const KDbQueryColumnInfo::Vector fieldsExpanded( dstTable->query()->fieldsExpanded() );
   // records are indexed from 1
   for ( xbULong i = 1; i <= (xbULong)numRecords ; ++i ) {
@@ -282,12 +286,12 @@ bool xBaseMigrate::drv_copyTable(const QString& srcTable, KDbConnection *destCon
     if (recordFilter && !(*recordFilter)(vals)) {
         continue;
     }
-    if (!destConn->insertRecord(*dstTable, vals)) {
+    if (!inserter.insert(vals)) {
       return false;
     }
   }
 
-  return true;
+  return inserter.finish();
 }
 
 KDbField::Type KexiMigration::xBaseMigrate::type(char xBaseColumnType)
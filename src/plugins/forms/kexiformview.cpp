@@ -58,6 +58,7 @@
 #include <QApplication>
 #include <QScrollBar>
 #include <QDebug>
+#include <QXmlStreamReader>
 
 //! @todo #define KEXI_SHOW_SPLITTER_WIDGET
 
@@ -447,12 +448,38 @@ static void setUnsavedBLOBIdsForDataViewMode(
   }
 }
 
+//! Used in KexiFormView::loadForm()
+//! @return identifiers of stored BLOBs referenced by "storedPixmapId" properties of form @a data
+static QList<KexiBLOBBuffer::Id_t> storedBLOBIds(const QString &data)
+{
+    QList<KexiBLOBBuffer::Id_t> ids;
+    QXmlStreamReader xml(data);
+    while (!xml.atEnd()) {
+        if (xml.readNext() == QXmlStreamReader::StartElement
+            && xml.name() == QLatin1String("property")
+            && xml.attributes().value(QLatin1String("name")) == QLatin1String("storedPixmapId")
+            && xml.readNextStartElement()
+            && xml.name() == QLatin1String("number"))
+        {
+            bool ok;
+            const KexiBLOBBuffer::Id_t id = xml.readElementText().toLong(&ok);
+            if (ok && id > 0) {
+                ids.append(id);
+            }
+        }
+    }
+    return ids;
+}
+
 bool KexiFormView::loadForm()
 {
 //! @todo also load d->resizeMode
     //qDebug() << "Loading the form with id" << window()->id();
     // If we are previewing the Form, use the tempData instead of the form stored in the db
     if (viewMode() == Kexi::DataViewMode && !tempData()->tempForm.isNull()) {
+        // load images in a few queries instead of one query per image widget
+        const QList<KexiBLOBBuffer::Handle> blobs(
+            KexiBLOBBuffer::self()->prefetchObjects(storedBLOBIds(tempData()->tempForm)));
         if (!KFormDesigner::FormIO::loadFormFromString(form(), d->dbform, tempData()->tempForm)) {
             return false;
         }
@@ -468,6 +495,8 @@ bool KexiFormView::loadForm()
         if (!loadDataBlock(&data)) {
             return false;
         }
+        const QList<KexiBLOBBuffer::Handle> blobs(
+            KexiBLOBBuffer::self()->prefetchObjects(storedBLOBIds(data)));
         if (!KFormDesigner::FormIO::loadFormFromString(form(), d->dbform, data)) {
             return false;
         }
@@ -51,6 +51,8 @@
 #include <QMimeType>
 #include <QImageReader>
 #include <QDebug>
+#include <QRunnable>
+#include <QThreadPool>
 
 //! @internal
 struct KexiDBImageBox_Static {
@@ -62,6 +64,63 @@ struct KexiDBImageBox_Static {
 
 Q_GLOBAL_STATIC(KexiDBImageBox_Static, KexiDBImageBox_static)
 
+namespace {
+
+//! Decodes value of KexiDBImageBox in a thread of the global thread pool
+class DecodeValueTask : public QRunnable
+{
+public:
+    DecodeValueTask(KexiDBImageBox *box, int request, const QByteArray &data,
+                    const QSize &sizeLimit, bool keepAspectRatio)
+        : m_box(box), m_request(request), m_data(data), m_sizeLimit(sizeLimit)
+        , m_keepAspectRatio(keepAspectRatio)
+    {
+    }
+
+    void run() override {
+        QBuffer buffer(&m_data);
+        buffer.open(QIODevice::ReadOnly);
+        QImageReader reader(&buffer);
+        reader.setDecideFormatFromContent(true);
+        const QSize imageSize(reader.size());
+        if (m_sizeLimit.isValid() && imageSize.isValid()
+            && (imageSize.width() > m_sizeLimit.width() || imageSize.height() > m_sizeLimit.height()))
+        {
+            // decode directly to the display size, this is much faster for large JPEG photos
+            reader.setScaledSize(imageSize.scaled(
+                m_sizeLimit, m_keepAspectRatio ? Qt::KeepAspectRatio : Qt::IgnoreAspectRatio)
+                .expandedTo(QSize(1, 1)));
+        }
+        QImage image(reader.read());
+        if (image.isNull()) { // formats not recognized by contents, see KexiUtils::loadPixmapFromData()
+            for (const QByteArray &format : QImageReader::supportedImageFormats()) {
+                if (image.loadFromData(m_data, format.constData())) {
+                    break;
+                }
+            }
+        }
+        const QPointer<KexiDBImageBox> box(m_box);
+        const int request = m_request;
+        const QSize originalSize(image.isNull() || imageSize.isValid() ? imageSize : image.size());
+        QMetaObject::invokeMethod(qApp, [box, request, image, originalSize] {
+            if (box) { // still exists, checked in the GUI thread
+                QMetaObject::invokeMethod(box, "slotImageDecoded", Qt::DirectConnection,
+                                          Q_ARG(int, request), Q_ARG(QImage, image),
+                                          Q_ARG(QSize, originalSize));
+            }
+        }, Qt::QueuedConnection);
+    }
+
+private:
+    const QPointer<KexiDBImageBox> m_box;
+    const int m_request;
+    QByteArray m_data;
+    const QSize m_sizeLimit;
+    const bool m_keepAspectRatio;
+};
+
+} // namespace
+
 KexiDBImageBox::KexiDBImageBox(bool designMode, QWidget *parent)
         : KexiFrame(parent)
         , KexiFormDataItemInterface()
@@ -75,6 +134,9 @@ KexiDBImageBox::KexiDBImageBox(bool designMode, QWidget *parent)
         , m_paintEventEnabled(true)
         , m_dropDownButtonVisible(true)
         , m_insideSetPalette(false)
+        , m_decodingRequest(0)
+        , m_valueDecoding(false)
+        , m_pixmapScaledDown(false)
 {
     setDesignMode(designMode);
     installEventFilter(this);
@@ -118,6 +180,8 @@ KexiDBImageBox::KexiDBImageBox(bool designMode, QWidget *parent)
             this, SLOT(clear()));
     connect(m_contextMenu, SIGNAL(showPropertiesRequested()),
             this, SLOT(handleShowPropertiesAction()));
+    connect(KexiBLOBBuffer::self(), SIGNAL(pixmapDecoded(KexiBLOBBuffer::Id_t,bool)),
+            this, SLOT(slotPixmapDecoded(KexiBLOBBuffer::Id_t,bool)));
 
     KexiFrame::setLineWidth(0);
     setDataSource(QString());   //to initialize popup menu and actions availability
@@ -151,24 +215,91 @@ void KexiDBImageBox::setValueInternal(const QVariant& add, bool removeOld, bool
         m_value = add.toByteArray();
     else //do not add "m_origValue" to "add" as this is QByteArray
         m_value = KexiDataItemInterface::originalValue().toByteArray();
+    ++m_decodingRequest; // results of previous decoding are not needed
+    m_valueDecoding = false;
+    m_pixmapScaledDown = false;
     bool ok = !m_value.isEmpty();
     if (ok) {
         if (loadPixmap) {
-            ok = KexiUtils::loadPixmapFromData(&m_pixmap, m_value);
+            // decode in background so record navigation does not wait for decoding,
+            // a placeholder is displayed meanwhile
+            m_pixmap = QPixmap();
+            m_valueImageSize = QSize();
             m_currentScaledPixmap = QPixmap(); // clear cache
-        }
-        if (!ok) {
-            //! @todo inform about error?
+            decodeValueInBackground();
+        } else {
+            m_valueImageSize = m_pixmap.size();
         }
     }
     if (!ok) {
         m_valueMimeType.clear();
         m_pixmap = QPixmap();
+        m_valueImageSize = QSize();
         m_currentScaledPixmap = QPixmap(); // clear cache
     }
     repaint();
 }
 
+QSize KexiDBImageBox::decodedImageSizeLimit() const
+{
+    if (!m_scaledContents) {
+        return QSize(); // the image is not scaled down when painted
+    }
+    QMargins margins(contentsMargins());
+    margins += realLineWidth();
+    QSize limit(size() - QSize(margins.left() + margins.right(), margins.top() + margins.bottom()));
+    if (m_chooser && m_dropDownButtonVisible && !dataSource().isEmpty()) {
+        limit.setWidth(limit.width() - m_chooser->width());
+    }
+    return limit.isEmpty() ? QSize() : limit;
+}
+
+void KexiDBImageBox::decodeValueInBackground()
+{
+    m_valueDecoding = true;
+    QThreadPool::globalInstance()->start(
+        new DecodeValueTask(this, ++m_decodingRequest, m_value, decodedImageSizeLimit(),
+                            m_keepAspectRatio));
+}
+
+void KexiDBImageBox::slotImageDecoded(int request, const QImage& image, const QSize& imageSize)
+{
+    if (request != m_decodingRequest) {
+        return; // value has been changed meanwhile
+    }
+    m_valueDecoding = false;
+    if (image.isNull()) {
+        //! @todo inform about error?
+        m_valueMimeType.clear();
+        m_pixmap = QPixmap();
+        m_valueImageSize = QSize();
+    } else {
+        m_pixmap = QPixmap::fromImage(image);
+        m_valueImageSize = imageSize;
+        m_pixmapScaledDown = m_pixmap.size() != imageSize;
+        decodeValueAgainIfNeeded(); // the widget could be resized meanwhile
+    }
+    m_currentScaledPixmap = QPixmap(); // clear cache
+    update();
+}
+
+void KexiDBImageBox::decodeValueAgainIfNeeded()
+{
+    if (!m_pixmapScaledDown || m_valueDecoding) {
+        return;
+    }
+    const QSize limit(decodedImageSizeLimit());
+    if (limit.isValid()) {
+        const QSize neededSize(m_valueImageSize.scaled(
+            limit, m_keepAspectRatio ? Qt::KeepAspectRatio : Qt::IgnoreAspectRatio));
+        if (neededSize.width() <= m_pixmap.width() && neededSize.height() <= m_pixmap.height()) {
+            return; // large enough
+        }
+    }
+    // the current pixmap is displayed until the new one is decoded
+    decodeValueInBackground();
+}
+
 void KexiDBImageBox::setInvalidState(const QString& displayText)
 {
     Q_UNUSED(displayText);
@@ -210,6 +341,22 @@ QPixmap KexiDBImageBox::pixmap() const
         return m_data.pixmap();
     }
     //db-aware mode
+    if (m_valueDecoding || m_pixmapScaledDown) {
+        // full size is needed, e.g. for copying
+        QPixmap pixmap;
+        KexiUtils::loadPixmapFromData(&pixmap, m_value);
+        return pixmap;
+    }
+    return m_pixmap;
+}
+
+QPixmap KexiDBImageBox::displayedPixmap() const
+{
+    if (dataSource().isEmpty()) {
+        //not db-aware
+        return m_data.pixmap(KexiBLOBBuffer::PixmapDecoding::InBackground);
+    }
+    //db-aware mode
     return m_pixmap;
 }
 
@@ -254,6 +401,7 @@ void KexiDBImageBox::setScaledContents(bool set)
 {
 //! @todo m_pixmapLabel->setScaledContents(set);
     m_scaledContents = set;
+    decodeValueAgainIfNeeded();
     m_currentScaledPixmap = QPixmap();
     repaint();
 }
@@ -283,6 +431,7 @@ void KexiDBImageBox::setSmoothTransformation(bool set)
 void KexiDBImageBox::setKeepAspectRatio(bool set)
 {
     m_keepAspectRatio = set;
+    decodeValueAgainIfNeeded();
     m_currentScaledPixmap = QPixmap();
     if (m_scaledContents) {
         repaint();
@@ -567,6 +716,10 @@ void KexiDBImageBox::setDataSource(const QString &ds)
 
 QSize KexiDBImageBox::sizeHint() const
 {
+    if (!dataSource().isEmpty()) {
+        //db-aware mode
+        return m_valueImageSize.isValid() ? m_valueImageSize : QSize(80, 80);
+    }
     if (pixmap().isNull())
         return QSize(80, 80);
     return pixmap().size();
@@ -604,6 +757,25 @@ int KexiDBImageBox::realLineWidth() const
     }
 }
 
+//! Loads icons used by scaledImageBoxIcon()
+static void loadImageBoxIcons()
+{
+    if (!KexiDBImageBox_static->pixmap) {
+        const QIcon icon(KexiIcon("imagebox"));
+        KexiDBImageBox_static->pixmap = new QPixmap(
+            icon.pixmap(KIconLoader::SizeLarge, KIconLoader::SizeLarge, QIcon::Disabled));
+        if (!KexiDBImageBox_static->pixmap->isNull()) {
+            KIconEffect::semiTransparent(*KexiDBImageBox_static->pixmap);
+            KIconEffect::semiTransparent(*KexiDBImageBox_static->pixmap);
+        }
+        KexiDBImageBox_static->small = new QPixmap(
+            icon.pixmap(KIconLoader::SizeSmall, KIconLoader::SizeSmall, QIcon::Disabled));
+        if (!KexiDBImageBox_static->small->isNull()) {
+            KIconEffect::semiTransparent(*KexiDBImageBox_static->small); // once is enough for small
+        }
+    }
+}
+
 static QPixmap *scaledImageBoxIcon(const QMargins& margins, const QSize& size)
 {
     const int realHeight = size.height() - margins.top() - margins.bottom();
@@ -629,7 +801,8 @@ void KexiDBImageBox::paintEvent(QPaintEvent *pe)
     p.setClipRect(pe->rect());
     QMargins margins(contentsMargins());
     margins += realLineWidth();
-    if (designMode() && pixmap().isNull()) {
+    const QPixmap pixmapToDisplay(displayedPixmap());
+    if (designMode() && pixmapToDisplay.isNull()) {
         QRect r(
             QPoint(margins.left(), margins.top()),
             size() - QSize(margins.left() + margins.right(), margins.top() + margins.bottom()));
@@ -671,15 +844,26 @@ void KexiDBImageBox::paintEvent(QPaintEvent *pe)
             internalSize.setWidth(internalSize.width() - m_chooser->width());
 
         const QRect internalRect(QPoint(0, 0), internalSize);
-        if (m_currentScaledPixmap.isNull() || internalRect != m_currentRect) {
-            m_currentRect = internalRect;
-            m_currentPixmapPos = QPoint(0, 0);
-            m_currentScaledPixmap = KexiUtils::scaledPixmap(
-                margins, m_currentRect, pixmap(), &m_currentPixmapPos, m_alignment,
-                m_scaledContents, m_keepAspectRatio,
-                m_smoothTransformation ? Qt::SmoothTransformation : Qt::FastTransformation);
+        const bool decoding = dataSource().isEmpty() ? m_data.isPixmapBeingDecoded()
+                                                     : m_valueDecoding;
+        if (pixmapToDisplay.isNull() && decoding) {
+            // placeholder until the image is decoded
+            loadImageBoxIcons();
+            const QPixmap *placeholder = scaledImageBoxIcon(margins, internalSize);
+            if (placeholder) {
+                p.drawPixmap(internalRect.center() - placeholder->rect().center(), *placeholder);
+            }
+        } else {
+            if (m_currentScaledPixmap.isNull() || internalRect != m_currentRect) {
+                m_currentRect = internalRect;
+                m_currentPixmapPos = QPoint(0, 0);
+                m_currentScaledPixmap = KexiUtils::scaledPixmap(
+                    margins, m_currentRect, pixmapToDisplay, &m_currentPixmapPos, m_alignment,
+                    m_scaledContents, m_keepAspectRatio,
+                    m_smoothTransformation ? Qt::SmoothTransformation : Qt::FastTransformation);
+            }
+            p.drawPixmap(m_currentPixmapPos, m_currentScaledPixmap);
         }
-        p.drawPixmap(m_currentPixmapPos, m_currentScaledPixmap);
     }
     KexiFrame::drawFrame(&p);
 
@@ -705,23 +889,10 @@ void KexiDBImageBox::paintEvent(QPaintEvent *pe)
 
 void KexiDBImageBox::updatePixmap()
 {
-    if (!(designMode() && pixmap().isNull()))
+    if (!(designMode() && displayedPixmap().isNull()))
         return;
 
-    if (!KexiDBImageBox_static->pixmap) {
-        const QIcon icon(KexiIcon("imagebox"));
-        KexiDBImageBox_static->pixmap = new QPixmap(
-            icon.pixmap(KIconLoader::SizeLarge, KIconLoader::SizeLarge, QIcon::Disabled));
-        if (!KexiDBImageBox_static->pixmap->isNull()) {
-            KIconEffect::semiTransparent(*KexiDBImageBox_static->pixmap);
-            KIconEffect::semiTransparent(*KexiDBImageBox_static->pixmap);
-        }
-        KexiDBImageBox_static->small = new QPixmap(
-            icon.pixmap(KIconLoader::SizeSmall, KIconLoader::SizeSmall, QIcon::Disabled));
-        if (!KexiDBImageBox_static->small->isNull()) {
-            KIconEffect::semiTransparent(*KexiDBImageBox_static->small); // once is enough for small
-        }
-    }
+    loadImageBoxIcons();
 }
 
 void KexiDBImageBox::setAlignment(Qt::Alignment alignment)
@@ -743,9 +914,18 @@ void KexiDBImageBox::setData(const KexiBLOBBuffer::Handle& handle)
     update();
 }
 
+void KexiDBImageBox::slotPixmapDecoded(KexiBLOBBuffer::Id_t id, bool stored)
+{
+    if (m_data && m_data.id() == id && m_data.stored() == stored) {
+        m_currentScaledPixmap = QPixmap(); // clear cache
+        update();
+    }
+}
+
 void KexiDBImageBox::resizeEvent(QResizeEvent * e)
 {
     KexiFrame::resizeEvent(e);
+    decodeValueAgainIfNeeded();
     if (m_chooser) {
         QSize s(m_chooser->sizeHint());
         const int _realLineWidth = realLineWidth();
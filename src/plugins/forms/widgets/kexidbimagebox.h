@@ -28,6 +28,7 @@
 #include <kexiblobbuffer.h>
 
 #include <QContextMenuEvent>
+#include <QImage>
 #include <QPixmap>
 #include <QPaintEvent>
 #include <QPointer>
@@ -198,6 +199,13 @@ protected Q_SLOTS:
     virtual void clear() override;
     void handleShowPropertiesAction();
 
+    //! Repaints the widget if pixmap of its static data has been decoded in background
+    void slotPixmapDecoded(KexiBLOBBuffer::Id_t id, bool stored);
+
+    //! Displays \a image decoded in background for value of the db-aware mode.
+    //! \a imageSize is the original size of the image.
+    void slotImageDecoded(int request, const QImage& image, const QSize& imageSize);
+
 protected:
     //! \return data depending on the current mode (db-aware or static)
     QByteArray data() const;
@@ -218,6 +226,20 @@ protected:
     void updateActionStrings();
     void updatePixmap();
 
+    //! \return pixmap to paint, possibly scaled down or null while it is decoded
+    QPixmap displayedPixmap() const;
+
+    //! Starts decoding of value of the db-aware mode in background
+    void decodeValueInBackground();
+
+    //! \return maximum size of image needed to display value of the db-aware mode,
+    //! invalid size if the image should not be scaled down at decoding time
+    QSize decodedImageSizeLimit() const;
+
+    //! Decodes value of the db-aware mode again if it has been scaled down to a size
+    //! that is too small for the current settings
+    void decodeValueAgainIfNeeded();
+
     //! @internal
     void setData(const KexiBLOBBuffer::Handle& handle);
 
@@ -235,7 +257,7 @@ protected:
     //! Implemented for KexiSubwidgetInterface
     virtual bool subwidgetStretchRequired(KexiDBAutoField* autoField) const override;
 
-    QPixmap m_pixmap;
+    QPixmap m_pixmap; //!< for db-aware mode, possibly scaled down to display size
     QByteArray m_value; //!< for db-aware mode
     QString m_valueMimeType; //!< for db-aware mode
     KexiBLOBBuffer::Handle m_data;
@@ -248,6 +270,11 @@ protected:
     QRect m_currentRect;           //!< for caching
     QPoint m_currentPixmapPos;     //!< for caching
 
+    int m_decodingRequest; //!< incremented for each decoding of m_value started
+    QSize m_valueImageSize; //!< original size of image of m_value
+    bool m_valueDecoding; //!< true while m_value is decoded in background
+    bool m_pixmapScaledDown; //!< true if m_pixmap is smaller than image of m_value
+
     bool m_readOnly;
     bool m_scaledContents;
     bool m_smoothTransformation;
@@ -0,0 +1,429 @@
+/* This file is part of the KDE project
+   Copyright (C) 2026 Kexi developers <kexi-devel@kde.org>
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public License
+   along with this library; see the file COPYING.LIB.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+*/
+
+#include "KexiCSVExportEngine.h"
+
+#include <KDb>
+#include <KDbConnection>
+#include <KDbCursor>
+#include <KDbQuerySchema>
+
+#include <KLocalizedString>
+
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QIODevice>
+#include <QTextCodec>
+
+#include <cstring>
+
+//! The buffer is written to the device when it contains at least FLUSH_SIZE bytes
+#define FLUSH_SIZE (1024 * 1024)
+//! MIB enum of UTF-8, see QTextCodec::mibEnum()
+#define UTF8_MIB 106
+
+KexiCSVExportEngine::Options::Options()
+    : delimiter(QLatin1Char(','))
+    , textQuote(QLatin1Char('"'))
+    , addColumnNames(true)
+    , lineEnd("\r\n")
+    , codec(nullptr)
+{
+}
+
+// --
+
+//! @internal Properties of an exported column, cached for faster checks
+struct KexiCSVExportColumn
+{
+    int valueIndex; //!< Index of the cursor's value, differs for lookup fields
+    bool isText;
+    bool isDateTime;
+    bool isTime;
+    bool isBLOB;
+};
+
+class Q_DECL_HIDDEN KexiCSVExportEngine::Private
+{
+public:
+    Private(KDbConnection *c, KDbQuerySchema *q, const Options &opt)
+        : conn(c)
+        , query(q)
+        , options(opt)
+        , converterState(QTextCodec::IgnoreHeader)
+    {
+    }
+
+    //! @return pointer to the buffer where at least @a count bytes can be written
+    inline char *reserve(int count)
+    {
+        if (size + count > buffer.size()) {
+            buffer.resize(qMax(size + count, buffer.size() * 2));
+        }
+        return buffer.data() + size;
+    }
+
+    //! Writes UTF-8 encoded character @a c to @a out, @a next is set to the next character
+    static inline char *encode(char *out, const QChar *c, const QChar *end, const QChar **next)
+    {
+        const ushort u = c->unicode();
+        *next = c + 1;
+        if (u < 0x80) {
+            *out++ = char(u);
+        } else if (u < 0x800) {
+            *out++ = char(0xc0 | (u >> 6));
+            *out++ = char(0x80 | (u & 0x3f));
+        } else if (QChar::isSurrogate(u)) {
+            if (QChar::isHighSurrogate(u) && c + 1 < end && (c + 1)->isLowSurrogate()) {
+                const uint ucs4 = QChar::surrogateToUcs4(u, (c + 1)->unicode());
+                *out++ = char(0xf0 | (ucs4 >> 18));
+                *out++ = char(0x80 | ((ucs4 >> 12) & 0x3f));
+                *out++ = char(0x80 | ((ucs4 >> 6) & 0x3f));
+                *out++ = char(0x80 | (ucs4 & 0x3f));
+                *next = c + 2;
+            } else {
+                *out++ = '?'; // unpaired surrogate, the same as QString::toUtf8()
+            }
+        } else {
+            *out++ = char(0xe0 | (u >> 12));
+            *out++ = char(0x80 | ((u >> 6) & 0x3f));
+            *out++ = char(0x80 | (u & 0x3f));
+        }
+        return out;
+    }
+
+    void append(char c)
+    {
+        *reserve(1) = c;
+        ++size;
+    }
+
+    void append(const QByteArray &data)
+    {
+        std::memcpy(reserve(data.size()), data.constData(), size_t(data.size()));
+        size += data.size();
+    }
+
+    void append(QChar c)
+    {
+        const QChar *next;
+        size = int(encode(reserve(3), &c, &c + 1, &next) - buffer.constData());
+    }
+
+    //! Appends UTF-8 encoded @a text
+    void append(QStringView text)
+    {
+        char *out = reserve(text.size() * 3);
+        const QChar *end = text.end();
+        for (const QChar *c = text.begin(); c < end;) {
+            out = encode(out, c, end, &c);
+        }
+        size = int(out - buffer.constData());
+    }
+
+    //! Appends UTF-8 encoded @a text between text quotes, quotes inside are doubled
+    void appendQuoted(QStringView text)
+    {
+        const QChar quote = options.textQuote;
+        char *out = reserve(text.size() * 6 + 6);
+        const QChar *end = text.end();
+        const QChar *next;
+        out = encode(out, &quote, &quote + 1, &next);
+        for (const QChar *c = text.begin(); c < end;) {
+            if (*c == quote) {
+                out = encode(out, &quote, &quote + 1, &next);
+            }
+            out = encode(out, c, end, &c);
+        }
+        out = encode(out, &quote, &quote + 1, &next);
+        size = int(out - buffer.constData());
+    }
+
+    void appendText(QStringView text)
+    {
+        if (options.textQuote.isNull()) {
+            append(text);
+        } else {
+            appendQuoted(text);
+        }
+    }
+
+    //! Appends @a value formatted without creating temporary strings
+    void appendNumber(qint64 value)
+    {
+        char digits[24];
+        char *p = digits + sizeof(digits);
+        quint64 v = value < 0 ? 0 - quint64(value) : quint64(value);
+        do {
+            *--p = char('0' + v % 10);
+            v /= 10;
+        } while (v);
+        if (value < 0) {
+            *--p = '-';
+        }
+        const int count = int(digits + sizeof(digits) - p);
+        std::memcpy(reserve(count), p, size_t(count));
+        size += count;
+    }
+
+    //! Appends @a number of @a width digits, padded with zeros
+    void appendPadded(int number, int width)
+    {
+        char *out = reserve(width) + width;
+        for (int i = 0; i < width; ++i, number /= 10) {
+            *--out = char('0' + number % 10);
+        }
+        size += width;
+    }
+
+    //! Appends time in ISO format, hh:mm:ss
+    void appendTime(const QTime &time)
+    {
+        appendPadded(time.hour(), 2);
+        append(':');
+        appendPadded(time.minute(), 2);
+        append(':');
+        appendPadded(time.second(), 2);
+    }
+
+    //! Appends date and time in ISO format without "T", yyyy-MM-dd hh:mm:ss
+    void appendDateTime(const QDateTime &dateTime)
+    {
+        const QDate date(dateTime.date());
+        if (date.year() < 1 || date.year() > 9999) { // rare, let QDate handle it
+            append(QStringView(date.toString(Qt::ISODate)));
+        } else {
+            appendPadded(date.year(), 4);
+            append('-');
+            appendPadded(date.month(), 2);
+            append('-');
+            appendPadded(date.day(), 2);
+        }
+        append(' ');
+        if (dateTime.time().isValid()) {
+            appendTime(dateTime.time());
+        }
+    }
+
+    void appendValue(const KexiCSVExportColumn &column, const QVariant &value)
+    {
+        if (column.isText) {
+            appendText(QStringView(value.toString()));
+        } else if (column.isDateTime) { //avoid "T" in ISO DateTime
+            appendDateTime(value.toDateTime());
+        } else if (column.isTime) { //time is temporarily stored as null date + time...
+            const QTime time(value.toTime());
+            if (time.isValid()) {
+                appendTime(time);
+            }
+        } else if (column.isBLOB) { //BLOB is escaped in a special way
+//! @todo add options to suppport other types from KDbBLOBEscapingType enum...
+            const QString escaped(KDb::escapeBLOB(value.toByteArray(), KDb::BLOBEscapingType::Hex));
+            if (options.textQuote.isNull()) {
+                append(QStringView(escaped));
+            } else {
+                append(options.textQuote);
+                append(QStringView(escaped));
+                append(options.textQuote);
+            }
+        } else {//other types
+            switch (value.type()) {
+            case QVariant::Int:
+            case QVariant::LongLong:
+            case QVariant::UInt:
+                appendNumber(value.toLongLong());
+                break;
+            default:
+                append(QStringView(value.toString()));
+            }
+        }
+    }
+
+    KDbConnection * const conn;
+    KDbQuerySchema * const query;
+    const Options options;
+    QList<QVariant> queryParams;
+    QIODevice *device = nullptr;
+    QByteArray buffer; //!< UTF-8 encoded output, reused for all blocks
+    int size = 0; //!< Number of used bytes of the buffer
+    QTextCodec::ConverterState converterState; //!< Used if the output is not UTF-8
+    qint64 exportedRecordCount = 0;
+    qint64 bytesWritten = 0;
+    qint64 firstRecordElapsed = -1;
+    bool cancelled = false;
+};
+
+KexiCSVExportEngine::KexiCSVExportEngine(KDbConnection *conn, KDbQuerySchema *query,
+                                         const Options &options, QObject *parent)
+    : QObject(parent)
+    , d(new Private(conn, query, options))
+{
+}
+
+KexiCSVExportEngine::~KexiCSVExportEngine()
+{
+    delete d;
+}
+
+void KexiCSVExportEngine::setQueryParameters(const QList<QVariant> &params)
+{
+    d->queryParams = params;
+}
+
+qint64 KexiCSVExportEngine::exportedRecordCount() const
+{
+    return d->exportedRecordCount;
+}
+
+qint64 KexiCSVExportEngine::bytesWritten() const
+{
+    return d->bytesWritten;
+}
+
+qint64 KexiCSVExportEngine::firstRecordElapsed() const
+{
+    return d->firstRecordElapsed;
+}
+
+void KexiCSVExportEngine::cancel()
+{
+    d->cancelled = true;
+}
+
+bool KexiCSVExportEngine::flush()
+{
+    if (d->size == 0) {
+        return true;
+    }
+    qint64 written;
+    if (!d->options.codec || d->options.codec->mibEnum() == UTF8_MIB) {
+        written = d->device->write(d->buffer.constData(), d->size) == d->size ? d->size : -1;
+    } else {
+        // blocks end with complete records so no character is split between blocks
+        const QString text(QString::fromUtf8(d->buffer.constData(), d->size));
+        const QByteArray encoded(d->options.codec->fromUnicode(text.constData(), text.length(),
+                                                                &d->converterState));
+        written = d->device->write(encoded) == encoded.size() ? encoded.size() : -1;
+    }
+    d->size = 0;
+    if (written < 0) {
+        m_result = KDbResult(xi18n("Could not write data. %1", d->device->errorString()));
+        return false;
+    }
+    d->bytesWritten += written;
+    emit progress(d->bytesWritten);
+    return true;
+}
+
+tristate KexiCSVExportEngine::exportTo(QIODevice *device)
+{
+    clearResult();
+    QElapsedTimer elapsedTimer;
+    elapsedTimer.start();
+    d->device = device;
+    d->exportedRecordCount = 0;
+    d->bytesWritten = 0;
+    d->firstRecordElapsed = -1;
+    d->cancelled = false;
+    d->size = 0;
+    d->buffer.resize(FLUSH_SIZE + FLUSH_SIZE / 4);
+    d->converterState = QTextCodec::ConverterState(QTextCodec::IgnoreHeader);
+
+//! @todo OPTIMIZATION: use fieldsExpanded(true /*UNIQUE*/)
+    const KDbQueryColumnInfo::Vector fields(
+        d->query->fieldsExpanded(d->conn, KDbQuerySchema::FieldsExpandedMode::WithInternalFields));
+    const int fieldsCount = d->query->fieldsExpanded(d->conn).count(); //real fields count without internals
+    QVector<KexiCSVExportColumn> columns(fieldsCount);
+    for (int i = 0; i < fieldsCount; i++) {
+        KDbQueryColumnInfo* ci;
+        const int indexForVisibleLookupValue = fields[i]->indexForVisibleLookupValue();
+        if (-1 != indexForVisibleLookupValue) {
+            ci = d->query->expandedOrInternalField(d->conn, indexForVisibleLookupValue);
+            columns[i].valueIndex = indexForVisibleLookupValue;
+        } else {
+            ci = fields[i];
+            columns[i].valueIndex = i;
+        }
+
+        const KDbField::Type t = ci->field()->type(); // cache: evaluating type of expressions can be expensive
+        columns[i].isText = KDbField::isTextType(t);
+        columns[i].isDateTime = t == KDbField::DateTime;
+        columns[i].isTime = t == KDbField::Time;
+        columns[i].isBLOB = t == KDbField::BLOB;
+    }
+
+    // 1. Output column names
+    if (d->options.addColumnNames) {
+        for (int i = 0; i < fieldsCount; i++) {
+            if (i > 0) {
+                d->append(d->options.delimiter);
+            }
+            d->appendText(QStringView(fields[i]->captionOrAliasOrName()));
+        }
+        d->append(d->options.lineEnd);
+    }
+
+    // 2. Output records, the cursor is unbuffered so it only moves forward
+    KDbCursor *cursor = d->conn->executeQuery(d->query, d->queryParams);
+    if (!cursor) {
+        m_result = d->conn->result();
+        return false;
+    }
+    tristate result = true;
+    for (cursor->moveFirst(); !cursor->eof() && !cursor->result().isError(); cursor->moveNext()) {
+        if (d->cancelled) {
+            result = cancelled;
+            break;
+        }
+        if (d->exportedRecordCount == 0) {
+            d->firstRecordElapsed = elapsedTimer.elapsed();
+        }
+        const int realFieldCount = qMin(cursor->fieldCount(), fieldsCount);
+        for (int i = 0; i < realFieldCount; i++) {
+            if (i > 0) {
+                d->append(d->options.delimiter);
+            }
+            const QVariant value(cursor->value(columns[i].valueIndex));
+            if (!value.isNull()) {
+                d->appendValue(columns[i], value);
+            }
+        }
+        d->append(d->options.lineEnd);
+        ++d->exportedRecordCount;
+        if (d->size >= FLUSH_SIZE && !flush()) {
+            result = false;
+            break;
+        }
+    }
+    if (result == true && cursor->result().isError()) {
+        m_result = cursor->result();
+        result = false;
+    }
+    if (!d->conn->deleteCursor(cursor) && result == true) {
+        m_result = d->conn->result();
+        result = false;
+    }
+    if (result == true && !flush()) {
+        result = false;
+    }
+    d->device = nullptr;
+    d->buffer.clear();
+    d->size = 0;
+    return result;
+}
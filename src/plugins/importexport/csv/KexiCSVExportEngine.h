@@ -0,0 +1,98 @@
+/* This file is part of the KDE project
+   Copyright (C) 2026 Kexi developers <kexi-devel@kde.org>
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public License
+   along with this library; see the file COPYING.LIB.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+*/
+
+#ifndef KEXICSVEXPORTENGINE_H
+#define KEXICSVEXPORTENGINE_H
+
+#include <QObject>
+#include <QVariant>
+
+#include <KDbResult>
+#include <KDbTristate>
+
+class QIODevice;
+class QTextCodec;
+class KDbConnection;
+class KDbQuerySchema;
+
+//! @short GUI-independent engine exporting data of a table or query to CSV
+/*! Records are read one by one using an unbuffered (forward-only) cursor and encoded
+ directly into a reusable byte buffer, which is written to the output device in large
+ blocks. Memory use does not depend on the number of exported records and the records
+ are not counted before the export.
+
+ The engine does not process events. Connect to progress() and call cancel() to implement
+ user interface. */
+class KexiCSVExportEngine : public QObject, public KDbResultable
+{
+    Q_OBJECT
+public:
+    //! Options of the export, they mirror options of the CSV export wizard
+    class Options
+    {
+    public:
+        Options();
+
+        QChar delimiter;
+        QChar textQuote; //!< Null if values are not quoted
+        bool addColumnNames;
+        QByteArray lineEnd; //!< "\r\n" as in RFC 4180 by default
+        QTextCodec *codec; //!< Encoding of the output, UTF-8 if null
+    };
+
+    KexiCSVExportEngine(KDbConnection *conn, KDbQuerySchema *query,
+                        const Options &options, QObject *parent = nullptr);
+
+    virtual ~KexiCSVExportEngine();
+
+    //! Sets parameters of the query
+    void setQueryParameters(const QList<QVariant> &params);
+
+    //! Exports all records to @a device opened for writing.
+    //! @return true on success, false on failure and cancelled if cancel() has been called.
+    //! On failure result() contains error information.
+    tristate exportTo(QIODevice *device);
+
+    //! @return number of records written by the last exportTo()
+    qint64 exportedRecordCount() const;
+
+    //! @return number of bytes written by the last exportTo()
+    qint64 bytesWritten() const;
+
+    //! @return number of milliseconds from the start of the last exportTo() until
+    //! the first record has been read, -1 if there were no records
+    qint64 firstRecordElapsed() const;
+
+public Q_SLOTS:
+    //! Requests cancelling of the export in progress
+    void cancel();
+
+Q_SIGNALS:
+    //! Emitted after each block written to the device with number of bytes written so far
+    void progress(qint64 bytesWritten);
+
+private:
+    //! Writes the buffer to the device. @return false on failure.
+    bool flush();
+
+    class Private;
+    Private * const d;
+};
+
+#endif
@@ -0,0 +1,273 @@
+/* This file is part of the KDE project
+   Copyright (C) 2026 Kexi developers <kexi-devel@kde.org>
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public License
+   along with this library; see the file COPYING.LIB.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+*/
+
+#include "KexiCSVImportEngine.h"
+#include "KexiCSVReader.h"
+#include "KexiCSVValueParser.h"
+
+#include <KDbConnection>
+#include <KDbTableSchema>
+#include <KDbTransaction>
+
+#include <KLocalizedString>
+
+#include <QDateTime>
+#include <QElapsedTimer>
+
+#define MINIMUM_YEAR_FOR_100_YEAR_SLIDING_WINDOW 1930
+#define PROGRESS_STEP_MS (1000/5) // 5 updates per second
+
+KexiCSVImportEngine::Options::Options()
+    : startLine(0)
+    , firstRowForFieldNames(false)
+    , implicitPrimaryKey(false)
+    , trimmedInTextValues(true)
+    , nullsImportedAsEmptyText(true)
+    , dateFormat(AutoDateFormat)
+    , minimumYearFor100YearSlidingWindow(MINIMUM_YEAR_FOR_100_YEAR_SLIDING_WINDOW)
+    , recordsPerTransaction(0)
+{
+}
+
+// --
+
+class Q_DECL_HIDDEN KexiCSVImportEngine::Private
+{
+public:
+    Private(KDbConnection *c, KDbTableSchema *table, const Options &opt)
+        : conn(c)
+        , destinationTable(table)
+        , options(opt)
+        , stringNo(QLatin1String("no"))
+        , stringI18nNo(xi18n("no"))
+        , stringFalse(QLatin1String("false"))
+        , stringI18nFalse(xi18n("false"))
+    {
+        parser.setDateFormat(static_cast<KexiCSVValueParser::DateFormat>(options.dateFormat));
+        parser.setMinimumYearFor100YearSlidingWindow(options.minimumYearFor100YearSlidingWindow);
+    }
+
+    KDbConnection * const conn;
+    KDbTableSchema * const destinationTable;
+    const Options options;
+    QVector<KDbField::Type> columnTypes;
+    KDbPreparedStatement statement;
+    KDbPreparedStatementParameters values; //!< Record buffer reused for all rows
+    KDbTransaction transaction;
+    qint64 importedRecordCount = 0;
+    qint64 firstRecordElapsed = -1;
+    bool cancelled = false;
+    KexiCSVValueParser parser;
+    const QString stringNo, stringI18nNo, stringFalse, stringI18nFalse; //!< used for importing boolean values
+};
+
+KexiCSVImportEngine::KexiCSVImportEngine(KDbConnection *conn, KDbTableSchema *destinationTable,
+                                         const Options &options, QObject *parent)
+    : QObject(parent)
+    , d(new Private(conn, destinationTable, options))
+{
+}
+
+KexiCSVImportEngine::~KexiCSVImportEngine()
+{
+    delete d;
+}
+
+void KexiCSVImportEngine::setColumnTypes(const QVector<KDbField::Type> &types)
+{
+    d->columnTypes = types;
+}
+
+QVector<KDbField::Type> KexiCSVImportEngine::columnTypes() const
+{
+    return d->columnTypes;
+}
+
+qint64 KexiCSVImportEngine::importedRecordCount() const
+{
+    return d->importedRecordCount;
+}
+
+qint64 KexiCSVImportEngine::firstRecordElapsed() const
+{
+    return d->firstRecordElapsed;
+}
+
+void KexiCSVImportEngine::cancel()
+{
+    d->cancelled = true;
+}
+
+bool KexiCSVImportEngine::insertFailed(const KDbPreparedStatementParameters &values)
+{
+    Q_UNUSED(values)
+    return false;
+}
+
+bool KexiCSVImportEngine::beginTransaction()
+{
+    if (d->options.recordsPerTransaction <= 0) {
+        return true;
+    }
+    d->transaction = d->conn->beginTransaction();
+    if (d->transaction.isNull()) {
+        m_result = d->conn->result();
+        return false;
+    }
+    return true;
+}
+
+bool KexiCSVImportEngine::commitTransaction()
+{
+    if (d->transaction.isNull()) {
+        return true;
+    }
+    const bool ok = d->conn->commitTransaction(d->transaction);
+    d->transaction = KDbTransaction();
+    if (!ok) {
+        m_result = d->conn->result();
+    }
+    return ok;
+}
+
+void KexiCSVImportEngine::rollbackTransaction()
+{
+    if (!d->transaction.isNull()) {
+        d->conn->rollbackTransaction(d->transaction);
+        d->transaction = KDbTransaction();
+    }
+}
+
+void KexiCSVImportEngine::setValue(int index, int col, QStringView text)
+{
+    QVariant *value = &d->values[index];
+    const KDbField::Type type = d->columnTypes.value(col, KDbField::Text);
+    if (type == KDbField::Integer) {
+        int intValue;
+        *value = KexiCSVValueParser::parseInt(text, &intValue) ? QVariant(intValue) : QVariant();
+//! @todo what about time and float/double types and different integer subtypes?
+    } else if (type == KDbField::Double) {
+        double doubleValue;
+        *value = d->parser.parseDouble(text, &doubleValue) ? QVariant(doubleValue) : QVariant();
+    } else if (type == KDbField::Boolean) {
+        const QString t(text.trimmed().toString().toLower());
+        if (t.isEmpty())
+            *value = QVariant();
+        else if (t == QLatin1String("0") || t == d->stringNo || t == d->stringI18nNo
+                 || t == d->stringFalse || t == d->stringI18nFalse)
+            *value = QVariant(false);
+        else
+            *value = QVariant(true); //anything nonempty
+    } else if (type == KDbField::Date) {
+        QDate date;
+        *value = d->parser.parseDate(text, &date) ? QVariant(date) : QVariant();
+    } else if (type == KDbField::Time) {
+        QTime time;
+        *value = KexiCSVValueParser::parseTime(text, &time) ? QVariant(time) : QVariant();
+    } else if (type == KDbField::DateTime) {
+        QDateTime dateTime;
+        *value = d->parser.parseDateTime(text, &dateTime) ? QVariant(dateTime) : QVariant();
+    } else { // Text type and the rest
+        if (text.isEmpty()) {
+            //default value is empty string not null - otherwise querying data without knowing SQL is very confusing
+            *value = d->options.nullsImportedAsEmptyText ? QVariant(QString(QLatin1String(""))) : QVariant();
+        } else {
+            *value = (d->options.trimmedInTextValues ? text.trimmed() : text).toString();
+        }
+    }
+}
+
+tristate KexiCSVImportEngine::import(KexiCSVReader *reader)
+{
+    clearResult();
+    QElapsedTimer elapsedTimer;
+    elapsedTimer.start();
+    d->importedRecordCount = 0;
+    d->firstRecordElapsed = -1;
+    d->cancelled = false;
+    d->statement = d->conn->prepareStatement(KDbPreparedStatement::InsertStatement,
+                                             d->destinationTable);
+    if (!d->statement.isValid()) {
+        m_result = d->conn->result();
+        return false;
+    }
+    const int columnCount = d->columnTypes.count();
+    const int firstValue = d->options.implicitPrimaryKey ? 1 : 0; // id will be autogenerated here
+    d->values.clear();
+    for (int i = 0; i < firstValue + columnCount; ++i) {
+        d->values.append(QVariant());
+    }
+    // do not save rows skipped by the user and the row with column names
+    const int firstRowToImport = d->options.startLine + (d->options.firstRowForFieldNames ? 1 : 0);
+
+    if (!beginTransaction()) {
+        return false;
+    }
+    qint64 elapsedMs = 0;
+    int recordsInTransaction = 0;
+    for (int row = 0; reader->readRow(); ++row) {
+        if ((row % 0x100) == 0 && (elapsedMs + PROGRESS_STEP_MS) < elapsedTimer.elapsed()) {
+            elapsedMs = elapsedTimer.elapsed();
+            emit progress(reader->bytesRead());
+            if (d->cancelled) {
+                rollbackTransaction();
+                return cancelled;
+            }
+        }
+        if (row < firstRowToImport) {
+            continue;
+        }
+        const int fieldCount = qMin(reader->fieldCount(), columnCount);
+        for (int col = 0; col < fieldCount; ++col) {
+            setValue(firstValue + col, col, reader->field(col));
+        }
+        //fill remaining empty fields (database wants them explicitly)
+        for (int col = fieldCount; col < columnCount; ++col) {
+            if (d->options.nullsImportedAsEmptyText
+                && KDbField::isTextType(d->columnTypes[col]))
+            {
+                d->values[firstValue + col] = QString(QLatin1String(""));
+            } else {
+                d->values[firstValue + col] = QVariant();
+            }
+        }
+        if (d->statement.execute(d->values)) {
+            if (++d->importedRecordCount == 1) {
+                d->firstRecordElapsed = elapsedTimer.elapsed();
+            }
+        } else if (!insertFailed(d->values)) {
+            m_result = d->statement.result();
+            rollbackTransaction();
+            return false;
+        }
+        if (d->options.recordsPerTransaction > 0
+            && ++recordsInTransaction >= d->options.recordsPerTransaction)
+        {
+            if (!commitTransaction() || !beginTransaction()) {
+                return false;
+            }
+            recordsInTransaction = 0;
+        }
+    }
+    if (!commitTransaction()) {
+        return false;
+    }
+    emit progress(reader->bytesRead());
+    return true;
+}
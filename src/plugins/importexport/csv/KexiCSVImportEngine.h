@@ -0,0 +1,122 @@
+/* This file is part of the KDE project
+   Copyright (C) 2026 Kexi developers <kexi-devel@kde.org>
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public License
+   along with this library; see the file COPYING.LIB.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+*/
+
+#ifndef KEXICSVIMPORTENGINE_H
+#define KEXICSVIMPORTENGINE_H
+
+#include <QObject>
+#include <QVector>
+
+#include <KDbField>
+#include <KDbPreparedStatement>
+#include <KDbResult>
+#include <KDbTristate>
+
+class KDbConnection;
+class KDbTableSchema;
+class KexiCSVReader;
+
+//! @short GUI-independent engine importing CSV rows into a database table
+/*! Rows are pulled from KexiCSVReader, converted according to column types and inserted
+ using a single reusable prepared statement. When Options::recordsPerTransaction is
+ greater than zero, the engine commits a transaction every given number of records.
+ Otherwise the caller is responsible for transactions.
+
+ The engine does not process events. Connect to progress() and call cancel() to implement
+ user interface. */
+class KexiCSVImportEngine : public QObject, public KDbResultable
+{
+    Q_OBJECT
+public:
+    //! Options of the import, they mirror options of the CSV import dialog
+    class Options
+    {
+    public:
+        Options();
+
+        //! Date format values
+        enum DateFormat {
+            AutoDateFormat = 0, //!< auto
+            DMY = 1, //!< day-month-year
+            YMD = 2, //!< year-month-day
+            MDY = 3  //!< month-day-year
+        };
+
+        int startLine; //!< Number of rows to skip at the beginning
+        bool firstRowForFieldNames; //!< true if the first imported row contains column names
+        bool implicitPrimaryKey; //!< true if the destination table has autonumber primary key
+                                 //!< not present in the CSV data
+        bool trimmedInTextValues;
+        bool nullsImportedAsEmptyText;
+        DateFormat dateFormat;
+        //! The minimum year for the "100 year sliding date window"
+        int minimumYearFor100YearSlidingWindow;
+        //! Number of records inserted within a single transaction, 0 if transactions
+        //! are managed by the caller
+        int recordsPerTransaction;
+    };
+
+    KexiCSVImportEngine(KDbConnection *conn, KDbTableSchema *destinationTable,
+                        const Options &options, QObject *parent = nullptr);
+
+    virtual ~KexiCSVImportEngine();
+
+    //! Sets types of the CSV columns. Types of columns without assigned type are text.
+    void setColumnTypes(const QVector<KDbField::Type> &types);
+
+    QVector<KDbField::Type> columnTypes() const;
+
+    //! Imports all rows from @a reader.
+    //! @return true on success, false on failure and cancelled if cancel() has been called.
+    //! On failure result() contains error information.
+    tristate import(KexiCSVReader *reader);
+
+    //! @return number of records inserted by the last import()
+    qint64 importedRecordCount() const;
+
+    //! @return number of milliseconds from the start of the last import() until
+    //! the first record has been inserted, -1 if no record has been inserted
+    qint64 firstRecordElapsed() const;
+
+public Q_SLOTS:
+    //! Requests cancelling of the import in progress
+    void cancel();
+
+Q_SIGNALS:
+    //! Emitted periodically during import with number of bytes processed so far
+    void progress(qint64 bytesProcessed);
+
+protected:
+    //! Called when inserting record @a values failed.
+    //! @return true if the import should continue. The default implementation returns false.
+    virtual bool insertFailed(const KDbPreparedStatementParameters &values);
+
+private:
+    //! Converts @a text to a value for column @a col and stores it at @a index of the record buffer
+    void setValue(int index, int col, QStringView text);
+
+    bool beginTransaction();
+    bool commitTransaction();
+    void rollbackTransaction();
+
+    class Private;
+    Private * const d;
+};
+
+#endif
@@ -0,0 +1,306 @@
+/* This file is part of the KDE project
+   Copyright (C) 2026 Kexi developers <kexi-devel@kde.org>
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public License
+   along with this library; see the file COPYING.LIB.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+*/
+
+#include "KexiCSVReader.h"
+#include "KexiCSVScanner.h"
+
+#include <QIODevice>
+#include <QTextCodec>
+#include <QTextDecoder>
+
+#define DEFAULT_BLOCK_SIZE (1024 * 1024) // 1MB is large enough to be limited by disk throughput
+#define BYTE_ORDER_MARK 0xfeff
+
+KexiCSVReader::Options::Options()
+    : delimiter(QLatin1Char(','))
+    , textQuote(QLatin1Char('"'))
+    , ignoreDuplicateDelimiters(false)
+    , codec(nullptr)
+    , blockSize(DEFAULT_BLOCK_SIZE)
+{
+}
+
+// --
+
+class Q_DECL_HIDDEN KexiCSVReader::Private
+{
+public:
+    Private(QIODevice *dev, const Options &opt)
+        : device(dev)
+        , options(opt)
+        , quoteEnabled(!opt.textQuote.isNull())
+        , commentsEnabled(!opt.commentSymbol.isNull())
+        , delimiter(opt.delimiter.unicode())
+        , quote(quoteEnabled ? opt.textQuote.unicode() : delimiter)
+        , comment(commentsEnabled ? opt.commentSymbol.unicode() : delimiter)
+        , findAnyOf(KexiCSVScanner::findAnyOfFunction())
+    {
+    }
+
+    ~Private() {
+        delete decoder;
+    }
+
+    inline bool isQuote(QChar c) const {
+        return quoteEnabled && c.unicode() == quote;
+    }
+
+    inline bool isComment(QChar c) const {
+        return commentsEnabled && c.unicode() == comment;
+    }
+
+    QIODevice * const device;
+    const Options options;
+    const bool quoteEnabled;
+    const bool commentsEnabled;
+    //! Structural characters; disabled ones are replaced by the delimiter
+    //! so they can be passed to findAnyOf() unconditionally
+    const ushort delimiter;
+    const ushort quote;
+    const ushort comment;
+    const KexiCSVScanner::FindAnyOfFunction findAnyOf;
+    QTextDecoder *decoder = nullptr;
+    QByteArray block; //!< Raw bytes of the current block
+    QString buffer; //!< Decoded characters of the current block
+    int pos = 0; //!< Current offset within the buffer
+    qint64 consumedBefore = 0; //!< Number of characters in the previous blocks
+    qint64 bytesRead = 0;
+    bool wasCR = false; //!< true if previous line ended with '\r', so '\n' should be eaten
+    bool rowTerminated = false;
+};
+
+KexiCSVReader::KexiCSVReader(QIODevice *device, const Options &options)
+    : d(new Private(device, options))
+{
+}
+
+KexiCSVReader::KexiCSVReader(const QString &data, const Options &options)
+    : d(new Private(nullptr, options))
+{
+    d->buffer = data;
+    if (!d->buffer.isEmpty() && d->buffer.at(0).unicode() == BYTE_ORDER_MARK) {
+        d->pos = 1;
+    }
+}
+
+KexiCSVReader::~KexiCSVReader()
+{
+    delete d;
+}
+
+bool KexiCSVReader::isRowTerminated() const
+{
+    return d->rowTerminated;
+}
+
+qint64 KexiCSVReader::charactersRead() const
+{
+    return d->consumedBefore + d->pos;
+}
+
+qint64 KexiCSVReader::bytesRead() const
+{
+    return d->device ? d->bytesRead : charactersRead();
+}
+
+bool KexiCSVReader::ensureData()
+{
+    if (d->pos < d->buffer.length()) {
+        return true;
+    }
+    if (!d->device) {
+        return false;
+    }
+    d->consumedBefore += d->buffer.length();
+    d->pos = 0;
+    d->buffer.resize(0);
+    if (d->block.size() != d->options.blockSize) {
+        d->block.resize(qMax(d->options.blockSize, 16));
+    }
+    while (true) {
+        const qint64 size = d->device->read(d->block.data(), d->block.size());
+        if (size <= 0) {
+            return false;
+        }
+        if (!d->decoder) {
+            // Like QTextStream, prefer encoding found in the byte order mark if there is one
+            QTextCodec *codec = d->options.codec ? d->options.codec : QTextCodec::codecForLocale();
+            codec = QTextCodec::codecForUtfText(QByteArray::fromRawData(d->block.constData(), int(size)),
+                                                codec);
+            d->decoder = codec->makeDecoder();
+        }
+        const bool firstBlock = d->bytesRead == 0;
+        d->bytesRead += size;
+        d->decoder->toUnicode(&d->buffer, d->block.constData(), int(size));
+        if (firstBlock && !d->buffer.isEmpty() && d->buffer.at(0).unicode() == BYTE_ORDER_MARK) {
+            d->pos = 1;
+        }
+        if (d->pos < d->buffer.length()) {
+            return true;
+        }
+        // only an incomplete multibyte sequence was read, continue
+    }
+}
+
+void KexiCSVReader::skipToEndOfLine()
+{
+    while (ensureData()) {
+        const QChar *data = d->buffer.constData();
+        const int size = d->buffer.length();
+        d->pos = d->findAnyOf(data, d->pos, size, '\n', '\r', '\n', '\r');
+        if (d->pos < size) {
+            d->wasCR = data[d->pos] == QLatin1Char('\r');
+            ++d->pos;
+            return;
+        }
+    }
+}
+
+bool KexiCSVReader::readRow()
+{
+    enum { S_START, S_QUOTED_FIELD, S_MAYBE_END_OF_QUOTED_FIELD, S_END_OF_QUOTED_FIELD,
+           S_MAYBE_NORMAL_FIELD, S_NORMAL_FIELD
+         } state = S_START;
+    m_rowData.resize(0); // keeps capacity
+    m_fieldEnds.resize(0);
+    const bool ignoreDups = d->options.ignoreDuplicateDelimiters;
+    const QChar delimiter(d->options.delimiter);
+    bool lastCharDelimiter = false;
+    bool rowStarted = false;
+    d->rowTerminated = false;
+
+    // Called after end of line or comment character @a c is consumed
+    auto finishRow = [this](QChar c) {
+        d->rowTerminated = true;
+        if (c == QLatin1Char('\r')) {
+            d->wasCR = true;
+        } else if (d->isComment(c)) {
+            skipToEndOfLine();
+        }
+    };
+
+    while (true) {
+        if (!ensureData()) {
+            if (!rowStarted) {
+                return false; // finish!
+            }
+            // simulate missing end of line at end of data
+            if (state != S_START || !(ignoreDups && lastCharDelimiter)) {
+                endField();
+            }
+            return true;
+        }
+        const QChar *data = d->buffer.constData();
+        const int size = d->buffer.length();
+        if (d->wasCR) {
+            d->wasCR = false;
+            if (data[d->pos] == QLatin1Char('\n')) {
+                ++d->pos;
+                continue; // previous character was '\r', eat '\n'
+            }
+        }
+        const QChar x = data[d->pos];
+        rowStarted = true;
+
+        switch (state) {
+        case S_START:
+            ++d->pos;
+            if (d->isQuote(x)) {
+                state = S_QUOTED_FIELD;
+            } else if (x == delimiter) {
+                if (!ignoreDups || !lastCharDelimiter) {
+                    endField(); // empty field
+                }
+                lastCharDelimiter = true;
+            } else if (x == QLatin1Char('\n') || x == QLatin1Char('\r') || d->isComment(x)) {
+                if (m_fieldEnds.isEmpty() && d->isComment(x)) {
+                    // the whole line is a comment, do not make a row out of it
+                    skipToEndOfLine();
+                    rowStarted = false;
+                    break;
+                }
+                if (!ignoreDups || !lastCharDelimiter) {
+                    endField();
+                } // else: we're ignoring repeated delimiters so remove any extra trailing delimiters
+                finishRow(x);
+                return true;
+            } else {
+                m_rowData.append(x);
+                state = S_MAYBE_NORMAL_FIELD;
+            }
+            break;
+        case S_QUOTED_FIELD: {
+            // copy everything up to the next quote at once, end of lines are allowed here
+            const int stop = d->findAnyOf(data, d->pos, size, d->quote, d->quote, d->quote, d->quote);
+            m_rowData.append(data + d->pos, stop - d->pos);
+            d->pos = stop;
+            if (stop < size) {
+                ++d->pos;
+                state = S_MAYBE_END_OF_QUOTED_FIELD;
+            }
+            break;
+        }
+        case S_MAYBE_END_OF_QUOTED_FIELD:
+        case S_END_OF_QUOTED_FIELD:
+            ++d->pos;
+            if (state == S_MAYBE_END_OF_QUOTED_FIELD && d->isQuote(x)) {
+                m_rowData.append(x); // no, this was just escaped quote character
+                state = S_QUOTED_FIELD;
+            } else if (x == delimiter) {
+                endField();
+                lastCharDelimiter = true;
+                state = S_START;
+            } else if (x == QLatin1Char('\n') || x == QLatin1Char('\r') || d->isComment(x)) {
+                endField();
+                finishRow(x);
+                return true;
+            } else {
+                state = S_END_OF_QUOTED_FIELD; // characters after closing quote are ignored
+            }
+            break;
+        case S_MAYBE_NORMAL_FIELD:
+            if (d->isQuote(x)) {
+                m_rowData.truncate(m_fieldEnds.isEmpty() ? 0 : m_fieldEnds.last());
+                ++d->pos;
+                state = S_QUOTED_FIELD;
+                break;
+            }
+            state = S_NORMAL_FIELD;
+            Q_FALLTHROUGH();
+        case S_NORMAL_FIELD: {
+            // copy everything up to the next structural character at once
+            const int stop = d->findAnyOf(data, d->pos, size, d->delimiter, '\n', '\r', d->comment);
+            m_rowData.append(data + d->pos, stop - d->pos);
+            d->pos = stop;
+            if (stop == size) {
+                break; // continue with the next block
+            }
+            const QChar c = data[d->pos++];
+            endField();
+            if (c == delimiter) {
+                lastCharDelimiter = true;
+                state = S_START;
+                break;
+            }
+            finishRow(c);
+            return true;
+        }
+        }
+    }
+}
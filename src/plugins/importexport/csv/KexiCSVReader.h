@@ -0,0 +1,115 @@
+/* This file is part of the KDE project
+   Copyright (C) 2026 Kexi developers <kexi-devel@kde.org>
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public License
+   along with this library; see the file COPYING.LIB.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+*/
+
+#ifndef KEXICSVREADER_H
+#define KEXICSVREADER_H
+
+#include <QString>
+#include <QStringView>
+#include <QVector>
+
+class QIODevice;
+class QTextCodec;
+
+//! @short Block-based, GUI-independent reader of CSV rows
+/*! The reader pulls data from a device in large blocks, decodes them at once and runs
+ the quote/delimiter state machine over the decoded buffer. Runs of characters that
+ cannot change the state are found using KexiCSVScanner and copied into the row buffer
+ in one step.
+
+ Fields of the current row are available as views into an internal buffer that
+ is reused for all rows, so they are only valid until the next readRow() call.
+
+ Usage:
+ @code
+ KexiCSVReader reader(&file, options);
+ while (reader.readRow()) {
+     for (int i = 0; i < reader.fieldCount(); ++i) {
+         qDebug() << reader.field(i);
+     }
+ }
+ @endcode */
+class KexiCSVReader
+{
+public:
+    //! Options of the CSV parser
+    class Options
+    {
+    public:
+        Options();
+
+        QChar delimiter;
+        QChar textQuote; //!< Null character means no quoting
+        QChar commentSymbol; //!< Null character means no comments
+        bool ignoreDuplicateDelimiters;
+        QTextCodec *codec; //!< Codec for decoding the device; the locale codec if null
+        int blockSize; //!< Number of bytes read from the device at once
+    };
+
+    //! Creates reader for @a device opened for reading. The device is not owned.
+    KexiCSVReader(QIODevice *device, const Options &options);
+
+    //! Creates reader for already decoded @a data, e.g. clipboard contents.
+    KexiCSVReader(const QString &data, const Options &options);
+
+    ~KexiCSVReader();
+
+    //! Reads the next row. @return false at the end of data.
+    //! Lines containing only a comment are skipped.
+    bool readRow();
+
+    //! @return number of fields in the current row
+    inline int fieldCount() const { return m_fieldEnds.count(); }
+
+    //! @return field @a index of the current row, valid until the next readRow() call
+    inline QStringView field(int index) const {
+        const int start = index == 0 ? 0 : m_fieldEnds[index - 1];
+        return QStringView(m_rowData.constData() + start, m_fieldEnds[index] - start);
+    }
+
+    //! @return true if the current row has been ended by end of line,
+    //! false if it has been ended by end of data
+    bool isRowTerminated() const;
+
+    //! @return number of decoded characters consumed so far
+    qint64 charactersRead() const;
+
+    //! @return number of bytes read from the device so far
+    //! (number of consumed characters for readers created for decoded data)
+    qint64 bytesRead() const;
+
+private:
+    Q_DISABLE_COPY(KexiCSVReader)
+
+    //! Makes sure the current block has unconsumed characters. @return false at the end.
+    bool ensureData();
+
+    //! Closes the current field.
+    inline void endField() { m_fieldEnds.append(m_rowData.length()); }
+
+    //! Skips characters up to and including the end of line.
+    void skipToEndOfLine();
+
+    class Private;
+    Private * const d;
+    QString m_rowData; //!< Contents of all fields of the current row
+    QVector<int> m_fieldEnds; //!< End offsets of fields within m_rowData
+};
+
+#endif
@@ -0,0 +1,165 @@
+/* This file is part of the KDE project
+   Copyright (C) 2026 Kexi developers <kexi-devel@kde.org>
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public License
+   along with this library; see the file COPYING.LIB.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+*/
+
+#include "KexiCSVScanner.h"
+
+#include <QtAlgorithms>
+#include <QtGlobal>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+# define KEXICSV_HAVE_SSE2
+# include <emmintrin.h>
+// AVX2 code is compiled with the target attribute so the rest of the code does not require AVX2
+# if defined(Q_CC_GNU) && !defined(Q_CC_INTEL)
+#  define KEXICSV_HAVE_AVX2
+#  include <immintrin.h>
+# endif
+#endif
+
+static int findAnyOfScalar(const QChar *data, int from, int to, ushort a, ushort b, ushort c,
+                           ushort d)
+{
+    for (; from < to; ++from) {
+        const ushort x = data[from].unicode();
+        if (x == a || x == b || x == c || x == d) {
+            break;
+        }
+    }
+    return from;
+}
+
+#ifdef KEXICSV_HAVE_SSE2
+static int findAnyOfSSE2(const QChar *data, int from, int to, ushort a, ushort b, ushort c,
+                         ushort d)
+{
+    const __m128i va = _mm_set1_epi16(short(a));
+    const __m128i vb = _mm_set1_epi16(short(b));
+    const __m128i vc = _mm_set1_epi16(short(c));
+    const __m128i vd = _mm_set1_epi16(short(d));
+    for (; from + 8 <= to; from += 8) {
+        const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + from));
+        const __m128i found = _mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi16(chunk, va), _mm_cmpeq_epi16(chunk, vb)),
+            _mm_or_si128(_mm_cmpeq_epi16(chunk, vc), _mm_cmpeq_epi16(chunk, vd)));
+        const uint mask = uint(_mm_movemask_epi8(found));
+        if (mask) {
+            return from + int(qCountTrailingZeroBits(mask) / 2); // two mask bits per character
+        }
+    }
+    return findAnyOfScalar(data, from, to, a, b, c, d);
+}
+#endif
+
+#ifdef KEXICSV_HAVE_AVX2
+__attribute__((target("avx2")))
+static int findAnyOfAVX2(const QChar *data, int from, int to, ushort a, ushort b, ushort c,
+                         ushort d)
+{
+    const __m256i va = _mm256_set1_epi16(short(a));
+    const __m256i vb = _mm256_set1_epi16(short(b));
+    const __m256i vc = _mm256_set1_epi16(short(c));
+    const __m256i vd = _mm256_set1_epi16(short(d));
+    for (; from + 16 <= to; from += 16) {
+        const __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + from));
+        const __m256i found = _mm256_or_si256(
+            _mm256_or_si256(_mm256_cmpeq_epi16(chunk, va), _mm256_cmpeq_epi16(chunk, vb)),
+            _mm256_or_si256(_mm256_cmpeq_epi16(chunk, vc), _mm256_cmpeq_epi16(chunk, vd)));
+        const uint mask = uint(_mm256_movemask_epi8(found));
+        if (mask) {
+            return from + int(qCountTrailingZeroBits(mask) / 2); // two mask bits per character
+        }
+    }
+    return findAnyOfSSE2(data, from, to, a, b, c, d);
+}
+#endif
+
+//! @return the best implementation supported by the CPU
+static KexiCSVScanner::Implementation detectImplementation()
+{
+#ifdef KEXICSV_HAVE_AVX2
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return KexiCSVScanner::AVX2;
+    }
+#endif
+#ifdef KEXICSV_HAVE_SSE2
+    return KexiCSVScanner::SSE2;
+#else
+    return KexiCSVScanner::Scalar;
+#endif
+}
+
+static KexiCSVScanner::FindAnyOfFunction functionFor(KexiCSVScanner::Implementation implementation)
+{
+    switch (implementation) {
+#ifdef KEXICSV_HAVE_AVX2
+    case KexiCSVScanner::AVX2:
+        return &findAnyOfAVX2;
+#endif
+#ifdef KEXICSV_HAVE_SSE2
+    case KexiCSVScanner::SSE2:
+        return &findAnyOfSSE2;
+#endif
+    default:
+        break;
+    }
+    return &findAnyOfScalar;
+}
+
+//! @internal Currently used implementation
+class KexiCSVScannerStatic
+{
+public:
+    KexiCSVScannerStatic()
+        : bestImplementation(detectImplementation())
+        , implementation(bestImplementation)
+        , findAnyOf(functionFor(implementation))
+    {
+    }
+    const KexiCSVScanner::Implementation bestImplementation;
+    KexiCSVScanner::Implementation implementation;
+    KexiCSVScanner::FindAnyOfFunction findAnyOf;
+};
+
+Q_GLOBAL_STATIC(KexiCSVScannerStatic, kexiCSVScannerStatic)
+
+bool KexiCSVScanner::isSupported(Implementation implementation)
+{
+    return implementation <= kexiCSVScannerStatic->bestImplementation;
+}
+
+KexiCSVScanner::Implementation KexiCSVScanner::implementation()
+{
+    return kexiCSVScannerStatic->implementation;
+}
+
+bool KexiCSVScanner::setImplementation(Implementation implementation)
+{
+    if (!isSupported(implementation)) {
+        return false;
+    }
+    kexiCSVScannerStatic->implementation = implementation;
+    kexiCSVScannerStatic->findAnyOf = functionFor(implementation);
+    return true;
+}
+
+KexiCSVScanner::FindAnyOfFunction KexiCSVScanner::findAnyOfFunction()
+{
+    return kexiCSVScannerStatic->findAnyOf;
+}
@@ -0,0 +1,61 @@
+/* This file is part of the KDE project
+   Copyright (C) 2026 Kexi developers <kexi-devel@kde.org>
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public License
+   along with this library; see the file COPYING.LIB.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+*/
+
+#ifndef KEXICSVSCANNER_H
+#define KEXICSVSCANNER_H
+
+#include <QChar>
+
+//! @short Search for structural characters of CSV data
+/*! KexiCSVReader uses the scanner to skip whole runs of ordinary characters, so its state
+ machine only runs at delimiters, quotes and end of lines. Vectorized implementations
+ compare 8 (SSE2) or 16 (AVX2) characters at once; the best one supported by the CPU
+ is selected at runtime. */
+namespace KexiCSVScanner
+{
+
+//! Implementations of the scanner
+enum Implementation {
+    Scalar, //!< Character by character, available everywhere
+    SSE2,   //!< 16-byte strides
+    AVX2    //!< 32-byte strides
+};
+
+/*! Type of function returning offset of the first character within <from, to) of @a data
+ that is equal to one of @a a, @a b, @a c, @a d, or @a to if there is no such character.
+ Pass the same character more than once if less than four characters are searched. */
+typedef int (*FindAnyOfFunction)(const QChar *data, int from, int to,
+                                 ushort a, ushort b, ushort c, ushort d);
+
+//! @return true if @a implementation is compiled in and supported by the CPU
+bool isSupported(Implementation implementation);
+
+//! @return implementation used by findAnyOfFunction()
+Implementation implementation();
+
+//! Forces use of @a implementation, e.g. for benchmarks.
+//! @return false if it is not supported; the current implementation is then kept.
+bool setImplementation(Implementation implementation);
+
+//! @return function implementing search using the current implementation
+FindAnyOfFunction findAnyOfFunction();
+
+}
+
+#endif
@@ -0,0 +1,568 @@
+/* This file is part of the KDE project
+   Copyright (C) 2026 Kexi developers <kexi-devel@kde.org>
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public License
+   along with this library; see the file COPYING.LIB.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+*/
+
+#include "KexiCSVTypeDetector.h"
+
+#include <QBuffer>
+#include <QFile>
+#include <QMutex>
+#include <QRunnable>
+#include <QTextCodec>
+#include <QThread>
+#include <QThreadPool>
+
+#include <cstring>
+#include <limits>
+
+//! Files smaller than two chunks are scanned by a single thread
+#define MINIMUM_CHUNK_SIZE (8 * 1024 * 1024)
+//! Number of chunks per thread, more chunks balance the load better
+#define CHUNKS_PER_THREAD 4
+//! Cancellation is checked every CANCEL_CHECK_ROWS rows
+#define CANCEL_CHECK_ROWS 0x400
+//! Maximum number of values stored for checking uniqueness, shared by all columns
+//! and chunks; about 16 bytes are used per value, so 16 MB at most.
+//! Above the limit uniqueness is estimated.
+#define UNIQUENESS_MAXIMUM_SIZE (1024 * 1024)
+//! Each column of each chunk can store at least this number of values
+#define UNIQUENESS_MINIMUM_SIZE 256
+
+//! @return types non-empty @a text can be converted to using @a parser;
+//! @a intValue is set if the text is an integer
+static KexiCSVTypeDetector::PossibleTypes possibleTypes(const KexiCSVValueParser &parser,
+                                                        QStringView text, int *intValue)
+{
+    if (KexiCSVValueParser::parseInt(text, intValue)) {
+        return KexiCSVTypeDetector::IntegerType | KexiCSVTypeDetector::DoubleType;
+    }
+    double doubleValue;
+    if (parser.parseDouble(text, &doubleValue)) {
+        return KexiCSVTypeDetector::DoubleType;
+    }
+    QDate date;
+    if (parser.parseDate(text, &date)) {
+        return KexiCSVTypeDetector::DateType;
+    }
+    QTime time;
+    if (KexiCSVValueParser::parseTime(text, &time)) {
+        return KexiCSVTypeDetector::TimeType;
+    }
+    QDateTime dateTime;
+    if (parser.parseDateTime(text, &dateTime)) {
+        return KexiCSVTypeDetector::DateTimeType;
+    }
+    return KexiCSVTypeDetector::PossibleTypes();
+}
+
+//! @internal Results of scanning a single chunk
+class KexiCSVTypeDetectorChunk
+{
+public:
+    qint64 begin = 0; //!< Offset of the first byte of the chunk
+    qint64 end = 0; //!< Offset after the last byte of the chunk
+    QVector<KexiCSVTypeDetector::PossibleTypes> possibleTypes; //!< Intersection for each column
+    QVector<bool> hasValues; //!< true for columns with at least one non-empty value
+    QVector<KexiCSVUniquenessTracker> uniqueness;
+    qint64 rowCount = 0;
+    bool endsWithCompleteRow = true; //!< false if the split was inside a quoted field
+};
+
+class Q_DECL_HIDDEN KexiCSVTypeDetector::Private
+{
+public:
+    explicit Private(KexiCSVTypeDetector *qq, const KexiCSVReader::Options &opt)
+        : q(qq)
+        , options(opt)
+    {
+    }
+
+    //! @return true if end of lines and quotes of the file can be found in raw bytes
+    bool canSplit(const uchar *data, qint64 size) const;
+
+    //! Splits @a size bytes of @a data into chunks starting at beginnings of rows.
+    //! @return false if the data cannot be split into chunks small enough for QByteArray.
+    bool split(const uchar *data, qint64 size);
+
+    //! Called by the task that finished scanning the last chunk
+    void chunksFinished();
+
+    KexiCSVTypeDetector * const q;
+    const KexiCSVReader::Options options;
+    KexiCSVValueParser parser;
+    int skippedRows = 0;
+    QThreadPool pool;
+    QAtomicInt canceled;
+    QAtomicInt pendingChunks;
+    QFile file;
+    const uchar *mappedData = nullptr;
+    QString data; //!< Data for startForData()
+    QVector<KexiCSVTypeDetectorChunk> chunks;
+
+    mutable QMutex mutex; //!< Guards members below
+    bool running = false;
+    QVector<KDbField::Type> types;
+    QVector<KexiCSVUniquenessTracker::Uniqueness> uniqueness;
+    QVector<qint64> distinctValueCounts;
+    qint64 rowCount = 0;
+};
+
+//! @internal Scans a single chunk
+class KexiCSVTypeDetectorChunkTask : public QRunnable
+{
+public:
+    KexiCSVTypeDetectorChunkTask(KexiCSVTypeDetector::Private *d, int index)
+        : m_d(d), m_index(index)
+    {
+    }
+
+    void run() override
+    {
+        KexiCSVTypeDetectorChunk *chunk = &m_d->chunks[m_index];
+        if (m_d->mappedData) {
+            QByteArray raw(QByteArray::fromRawData(
+                reinterpret_cast<const char*>(m_d->mappedData + chunk->begin),
+                int(chunk->end - chunk->begin)));
+            QBuffer buffer(&raw);
+            buffer.open(QIODevice::ReadOnly);
+            KexiCSVReader reader(&buffer, m_d->options);
+            scan(&reader, chunk);
+        } else if (m_d->file.isOpen()) {
+            m_d->file.seek(0);
+            KexiCSVReader reader(&m_d->file, m_d->options);
+            scan(&reader, chunk);
+        } else {
+            KexiCSVReader reader(m_d->data, m_d->options);
+            scan(&reader, chunk);
+        }
+        if (!m_d->pendingChunks.deref()) {
+            m_d->chunksFinished();
+        }
+    }
+
+private:
+    void scan(KexiCSVReader *reader, KexiCSVTypeDetectorChunk *chunk)
+    {
+        const KexiCSVValueParser &parser = m_d->parser;
+        int rowsToSkip = m_index == 0 ? m_d->skippedRows : 0;
+        bool rowTerminated = true;
+        while (reader->readRow()) {
+            rowTerminated = reader->isRowTerminated();
+            if (rowsToSkip > 0) {
+                --rowsToSkip;
+                continue;
+            }
+            const int fieldCount = reader->fieldCount();
+            if (chunk->possibleTypes.count() < fieldCount) {
+                const int oldCount = chunk->possibleTypes.count();
+                chunk->possibleTypes.resize(fieldCount);
+                chunk->hasValues.resize(fieldCount);
+                chunk->uniqueness.resize(fieldCount);
+                const int maximumSize = qMax(UNIQUENESS_MINIMUM_SIZE,
+                    UNIQUENESS_MAXIMUM_SIZE / (m_d->chunks.count() * fieldCount));
+                for (int col = oldCount; col < fieldCount; ++col) {
+                    chunk->uniqueness[col].setMaximumSize(maximumSize);
+                }
+            }
+            for (int col = 0; col < fieldCount; ++col) {
+                const QStringView field(reader->field(col));
+                KexiCSVUniquenessTracker &tracker = chunk->uniqueness[col];
+                if (field.isEmpty()) {
+                    tracker.addEmpty();
+                    continue; // empty values fit any type
+                }
+                KexiCSVTypeDetector::PossibleTypes &types = chunk->possibleTypes[col];
+                int intValue;
+                if (chunk->hasValues[col] && !types) {
+                    // it's a text column, only uniqueness has to be checked; integers
+                    // are still added as integers so equal values have equal keys
+                    if (KexiCSVValueParser::parseInt(field, &intValue)) {
+                        tracker.addInteger(intValue);
+                    } else {
+                        tracker.addText(field);
+                    }
+                    continue;
+                }
+                const KexiCSVTypeDetector::PossibleTypes valueTypes
+                    = possibleTypes(parser, field, &intValue);
+                if (valueTypes & KexiCSVTypeDetector::IntegerType) {
+                    tracker.addInteger(intValue);
+                } else {
+                    tracker.addText(field);
+                }
+                if (!chunk->hasValues[col]) {
+                    chunk->hasValues[col] = true;
+                    types = valueTypes;
+                } else {
+                    types &= valueTypes;
+                }
+            }
+            ++chunk->rowCount;
+            if ((chunk->rowCount % CANCEL_CHECK_ROWS) == 0 && m_d->canceled.load()) {
+                return;
+            }
+        }
+        chunk->endsWithCompleteRow = rowTerminated;
+    }
+
+    KexiCSVTypeDetector::Private * const m_d;
+    const int m_index;
+};
+
+//! @internal Splits the file into chunks and starts tasks scanning them.
+//! Runs in the pool because it touches the whole file.
+class KexiCSVTypeDetectorPlanTask : public QRunnable
+{
+public:
+    explicit KexiCSVTypeDetectorPlanTask(KexiCSVTypeDetector::Private *d)
+        : m_d(d)
+    {
+    }
+
+    void run() override
+    {
+        const qint64 size = m_d->file.isOpen() ? m_d->file.size() : 0;
+        if (size >= 2 * MINIMUM_CHUNK_SIZE && m_d->pool.maxThreadCount() > 1) {
+            m_d->mappedData = m_d->file.map(0, size);
+        }
+        if (!m_d->mappedData || !m_d->canSplit(m_d->mappedData, size)
+            || !m_d->split(m_d->mappedData, size))
+        {
+            if (m_d->mappedData) {
+                m_d->file.unmap(const_cast<uchar*>(m_d->mappedData));
+                m_d->mappedData = nullptr;
+            }
+            m_d->chunks.resize(1);
+        }
+        m_d->pendingChunks.store(m_d->chunks.count());
+        for (int i = 0; i < m_d->chunks.count(); ++i) {
+            m_d->pool.start(new KexiCSVTypeDetectorChunkTask(m_d, i));
+        }
+    }
+
+private:
+    KexiCSVTypeDetector::Private * const m_d;
+};
+
+bool KexiCSVTypeDetector::Private::canSplit(const uchar *data, qint64 size) const
+{
+    if (!options.commentSymbol.isNull() // quotes inside comments are not counted properly
+        || (!options.textQuote.isNull() && options.textQuote.unicode() > 0x7f))
+    {
+        return false;
+    }
+    // Like KexiCSVReader, prefer encoding found in the byte order mark if there is one
+    QTextCodec *codec = options.codec ? options.codec : QTextCodec::codecForLocale();
+    codec = QTextCodec::codecForUtfText(
+        QByteArray::fromRawData(reinterpret_cast<const char*>(data), int(qMin(size, qint64(4)))), codec);
+    // in ASCII-compatible encodings these bytes can't be a part of other characters
+    const QByteArray encoded(codec->fromUnicode(QLatin1String("\n\"")));
+    return encoded == "\n\"";
+}
+
+bool KexiCSVTypeDetector::Private::split(const uchar *data, qint64 size)
+{
+    const char *chars = reinterpret_cast<const char*>(data);
+    const char quote = options.textQuote.isNull() ? '\0' : char(options.textQuote.unicode());
+    // number of quotes in [from, to)
+    auto countQuotes = [chars, quote](qint64 from, qint64 to) {
+        qint64 count = 0;
+        if (quote == '\0') {
+            return count;
+        }
+        while (from < to) {
+            const void *found = std::memchr(chars + from, quote, size_t(to - from));
+            if (!found) {
+                break;
+            }
+            ++count;
+            from = static_cast<const char*>(found) - chars + 1;
+        }
+        return count;
+    };
+
+    const qint64 maximumChunkSize = std::numeric_limits<int>::max();
+    const qint64 chunkCount = qMax(qBound(qint64(1), size / MINIMUM_CHUNK_SIZE,
+                                          qint64(pool.maxThreadCount()) * CHUNKS_PER_THREAD),
+                                   size / (maximumChunkSize / 2) + 1);
+    chunks.clear();
+    // Speculatively split after end of lines that are not inside quoted fields, assuming
+    // that quotes only start and end fields. Chunks ending with incomplete rows reveal
+    // a wrong guess; chunksFinished() then falls back to a single chunk.
+    qint64 begin = 0;
+    qint64 pos = 0;
+    bool inQuotes = false;
+    for (qint64 i = 1; i < chunkCount; ++i) {
+        const qint64 target = size * i / chunkCount;
+        if (target <= pos) {
+            continue;
+        }
+        inQuotes ^= (countQuotes(pos, target) & 1) != 0;
+        pos = target;
+        while (pos < size) {
+            const void *found = std::memchr(chars + pos, '\n', size_t(size - pos));
+            if (!found) {
+                pos = size;
+                break;
+            }
+            const qint64 endOfLine = static_cast<const char*>(found) - chars;
+            inQuotes ^= (countQuotes(pos, endOfLine) & 1) != 0;
+            pos = endOfLine + 1;
+            if (!inQuotes) {
+                break;
+            }
+        }
+        if (pos >= size) {
+            break;
+        }
+        if (pos - begin > maximumChunkSize) {
+            return false;
+        }
+        KexiCSVTypeDetectorChunk chunk;
+        chunk.begin = begin;
+        chunk.end = pos;
+        chunks.append(chunk);
+        begin = pos;
+    }
+    if (size - begin > maximumChunkSize) {
+        return false;
+    }
+    KexiCSVTypeDetectorChunk chunk;
+    chunk.begin = begin;
+    chunk.end = size;
+    chunks.append(chunk);
+    return true;
+}
+
+void KexiCSVTypeDetector::Private::chunksFinished()
+{
+    if (!canceled.load()) {
+        for (int i = 0; i < chunks.count() - 1; ++i) {
+            if (!chunks[i].endsWithCompleteRow) {
+                // the file has quotes inside unquoted fields, scan it again without splitting
+                file.unmap(const_cast<uchar*>(mappedData));
+                mappedData = nullptr;
+                chunks.resize(1);
+                chunks[0] = KexiCSVTypeDetectorChunk();
+                pendingChunks.store(1);
+                pool.start(new KexiCSVTypeDetectorChunkTask(this, 0));
+                return;
+            }
+        }
+    }
+    if (mappedData) {
+        file.unmap(const_cast<uchar*>(mappedData));
+        mappedData = nullptr;
+    }
+    file.close();
+    if (canceled.load()) {
+        QMutexLocker locker(&mutex);
+        running = false;
+        return;
+    }
+
+    // intersect possible types of all chunks
+    QVector<KexiCSVTypeDetector::PossibleTypes> possibleTypes;
+    QVector<bool> hasValues;
+    qint64 rows = 0;
+    for (const KexiCSVTypeDetectorChunk &chunk : qAsConst(chunks)) {
+        if (possibleTypes.count() < chunk.possibleTypes.count()) {
+            possibleTypes.resize(chunk.possibleTypes.count());
+            hasValues.resize(chunk.possibleTypes.count());
+        }
+        for (int col = 0; col < chunk.possibleTypes.count(); ++col) {
+            if (!chunk.hasValues[col]) {
+                continue;
+            }
+            possibleTypes[col] = hasValues[col] ? (possibleTypes[col] & chunk.possibleTypes[col])
+                                                : chunk.possibleTypes[col];
+            hasValues[col] = true;
+        }
+        rows += chunk.rowCount;
+    }
+    QVector<KDbField::Type> result(possibleTypes.count(), KDbField::InvalidType);
+    for (int col = 0; col < possibleTypes.count(); ++col) {
+        if (hasValues[col]) {
+            result[col] = KexiCSVTypeDetector::typeFor(possibleTypes[col]);
+        }
+    }
+
+    // merge uniqueness of all chunks, releasing memory of merged trackers
+    QVector<KexiCSVUniquenessTracker::Uniqueness> uniquenessResult(possibleTypes.count(),
+                                                                   KexiCSVUniquenessTracker::NotUnique);
+    QVector<qint64> distinctValueCountsResult(possibleTypes.count(), 0);
+    for (int col = 0; col < possibleTypes.count(); ++col) {
+        KexiCSVUniquenessTracker tracker;
+        tracker.setMaximumSize(qMax(UNIQUENESS_MINIMUM_SIZE, UNIQUENESS_MAXIMUM_SIZE / possibleTypes.count()));
+        for (KexiCSVTypeDetectorChunk &chunk : chunks) {
+            if (col < chunk.uniqueness.count()) {
+                tracker.merge(chunk.uniqueness[col]);
+                chunk.uniqueness[col] = KexiCSVUniquenessTracker();
+            }
+        }
+        // rows too short to contain the column have no value in it
+        if (tracker.valueCount() == rows) {
+            uniquenessResult[col] = tracker.uniqueness();
+        }
+        distinctValueCountsResult[col] = tracker.distinctCount();
+    }
+    chunks.clear();
+    {
+        QMutexLocker locker(&mutex);
+        types = result;
+        uniqueness = uniquenessResult;
+        distinctValueCounts = distinctValueCountsResult;
+        rowCount = rows;
+        running = false;
+    }
+    QMetaObject::invokeMethod(q, "finished", Qt::QueuedConnection);
+}
+
+// --
+
+KexiCSVTypeDetector::KexiCSVTypeDetector(const KexiCSVReader::Options &options, QObject *parent)
+    : QObject(parent)
+    , d(new Private(this, options))
+{
+    d->pool.setMaxThreadCount(QThread::idealThreadCount());
+}
+
+KexiCSVTypeDetector::~KexiCSVTypeDetector()
+{
+    cancel();
+    d->pool.waitForDone();
+    delete d;
+}
+
+void KexiCSVTypeDetector::setSkippedRows(int rows)
+{
+    d->skippedRows = rows;
+}
+
+void KexiCSVTypeDetector::setValueParser(const KexiCSVValueParser &parser)
+{
+    d->parser = parser;
+}
+
+void KexiCSVTypeDetector::setMaximumThreadCount(int count)
+{
+    d->pool.setMaxThreadCount(qMax(1, count));
+}
+
+bool KexiCSVTypeDetector::start(const QString &fileName)
+{
+    cancel();
+    d->pool.waitForDone();
+    d->canceled.store(0);
+    d->data.clear();
+    d->chunks.clear();
+    d->file.setFileName(fileName);
+    if (!d->file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    {
+        QMutexLocker locker(&d->mutex);
+        d->running = true;
+        d->types.clear();
+        d->uniqueness.clear();
+        d->distinctValueCounts.clear();
+        d->rowCount = 0;
+    }
+    d->pool.start(new KexiCSVTypeDetectorPlanTask(d));
+    return true;
+}
+
+void KexiCSVTypeDetector::startForData(const QString &data)
+{
+    cancel();
+    d->pool.waitForDone();
+    d->canceled.store(0);
+    d->data = data;
+    d->chunks.resize(1);
+    {
+        QMutexLocker locker(&d->mutex);
+        d->running = true;
+        d->types.clear();
+        d->uniqueness.clear();
+        d->distinctValueCounts.clear();
+        d->rowCount = 0;
+    }
+    d->pendingChunks.store(1);
+    d->pool.start(new KexiCSVTypeDetectorChunkTask(d, 0));
+}
+
+void KexiCSVTypeDetector::waitForFinished()
+{
+    d->pool.waitForDone();
+}
+
+bool KexiCSVTypeDetector::isRunning() const
+{
+    QMutexLocker locker(&d->mutex);
+    return d->running;
+}
+
+void KexiCSVTypeDetector::cancel()
+{
+    d->canceled.store(1);
+}
+
+QVector<KDbField::Type> KexiCSVTypeDetector::types() const
+{
+    QMutexLocker locker(&d->mutex);
+    return d->types;
+}
+
+KexiCSVUniquenessTracker::Uniqueness KexiCSVTypeDetector::uniqueness(int column) const
+{
+    QMutexLocker locker(&d->mutex);
+    return d->uniqueness.value(column, KexiCSVUniquenessTracker::NotUnique);
+}
+
+qint64 KexiCSVTypeDetector::distinctValueCount(int column) const
+{
+    QMutexLocker locker(&d->mutex);
+    return d->distinctValueCounts.value(column);
+}
+
+qint64 KexiCSVTypeDetector::rowCount() const
+{
+    QMutexLocker locker(&d->mutex);
+    return d->rowCount;
+}
+
+//static
+KDbField::Type KexiCSVTypeDetector::typeFor(PossibleTypes possibleTypes)
+{
+    if (possibleTypes & IntegerType) {
+        return KDbField::Integer;
+    }
+    if (possibleTypes & DoubleType) {
+        return KDbField::Double;
+    }
+    if (possibleTypes & DateType) {
+        return KDbField::Date;
+    }
+    if (possibleTypes & TimeType) {
+        return KDbField::Time;
+    }
+    if (possibleTypes & DateTimeType) {
+        return KDbField::DateTime;
+    }
+    return KDbField::Text;
+}
@@ -0,0 +1,124 @@
+/* This file is part of the KDE project
+   Copyright (C) 2026 Kexi developers <kexi-devel@kde.org>
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public License
+   along with this library; see the file COPYING.LIB.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+*/
+
+#ifndef KEXICSVTYPEDETECTOR_H
+#define KEXICSVTYPEDETECTOR_H
+
+#include "KexiCSVReader.h"
+#include "KexiCSVUniquenessTracker.h"
+#include "KexiCSVValueParser.h"
+
+#include <QObject>
+#include <QVector>
+
+#include <KDbField>
+
+//! @short Detects types of CSV columns using all rows of a file
+/*! Values are checked using KexiCSVValueParser, the same way as they are converted on import.
+ The file is split into chunks at row boundaries and the chunks are scanned in parallel
+ on a thread pool. For each column, every chunk computes a set of types all of its values
+ can be converted to (a type lattice). Sets of all chunks are then intersected, so the
+ result does not depend on the order of rows. Uniqueness of values is checked the same way
+ using KexiCSVUniquenessTracker, so candidates for primary key are known too.
+
+ Chunks are only used for files in encodings compatible with ASCII, e.g. UTF-8 or Latin-1,
+ so that end of lines and quotes can be found without decoding. Other files and
+ decoded data are scanned by a single thread.
+
+ Detection runs in the background after start(); finished() is emitted when results
+ are available. */
+class KexiCSVTypeDetector : public QObject
+{
+    Q_OBJECT
+public:
+    //! Types a value can be converted to
+    enum PossibleType {
+        IntegerType = 0x01,
+        DoubleType = 0x02,
+        DateType = 0x04,
+        TimeType = 0x08,
+        DateTimeType = 0x10,
+        AllTypes = 0x1f
+    };
+    Q_DECLARE_FLAGS(PossibleTypes, PossibleType)
+
+    explicit KexiCSVTypeDetector(const KexiCSVReader::Options &options, QObject *parent = nullptr);
+
+    //! Cancels detection in progress and waits for the worker threads.
+    virtual ~KexiCSVTypeDetector();
+
+    //! Sets number of rows at the beginning of data that are not checked,
+    //! e.g. rows skipped by the user and the row with column names. 0 by default.
+    void setSkippedRows(int rows);
+
+    //! Sets parser used to check values; it should have the same settings
+    //! as the one used for importing.
+    void setValueParser(const KexiCSVValueParser &parser);
+
+    //! Sets maximum number of worker threads, QThread::idealThreadCount() by default.
+    void setMaximumThreadCount(int count);
+
+    //! Starts detection for file @a fileName. @return false if the file cannot be opened.
+    bool start(const QString &fileName);
+
+    //! Starts detection for already decoded @a data, e.g. clipboard contents.
+    void startForData(const QString &data);
+
+    //! Blocks until detection is finished.
+    void waitForFinished();
+
+    //! @return true if detection has been started and is not finished yet
+    bool isRunning() const;
+
+    //! Cancels detection. finished() is not emitted.
+    void cancel();
+
+    //! @return detected types of columns; columns containing only empty values have
+    //! KDbField::InvalidType. Only valid after finished().
+    QVector<KDbField::Type> types() const;
+
+    //! @return uniqueness of values of column @a column, see KexiCSVUniquenessTracker.
+    //! Columns with empty values are not unique. Only valid after finished().
+    KexiCSVUniquenessTracker::Uniqueness uniqueness(int column) const;
+
+    //! @return number of distinct values of column @a column, estimated if there are
+    //! too many values to store them all. Only valid after finished().
+    qint64 distinctValueCount(int column) const;
+
+    //! @return number of checked rows. Only valid after finished().
+    qint64 rowCount() const;
+
+    //! @return type with the highest priority out of @a possibleTypes, the same as
+    //! preferred by the CSV import dialog; KDbField::Text if @a possibleTypes is empty
+    static KDbField::Type typeFor(PossibleTypes possibleTypes);
+
+Q_SIGNALS:
+    //! Emitted in the thread of the detector when detection is finished
+    void finished();
+
+private:
+    class Private;
+    Private * const d;
+    friend class KexiCSVTypeDetectorChunkTask;
+    friend class KexiCSVTypeDetectorPlanTask;
+};
+
+Q_DECLARE_OPERATORS_FOR_FLAGS(KexiCSVTypeDetector::PossibleTypes)
+
+#endif
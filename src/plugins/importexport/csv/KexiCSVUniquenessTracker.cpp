@@ -0,0 +1,253 @@
+/* This file is part of the KDE project
+   Copyright (C) 2026 Kexi developers <kexi-devel@kde.org>
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public License
+   along with this library; see the file COPYING.LIB.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+*/
+
+#include "KexiCSVUniquenessTracker.h"
+
+#include <QtAlgorithms>
+
+#include <cmath>
+#include <cstring>
+
+#define DEFAULT_MAXIMUM_SIZE (1024 * 1024)
+#define INITIAL_CAPACITY 64
+//! HyperLogLog uses 2^HLL_PRECISION registers, standard error is 1.04/sqrt(2^HLL_PRECISION)
+#define HLL_PRECISION 12
+#define HLL_REGISTER_COUNT (1 << HLL_PRECISION)
+//! Values are not unique if the estimate is lower by more than three standard errors
+#define HLL_TOLERANCE (3 * 1.04 / 64.0)
+
+//! Finalizer of SplitMix64, spreads bits of @a x over the whole result
+static inline quint64 mix(quint64 x)
+{
+    x ^= x >> 30;
+    x *= Q_UINT64_C(0xbf58476d1ce4e5b9);
+    x ^= x >> 27;
+    x *= Q_UINT64_C(0x94d049bb133111eb);
+    x ^= x >> 31;
+    return x;
+}
+
+//! @return 64-bit hash of @a text, four characters are hashed at once
+static quint64 hashText(QStringView text)
+{
+    const char *data = reinterpret_cast<const char*>(text.utf16());
+    qsizetype size = text.size();
+    quint64 hash = Q_UINT64_C(0x9e3779b97f4a7c15) ^ quint64(size);
+    for (; size >= 4; size -= 4, data += 8) {
+        quint64 word;
+        std::memcpy(&word, data, 8);
+        hash = mix(hash ^ word);
+    }
+    if (size > 0) {
+        quint64 word = 0;
+        std::memcpy(&word, data, size_t(size) * 2);
+        hash = mix(hash ^ word);
+    }
+    return hash;
+}
+
+KexiCSVUniquenessTracker::KexiCSVUniquenessTracker()
+    : m_size(0)
+    , m_hasZeroKey(false)
+    , m_exact(true)
+    , m_notUnique(false)
+    , m_valueCount(0)
+    , m_maximumSize(DEFAULT_MAXIMUM_SIZE)
+    , m_registers(HLL_REGISTER_COUNT, '\0')
+{
+}
+
+void KexiCSVUniquenessTracker::setMaximumSize(int size)
+{
+    m_maximumSize = size;
+    if (m_size > m_maximumSize) {
+        m_exact = false;
+        releaseSet();
+    }
+}
+
+void KexiCSVUniquenessTracker::addInteger(qint64 value)
+{
+    addKey(quint64(value));
+}
+
+void KexiCSVUniquenessTracker::addText(QStringView value)
+{
+    addKey(hashText(value));
+}
+
+void KexiCSVUniquenessTracker::addEmpty()
+{
+    if (!m_notUnique) {
+        m_notUnique = true; // empty value cannot be in PK
+        releaseSet();
+    }
+}
+
+void KexiCSVUniquenessTracker::addKey(quint64 key)
+{
+    ++m_valueCount;
+    const quint64 hash = mix(key);
+    // the highest bits select the register, the rest is used for the rank
+    const int index = int(hash >> (64 - HLL_PRECISION));
+    const quint64 rest = hash << HLL_PRECISION;
+    const char rank = char(rest ? qCountLeadingZeroBits(rest) + 1 : 64 - HLL_PRECISION + 1);
+    if (m_registers.at(index) < rank) {
+        m_registers[index] = rank;
+    }
+    if (m_exact && !m_notUnique) {
+        insertKey(key, hash);
+    }
+}
+
+void KexiCSVUniquenessTracker::insertKey(quint64 key, quint64 hash)
+{
+    if (key == 0) {
+        if (m_hasZeroKey) {
+            m_notUnique = true;
+            releaseSet();
+        } else {
+            m_hasZeroKey = true;
+        }
+        return;
+    }
+    if ((m_size + 1) * 2 > m_table.size() && !grow()) { // keep load factor <= 0.5
+        return;
+    }
+    const int mask = m_table.size() - 1;
+    quint64 *slots = m_table.data();
+    int i = int(hash & quint64(mask));
+    for (; slots[i] != 0; i = (i + 1) & mask) {
+        if (slots[i] == key) {
+            m_notUnique = true;
+            releaseSet();
+            return;
+        }
+    }
+    slots[i] = key;
+    ++m_size;
+}
+
+bool KexiCSVUniquenessTracker::grow()
+{
+    const int capacity = qMax(INITIAL_CAPACITY, m_table.size() * 2);
+    if (capacity / 2 > m_maximumSize) {
+        m_exact = false;
+        releaseSet();
+        return false;
+    }
+    const QVector<quint64> old(m_table);
+    m_table = QVector<quint64>(capacity, 0);
+    const int mask = capacity - 1;
+    quint64 *slots = m_table.data();
+    for (quint64 key : old) {
+        if (key != 0) {
+            int i = int(mix(key) & quint64(mask));
+            while (slots[i] != 0) {
+                i = (i + 1) & mask;
+            }
+            slots[i] = key;
+        }
+    }
+    return true;
+}
+
+void KexiCSVUniquenessTracker::releaseSet()
+{
+    m_table = QVector<quint64>();
+    m_size = 0;
+    m_hasZeroKey = false;
+}
+
+void KexiCSVUniquenessTracker::merge(const KexiCSVUniquenessTracker &other)
+{
+    m_valueCount += other.m_valueCount;
+    for (int i = 0; i < HLL_REGISTER_COUNT; ++i) {
+        if (m_registers.at(i) < other.m_registers.at(i)) {
+            m_registers[i] = other.m_registers.at(i);
+        }
+    }
+    if (m_notUnique) {
+        return;
+    }
+    if (other.m_notUnique) {
+        m_notUnique = true;
+        releaseSet();
+        return;
+    }
+    if (!m_exact) {
+        return;
+    }
+    if (!other.m_exact) {
+        m_exact = false;
+        releaseSet();
+        return;
+    }
+    if (other.m_hasZeroKey) {
+        insertKey(0, mix(0));
+    }
+    for (quint64 key : other.m_table) {
+        if (!m_exact || m_notUnique) {
+            break;
+        }
+        if (key != 0) {
+            insertKey(key, mix(key));
+        }
+    }
+}
+
+KexiCSVUniquenessTracker::Uniqueness KexiCSVUniquenessTracker::uniqueness() const
+{
+    if (m_notUnique) {
+        return NotUnique;
+    }
+    if (m_exact) {
+        return Unique;
+    }
+    return estimatedDistinctCount() < double(m_valueCount) * (1.0 - HLL_TOLERANCE)
+            ? NotUnique : ProbablyUnique;
+}
+
+qint64 KexiCSVUniquenessTracker::distinctCount() const
+{
+    if (!m_notUnique && m_exact) {
+        return m_valueCount;
+    }
+    return qMin(m_valueCount, qint64(std::llround(estimatedDistinctCount())));
+}
+
+double KexiCSVUniquenessTracker::estimatedDistinctCount() const
+{
+    const double m = HLL_REGISTER_COUNT;
+    double sum = 0.0;
+    int zeros = 0;
+    for (int i = 0; i < HLL_REGISTER_COUNT; ++i) {
+        const int rank = m_registers.at(i);
+        sum += std::ldexp(1.0, -rank);
+        if (rank == 0) {
+            ++zeros;
+        }
+    }
+    const double alpha = 0.7213 / (1.0 + 1.079 / m);
+    const double estimate = alpha * m * m / sum;
+    if (estimate <= 2.5 * m && zeros > 0) {
+        return m * std::log(m / zeros); // linear counting is better for small cardinalities
+    }
+    return estimate;
+}
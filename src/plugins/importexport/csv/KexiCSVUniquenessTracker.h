@@ -0,0 +1,105 @@
+/* This file is part of the KDE project
+   Copyright (C) 2026 Kexi developers <kexi-devel@kde.org>
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public License
+   along with this library; see the file COPYING.LIB.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+*/
+
+#ifndef KEXICSVUNIQUENESSTRACKER_H
+#define KEXICSVUNIQUENESSTRACKER_H
+
+#include <QByteArray>
+#include <QStringView>
+#include <QVector>
+
+//! @short Incrementally checks whether values of a CSV column are unique
+/*! Values are added one by one while rows are read. Integers are stored directly, texts
+ as 64-bit hashes, in an open-addressing hash set, so a duplicate is found as soon as it
+ is added. Once a duplicate or an empty value is found, the set is released.
+
+ The number of values stored in the set is limited by maximumSize(). Above the limit
+ the set is released too and only a HyperLogLog sketch of a few kilobytes is kept;
+ it estimates the number of distinct values within about 2%, so values are then only
+ known to be probably unique.
+
+ The tracker has value semantics. Trackers filled with different parts of the data
+ (e.g. by different threads) can be merged. */
+class KexiCSVUniquenessTracker
+{
+public:
+    enum Uniqueness {
+        NotUnique, //!< There are duplicates or empty values
+        ProbablyUnique, //!< There are too many values to be sure, see isExact()
+        Unique
+    };
+
+    KexiCSVUniquenessTracker();
+
+    //! @return maximum number of values stored exactly
+    int maximumSize() const { return m_maximumSize; }
+
+    //! Sets maximum number of values stored exactly. About 16 bytes are used per value.
+    void setMaximumSize(int size);
+
+    //! Adds integer @a value
+    void addInteger(qint64 value);
+
+    //! Adds text @a value; two texts are equal if their 64-bit hashes are equal
+    void addText(QStringView value);
+
+    //! Adds empty value, values containing empty values cannot be unique
+    void addEmpty();
+
+    //! Adds values of @a other tracker to this one
+    void merge(const KexiCSVUniquenessTracker &other);
+
+    //! @return uniqueness of all values added so far
+    Uniqueness uniqueness() const;
+
+    //! @return false if the set has been released because of the size limit
+    bool isExact() const { return m_exact; }
+
+    //! @return number of added non-empty values
+    qint64 valueCount() const { return m_valueCount; }
+
+    //! @return number of distinct values; exact if uniqueness() is Unique, estimated otherwise
+    qint64 distinctCount() const;
+
+private:
+    void addKey(quint64 key);
+
+    //! Inserts @a key with @a hash to the set, marks duplicates
+    void insertKey(quint64 key, quint64 hash);
+
+    //! Doubles capacity of the set. @return false if the size limit has been reached.
+    bool grow();
+
+    //! Releases the set, e.g. after a duplicate is found
+    void releaseSet();
+
+    //! @return number of distinct values estimated by the HyperLogLog sketch
+    double estimatedDistinctCount() const;
+
+    QVector<quint64> m_table; //!< Open-addressing hash set; 0 marks an empty slot
+    int m_size; //!< Number of keys in m_table
+    bool m_hasZeroKey; //!< Key 0 is not stored in m_table
+    bool m_exact;
+    bool m_notUnique;
+    qint64 m_valueCount;
+    int m_maximumSize;
+    QByteArray m_registers; //!< HyperLogLog registers
+};
+
+#endif
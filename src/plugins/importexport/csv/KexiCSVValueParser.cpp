@@ -0,0 +1,355 @@
+/* This file is part of the KDE project
+   Copyright (C) 2026 Kexi developers <kexi-devel@kde.org>
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public License
+   along with this library; see the file COPYING.LIB.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+*/
+
+#include "KexiCSVValueParser.h"
+
+#include <QByteArray>
+#include <QLocale>
+
+#include <limits>
+
+#define MINIMUM_YEAR_FOR_100_YEAR_SLIDING_WINDOW 1930
+//! Mantissas with up to 15 digits and powers of ten up to 10^22 are exact doubles,
+//! so decimals within these limits are converted exactly by a single multiplication
+//! or division. Other values are converted by the slow path.
+#define MAXIMUM_EXACT_DIGITS 15
+#define MAXIMUM_EXACT_EXPONENT 22
+//! Number of significant digits stored in a 64-bit mantissa
+#define MAXIMUM_MANTISSA_DIGITS 19
+
+static const double exactPowersOfTen[MAXIMUM_EXACT_EXPONENT + 1] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+//! @return value of decimal digit @a c or a value larger than 9 if @a c is not a digit
+static inline uint digitValue(QChar c)
+{
+    return uint(c.unicode()) - uint('0');
+}
+
+//! Reads up to @a maxDigits digits of @a text starting at @a pos into @a value.
+//! @return number of digits read
+static int readNumber(QStringView text, int pos, int maxDigits, int *value)
+{
+    int count = 0;
+    int result = 0;
+    for (; pos < text.size() && count < maxDigits; ++pos, ++count) {
+        const uint digit = digitValue(text[pos]);
+        if (digit > 9) {
+            break;
+        }
+        result = result * 10 + int(digit);
+    }
+    *value = result;
+    return count;
+}
+
+static inline bool isDateSeparator(QChar c)
+{
+    return c == QLatin1Char('/') || c == QLatin1Char('-') || c == QLatin1Char('.');
+}
+
+KexiCSVValueParser::KexiCSVValueParser()
+    : m_dateFormat(AutoDateFormat)
+    , m_minimumYear(MINIMUM_YEAR_FOR_100_YEAR_SLIDING_WINDOW)
+{
+    const QChar point = QLocale().decimalPoint();
+    m_decimalSeparator = point == QLatin1Char('.') ? QLatin1Char(',') : point;
+}
+
+//static
+bool KexiCSVValueParser::parseInt(QStringView text, int *value)
+{
+    text = text.trimmed();
+    int pos = 0;
+    bool negative = false;
+    if (!text.isEmpty() && (text[0] == QLatin1Char('-') || text[0] == QLatin1Char('+'))) {
+        negative = text[0] == QLatin1Char('-');
+        pos = 1;
+    }
+    if (pos == text.size()) {
+        return false;
+    }
+    const qint64 limit = qint64(std::numeric_limits<int>::max()) + (negative ? 1 : 0);
+    qint64 result = 0;
+    for (; pos < text.size(); ++pos) {
+        const uint digit = digitValue(text[pos]);
+        if (digit > 9) {
+            return false;
+        }
+        result = result * 10 + digit;
+        if (result > limit) {
+            return false;
+        }
+    }
+    *value = int(negative ? -result : result);
+    return true;
+}
+
+bool KexiCSVValueParser::parseDouble(QStringView text, double *value) const
+{
+    text = text.trimmed();
+    const int size = text.size();
+    int pos = 0;
+    bool negative = false;
+    if (size > 0 && (text[0] == QLatin1Char('-') || text[0] == QLatin1Char('+'))) {
+        negative = text[0] == QLatin1Char('-');
+        pos = 1;
+    }
+    quint64 mantissa = 0;
+    int significantDigits = 0;
+    int exponent = 0;
+    bool anyDigit = false;
+    bool truncated = false; //!< true if some nonzero digits did not fit into the mantissa
+    // integer part
+    for (; pos < size; ++pos) {
+        const uint digit = digitValue(text[pos]);
+        if (digit > 9) {
+            break;
+        }
+        anyDigit = true;
+        if (mantissa == 0 && digit == 0) {
+            continue; // leading zero
+        }
+        if (significantDigits < MAXIMUM_MANTISSA_DIGITS) {
+            mantissa = mantissa * 10 + digit;
+            ++significantDigits;
+        } else {
+            ++exponent;
+            truncated = truncated || digit != 0;
+        }
+    }
+    // fractional part
+    if (pos < size && (text[pos] == QLatin1Char('.') || text[pos] == m_decimalSeparator)) {
+        for (++pos; pos < size; ++pos) {
+            const uint digit = digitValue(text[pos]);
+            if (digit > 9) {
+                break;
+            }
+            anyDigit = true;
+            if (mantissa == 0 && digit == 0) {
+                --exponent; // leading zero
+            } else if (significantDigits < MAXIMUM_MANTISSA_DIGITS) {
+                mantissa = mantissa * 10 + digit;
+                ++significantDigits;
+                --exponent;
+            } else {
+                truncated = truncated || digit != 0;
+            }
+        }
+    }
+    if (!anyDigit) {
+        return false;
+    }
+    // exponent
+    if (pos < size && (text[pos] == QLatin1Char('e') || text[pos] == QLatin1Char('E'))) {
+        ++pos;
+        bool negativeExponent = false;
+        if (pos < size && (text[pos] == QLatin1Char('-') || text[pos] == QLatin1Char('+'))) {
+            negativeExponent = text[pos] == QLatin1Char('-');
+            ++pos;
+        }
+        int explicitExponent = 0;
+        bool anyExponentDigit = false;
+        for (; pos < size; ++pos) {
+            const uint digit = digitValue(text[pos]);
+            if (digit > 9) {
+                break;
+            }
+            anyExponentDigit = true;
+            if (explicitExponent < 100000) { // larger values are out of range anyway
+                explicitExponent = explicitExponent * 10 + int(digit);
+            }
+        }
+        if (!anyExponentDigit) {
+            return false;
+        }
+        exponent += negativeExponent ? -explicitExponent : explicitExponent;
+    }
+    if (pos != size) {
+        return false;
+    }
+
+    double result;
+    if (mantissa == 0) {
+        result = 0.0;
+    } else if (!truncated && significantDigits <= MAXIMUM_EXACT_DIGITS
+               && exponent >= -MAXIMUM_EXACT_EXPONENT && exponent <= MAXIMUM_EXACT_EXPONENT)
+    {
+        result = double(mantissa);
+        if (exponent < 0) {
+            result /= exactPowersOfTen[-exponent];
+        } else {
+            result *= exactPowersOfTen[exponent];
+        }
+    } else {
+        // Slow path for correct rounding: the text is known to be ASCII-only
+        // except for the decimal separator so it is copied with '.' instead.
+        char buffer[64];
+        QByteArray copy;
+        char *data = buffer;
+        if (size >= int(sizeof(buffer))) {
+            copy.resize(size);
+            data = copy.data();
+        }
+        for (int i = 0; i < size; ++i) {
+            const QChar c = text[i];
+            data[i] = c == m_decimalSeparator ? '.' : char(c.unicode());
+        }
+        bool ok;
+        result = QByteArray::fromRawData(data, size).toDouble(&ok);
+        if (!ok) {
+            return false;
+        }
+        *value = result; // the sign has been copied too
+        return true;
+    }
+    *value = negative ? -result : result;
+    return true;
+}
+
+QDate KexiCSVValueParser::buildDate(int y, int m, int d) const
+{
+    if (y < 100) {
+        if ((1900 + y) >= m_minimumYear)
+            return QDate(1900 + y, m, d);
+        else
+            return QDate(2000 + y, m, d);
+    }
+    return QDate(y, m, d);
+}
+
+bool KexiCSVValueParser::parseDate(QStringView text, QDate *date) const
+{
+    text = text.trimmed();
+    //dddd - dd - dddd
+    //1    2 3  4 5    <- parts
+    int d1, d3, d5;
+    int pos = readNumber(text, 0, 4, &d1);
+    if (pos == 0 || pos >= text.size() || !isDateSeparator(text[pos])) {
+        return false;
+    }
+    const QChar separator = text[pos++];
+    int count = readNumber(text, pos, 2, &d3);
+    if (count == 0) {
+        return false;
+    }
+    pos += count;
+    if (pos >= text.size() || !isDateSeparator(text[pos])) {
+        return false;
+    }
+    ++pos;
+    count = readNumber(text, pos, 4, &d5);
+    if (count == 0 || pos + count != text.size()) {
+        return false;
+    }
+    QDate result;
+    switch (m_dateFormat) {
+    case DMY: result = buildDate(d5, d3, d1); break;
+    case YMD: result = buildDate(d1, d3, d5); break;
+    case MDY: result = buildDate(d5, d1, d3); break;
+    case AutoDateFormat:
+        if (separator == QLatin1Char('/')) { //probably separator for american format mm/dd/yyyy
+            result = buildDate(d5, d1, d3);
+        } else {
+            if (d5 > 31) //d5 == year
+                result = buildDate(d5, d3, d1);
+            else //d1 == year
+                result = buildDate(d1, d3, d5);
+        }
+        break;
+    }
+    if (!result.isValid()) {
+        return false;
+    }
+    *date = result;
+    return true;
+}
+
+//static
+bool KexiCSVValueParser::parseTime(QStringView text, QTime *time)
+{
+    text = text.trimmed();
+    const int size = text.size();
+    int h, m, s = 0, ms = 0;
+    int pos = readNumber(text, 0, 2, &h);
+    if (pos == 0 || pos >= size || text[pos] != QLatin1Char(':')) {
+        return false;
+    }
+    ++pos;
+    int count = readNumber(text, pos, 2, &m);
+    if (count == 0) {
+        return false;
+    }
+    pos += count;
+    if (pos < size && text[pos] == QLatin1Char(':')) {
+        ++pos;
+        count = readNumber(text, pos, 2, &s);
+        if (count == 0) {
+            return false;
+        }
+        pos += count;
+        if (pos < size && (text[pos] == QLatin1Char('.') || text[pos] == QLatin1Char(','))) {
+            // fraction of second, like in ISO 8601; digits after milliseconds are ignored
+            ++pos;
+            count = readNumber(text, pos, 3, &ms);
+            if (count == 0) {
+                return false;
+            }
+            pos += count;
+            for (; count < 3; ++count) {
+                ms *= 10;
+            }
+            while (pos < size && digitValue(text[pos]) <= 9) {
+                ++pos;
+            }
+        }
+    }
+    if (pos != size || !QTime::isValid(h, m, s, ms)) {
+        return false;
+    }
+    *time = QTime(h, m, s, ms);
+    return true;
+}
+
+bool KexiCSVValueParser::parseDateTime(QStringView text, QDateTime *dateTime) const
+{
+    text = text.trimmed();
+    int separator = -1;
+    for (int i = 0; i < text.size(); ++i) {
+        if (text[i] == QLatin1Char(' ')) {
+            separator = i;
+            break;
+        }
+        if (separator < 0 && text[i] == QLatin1Char('T')) {
+            separator = i; //also support ISODateTime's "T" separator
+        }
+    }
+//! @todo also support timezones?
+    QDate date;
+    QTime time;
+    if (separator < 0 || !parseDate(text.left(separator), &date)
+        || !parseTime(text.mid(separator + 1), &time))
+    {
+        return false;
+    }
+    *dateTime = QDateTime(date, time);
+    return true;
+}
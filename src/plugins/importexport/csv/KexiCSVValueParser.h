@@ -0,0 +1,96 @@
+/* This file is part of the KDE project
+   Copyright (C) 2026 Kexi developers <kexi-devel@kde.org>
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public License
+   along with this library; see the file COPYING.LIB.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+*/
+
+#ifndef KEXICSVVALUEPARSER_H
+#define KEXICSVVALUEPARSER_H
+
+#include <QDateTime>
+#include <QStringView>
+
+//! @short Parsers of numeric, date and time values of CSV fields
+/*! Values are parsed directly from string views of the input buffer without allocating
+ memory, so the same code can be used for detecting column types of all rows and for
+ inserting values.
+
+ Whitespace around values is ignored. Supported formats are:
+ - integers: optional sign and decimal digits,
+ - decimals: optional sign, digits with '.' or decimalSeparator() and an optional exponent,
+   e.g. 1.5, -,5 or 0.1e-2,
+ - dates: three groups of digits separated by '/', '-' or '.'; order of the groups
+   is determined by dateFormat(),
+ - times: hh:mm, hh:mm:ss or hh:mm:ss.zzz, hours and minutes may have one digit,
+ - date-times: date and time separated by space or 'T'.
+
+ Methods are const and reentrant, so one parser can be shared by many threads. */
+class KexiCSVValueParser
+{
+public:
+    //! Order of day, month and year in dates
+    enum DateFormat {
+        AutoDateFormat = 0, //!< mm/dd/yyyy if '/' separator is used, else dd-mm-yyyy or yyyy-mm-dd
+        DMY = 1, //!< day-month-year
+        YMD = 2, //!< year-month-day
+        MDY = 3  //!< month-day-year
+    };
+
+    KexiCSVValueParser();
+
+    DateFormat dateFormat() const { return m_dateFormat; }
+
+    void setDateFormat(DateFormat format) { m_dateFormat = format; }
+
+    /*! The minimum year for the "100 year sliding date window": range of years that defines
+     where any year expressed as two digits falls. 1930 by default. */
+    int minimumYearFor100YearSlidingWindow() const { return m_minimumYear; }
+
+    void setMinimumYearFor100YearSlidingWindow(int year) { m_minimumYear = year; }
+
+    //! Character accepted as decimal separator in addition to '.'. By default it is
+    //! the decimal point of the current locale, or ',' if the locale uses '.'.
+    QChar decimalSeparator() const { return m_decimalSeparator; }
+
+    void setDecimalSeparator(QChar separator) { m_decimalSeparator = separator; }
+
+    //! Parses integer from @a text. @return false if @a text is not an integer
+    //! or is out of range of int.
+    static bool parseInt(QStringView text, int *value);
+
+    //! Parses decimal number from @a text.
+    bool parseDouble(QStringView text, double *value) const;
+
+    //! Parses valid date from @a text.
+    bool parseDate(QStringView text, QDate *date) const;
+
+    //! Parses valid time from @a text.
+    static bool parseTime(QStringView text, QTime *time);
+
+    //! Parses valid date and time from @a text.
+    bool parseDateTime(QStringView text, QDateTime *dateTime) const;
+
+private:
+    //! @return date built out of @a y, @a m, @a d parts,
+    //! taking minimumYearFor100YearSlidingWindow() into account
+    QDate buildDate(int y, int m, int d) const;
+
+    DateFormat m_dateFormat;
+    int m_minimumYear;
+    QChar m_decimalSeparator;
+};
+
+#endif
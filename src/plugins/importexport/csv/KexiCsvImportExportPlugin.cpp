@@ -20,12 +20,23 @@
 #include "KexiCsvImportExportPlugin.h"
 #include "kexicsvimportdialog.h"
 #include "kexicsvexportwizard.h"
+#include "kexicsvwidgets.h"
+#include "KexiCSVImportEngine.h"
+#include "KexiCSVReader.h"
 #include <core/KexiMainWindowIface.h>
 #include <core/kexiproject.h>
 #include <core/kexipart.h>
 #include <kexiutils/utils.h>
 
+#include <KDbConnection>
 #include <KDbTableOrQuerySchema>
+#include <KDbTableSchema>
+#include <KDbTransactionGuard>
+
+#include <KLocalizedString>
+
+#include <QDir>
+#include <QFile>
 
 KEXI_PLUGIN_FACTORY(KexiCsvImportExportPlugin, "kexi_csvimportexportplugin.json")
 
@@ -70,6 +81,114 @@ QWidget *KexiCsvImportExportPlugin::createWidget(const char* widgetClass,
     return 0;
 }
 
+//! Stores error information from @a result in @a args
+static void setError(QMap<QString, QString>* args, const KDbResult &result)
+{
+    args->insert("errorMessage", result.message());
+    args->insert("errorDetails", result.serverMessage());
+}
+
+//! @return true if @a text is name or caption of @a field
+static bool isNameOf(QStringView text, const KDbField &field)
+{
+    const QString name(text.trimmed().toString());
+    return 0 == name.compare(field.name(), Qt::CaseInsensitive)
+        || 0 == name.compare(field.captionOrName(), Qt::CaseInsensitive);
+}
+
+/*! Imports CSV file "fileName" into existing table "tableName" without using GUI.
+ Columns of the file are assigned to fields of the table in order. An autonumber primary key
+ is filled automatically if the file has one column less than the table. The first row is
+ skipped if it contains names or captions of the fields. */
+static bool importFile(KDbConnection *conn, QMap<QString, QString>* args)
+{
+    const QString tableName(args->value("tableName"));
+    KDbTableSchema *table = conn->tableSchema(tableName);
+    if (!table) {
+        setError(args, KDbResult(xi18nc("@info", "Table <resource>%1</resource> does not exist.",
+                                        tableName)));
+        return false;
+    }
+    const QString fileName(args->value("fileName"));
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly)) {
+        setError(args, KDbResult(xi18nc("@info", "Could not open file <filename>%1</filename>. %2",
+                                        QDir::toNativeSeparators(fileName), file.errorString())));
+        return false;
+    }
+    KexiCSVReader::Options readerOptions;
+    const QString delimiter(args->value("delimiter", KEXICSV_DEFAULT_FILE_DELIMITER));
+    readerOptions.delimiter = delimiter.isEmpty() ? QLatin1Char(',') : delimiter.at(0);
+    const QString textQuote(args->value("textQuote", KEXICSV_DEFAULT_FILE_TEXT_QUOTE));
+    readerOptions.textQuote = textQuote.isEmpty() ? QChar() : textQuote.at(0);
+
+    // the first row determines the column count and whether it contains field names
+    const int fieldCount = table->fieldCount();
+    int columnCount = 0;
+    bool implicitPrimaryKey = false;
+    bool firstRowForFieldNames = false;
+    {
+        KexiCSVReader reader(&file, readerOptions);
+        if (reader.readRow()) {
+            columnCount = reader.fieldCount();
+            implicitPrimaryKey = fieldCount > 1 && table->field(0)->isAutoIncrement()
+                                 && columnCount == fieldCount - 1;
+            firstRowForFieldNames = true;
+            for (int col = 0; col < columnCount && col + (implicitPrimaryKey ? 1 : 0) < fieldCount; ++col) {
+                if (!isNameOf(reader.field(col), *table->field(col + (implicitPrimaryKey ? 1 : 0)))) {
+                    firstRowForFieldNames = false;
+                    break;
+                }
+            }
+        }
+    }
+    const int firstField = implicitPrimaryKey ? 1 : 0;
+    if (columnCount > fieldCount - firstField) {
+        setError(args, KDbResult(xi18nc("@info", "Field count does not match. The file has %1 "
+                                        "columns while table <resource>%2</resource> has %3 fields.",
+                                        columnCount, tableName, fieldCount - firstField)));
+        return false;
+    }
+    QVector<KDbField::Type> columnTypes;
+    for (int i = firstField; i < fieldCount; ++i) {
+        const KDbField::Type type = table->field(i)->type();
+        if (KDbField::isIntegerType(type)) {
+            columnTypes.append(KDbField::Integer);
+        } else if (KDbField::isFPNumericType(type)) {
+            columnTypes.append(KDbField::Double);
+        } else {
+            columnTypes.append(type);
+        }
+    }
+
+    KDbTransaction transaction = conn->beginTransaction();
+    if (transaction.isNull()) {
+        setError(args, conn->result());
+        return false;
+    }
+    KDbTransactionGuard tg(transaction);
+    KexiCSVImportEngine::Options engineOptions;
+    engineOptions.firstRowForFieldNames = firstRowForFieldNames;
+    engineOptions.implicitPrimaryKey = implicitPrimaryKey;
+    // recordsPerTransaction is 0: the transaction guard above makes the import all-or-nothing
+    KexiCSVImportEngine engine(conn, table, engineOptions);
+    engine.setColumnTypes(columnTypes);
+    file.seek(0);
+    KexiCSVReader reader(&file, readerOptions);
+    const tristate res = engine.import(&reader);
+    args->insert("recordCount", QString::number(engine.importedRecordCount()));
+    args->insert("firstRecordElapsed", QString::number(engine.firstRecordElapsed()));
+    if (res != true) {
+        setError(args, engine.result());
+        return false;
+    }
+    if (!tg.commit()) {
+        setError(args, conn->result());
+        return false;
+    }
+    return true;
+}
+
 bool KexiCsvImportExportPlugin::executeCommand(const char* commandName,
         QMap<QString, QString>* args)
 {
@@ -83,7 +202,34 @@ bool KexiCsvImportExportPlugin::executeCommand(const char* commandName,
         if (args->contains("textStream")) {
             stream = KDbUtils::stringToPointer<QTextStream>(args->value("textStream"));
         }
-        return KexiCSVExport::exportData(conn, &tableOrQuery, options, -1, stream);
+        return KexiCSVExport::exportData(conn, &tableOrQuery, options, stream);
+    }
+    // Commands not using GUI, e.g. for the command line. The connection is passed in args.
+    // Number of records and time of reading the first record are put into the args,
+    // and error information on failure.
+    if (0 == qstrcmp(commandName, "KexiCSVExportFile")) {
+        KexiCSVExport::Options options;
+        if (!options.assign(args))
+            return false;
+        KDbConnection *conn = KDbUtils::stringToPointer<KDbConnection>(args->value("connection"));
+        KDbTableOrQuerySchema tableOrQuery(conn, options.itemId);
+        if (!tableOrQuery.table() && !tableOrQuery.query()) {
+            setError(args, KDbResult(xi18n("Could not open data for exporting.")));
+            return false;
+        }
+        KDbResult result;
+        KexiCSVExport::Statistics statistics;
+        const bool ok = KexiCSVExport::exportDataToFile(conn, &tableOrQuery, options, &result, &statistics);
+        args->insert("recordCount", QString::number(statistics.recordCount));
+        args->insert("firstRecordElapsed", QString::number(statistics.firstRecordElapsed));
+        if (!ok) {
+            setError(args, result);
+        }
+        return ok;
+    }
+    if (0 == qstrcmp(commandName, "KexiCSVImportFile")) {
+        KDbConnection *conn = KDbUtils::stringToPointer<KDbConnection>(args->value("connection"));
+        return importFile(conn, args);
     }
     return false;
 }
@@ -19,6 +19,7 @@
 
 #include "kexicsvexport.h"
 #include "kexicsvwidgets.h"
+#include "KexiCSVExportEngine.h"
 #include <core/KexiMainWindowIface.h>
 #include <core/kexiproject.h>
 #include <core/kexipartinfo.h>
@@ -27,9 +28,7 @@
 #include <kexiutils/utils.h>
 #include <widget/kexicharencodingcombobox.h>
 
-#include <KDb>
 #include <KDbConnection>
-#include <KDbCursor>
 #include <KDbQuerySchema>
 #include <KDbTableOrQuerySchema>
 #include <KDbTableSchema>
@@ -38,11 +37,21 @@
 #include <KLocalizedString>
 
 #include <QApplication>
+#include <QBuffer>
+#include <QTextCodec>
 #include <QTextStream>
 #include <QCheckBox>
 #include <QClipboard>
 #include <QDebug>
+#include <QDir>
 #include <QSaveFile>
+#include <QElapsedTimer>
+#include <QLocale>
+#include <QProgressDialog>
+#include <QScopedPointer>
+
+//! Number of milliseconds after which progress of a longer export is displayed
+#define PROGRESS_DIALOG_DELAY 500
 
 using namespace KexiCSVExport;
 
@@ -72,6 +81,8 @@ bool Options::assign(QMap<QString, QString> *args)
     if (!ok || itemId == 0) {
         result = false; //neverSaved items are supported
     }
+    if (args->contains("fileName"))
+        fileName = args->value("fileName");
     if (args->contains("forceDelimiter"))
         forceDelimiter = args->value("forceDelimiter");
     if (args->contains("addColumnNames"))
@@ -82,203 +93,154 @@ bool Options::assign(QMap<QString, QString> *args)
 
 //------------------------------------
 
+Statistics::Statistics()
+        : recordCount(0), bytesWritten(0), firstRecordElapsed(-1)
+{
+}
+
+//------------------------------------
+
+//! @return options of the export engine for @a options
+static KexiCSVExportEngine::Options engineOptions(const Options& options, bool collectText)
+{
+    KexiCSVExportEngine::Options result;
+    result.delimiter = options.delimiter.at(0);
+    result.textQuote = options.textQuote.isEmpty() ? QChar() : options.textQuote.at(0);
+    result.addColumnNames = options.addColumnNames;
+    // use native line ending for copying, RFC 4180 one for saving to file
+    result.lineEnd = options.mode == Clipboard ? "\n" : "\r\n";
+    // the same encoding as QTextStream used by default
+    result.codec = collectText ? nullptr : QTextCodec::codecForLocale();
+    return result;
+}
+
+//! @return query for @a tableOrQuery
+static KDbQuerySchema* queryFor(KDbTableOrQuerySchema *tableOrQuery)
+{
+    return tableOrQuery->query() ? tableOrQuery->query() : tableOrQuery->table()->query();
+}
+
+//! Exports data using @a engine to file @a fileName. The file is only replaced on success.
+//! On failure @a result is set.
+static tristate exportToFile(KexiCSVExportEngine *engine, const QString &fileName, KDbResult *result)
+{
+    if (fileName.isEmpty()) {//sanity
+        qWarning() << "Fname is empty";
+        return false;
+    }
+    QSaveFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly)) {
+        *result = KDbResult(xi18nc("@info", "Could not open file <filename>%1</filename> for writing. %2",
+                                   QDir::toNativeSeparators(fileName), file.errorString()));
+        return false;
+    }
+    const tristate res = engine->exportTo(&file);
+    if (res != true) {
+        if (res == false) {
+            *result = engine->result();
+        }
+        file.cancelWriting();
+        return res;
+    }
+    if (!file.commit()) {
+        *result = KDbResult(xi18nc("@info", "Could not save file <filename>%1</filename>. %2",
+                                   QDir::toNativeSeparators(fileName), file.errorString()));
+        return false;
+    }
+    return true;
+}
+
 bool KexiCSVExport::exportData(KDbConnection* conn, KDbTableOrQuerySchema *tableOrQuery,
-                               const Options& options, int recordCount, QTextStream *predefinedTextStream)
+                               const Options& options, QTextStream *predefinedTextStream,
+                               QWidget *progressParent)
 {
     if (!conn)
         return false;
 
-    KDbQuerySchema* query = tableOrQuery->query();
+    KDbQuerySchema* query = queryFor(tableOrQuery);
     QList<QVariant> queryParams;
-    if (!query) {
-        query = tableOrQuery->table()->query();
-    }
-    else {
+    if (tableOrQuery->query()) {
         queryParams = KexiMainWindowIface::global()->currentParametersForQuery(query->id());
     }
 
-    if (recordCount == -1)
-        recordCount = conn->recordCount(tableOrQuery, queryParams);
-    if (recordCount == -1)
-        return false;
-
-//! @todo move this to non-GUI location so it can be also used via command line
-//! @todo add a "finish" page with a progressbar.
-//! @todo look at recordCount whether the data is really large;
+//! @todo look at size of the data whether it's really large;
 //!       if so: avoid copying to clipboard (or ask user) because of system memory
 
-//! @todo OPTIMIZATION: use fieldsExpanded(true /*UNIQUE*/)
 //! @todo OPTIMIZATION? (avoid multiple data retrieving) look for already fetched data within KexiProject..
 
-    const KDbQueryColumnInfo::Vector fields(
-        query->fieldsExpanded(conn, KDbQuerySchema::FieldsExpandedMode::WithInternalFields));
-    QString buffer;
-
-    QScopedPointer<QSaveFile> kSaveFile;
-    QTextStream *stream = 0;
-    QScopedPointer<QTextStream> kSaveFileTextStream;
-
     const bool copyToClipboard = options.mode == Clipboard;
-    if (copyToClipboard) {
-//! @todo (during exporting): enlarge bufSize by factor of 2 when it became too small
-        int bufSize = qMin((recordCount < 0 ? 10 : recordCount) * fields.count() * 20, 128000);
-        buffer.reserve(bufSize);
-        if (buffer.capacity() < bufSize) {
-            qWarning() << "Cannot allocate memory for" << bufSize
-                       << "characters";
-            return false;
-        }
-    } else {
-        if (predefinedTextStream) {
-            stream = predefinedTextStream;
-        } else {
-            if (options.fileName.isEmpty()) {//sanity
-                qWarning() << "Fname is empty";
-                return false;
+    // text for clipboard or the predefined stream is collected as a whole
+    const bool collectText = copyToClipboard || predefinedTextStream;
+    KexiCSVExportEngine engine(conn, query, engineOptions(options, collectText));
+    engine.setQueryParameters(queryParams);
+
+    // number of records is not known, so only the number of bytes written is displayed
+    QScopedPointer<QProgressDialog> progressDlg;
+    QElapsedTimer elapsed;
+    if (progressParent) {
+        progressDlg.reset(new QProgressDialog(progressParent));
+        progressDlg->setObjectName("exportProgressDlg");
+        progressDlg->setWindowTitle(xi18nc("@title:window", "Exporting Data"));
+        progressDlg->setModal(true);
+        progressDlg->setRange(0, 0);
+        elapsed.start();
+        QObject::connect(&engine, &KexiCSVExportEngine::progress, progressDlg.data(),
+                         [&progressDlg, &engine, &elapsed](qint64 bytesWritten)
+        {
+            if (!progressDlg->isVisible() && elapsed.elapsed() < PROGRESS_DIALOG_DELAY) {
+                return;
             }
-            kSaveFile.reset(new QSaveFile(options.fileName));
-
-            //qDebug() << "QSaveFile Filename:" << kSaveFile->fileName();
-
-            if (kSaveFile->open(QIODevice::WriteOnly)) {
-                kSaveFileTextStream.reset(new QTextStream(kSaveFile.data()));
-                stream = kSaveFileTextStream.data();
-                //qDebug() << "have a stream";
+            progressDlg->setLabelText(xi18nc("@info", "Exporting data... %1 written",
+                                             QLocale().formattedDataSize(bytesWritten)));
+            progressDlg->show();
+            qApp->processEvents();
+            if (progressDlg->wasCanceled()) {
+                engine.cancel();
             }
-            if (QFileDevice::NoError != kSaveFile->error() || !stream) {//sanity
-                qWarning() << "Status != 0 or stream == 0";
-//! @todo show error
-                return false;
-            }
-        }
-    }
-
-//! @todo escape strings
-
-#define _ERR \
-    if (kSaveFile) { kSaveFile->cancelWriting(); } \
-    return false
-
-#define APPEND(what) \
-    if (copyToClipboard) buffer.append(what); else (*stream) << (what)
-
-// use native line ending for copying, RFC 4180 one for saving to file
-#define APPEND_EOLN \
-    if (copyToClipboard) { APPEND('\n'); } else { APPEND("\r\n"); }
-
-    // 0. Cache information
-    const int fieldsCount = query->fieldsExpanded(conn).count(); //real fields count without internals
-    const QChar delimiter(options.delimiter.at(0));
-    const bool hasTextQuote = !options.textQuote.isEmpty();
-    const QString textQuote(hasTextQuote ? options.textQuote.at(0) : QString());
-    const QByteArray escapedTextQuote((textQuote + textQuote).toLatin1());   //ok?
-    //cache for faster checks
-    QScopedArrayPointer<bool> isText(new bool[fieldsCount]);
-    QScopedArrayPointer<bool> isDateTime(new bool[fieldsCount]);
-    QScopedArrayPointer<bool> isTime(new bool[fieldsCount]);
-    QScopedArrayPointer<bool> isBLOB(new bool[fieldsCount]);
-    QScopedArrayPointer<int> visibleFieldIndex(new int[fieldsCount]);
-// bool isInteger[fieldsCount]; //cache for faster checks
-// bool isFloatingPoint[fieldsCount]; //cache for faster checks
-    for (int i = 0; i < fieldsCount; i++) {
-        KDbQueryColumnInfo* ci;
-        const int indexForVisibleLookupValue = fields[i]->indexForVisibleLookupValue();
-        if (-1 != indexForVisibleLookupValue) {
-            ci = query->expandedOrInternalField(conn, indexForVisibleLookupValue);
-            visibleFieldIndex[i] = indexForVisibleLookupValue;
-        } else {
-            ci = fields[i];
-            visibleFieldIndex[i] = i;
-        }
-
-        const KDbField::Type t = ci->field()->type(); // cache: evaluating type of expressions can be expensive
-        isText[i] = KDbField::isTextType(t);
-        isDateTime[i] = t == KDbField::DateTime;
-        isTime[i] = t == KDbField::Time;
-        isBLOB[i] = t == KDbField::BLOB;
-//  isInteger[i] = KDbField::isIntegerType(t)
-//   || t == KDbField::Boolean;
-//  isFloatingPoint[i] = KDbField::isFPNumericType(t);
+        });
     }
 
-    // 1. Output column names
-    if (options.addColumnNames) {
-        for (int i = 0; i < fieldsCount; i++) {
-            //qDebug() << "Adding column names";
-            if (i > 0) {
-                APPEND(delimiter);
-            }
-
-            if (hasTextQuote) {
-                APPEND(textQuote + fields[i]->captionOrAliasOrName().replace(textQuote, escapedTextQuote) + textQuote);
-            } else {
-                APPEND(fields[i]->captionOrAliasOrName());
-            }
+    QBuffer buffer;
+    KDbResult result;
+    tristate res;
+    if (collectText) {
+        buffer.open(QIODevice::WriteOnly);
+        res = engine.exportTo(&buffer);
+        if (res == false) {
+            result = engine.result();
         }
-        APPEND_EOLN
-    }
-
-    KexiGUIMessageHandler handler;
-    KDbCursor *cursor = conn->executeQuery(query, queryParams);
-    if (!cursor) {
-        handler.showErrorMessage(conn->result());
-        _ERR;
+    } else {
+        res = exportToFile(&engine, options.fileName, &result);
     }
-    for (cursor->moveFirst(); !cursor->eof() && !cursor->result().isError(); cursor->moveNext()) {
-        //qDebug() << "Adding records";
-        const int realFieldCount = qMin(cursor->fieldCount(), fieldsCount);
-        for (int i = 0; i < realFieldCount; i++) {
-            const int real_i = visibleFieldIndex[i];
-            if (i > 0) {
-                APPEND(delimiter);
-            }
-
-            if (cursor->value(real_i).isNull()) {
-                continue;
-            }
-
-            if (isText[real_i]) {
-                if (hasTextQuote)
-                    APPEND(textQuote + QString(cursor->value(real_i).toString()).replace(textQuote, escapedTextQuote) + textQuote);
-                else
-                    APPEND(cursor->value(real_i).toString());
-            } else if (isDateTime[real_i]) { //avoid "T" in ISO DateTime
-                APPEND(cursor->value(real_i).toDateTime().date().toString(Qt::ISODate) + " "
-                       + cursor->value(real_i).toDateTime().time().toString(Qt::ISODate));
-            } else if (isTime[real_i]) { //time is temporarily stored as null date + time...
-                APPEND(cursor->value(real_i).toTime().toString(Qt::ISODate));
-            } else if (isBLOB[real_i]) { //BLOB is escaped in a special way
-                if (hasTextQuote)
-//! @todo add options to suppport other types from KDbBLOBEscapingType enum...
-                    APPEND(textQuote + KDb::escapeBLOB(cursor->value(real_i).toByteArray(),
-                                                       KDb::BLOBEscapingType::Hex) + textQuote);
-                else
-                    APPEND(KDb::escapeBLOB(cursor->value(real_i).toByteArray(), KDb::BLOBEscapingType::Hex));
-            } else {//other types
-                APPEND(cursor->value(real_i).toString());
-            }
+    if (res != true) {
+        if (res == false && result.isError()) {
+            KexiGUIMessageHandler handler;
+            handler.showErrorMessage(result);
         }
-        APPEND_EOLN
+        return false;
     }
 
-    if (copyToClipboard)
-        buffer.squeeze();
-
-    if (!conn->deleteCursor(cursor)) {
-        handler.showErrorMessage(conn->result());
-        _ERR;
+    if (copyToClipboard) {
+        QApplication::clipboard()->setText(QString::fromUtf8(buffer.data()), QClipboard::Clipboard);
+    } else if (predefinedTextStream) {
+        (*predefinedTextStream) << QString::fromUtf8(buffer.data());
     }
 
-    if (copyToClipboard)
-        QApplication::clipboard()->setText(buffer, QClipboard::Clipboard);
-
     //qDebug() << "Done";
+    return true;
+}
 
-    if (kSaveFile) {
-        stream->flush();
-        if (!kSaveFile->commit()) {
-            qWarning() << "Error committing the file" << kSaveFile->fileName();
-        }
+bool KexiCSVExport::exportDataToFile(KDbConnection* conn, KDbTableOrQuerySchema *tableOrQuery,
+                                     const Options& options, KDbResult *result, Statistics *statistics)
+{
+    Q_ASSERT(conn);
+    Q_ASSERT(result);
+    KexiCSVExportEngine engine(conn, queryFor(tableOrQuery), engineOptions(options, false));
+    const tristate res = exportToFile(&engine, options.fileName, result);
+    if (statistics) {
+        statistics->recordCount = engine.exportedRecordCount();
+        statistics->bytesWritten = engine.bytesWritten();
+        statistics->firstRecordElapsed = engine.firstRecordElapsed();
     }
-    return true;
+    return res == true;
 }
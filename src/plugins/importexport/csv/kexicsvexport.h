@@ -23,7 +23,9 @@
 #include <KDbUtils>
 
 class QTextStream;
+class QWidget;
 class KDbConnection;
+class KDbResult;
 class KDbTableOrQuerySchema;
 
 namespace KexiCSVExport
@@ -51,15 +53,39 @@ public:
     bool useTempQuery;
 };
 
-/*! Exports data. \return false on failure.
+//! Statistics of an export done by exportDataToFile()
+class Statistics
+{
+public:
+    Statistics();
+
+    qint64 recordCount;
+    qint64 bytesWritten;
+    //! Number of milliseconds from the start of the export until the first record
+    //! has been read, -1 if there were no records
+    qint64 firstRecordElapsed;
+};
+
+/*! Exports data using KexiCSVExportEngine. Records are not counted before exporting.
+ Files are written in blocks so memory use does not depend on size of the data.
+ \return false on failure.
  @param conn connection
  @param tableOrQuery table OR query schema
  @param options options for the export
- @param recordCount record count of the input data or -1 if the record count has not yet been computed
  @param predefinedTextStream text stream that should be used instead of writing to a file
+ @param progressParent if not null, a progress dialog with this parent is displayed
+        while exporting takes longer; the export can be canceled using it
 */
 bool exportData(KDbConnection* conn, KDbTableOrQuerySchema *tableOrQuery, const Options& options,
-                int recordCount = -1,  QTextStream *predefinedTextStream = 0);
+                QTextStream *predefinedTextStream = 0, QWidget *progressParent = nullptr);
+
+/*! Exports data to file options.fileName without using GUI, e.g. from command line.
+ Values of query parameters are not asked for so queries are executed without parameters.
+ \return false on failure, in this case @a result contains error information.
+ Statistics of the export are stored in @a statistics if it is not null.
+*/
+bool exportDataToFile(KDbConnection* conn, KDbTableOrQuerySchema *tableOrQuery, const Options& options,
+                      KDbResult *result, Statistics *statistics = nullptr);
 
 }
 
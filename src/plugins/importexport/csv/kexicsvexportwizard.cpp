@@ -115,13 +115,10 @@ KexiCSVExportWizard::KexiCSVExportWizard(const KexiCSVExport::Options& options,
     }
 
     QString text = "\n" + captionOrName;
-    int m_recordCount = conn->recordCount(m_tableOrQuery);
+    // records are not counted, that would need executing the query once more
     int columns = m_tableOrQuery->fieldCount(conn);
     text += "\n";
-    if (m_recordCount > 0)
-        text += xi18n("(rows: %1, columns: %2)", m_recordCount, columns);
-    else
-        text += xi18n("(columns: %1)", columns);
+    text += xi18n("(columns: %1)", columns);
     infoLblFromText.append(text);
 
     // OK, source data found.
@@ -337,7 +334,7 @@ void KexiCSVExportWizard::done(int result)
         m_options.delimiter = m_delimiterWidget->delimiter();
         m_options.textQuote = m_textQuote->textQuote();
         m_options.addColumnNames = m_addColumnNamesCheckBox->isChecked();
-        if (!KexiCSVExport::exportData(conn, m_tableOrQuery, m_options))
+        if (!KexiCSVExport::exportData(conn, m_tableOrQuery, m_options, nullptr, this))
             return;
 
         //store options
@@ -27,6 +27,10 @@
 
 #include "kexicsvimportdialog.h"
 #include "KexiCSVImportDialogModel.h"
+#include "KexiCSVImportEngine.h"
+#include "KexiCSVReader.h"
+#include "KexiCSVTypeDetector.h"
+#include "KexiCSVUniquenessTracker.h"
 #include <KexiIcon.h>
 #include <kexiutils/utils.h>
 #include <core/kexi.h>
@@ -88,6 +92,10 @@
 #include <QDialog>
 #include <QDebug>
 #include <QRadioButton>
+#include <QFileInfo>
+#include <QScopedPointer>
+#include <QSet>
+#include <QEventLoop>
 
 #define _IMPORT_ICON koIconNeededWithSubs("change to file_import or so", "file_import","table")
 
@@ -160,12 +168,38 @@ Q_GLOBAL_STATIC(KexiCSVImportStatic, kexiCSVImportStatic)
 #define MAX_BYTES_TO_PREVIEW 10240 //max 10KB is reasonable
 #define MAX_CHARS_TO_SCAN_WHILE_DETECTING_DELIMITER 4096
 #define MINIMUM_YEAR_FOR_100_YEAR_SLIDING_WINDOW 1930
-#define PROGRESS_STEP_MS (1000/5) // 5 updates per second
+#define PREVIEW_BLOCK_SIZE 0x10000 // 64KB, larger than MAX_BYTES_TO_PREVIEW
+#define IMPORT_PROGRESS_MAXIMUM 1000 // progress is displayed in per mille, so huge files are supported
 
-static bool shouldSaveRow(int row, bool firstRowForFieldNames)
+//! @internal Import engine that asks the user whether the import should continue on errors
+class KexiCSVImportDialogEngine : public KexiCSVImportEngine
 {
-    return row > (firstRowForFieldNames ? 1 : 0);
-}
+public:
+    KexiCSVImportDialogEngine(QWidget *dialog, KDbConnection *conn, KDbTableSchema *destinationTable,
+                              const Options &options)
+        : KexiCSVImportEngine(conn, destinationTable, options)
+        , m_dialog(dialog)
+    {
+    }
+
+protected:
+    virtual bool insertFailed(const KDbPreparedStatementParameters &values) override
+    {
+        const QStringList msgList = KexiUtils::convertTypesUsingMethod<QVariant, QString, &QVariant::toString>(values);
+        const KMessageBox::ButtonCode msgRes = KMessageBox::warningContinueCancelList(m_dialog,
+                    xi18nc("@info", "An error occurred during insert record."),
+                    QStringList(msgList.join(";")),
+                    QString(),
+                    KStandardGuiItem::cont(),
+                    KStandardGuiItem::cancel(),
+                    "SkipImportErrors"
+                  );
+        return msgRes == KMessageBox::Continue;
+    }
+
+private:
+    QWidget * const m_dialog;
+};
 
 // --
 
@@ -174,14 +208,18 @@ class Q_DECL_HIDDEN KexiCSVImportDialog::Private
 public:
     Private()
         : imported(false)
+        , typeDetector(nullptr)
+        , primaryKeySetByUser(false)
     {
     }
     ~Private() {
+        delete typeDetector;
         qDeleteAll(m_uniquenessTest);
     }
 
     void clearDetectedTypes() {
         m_detectedTypes.clear();
+        typesSetByUser.clear();
     }
 
     void clearUniquenessTests() {
@@ -207,12 +245,12 @@ public:
         }
     }
 
-    QList<int>* uniquenessTest(int col) const
+    KexiCSVUniquenessTracker* uniquenessTest(int col) const
     {
         return m_uniquenessTest.value(col);
     }
 
-    void setUniquenessTest(int col, QList<int>* test)
+    void setUniquenessTest(int col, KexiCSVUniquenessTracker* test)
     {
         if (m_uniquenessTest.count() <= col) {
             for (int i = m_uniquenessTest.count(); i < col; ++i) { // append missing bits
@@ -226,14 +264,26 @@ public:
     }
 
     bool imported;
+
+    //! Detects types using all rows of the file, in the background
+    KexiCSVTypeDetector *typeDetector;
+
+    //! Columns with type selected by the user, not overwritten by typeDetector
+    QSet<int> typesSetByUser;
+
+    //! Parser used for detecting types of values, updated by fillTable()
+    KexiCSVValueParser valueParser;
+
+    //! true if primary key column has been selected or unset by the user,
+    //! so it's not changed by typeDetector
+    bool primaryKeySetByUser;
 private:
     //! vector of detected types
     //! @todo more types
     QList<KDbField::Type> m_detectedTypes;
 
-    //! m_detectedUniqueColumns[i]==true means that i-th column has unique values
-    //! (only for numeric type)
-    QList< QList<int>* > m_uniquenessTest;
+    //! Checks uniqueness of values of i-th column in the preview
+    QList<KexiCSVUniquenessTracker*> m_uniquenessTest;
 };
 
 // --
@@ -258,10 +308,6 @@ KexiCSVImportDialog::KexiCSVImportDialog(Mode mode, QWidget * parent)
         m_implicitPrimaryKeyAdded(false),
         m_allRowsLoadedInPreview(false),
         m_stoppedAt_MAX_BYTES_TO_PREVIEW(false),
-        m_stringNo("no"),
-        m_stringI18nNo(xi18n("no")),
-        m_stringFalse("false"),
-        m_stringI18nFalse(xi18n("false")),
         m_partItemForSavedTable(0),
         m_importInProgress(false),
         m_importCanceled(false),
@@ -309,7 +355,7 @@ KexiCSVImportDialog::KexiCSVImportDialog(Mode mode, QWidget * parent)
 
 
     m_file = 0;
-    m_inputStream = 0;
+    m_reader = 0;
 
     createOptionsPage();
     createImportMethodPage();
@@ -339,12 +385,6 @@ KexiCSVImportDialog::KexiCSVImportDialog(Mode mode, QWidget * parent)
       }
       else if ( mode == File )
       {*/
-    m_dateRegExp = QRegularExpression("^(\\d{1,4})([/\\-\\.])(\\d{1,2})([/\\-\\.])(\\d{1,4})$");
-    m_timeRegExp1 = QRegularExpression("^(\\d{1,2}):(\\d{1,2}):(\\d{1,2})$");
-    m_timeRegExp2 = QRegularExpression("^(\\d{1,2}):(\\d{1,2})$");
-    m_fpNumberRegExp1 = QRegularExpression("^[\\-]{0,1}\\d*[,\\.]\\d+$");
-    // E notation, e.g. 0.1e2, 0.1e+2, 0.1e-2, 0.1E2, 0.1E+2, 0.1E-2
-    m_fpNumberRegExp2 = QRegularExpression("^[\\-]{0,1}\\d*[,\\.]\\d+[Ee][+-]{0,1}\\d+$");
     m_loadingProgressDlg = 0;
     if (m_mode == Clipboard) {
         m_infoLbl->setIcon(koIconName("edit-paste"));
@@ -380,8 +420,8 @@ KexiCSVImportDialog::KexiCSVImportDialog(Mode mode, QWidget * parent)
 
 KexiCSVImportDialog::~KexiCSVImportDialog()
 {
+    delete m_reader;
     delete m_file;
-    delete m_inputStream;
     delete d;
 }
 
@@ -838,8 +878,8 @@ bool KexiCSVImportDialog::openData()
     if (m_mode != File) //data already loaded, no encoding stuff needed
         return true;
 
-    delete m_inputStream;
-    m_inputStream = 0;
+    delete m_reader;
+    m_reader = 0;
     if (m_file) {
         m_file->close();
         delete m_file;
@@ -876,30 +916,25 @@ void KexiCSVImportDialog::fillTable()
     if (m_table->rowCount() > 0) //to accept editor
         m_tableView->setCurrentIndex(QModelIndex());
 
-    int row, column, maxColumn;
-    QString field;
+    int row, maxColumn;
 
     m_table->clear();
+    delete d->typeDetector; // results would be out of date
+    d->typeDetector = nullptr;
     d->clearDetectedTypes();
+    d->valueParser = valueParser();
     d->clearUniquenessTests();
     m_primaryKeyColumn = -1;
+    d->primaryKeySetByUser = false;
 
-    if (true != loadRows(field, row, column, maxColumn, true))
+    if (true != loadRows(row, maxColumn))
         return;
 
-    // file with only one line without EOL
-    if (field.length() > 0) {
-        setText(row - m_startline, column, field, true);
-        ++row;
-        field.clear();
-    }
-
     adjustRows(row - m_startline - (m_1stRowForFieldNames->isChecked() ? 1 : 0));
 
-    maxColumn = qMax(maxColumn, column);
     m_table->setColumnCount(maxColumn);
 
-    for (column = 0; column < m_table->columnCount(); ++column) {
+    for (int column = 0; column < m_table->columnCount(); ++column) {
         updateColumn(column);
         if (!m_columnsAdjusted)
             m_tableView->resizeColumnToContents(column);
@@ -940,6 +975,7 @@ void KexiCSVImportDialog::fillTable()
         m_startAtLineLabel->setEnabled(false);
     }
     updateRowCountInfo();
+    startTypeDetection();
 
     m_blockUserEvents = false;
     repaint();
@@ -967,7 +1003,7 @@ QString KexiCSVImportDialog::detectDelimiterByLookingAtFirstBytesOfFile(QTextStr
     int line = 0;
     bool wasChar13 = false; // true if previous x was '\r'
     for (int i = 0; !inputStream->atEnd() && i < MAX_CHARS_TO_SCAN_WHILE_DETECTING_DELIMITER; i++) {
-        (*m_inputStream) >> c; // read one char
+        (*inputStream) >> c; // read one char
         if (prevChar == '"') {
             if (c != '"') //real quote (not double "")
                 insideQuote = !insideQuote;
@@ -1048,244 +1084,68 @@ QString KexiCSVImportDialog::detectDelimiterByLookingAtFirstBytesOfFile(QTextStr
     return KEXICSV_DEFAULT_FILE_DELIMITER; //<-- default
 }
 
-tristate KexiCSVImportDialog::loadRows(QString &field, int &row, int &column, int &maxColumn,
-                                       bool inGUI)
+KexiCSVReader::Options KexiCSVImportDialog::readerOptions() const
+{
+    KexiCSVReader::Options options;
+    options.delimiter = m_delimiterWidget->delimiter()[0];
+    options.textQuote = m_textquote;
+    if (m_parseComments) {
+        options.commentSymbol = m_commentWidget->commentSymbol()[0];
+    }
+    options.ignoreDuplicateDelimiters = m_ignoreDuplicates->isChecked();
+    if (m_mode == File) {
+        options.codec = KCharsets::charsets()->codecForName(m_options.encoding);
+    }
+    return options;
+}
+
+KexiCSVValueParser KexiCSVImportDialog::valueParser() const
+{
+    KexiCSVValueParser parser;
+    parser.setDateFormat(static_cast<KexiCSVValueParser::DateFormat>(m_options.dateFormat));
+    parser.setMinimumYearFor100YearSlidingWindow(m_minimumYearFor100YearSlidingWindow);
+    return parser;
+}
+
+tristate KexiCSVImportDialog::loadRows(int &row, int &maxColumn)
 {
-    enum { S_START, S_QUOTED_FIELD, S_MAYBE_END_OF_QUOTED_FIELD, S_END_OF_QUOTED_FIELD,
-           S_MAYBE_NORMAL_FIELD, S_NORMAL_FIELD, S_COMMENT
-         } state = S_START;
-    field.clear();
-    const bool ignoreDups = m_ignoreDuplicates->isChecked();
-    bool lastCharDelimiter = false;
-    bool nextRow = false;
-    row = column = 1;
-    m_prevColumnForSetText = 0;
+    row = 1;
     maxColumn = 0;
-    QChar x;
-    const bool hadInputStream = m_inputStream != 0;
-    delete m_inputStream;
+    const bool hadReader = m_reader != 0;
+    delete m_reader;
+    m_reader = 0;
     if (m_mode == Clipboard) {
-        m_inputStream = new QTextStream(&m_clipboardData, QIODevice::ReadOnly);
-        if (!hadInputStream)
+        if (!hadReader)
             m_delimiterWidget->setDelimiter(KEXICSV_DEFAULT_CLIPBOARD_DELIMITER);
+        m_reader = new KexiCSVReader(m_clipboardData, readerOptions());
     } else {
         m_file->seek(0); //always seek at 0 because loadRows() is called many times
-        m_inputStream = new QTextStream(m_file);
-        QTextCodec *codec = KCharsets::charsets()->codecForName(m_options.encoding);
-        if (codec) {
-            m_inputStream->setCodec(codec); //QTextCodec::codecForName("CP1250"));
-        }
         if (m_detectDelimiter) {
-            const QString delimiter(detectDelimiterByLookingAtFirstBytesOfFile(m_inputStream));
+            QTextStream inputStream(m_file);
+            QTextCodec *codec = KCharsets::charsets()->codecForName(m_options.encoding);
+            if (codec) {
+                inputStream.setCodec(codec); //QTextCodec::codecForName("CP1250"));
+            }
+            const QString delimiter(detectDelimiterByLookingAtFirstBytesOfFile(&inputStream));
             if (m_delimiterWidget->delimiter() != delimiter)
                 m_delimiterWidget->setDelimiter(delimiter);
+            m_file->seek(0);
         }
+        KexiCSVReader::Options options(readerOptions());
+        options.blockSize = PREVIEW_BLOCK_SIZE; // only the beginning of the file is needed
+        m_reader = new KexiCSVReader(m_file, options);
     }
-    const QChar delimiter(m_delimiterWidget->delimiter()[0]);
-    const QChar commentSymbol(m_commentWidget->commentSymbol()[0]);
     m_stoppedAt_MAX_BYTES_TO_PREVIEW = false;
-    if (m_importingProgressBar) {
-        m_elapsedTimer.start();
-        m_elapsedMs = m_elapsedTimer.elapsed();
-    }
-    int offset = 0;
-    bool wasChar13 = false; // true if previous x was '\r'
-    for (;; ++offset) {
-        if (m_importingProgressBar && (offset % 0x100) == 0
-            && (m_elapsedMs + PROGRESS_STEP_MS) < m_elapsedTimer.elapsed())
-        {
-            //update progr. bar dlg on final exporting
-            m_elapsedMs = m_elapsedTimer.elapsed();
-            m_importingProgressBar->setValue(offset);
-            qApp->processEvents();
-            if (m_importCanceled) {
-                return ::cancelled;
+    while (m_reader->readRow()) {
+        const int fieldCount = m_reader->fieldCount();
+        for (int column = 0; column < fieldCount; ++column) {
+            const QStringView field(m_reader->field(column));
+            if (!field.isEmpty()) {
+                setText(row - m_startline, column + 1, field.toString());
             }
         }
-        if (m_inputStream->atEnd()) {
-            if (x != '\n' && x != '\r') {
-                x = '\n'; // simulate missing \n at end
-                wasChar13 = false;
-            }
-            else {
-                break; // finish!
-            }
-        }
-        else {
-            (*m_inputStream) >> x; // read one char
-        }
-
-        if (wasChar13 && x == '\n') {
-            wasChar13 = false;
-            continue; // previous x was '\r', eat '\n'
-        }
-        wasChar13 = x == '\r';
-        if (offset == 0 && x.unicode() == 0xfeff) {
-            // Ignore BOM, the "Byte Order Mark"
-            // (http://en.wikipedia.org/wiki/Byte_Order_Mark, // http://www.unicode.org/charts/PDF/UFFF0.pdf)
-            // Probably fixed in Qt4.
-            continue;
-        }
-
-        switch (state) {
-        case S_START :
-            if (x == m_textquote) {
-                state = S_QUOTED_FIELD;
-            } else if (x == delimiter) {
-                field.clear();
-                if ((ignoreDups == false) || (lastCharDelimiter == false))
-                    ++column;
-                lastCharDelimiter = true;
-            } else if (x == '\n' || x == '\r' || (x == commentSymbol && m_parseComments)) {
-                if (!inGUI) {
-                    //fill remaining empty fields (database wants them explicitly)
-                    for (int additionalColumn = column; additionalColumn <= maxColumn; additionalColumn++) {
-                        setText(row - m_startline, additionalColumn, QString(), inGUI);
-                    }
-                }
-                nextRow = true;
-                if (ignoreDups && lastCharDelimiter) {
-                    // we're ignoring repeated delimiters so remove any extra trailing delimiters
-                    --column;
-                }
-                maxColumn = qMax(maxColumn, column);
-                column = 1;
-                m_prevColumnForSetText = 0;
-                if (x == commentSymbol && m_parseComments) {
-                    state = S_COMMENT;
-                    maxColumn -= 1;
-                    break;
-                }
-            } else {
-                field += x;
-                state = S_MAYBE_NORMAL_FIELD;
-            }
-            break;
-        case S_QUOTED_FIELD :
-            if (x == m_textquote) {
-                state = S_MAYBE_END_OF_QUOTED_FIELD;
-            }
-            /*allow \n inside quoted fields
-                  else if (x == '\n')
-                  {
-                    setText(row - m_startline, column, field, inGUI);
-                    field = "";
-                    if (x == '\n')
-                    {
-                      nextRow = true;
-                      maxColumn = qMax( maxColumn, column );
-                      column = 1;
-                    }
-                    else
-                    {
-                      if ((ignoreDups == false) || (lastCharDelimiter == false))
-                        ++column;
-                      lastCharDelimiter = true;
-                    }
-                    state = S_START;
-                  }*/
-            else {
-                field += x;
-            }
-            break;
-        case S_MAYBE_END_OF_QUOTED_FIELD :
-            if (x == m_textquote) {
-                field += x; //no, this was just escaped quote character
-                state = S_QUOTED_FIELD;
-            } else if (x == delimiter || x == '\n' || x == '\r' || (x == commentSymbol && m_parseComments)) {
-                setText(row - m_startline, column, field, inGUI);
-                field.clear();
-                if (x == '\n' || x == '\r' || (x == commentSymbol && m_parseComments)) {
-                    nextRow = true;
-                    maxColumn = qMax(maxColumn, column);
-                    column = 1;
-                    m_prevColumnForSetText = 0;
-                    if (x == commentSymbol && m_parseComments) {
-                        state = S_COMMENT;
-                        break;
-                    }
-                } else {
-                    if ((ignoreDups == false) || (lastCharDelimiter == false))
-                        ++column;
-                    lastCharDelimiter = true;
-                }
-                state = S_START;
-            } else {
-                state = S_END_OF_QUOTED_FIELD;
-            }
-            break;
-        case S_END_OF_QUOTED_FIELD :
-            if (x == delimiter || x == '\n' || x == '\r' || (x == commentSymbol && m_parseComments)) {
-                setText(row - m_startline, column, field, inGUI);
-                field.clear();
-                if (x == '\n' || x == '\r' || (x == commentSymbol && m_parseComments)) {
-                    nextRow = true;
-                    maxColumn = qMax(maxColumn, column);
-                    column = 1;
-                    m_prevColumnForSetText = 0;
-                    if (x == commentSymbol && m_parseComments) {
-                        state = S_COMMENT;
-                        break;
-                    }
-                } else {
-                    if ((ignoreDups == false) || (lastCharDelimiter == false))
-                        ++column;
-                    lastCharDelimiter = true;
-                }
-                state = S_START;
-            } else {
-                state = S_END_OF_QUOTED_FIELD;
-            }
-            break;
-        case S_COMMENT :
-            if (x == '\n' || x == '\r') {
-                state = S_START;
-            }
-            if (lastCharDelimiter) {
-                lastCharDelimiter = false;
-            }
-            break;
-        case S_MAYBE_NORMAL_FIELD :
-        case S_NORMAL_FIELD :
-            if (state == S_MAYBE_NORMAL_FIELD && x == m_textquote) {
-                field.clear();
-                state = S_QUOTED_FIELD;
-                break;
-            }
-            if (x == delimiter || x == '\n' || x == '\r' || (x == commentSymbol && m_parseComments)) {
-                setText(row - m_startline, column, field, inGUI);
-                field.clear();
-                if (x == '\n' || x == '\r' || (x == commentSymbol && m_parseComments)) {
-                    nextRow = true;
-                    maxColumn = qMax(maxColumn, column);
-                    column = 1;
-                    m_prevColumnForSetText = 0;
-                    if (x == commentSymbol && m_parseComments) {
-                        state = S_COMMENT;
-                        break;
-                    }
-                } else {
-                    if ((ignoreDups == false) || (lastCharDelimiter == false))
-                        ++column;
-                    lastCharDelimiter = true;
-                }
-                state = S_START;
-            } else {
-                field += x;
-            }
-            break;
-        } // switch
-        if (x != delimiter)
-            lastCharDelimiter = false;
-
-        if (nextRow) {
-            if (!inGUI && !shouldSaveRow(row - m_startline, m_1stRowForFieldNames->isChecked())) {
-                // do not save to the database 1st row if it contains column names
-                m_valuesToInsert.clear();
-            } else if (!saveRow(inGUI))
-                return false;
-            ++row;
-        }
+        maxColumn = qMax(maxColumn, fieldCount);
+        ++row;
 
         if (m_firstFillTableCall && row == 2
                 && !m_1stRowForFieldNames->isChecked() && m_table->firstRowForFieldNames()) {
@@ -1297,9 +1157,8 @@ tristate KexiCSVImportDialog::loadRows(QString &field, int &row, int &column, in
             return false;
         }
 
-        if (!m_importingProgressBar && row % 20 == 0) {
+        if (row % 20 == 0) {
             qApp->processEvents();
-            //only for GUI mode:
             if (!m_firstFillTableCall && m_loadingProgressDlg && m_loadingProgressDlg->wasCanceled()) {
                 delete m_loadingProgressDlg;
                 m_loadingProgressDlg = 0;
@@ -1313,18 +1172,14 @@ tristate KexiCSVImportDialog::loadRows(QString &field, int &row, int &column, in
             m_loadingProgressDlg->setValue(qMin(m_maximumRowsForPreview, row));
         }
 
-        if (inGUI && row > (m_maximumRowsForPreview + (m_table->firstRowForFieldNames() ? 1 : 0))) {
+        if (row > (m_maximumRowsForPreview + (m_table->firstRowForFieldNames() ? 1 : 0))) {
             //qDebug() << "loading stopped at row #" << m_maximumRowsForPreview;
             break;
         }
-        if (nextRow) {
-            nextRow = false;
-            //additional speedup: stop processing now if too many bytes were loaded for preview
-            //qDebug() << offset;
-            if (inGUI && offset >= m_maximumBytesForPreview && row >= 2) {
-                m_stoppedAt_MAX_BYTES_TO_PREVIEW = true;
-                return true;
-            }
+        //additional speedup: stop processing now if too many bytes were loaded for preview
+        if (m_reader->charactersRead() >= m_maximumBytesForPreview && row >= 2) {
+            m_stoppedAt_MAX_BYTES_TO_PREVIEW = true;
+            return true;
         }
     }
     return true;
@@ -1348,32 +1203,22 @@ void KexiCSVImportDialog::updateColumn(int col)
 
 bool KexiCSVImportDialog::isPrimaryKeyAllowed(int col)
 {
-    QList<int> *list = d->uniquenessTest(col);
-    if (m_primaryKeyColumn != -1 || !list || list->isEmpty()) {
+    const KexiCSVUniquenessTracker *tracker = d->uniquenessTest(col);
+    if (m_primaryKeyColumn != -1 || !tracker || KDbField::Integer != d->detectedType(col)) {
         return false;
     }
-    bool result = false;
     int expectedRowCount = m_table->rowCount();
     if (m_table->firstRowForFieldNames()) {
         expectedRowCount--;
     }
-    if (list->count() == expectedRowCount) {
-        std::sort(list->begin(), list->end());
-        QList<int>::ConstIterator it = list->constBegin();
-        int prevValue = *it;
-        ++it;
-        for (; it != list->constEnd() && prevValue != (*it); ++it) {
-            prevValue = (*it);
-        }
-        result = it == list->constEnd(); // no duplicates
-    }
-    list->clear(); // not needed now: conserve memory
-    return result;
+    return tracker->valueCount() == expectedRowCount
+        && tracker->uniqueness() == KexiCSVUniquenessTracker::Unique;
 }
 
 void KexiCSVImportDialog::detectTypeAndUniqueness(int row, int col, const QString& text)
 {
     int intValue;
+    const bool isInteger = KexiCSVValueParser::parseInt(text, &intValue);
     KDbField::Type type = d->detectedType(col);
     if (row == 1 || type != KDbField::Text) {
         bool found = false;
@@ -1384,7 +1229,8 @@ void KexiCSVImportDialog::detectTypeAndUniqueness(int row, int col, const QStrin
         if (!found && (row == 1 || type == KDbField::Integer || type == KDbField::Double
                                 || type == KDbField::InvalidType))
         {
-            bool ok = text.isEmpty() || m_fpNumberRegExp1.match(text).hasMatch() || m_fpNumberRegExp2.match(text).hasMatch();
+            double doubleValue;
+            bool ok = text.isEmpty() || (!isInteger && d->valueParser.parseDouble(text, &doubleValue));
             if (ok && (row == 1 || type == KDbField::InvalidType))
             {
                 d->setDetectedType(col, KDbField::Double);
@@ -1393,9 +1239,7 @@ void KexiCSVImportDialog::detectTypeAndUniqueness(int row, int col, const QStrin
         }
         //-number?
         if (!found && (row == 1 || type == KDbField::Integer || type == KDbField::InvalidType)) {
-            bool ok = text.isEmpty();//empty values allowed
-            if (!ok)
-                intValue = text.toInt(&ok);
+            bool ok = text.isEmpty() || isInteger; //empty values allowed
             if (ok && (row == 1 || type == KDbField::InvalidType)) {
                 d->setDetectedType(col, KDbField::Integer);
                 found = true; //yes
@@ -1403,16 +1247,18 @@ void KexiCSVImportDialog::detectTypeAndUniqueness(int row, int col, const QStrin
         }
         //-date?
         if (!found && (row == 1 || type == KDbField::Date || type == KDbField::InvalidType)) {
+            QDate date;
             if ((row == 1 || type == KDbField::InvalidType)
-                    && (text.isEmpty() || m_dateRegExp.match(text).hasMatch())) {
+                    && (text.isEmpty() || d->valueParser.parseDate(text, &date))) {
                 d->setDetectedType(col, KDbField::Date);
                 found = true; //yes
             }
         }
         //-time?
         if (!found && (row == 1 || type == KDbField::Time || type == KDbField::InvalidType)) {
+            QTime time;
             if ((row == 1 || type == KDbField::InvalidType)
-                 && (text.isEmpty() || m_timeRegExp1.match(text).hasMatch() || m_timeRegExp2.match(text).hasMatch()))
+                 && (text.isEmpty() || KexiCSVValueParser::parseTime(text, &time)))
             {
                 d->setDetectedType(col, KDbField::Time);
                 found = true; //yes
@@ -1420,26 +1266,12 @@ void KexiCSVImportDialog::detectTypeAndUniqueness(int row, int col, const QStrin
         }
         //-date/time?
         if (!found && (row == 1 || type == KDbField::Time || type == KDbField::InvalidType)) {
-            if (row == 1 || type == KDbField::InvalidType) {
-                bool detected = text.isEmpty();
-                if (!detected) {
-                    const QStringList dateTimeList(text.split(' '));
-                    bool ok = dateTimeList.count() >= 2;
-//! @todo also support ISODateTime's "T" separator?
-//! @todo also support timezones?
-                    if (ok) {
-                        //try all combinations
-                        QString datePart(dateTimeList[0].trimmed());
-                        QString timePart(dateTimeList[1].trimmed());
-                        ok = m_dateRegExp.match(datePart).hasMatch()
-                             && (m_timeRegExp1.match(timePart).hasMatch() || m_timeRegExp2.match(timePart).hasMatch());
-                    }
-                    detected = ok;
-                }
-                if (detected) {
-                    d->setDetectedType(col, KDbField::DateTime);
-                    found = true; //yes
-                }
+            QDateTime dateTime;
+            if ((row == 1 || type == KDbField::InvalidType)
+                 && (text.isEmpty() || d->valueParser.parseDateTime(text, &dateTime)))
+            {
+                d->setDetectedType(col, KDbField::DateTime);
+                found = true; //yes
             }
         }
         if (!found && type == KDbField::InvalidType && !text.isEmpty()) {
@@ -1453,168 +1285,117 @@ void KexiCSVImportDialog::detectTypeAndUniqueness(int row, int col, const QStrin
     type = d->detectedType(col);
     //qDebug() << type;
 
-    if (type == KDbField::Integer) {
-        // check uniqueness for this value
-        QList<int> *list = d->uniquenessTest(col);
-        if (text.isEmpty()) {
-            if (list) {
-                list->clear(); // empty value cannot be in PK
-            }
-        }
-        else {
-            if (!list) {
-                list = new QList<int>();
-                d->setUniquenessTest(col, list);
-            }
-            list->append(intValue);
-        }
+    // check uniqueness for this value
+    KexiCSVUniquenessTracker *tracker = d->uniquenessTest(col);
+    if (!tracker) {
+        tracker = new KexiCSVUniquenessTracker;
+        d->setUniquenessTest(col, tracker);
+    }
+    if (text.isEmpty()) {
+        tracker->addEmpty(); // empty value cannot be in PK
+    } else if (isInteger) {
+        tracker->addInteger(intValue);
+    } else {
+        tracker->addText(text);
     }
 }
 
-QDate KexiCSVImportDialog::buildDate(int y, int m, int d) const
+void KexiCSVImportDialog::startTypeDetection()
 {
-    if (y < 100) {
-        if ((1900 + y) >= m_minimumYearFor100YearSlidingWindow)
-            return QDate(1900 + y, m, d);
-        else
-            return QDate(2000 + y, m, d);
+    delete d->typeDetector; // cancels previous detection
+    d->typeDetector = nullptr;
+    if (m_mode != File || !m_file || m_allRowsLoadedInPreview) {
+        return; // the preview already checked all the rows
+    }
+    d->typeDetector = new KexiCSVTypeDetector(readerOptions());
+    d->typeDetector->setValueParser(d->valueParser);
+    d->typeDetector->setSkippedRows(m_startline + (m_1stRowForFieldNames->isChecked() ? 1 : 0));
+    connect(d->typeDetector, &KexiCSVTypeDetector::finished,
+            this, &KexiCSVImportDialog::slotTypeDetectionFinished);
+    if (!d->typeDetector->start(m_fname)) {
+        delete d->typeDetector;
+        d->typeDetector = nullptr;
     }
-    return QDate(y, m, d);
 }
 
-bool KexiCSVImportDialog::parseDate(const QString& text, QDate& date)
+bool KexiCSVImportDialog::waitForTypeDetection()
 {
-    QRegularExpressionMatch match = m_dateRegExp.match(text);
-    if (!match.hasMatch())
-        return false;
-    //dddd - dd - dddd
-    //1    2 3  4 5    <- pos
-    const int d1 = match.captured(1).toInt(), d3 = match.captured(3).toInt(), d5 = match.captured(5).toInt();
-    switch (m_options.dateFormat) {
-    case KexiCSVImportOptions::DMY: date = buildDate(d5, d3, d1); break;
-    case KexiCSVImportOptions::YMD: date = buildDate(d1, d3, d5); break;
-    case KexiCSVImportOptions::MDY: date = buildDate(d5, d1, d3); break;
-    case KexiCSVImportOptions::AutoDateFormat:
-        if (match.captured(2) == "/") { //probably separator for american format mm/dd/yyyy
-            date = buildDate(d5, d1, d3);
-        } else {
-            if (d5 > 31) //d5 == year
-                date = buildDate(d5, d3, d1);
-            else //d1 == year
-                date = buildDate(d1, d3, d5);
+    if (d->typeDetector->isRunning()) {
+        QProgressDialog progressDlg(this);
+        progressDlg.setObjectName("typeDetectionProgressDlg");
+        progressDlg.setLabelText(
+            xi18nc("@info", "Detecting types of columns in <filename>%1</filename>...",
+                   QDir::toNativeSeparators(m_fname)));
+        progressDlg.setWindowTitle(xi18nc("@title:window", "Detecting Column Types"));
+        progressDlg.setModal(true);
+        progressDlg.setRange(0, 0); // busy indicator, the detector does not report progress
+        QEventLoop loop;
+        // slotTypeDetectionFinished() is connected first, so results are taken before quitting
+        connect(d->typeDetector, &KexiCSVTypeDetector::finished, &loop, &QEventLoop::quit);
+        connect(&progressDlg, &QProgressDialog::canceled, &loop, &QEventLoop::quit);
+        progressDlg.show();
+        loop.exec();
+        if (progressDlg.wasCanceled()) {
+            return false;
         }
-        break;
-    default:;
     }
-    return date.isValid();
+    slotTypeDetectionFinished(); // no-op if results have been already taken
+    return true;
 }
 
-bool KexiCSVImportDialog::parseTime(const QString& text, QTime& time)
+void KexiCSVImportDialog::slotTypeDetectionFinished()
 {
-    time = QTime::fromString(text, Qt::ISODate); //same as m_timeRegExp1
-    if (time.isValid())
-        return true;
-
-    QRegularExpressionMatch match = m_timeRegExp2.match(text);
-    if (match.hasMatch()) { //hh:mm:ss
-        time = QTime(match.captured(1).toInt(),
-                     match.captured(3).toInt(), match.captured(5).toInt());
-        return true;
+    if (!d->typeDetector) {
+        return;
     }
-    return false;
-}
-
-void KexiCSVImportDialog::setText(int row, int col, const QString& text, bool inGUI)
-{
-    if (!inGUI) {
-        if (!shouldSaveRow(row, m_1stRowForFieldNames->isChecked()))
-            return; // do not care about this value if it contains column names (these were already used)
-
-        //save text directly to database buffer
-        if (m_prevColumnForSetText == 0) { //1st call
-            m_valuesToInsert.clear();
-            if (m_implicitPrimaryKeyAdded) {
-                m_valuesToInsert << QVariant(); //id will be autogenerated here
-            }
+    const QVector<KDbField::Type> types(d->typeDetector->types());
+    QVector<KexiCSVUniquenessTracker::Uniqueness> uniqueness(types.count());
+    for (int col = 0; col < types.count(); ++col) {
+        uniqueness[col] = d->typeDetector->uniqueness(col);
+    }
+    d->typeDetector->deleteLater(); // the slot may be called by the detector's signal
+    d->typeDetector = nullptr;
+    const int oldPrimaryKeyColumn = m_primaryKeyColumn;
+    for (int col = 0; col < m_table->columnCount() && col < types.count(); ++col) {
+        const KDbField::Type type = types[col] == KDbField::InvalidType ? KDbField::Text : types[col];
+        if (d->typesSetByUser.contains(col) || type == d->detectedType(col)) {
+            continue;
         }
-        if ((m_prevColumnForSetText + 1) < col) { //skipped one or more columns
-                                                  //before this: save NULLs first
-            for (int i = m_prevColumnForSetText + 1; i < col; i++) {
-                if (m_options.nullsImportedAsEmptyTextChecked && KDbField::isTextType(d->detectedType(i-1))) {
-                    m_valuesToInsert << QString("");
-                } else {
-                    m_valuesToInsert << QVariant();
-                }
-            }
+        d->setDetectedType(col, type);
+        if (col == m_primaryKeyColumn && type != KDbField::Integer) {
+            m_primaryKeyColumn = -1;
         }
-        m_prevColumnForSetText = col;
-
-        const KDbField::Type detectedType = d->detectedType(col-1);
-        if (detectedType == KDbField::Integer) {
-            m_valuesToInsert << (text.isEmpty() ? QVariant() : text.toInt());
-//! @todo what about time and float/double types and different integer subtypes?
-        } else if (detectedType == KDbField::Double) {
-            //replace ',' with '.'
-            QByteArray t(text.toLatin1());
-            const int textLen = t.length();
-            for (int i = 0; i < textLen; i++) {
-                if (t[i] == ',') {
-                    t[i] = '.';
-                    break;
-                }
-            }
-            m_valuesToInsert << (t.isEmpty() ? QVariant() : t.toDouble());
-        } else if (detectedType == KDbField::Boolean) {
-            const QString t(text.trimmed().toLower());
-            if (t.isEmpty())
-                m_valuesToInsert << QVariant();
-            else if (t == "0" || t == m_stringNo || t == m_stringI18nNo || t == m_stringFalse || t == m_stringI18nFalse)
-                m_valuesToInsert << QVariant(false);
-            else
-                m_valuesToInsert << QVariant(true); //anything nonempty
-        } else if (detectedType == KDbField::Date) {
-            QDate date;
-            if (parseDate(text, date))
-                m_valuesToInsert << date;
-            else
-                m_valuesToInsert << QVariant();
-        } else if (detectedType == KDbField::Time) {
-            QTime time;
-            if (parseTime(text, time))
-                m_valuesToInsert << time;
-            else
-                m_valuesToInsert << QVariant();
-        } else if (detectedType == KDbField::DateTime) {
-            QStringList dateTimeList(text.split(' '));
-            if (dateTimeList.count() < 2)
-                dateTimeList = text.split('T'); //also support ISODateTime's "T" separator
-//! @todo also support timezones?
-            if (dateTimeList.count() >= 2) {
-                //try all combinations
-                QString datePart(dateTimeList[0].trimmed());
-                QDate date;
-                if (parseDate(datePart, date)) {
-                    QString timePart(dateTimeList[1].trimmed());
-                    QTime time;
-                    if (parseTime(timePart, time))
-                        m_valuesToInsert << QDateTime(date, time);
-                    else
-                        m_valuesToInsert << QVariant();
-                } else
-                    m_valuesToInsert << QVariant();
-            } else
-                m_valuesToInsert << QVariant();
-        } else {   // Text type and the rest
-            if (m_options.nullsImportedAsEmptyTextChecked && text.isNull()) {
-                //default value is empty string not null - otherwise querying data without knowing SQL is very confusing
-                m_valuesToInsert << QString("");
-            } else {
-                m_valuesToInsert <<QVariant((m_options.trimmedInTextValuesChecked ? text.trimmed() : text));
+        updateColumn(col);
+    }
+    // updateColumn() may select a column unique in the preview
+    if (!d->primaryKeySetByUser && m_primaryKeyColumn >= 0
+        && uniqueness.value(m_primaryKeyColumn) == KexiCSVUniquenessTracker::NotUnique)
+    {
+        m_primaryKeyColumn = -1; // the column has been unique only in the preview
+    }
+    if (!d->primaryKeySetByUser && m_primaryKeyColumn == -1) {
+        // values of all rows are known to be unique only if they have been stored
+        for (int col = 0; col < m_table->columnCount() && col < types.count(); ++col) {
+            if (d->detectedType(col) == KDbField::Integer
+                && uniqueness[col] == KexiCSVUniquenessTracker::Unique)
+            {
+                m_primaryKeyColumn = col;
+                break;
             }
-        };
-
-        return;
+        }
     }
+    if (m_primaryKeyColumn != oldPrimaryKeyColumn) {
+        setPrimaryKeyIcon(oldPrimaryKeyColumn, false);
+        setPrimaryKeyIcon(m_primaryKeyColumn, true);
+    }
+    const QModelIndex current(m_tableView->currentIndex());
+    if (current.isValid()) { // update the format combo box
+        currentCellChanged(current, QModelIndex());
+    }
+}
+
+void KexiCSVImportDialog::setText(int row, int col, const QString& text)
+{
     //save text to GUI (table view)
     if (m_table->columnCount() < col) {
         m_table->setColumnCount(col);
@@ -1654,30 +1435,6 @@ void KexiCSVImportDialog::setText(int row, int col, const QString& text, bool in
     detectTypeAndUniqueness(row - 1, col - 1, text);
 }
 
-bool KexiCSVImportDialog::saveRow(bool inGUI)
-{
-    if (inGUI) {
-        //nothing to do
-        return true;
-    }
-    bool res = m_importingStatement.execute(m_valuesToInsert);
-//! @todo move
-    if (!res) {
-        const QStringList msgList = KexiUtils::convertTypesUsingMethod<QVariant, QString, &QVariant::toString>(m_valuesToInsert);
-        const KMessageBox::ButtonCode msgRes = KMessageBox::warningContinueCancelList(this,
-                    xi18nc("@info", "An error occurred during insert record."),
-                    QStringList(msgList.join(";")),
-                    QString(),
-                    KStandardGuiItem::cont(),
-                    KStandardGuiItem::cancel(),
-                    "SkipImportErrors"
-                  );
-        res = msgRes == KMessageBox::Continue;
-    }
-    m_valuesToInsert.clear();
-    return res;
-}
-
 void KexiCSVImportDialog::adjustRows(int iRows)
 {
     if (m_adjustRows) {
@@ -1694,6 +1451,7 @@ void KexiCSVImportDialog::formatChanged(int index)
         return;
     KDbField::Type type = kexiCSVImportStatic->types[index];
     d->setDetectedType(m_tableView->currentIndex().column(), type);
+    d->typesSetByUser.insert(m_tableView->currentIndex().column());
     m_primaryKeyField->setEnabled(KDbField::Integer == type);
     m_primaryKeyField->setChecked(m_primaryKeyColumn == m_tableView->currentIndex().column() && m_primaryKeyField->isEnabled());
     updateColumn(m_tableView->currentIndex().column());
@@ -1826,6 +1584,11 @@ void KexiCSVImportDialog::import()
         return;
     }
 
+    // types of columns have to be known before the table is created
+    if (d->typeDetector && !waitForTypeDetection()) {
+        return; // the user can import again later
+    }
+
     if (m_newTableOption->isChecked()) {
         m_destinationTableSchema = new KDbTableSchema(m_partItemForSavedTable->name());
         m_destinationTableSchema->setCaption(m_partItemForSavedTable->caption());
@@ -1987,54 +1750,65 @@ void KexiCSVImportDialog::import()
         return;
     }
 
-    m_importingStatement = m_conn->prepareStatement(
-                               KDbPreparedStatement::InsertStatement, m_destinationTableSchema);
-    if (!m_importingStatement.isValid()) {
-        msg.showErrorMessage(m_conn->result());
-        raiseErrorInAccept(project, m_partItemForSavedTable);
-        return;
-    }
-
+    KexiCSVImportEngine::Options engineOptions;
+    engineOptions.startLine = m_startline;
+    engineOptions.firstRowForFieldNames = m_1stRowForFieldNames->isChecked();
+    engineOptions.implicitPrimaryKey = m_implicitPrimaryKeyAdded;
+    engineOptions.trimmedInTextValues = m_options.trimmedInTextValuesChecked;
+    engineOptions.nullsImportedAsEmptyText = m_options.nullsImportedAsEmptyTextChecked;
+    engineOptions.dateFormat = static_cast<KexiCSVImportEngine::Options::DateFormat>(m_options.dateFormat);
+    engineOptions.minimumYearFor100YearSlidingWindow = m_minimumYearFor100YearSlidingWindow;
+    // recordsPerTransaction is 0: the transaction guard above makes the import all-or-nothing
+    KexiCSVImportDialogEngine engine(this, m_conn, m_destinationTableSchema, engineOptions);
+    QVector<KDbField::Type> columnTypes;
+    for (int col = 0; col < m_table->columnCount(); ++col) {
+        const KDbField::Type detectedType = d->detectedType(col);
+        columnTypes.append(detectedType == KDbField::InvalidType ? KDbField::Text : detectedType);
+    }
+    engine.setColumnTypes(columnTypes);
+
+    QScopedPointer<KexiCSVReader> reader;
+    qint64 fileSize = 0;
     if (m_file) {
         m_importProgressLabel->setText(xi18n("Importing data..."));
-        m_importingProgressBar->setMaximum(QFileInfo(*m_file).size() - 1);
+        m_importingProgressBar->setMaximum(IMPORT_PROGRESS_MAXIMUM);
+        m_importingProgressBar->setValue(0);
         m_importingProgressBar->show();
         m_importProgressLabel->show();
+        fileSize = QFileInfo(*m_file).size();
+        m_file->seek(0);
+        reader.reset(new KexiCSVReader(m_file, readerOptions()));
+    } else {
+        reader.reset(new KexiCSVReader(m_clipboardData, readerOptions()));
     }
-
-    int row, column, maxColumn;
-    QString field;
+    connect(&engine, &KexiCSVImportEngine::progress, this, [this, &engine, fileSize](qint64 bytesProcessed) {
+        //update progr. bar dlg on final exporting
+        if (fileSize > 0) {
+            m_importingProgressBar->setValue(int(bytesProcessed * IMPORT_PROGRESS_MAXIMUM / fileSize));
+        }
+        qApp->processEvents();
+        if (m_importCanceled) {
+            engine.cancel();
+        }
+    });
 
     // main job
-    tristate res = loadRows(field, row, column, maxColumn, false /*!gui*/);
+    const tristate res = engine.import(reader.data());
 
     if (true != res) {
         //importing canceled or failed
-        if (!res) { //do not display err msg when res == cancelled
+        if (~res) {
             m_importProgressLabel->setText(xi18n("Import has been canceled."));
-        } else if (~res) {
+        } else {
             m_importProgressLabel->setText(xi18n("Error occurred during import."));
+            if (engine.result().isError()) {
+                msg.showErrorMessage(engine.result());
+            }
         }
         raiseErrorInAccept(project, m_partItemForSavedTable);
         return;
     }
 
-    // file with only one line without '\n'
-    if (field.length() > 0) {
-        setText(row - m_startline, column, field, false /*!gui*/);
-        //fill remaining empty fields (database wants them explicitly)
-        for (int additionalColumn = column; additionalColumn <= maxColumn; additionalColumn++) {
-            setText(row - m_startline, additionalColumn, QString(), false /*!gui*/);
-        }
-        if (!saveRow(false /*!gui*/)) {
-            msg.showErrorMessage(m_conn->result());
-            raiseErrorInAccept(project, m_partItemForSavedTable);
-            return;
-        }
-        ++row;
-        field.clear();
-    }
-
     if (!tg.commit()) {
         msg.showErrorMessage(m_conn->result());
         raiseErrorInAccept(project, m_partItemForSavedTable);
@@ -2142,6 +1916,7 @@ bool KexiCSVImportDialog::eventFilter(QObject * watched, QEvent * e)
 
 void KexiCSVImportDialog::slotPrimaryKeyFieldToggled(bool on)
 {
+    d->primaryKeySetByUser = true;
     setPrimaryKeyIcon(m_primaryKeyColumn, false);
     m_primaryKeyColumn = on ? m_tableView->currentIndex().column() : -1;
     setPrimaryKeyIcon(m_primaryKeyColumn, true);
@@ -29,19 +29,18 @@
 #define KEXI_CSVIMPORTDIALOG_H
 
 #include <QList>
-#include <QRegularExpression>
 #include <QPixmap>
 #include <QTextStream>
 #include <QEvent>
 #include <QModelIndex>
-#include <QElapsedTimer>
 
 #include <KAssistantDialog>
 
 #include <KDbTristate>
-#include <KDbPreparedStatement>
 
 #include "kexicsvimportoptionsdlg.h"
+#include "KexiCSVReader.h"
+#include "KexiCSVValueParser.h"
 
 class QHBoxLayout;
 class QGridLayout;
@@ -166,21 +165,9 @@ private:
     QLabel *m_importProgressLabel;
 
     void detectTypeAndUniqueness(int row, int col, const QString& text);
-    void setText(int row, int col, const QString& text, bool inGUI);
-
-    /*! Parses date from \a text and stores into \a date.
-     m_dateRegExp is used for clever detection;
-     if '/' separated is found, it's assumed the format is american mm/dd/yyyy.
-     This function supports omitted zeros, so 1/2/2006 is parsed properly too.
-     \return true on success. */
-    bool parseDate(const QString& text, QDate& date);
-
-    /*! Parses time from \a text and stores into \a date.
-     m_timeRegExp1 and m_timeRegExp2 are used for clever detection;
-     both hh:mm:ss and hh:mm are supported.
-     This function supports omitted zeros, so 1:2:3 is parsed properly too.
-     \return true on success. */
-    bool parseTime(const QString& text, QTime& time);
+
+    //! Puts @a text into the preview table
+    void setText(int row, int col, const QString& text);
 
     /*! Called after the first fillTable() when number of rows is unknown. */
     void adjustRows(int iRows);
@@ -191,7 +178,23 @@ private:
     bool isPrimaryKeyAllowed(int col);
     void setPrimaryKeyIcon(int column, bool set);
     void updateRowCountInfo();
-    tristate loadRows(QString &field, int &row, int &columnm, int &maxColumn, bool inGUI);
+
+    //! Loads rows for preview. On return @a row is the number of loaded rows plus 1.
+    tristate loadRows(int &row, int &maxColumn);
+
+    //! Starts detection of column types using all rows of the file
+    //! if the preview does not contain all of them.
+    void startTypeDetection();
+
+    //! Waits for detection of column types started by startTypeDetection(),
+    //! showing a progress dialog. @return false if waiting has been canceled by the user.
+    bool waitForTypeDetection();
+
+    //! @return options for the CSV parser, based on current state of the dialog
+    KexiCSVReader::Options readerOptions() const;
+
+    //! @return parser of values, based on current import options
+    KexiCSVValueParser valueParser() const;
 
     /*! Detects delimiter by looking at first 4K bytes of the data. Used by loadRows().
     The used algorithm:
@@ -216,14 +219,6 @@ private:
       the highest priority is retured as delimiter. */
     QString detectDelimiterByLookingAtFirstBytesOfFile(QTextStream *inputStream);
 
-    /*! Callback, called whenever row is loaded in loadRows(). When inGUI is true,
-    nothing is performed, else database buffer is written back to the database. */
-    bool saveRow(bool inGUI);
-
-    //! @return date built out of @a y, @a m, @a d parts,
-    //! taking m_minimumYearFor100YearSlidingWindow into account
-    QDate buildDate(int y, int m, int d) const;
-
     //! Updates size of m_columnNames and m_changedColumnNames if needed
     void updateColumnVectorSize();
 
@@ -239,7 +234,6 @@ private:
     QByteArray m_fileArray;
     Mode m_mode;
 
-    QRegularExpression m_dateRegExp, m_timeRegExp1, m_timeRegExp2, m_fpNumberRegExp1, m_fpNumberRegExp2;
     bool m_columnsAdjusted; //!< to call adjustColumn() only once
     bool m_1stRowForFieldNamesDetected; //!< used to force rerun fillTable() after 1st row
     bool m_firstFillTableCall; //!< used to know whether it's 1st fillTable() call
@@ -256,7 +250,7 @@ private:
     QPixmap m_pkIcon;
     QString m_fname;
     QFile* m_file;
-    QTextStream *m_inputStream; //!< used in loadData()
+    KexiCSVReader *m_reader; //!< used in loadRows()
     KexiCSVImportOptions m_options;
     QProgressDialog *m_loadingProgressDlg;
     QProgressBar *m_importingProgressBar;
@@ -265,17 +259,9 @@ private:
     KDbConnection *m_conn; //!< (temp) database connection used for importing
     KexiFieldListModel *m_fieldsListModel;
     KDbTableSchema *m_destinationTableSchema;  //!< (temp) dest. table schema used for importing
-    KDbPreparedStatement m_importingStatement;
-    QList<QVariant> m_dbRowBuffer; //!< (temp) used for importing
     bool m_implicitPrimaryKeyAdded; //!< (temp) used for importing
     bool m_allRowsLoadedInPreview; //!< we need to know whether all rows were loaded or it's just a partial data preview
     bool m_stoppedAt_MAX_BYTES_TO_PREVIEW; //!< used to compute m_allRowsLoadedInPreview
-    const QString m_stringNo, m_stringI18nNo, m_stringFalse, m_stringI18nFalse; //!< used for importing boolean values
-    int m_prevColumnForSetText; //!< used for non-gui tracking of skipped clolumns,
-                                //!< so can be saved to the database,
-                                //!< e.g. first three columns are saved for ,,,"abc" line in the CSV data
-    QElapsedTimer m_elapsedTimer; //!< Used to update progress
-    qint64 m_elapsedMs;
 
     void createImportMethodPage();
     void createOptionsPage();
@@ -283,7 +269,6 @@ private:
     void createTableNamePage();
     void createImportPage();
 
-    KDbPreparedStatementParameters m_valuesToInsert;
     KexiPart::Item* m_partItemForSavedTable;
     bool m_importInProgress;
     bool m_importCanceled;
@@ -310,6 +295,7 @@ private Q_SLOTS:
     void slotCurrentPageChanged(KPageWidgetItem *page, KPageWidgetItem *prev);
     void slotShowSchema(KexiPart::Item *item);
     void import();
+    void slotTypeDetectionFinished();
 };
 
 #endif
@@ -69,8 +69,10 @@ KexiQueryView::KexiQueryView(QWidget *parent)
 
 KexiQueryView::~KexiQueryView()
 {
-    if (d->cursor)
+    if (d->cursor) {
+        setData(nullptr); // stop fetching records before the cursor is deleted
         d->cursor->connection()->deleteCursor(d->cursor);
+    }
     delete d;
 }
 
@@ -102,16 +104,14 @@ tristate KexiQueryView::setQuery(KDbQuerySchema *query)
         newCursor = nullptr;
     }
 
-    if (d->cursor) {
-        d->cursor->connection()->deleteCursor(d->cursor);
-    }
+    // the new cursor is set before the old one is deleted, so fetching records
+    // of the old one is stopped; the cursor stays open because records are fetched on demand
+    KDbCursor *oldCursor = d->cursor;
     d->cursor = newCursor;
     d->query = query;
     setData(d->cursor);
-
-//! @todo remove close() when dynamic cursors arrive
-    if (d->cursor && !d->cursor->close()) {
-        return false;
+    if (oldCursor) {
+        oldCursor->connection()->deleteCursor(oldCursor);
     }
 
 //! @todo maybe allow writing and inserting for single-table relations?
@@ -0,0 +1,234 @@
+/* This file is part of the KDE project
+   Copyright (C) 2026 Kexi developers <kexi-devel@kde.org>
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public License
+   along with this program; see the file COPYING.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+*/
+
+#include <KexiCSVReader.h>
+#include <KexiCSVScanner.h>
+
+#include <QBuffer>
+#include <QTextCodec>
+#include <QTextStream>
+#include <QtTest>
+
+//! Number of rows of generated data
+const int NARROW_ROWS = 200000;
+const int WIDE_ROWS = 10000;
+const int WIDE_COLUMNS = 40;
+
+//! Parses @a data the way KexiCSVImportDialog did before KexiCSVReader, one QChar at a time
+//! through QTextStream. Only delimiters, quotes and end of lines are supported.
+//! @return number of fields; @a rows is set to number of rows
+static qint64 parseUsingLegacyParser(QIODevice *device, int *rows)
+{
+    enum { S_START, S_QUOTED_FIELD, S_MAYBE_END_OF_QUOTED_FIELD, S_END_OF_QUOTED_FIELD,
+           S_MAYBE_NORMAL_FIELD, S_NORMAL_FIELD
+         } state = S_START;
+    const QChar delimiter(QLatin1Char(','));
+    const QChar textQuote(QLatin1Char('"'));
+    QTextStream stream(device);
+    stream.setCodec("UTF-8");
+    QString field;
+    QChar x;
+    qint64 fields = 0;
+    *rows = 0;
+    bool wasChar13 = false;
+    while (true) {
+        if (stream.atEnd()) {
+            if (x != QLatin1Char('\n') && x != QLatin1Char('\r')) {
+                x = QLatin1Char('\n'); // simulate missing \n at end
+            } else {
+                break;
+            }
+        } else {
+            stream >> x;
+        }
+        if (wasChar13 && x == QLatin1Char('\n')) {
+            wasChar13 = false;
+            continue;
+        }
+        wasChar13 = x == QLatin1Char('\r');
+        const bool endOfLine = x == QLatin1Char('\n') || x == QLatin1Char('\r');
+        switch (state) {
+        case S_START:
+            if (x == textQuote) {
+                state = S_QUOTED_FIELD;
+            } else if (x == delimiter) {
+                ++fields;
+            } else if (endOfLine) {
+                ++fields;
+                ++(*rows);
+            } else {
+                field += x;
+                state = S_MAYBE_NORMAL_FIELD;
+            }
+            break;
+        case S_QUOTED_FIELD:
+            if (x == textQuote) {
+                state = S_MAYBE_END_OF_QUOTED_FIELD;
+            } else {
+                field += x;
+            }
+            break;
+        case S_MAYBE_END_OF_QUOTED_FIELD:
+        case S_END_OF_QUOTED_FIELD:
+            if (state == S_MAYBE_END_OF_QUOTED_FIELD && x == textQuote) {
+                field += x;
+                state = S_QUOTED_FIELD;
+            } else if (x == delimiter || endOfLine) {
+                field.clear();
+                ++fields;
+                if (endOfLine) {
+                    ++(*rows);
+                }
+                state = S_START;
+            } else {
+                state = S_END_OF_QUOTED_FIELD;
+            }
+            break;
+        case S_MAYBE_NORMAL_FIELD:
+        case S_NORMAL_FIELD:
+            if (state == S_MAYBE_NORMAL_FIELD && x == textQuote) {
+                field.clear();
+                state = S_QUOTED_FIELD;
+                break;
+            }
+            if (x == delimiter || endOfLine) {
+                field.clear();
+                ++fields;
+                if (endOfLine) {
+                    ++(*rows);
+                }
+                state = S_START;
+            } else {
+                field += x;
+            }
+            break;
+        }
+    }
+    return fields;
+}
+
+class KexiCSVReaderBenchmark : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void initTestCase();
+    void benchmarkLegacyParser_data();
+    void benchmarkLegacyParser();
+    void benchmarkReader_data();
+    void benchmarkReader();
+
+private:
+    QByteArray m_narrowData; //!< Many rows with a few short numeric fields
+    QByteArray m_wideData; //!< Rows with many long text fields, some of them quoted
+};
+
+void KexiCSVReaderBenchmark::initTestCase()
+{
+    for (int row = 0; row < NARROW_ROWS; ++row) {
+        m_narrowData += QByteArray::number(row) + ',' + QByteArray::number(row % 97) + ",3.14,"
+                        + QByteArray::number(row * 7) + ",2017-01-0" + QByteArray::number(row % 9 + 1)
+                        + "\r\n";
+    }
+    // commas are only allowed in quoted fields
+    const QByteArray quotedText("Lorem ipsum dolor sit amet, consectetur adipiscing elit ");
+    const QByteArray text("Lorem ipsum dolor sit amet consectetur adipiscing elit ");
+    for (int row = 0; row < WIDE_ROWS; ++row) {
+        for (int col = 0; col < WIDE_COLUMNS; ++col) {
+            if (col > 0) {
+                m_wideData += ',';
+            }
+            if (col % 4 == 0) {
+                m_wideData += '"' + quotedText + "\"\"quoted\"\" " + QByteArray::number(row) + '"';
+            } else {
+                m_wideData += text.mid(12 + col % 5) + QByteArray::number(col);
+            }
+        }
+        m_wideData += '\n';
+    }
+}
+
+void KexiCSVReaderBenchmark::benchmarkLegacyParser_data()
+{
+    QTest::addColumn<bool>("wide");
+    QTest::newRow("narrow") << false;
+    QTest::newRow("wide") << true;
+}
+
+void KexiCSVReaderBenchmark::benchmarkLegacyParser()
+{
+    QFETCH(bool, wide);
+    QByteArray data(wide ? m_wideData : m_narrowData);
+    int rows = 0;
+    QBENCHMARK {
+        QBuffer buffer(&data);
+        QVERIFY(buffer.open(QIODevice::ReadOnly));
+        parseUsingLegacyParser(&buffer, &rows);
+    }
+    QCOMPARE(rows, wide ? WIDE_ROWS : NARROW_ROWS);
+}
+
+void KexiCSVReaderBenchmark::benchmarkReader_data()
+{
+    QTest::addColumn<bool>("wide");
+    QTest::addColumn<int>("implementation");
+    QTest::newRow("narrow, scalar") << false << int(KexiCSVScanner::Scalar);
+    QTest::newRow("narrow, SSE2") << false << int(KexiCSVScanner::SSE2);
+    QTest::newRow("narrow, AVX2") << false << int(KexiCSVScanner::AVX2);
+    QTest::newRow("wide, scalar") << true << int(KexiCSVScanner::Scalar);
+    QTest::newRow("wide, SSE2") << true << int(KexiCSVScanner::SSE2);
+    QTest::newRow("wide, AVX2") << true << int(KexiCSVScanner::AVX2);
+}
+
+void KexiCSVReaderBenchmark::benchmarkReader()
+{
+    QFETCH(bool, wide);
+    QFETCH(int, implementation);
+    if (!KexiCSVScanner::setImplementation(KexiCSVScanner::Implementation(implementation))) {
+        QSKIP("Implementation not supported on this CPU");
+    }
+    QByteArray data(wide ? m_wideData : m_narrowData);
+    KexiCSVReader::Options options;
+    options.codec = QTextCodec::codecForName("UTF-8");
+    int rows = 0;
+    qint64 fields = 0;
+    QBENCHMARK {
+        QBuffer buffer(&data);
+        QVERIFY(buffer.open(QIODevice::ReadOnly));
+        KexiCSVReader reader(&buffer, options);
+        rows = 0;
+        fields = 0;
+        while (reader.readRow()) {
+            ++rows;
+            fields += reader.fieldCount();
+        }
+    }
+    QCOMPARE(rows, wide ? WIDE_ROWS : NARROW_ROWS);
+    QCOMPARE(fields, qint64(rows) * (wide ? WIDE_COLUMNS : 5));
+
+    // the same results are expected from the legacy parser
+    QBuffer buffer(&data);
+    QVERIFY(buffer.open(QIODevice::ReadOnly));
+    int legacyRows;
+    QCOMPARE(parseUsingLegacyParser(&buffer, &legacyRows), fields);
+    QCOMPARE(legacyRows, rows);
+}
+
+QTEST_GUILESS_MAIN(KexiCSVReaderBenchmark)
+
+#include "KexiCSVReaderBenchmark.moc"
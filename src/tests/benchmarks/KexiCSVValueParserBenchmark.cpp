@@ -0,0 +1,275 @@
+/* This file is part of the KDE project
+   Copyright (C) 2026 Kexi developers <kexi-devel@kde.org>
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public License
+   along with this program; see the file COPYING.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+*/
+
+#include <KexiCSVValueParser.h>
+
+#include <QRegularExpression>
+#include <QStringList>
+#include <QtTest>
+
+#include <limits>
+
+//! Number of generated values of each kind
+const int VALUE_COUNT = 100000;
+
+//! The way values were converted by KexiCSVImportDialog before KexiCSVValueParser
+class LegacyParser
+{
+public:
+    LegacyParser()
+        : dateRegExp(QLatin1String("^(\\d{1,4})([/\\-\\.])(\\d{1,2})([/\\-\\.])(\\d{1,4})$"))
+        , timeRegExp2(QLatin1String("^(\\d{1,2}):(\\d{1,2})$"))
+    {
+    }
+
+    bool parseInt(const QString &text, int *value) const
+    {
+        bool ok;
+        *value = text.toInt(&ok);
+        return ok;
+    }
+
+    bool parseDouble(const QString &text, double *value) const
+    {
+        QByteArray t(text.toLatin1());
+        const int commaIndex = t.indexOf(',');
+        if (commaIndex >= 0) {
+            t[commaIndex] = '.';
+        }
+        bool ok;
+        *value = t.toDouble(&ok);
+        return ok;
+    }
+
+    bool parseDate(const QString &text, QDate *date) const
+    {
+        const QRegularExpressionMatch match = dateRegExp.match(text);
+        if (!match.hasMatch())
+            return false;
+        const int d1 = match.capturedRef(1).toInt(), d3 = match.capturedRef(3).toInt(),
+                  d5 = match.capturedRef(5).toInt();
+        if (match.capturedRef(2) == QLatin1String("/")) {
+            *date = QDate(d5, d1, d3);
+        } else if (d5 > 31) {
+            *date = QDate(d5, d3, d1);
+        } else {
+            *date = QDate(d1, d3, d5);
+        }
+        return date->isValid();
+    }
+
+    bool parseTime(const QString &text, QTime *time) const
+    {
+        *time = QTime::fromString(text, Qt::ISODate);
+        if (time->isValid())
+            return true;
+        const QRegularExpressionMatch match = timeRegExp2.match(text);
+        if (match.hasMatch()) {
+            *time = QTime(match.capturedRef(1).toInt(), match.capturedRef(2).toInt());
+            return true;
+        }
+        return false;
+    }
+
+    bool parseDateTime(const QString &text, QDateTime *dateTime) const
+    {
+        const QStringList parts(text.split(QLatin1Char(' ')));
+        QDate date;
+        QTime time;
+        if (parts.count() < 2 || !parseDate(parts[0].trimmed(), &date)
+            || !parseTime(parts[1].trimmed(), &time))
+        {
+            return false;
+        }
+        *dateTime = QDateTime(date, time);
+        return true;
+    }
+
+private:
+    const QRegularExpression dateRegExp, timeRegExp2;
+};
+
+class KexiCSVValueParserBenchmark : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void initTestCase();
+    void testParsers();
+    void benchmarkLegacy_data();
+    void benchmarkLegacy();
+    void benchmarkParser_data();
+    void benchmarkParser();
+
+private:
+    enum Kind { Integer, Double, Date, Time, DateTime };
+    void addKinds();
+
+    //! Values stored in one buffer like in KexiCSVReader, as views and as separate strings
+    QString m_buffer[DateTime + 1];
+    QVector<QStringView> m_views[DateTime + 1];
+    QStringList m_strings[DateTime + 1];
+};
+
+void KexiCSVValueParserBenchmark::initTestCase()
+{
+    for (int i = 0; i < VALUE_COUNT; ++i) {
+        QStringList values;
+        values << QString::number(i * 37 - 1000000)
+               << QString::number(i * 0.37 - 100, 'f', i % 6 + 1)
+               << QString::asprintf("%04d-%02d-%02d", 1990 + i % 30, i % 12 + 1, i % 28 + 1)
+               << QString::asprintf("%02d:%02d:%02d", i % 24, i % 60, (i * 7) % 60)
+               << QString::asprintf("%d/%d/%04d %02d:%02d", i % 12 + 1, i % 28 + 1, 1990 + i % 30,
+                                    i % 24, i % 60);
+        for (int kind = Integer; kind <= DateTime; ++kind) {
+            m_strings[kind].append(values[kind]);
+            m_buffer[kind] += values[kind];
+        }
+    }
+    for (int kind = Integer; kind <= DateTime; ++kind) {
+        int pos = 0;
+        for (const QString &value : qAsConst(m_strings[kind])) {
+            m_views[kind].append(QStringView(m_buffer[kind].constData() + pos, value.length()));
+            pos += value.length();
+        }
+    }
+}
+
+void KexiCSVValueParserBenchmark::testParsers()
+{
+    const LegacyParser legacy;
+    KexiCSVValueParser parser;
+    parser.setDecimalSeparator(QLatin1Char(','));
+    for (int i = 0; i < VALUE_COUNT; i += 97) {
+        int legacyInt, intValue;
+        QVERIFY(legacy.parseInt(m_strings[Integer][i], &legacyInt));
+        QVERIFY(KexiCSVValueParser::parseInt(m_views[Integer][i], &intValue));
+        QCOMPARE(intValue, legacyInt);
+        double legacyDouble, doubleValue;
+        QVERIFY(legacy.parseDouble(m_strings[Double][i], &legacyDouble));
+        QVERIFY(parser.parseDouble(m_views[Double][i], &doubleValue));
+        QCOMPARE(doubleValue, legacyDouble);
+        QDate legacyDate, date;
+        QVERIFY(legacy.parseDate(m_strings[Date][i], &legacyDate));
+        QVERIFY(parser.parseDate(m_views[Date][i], &date));
+        QCOMPARE(date, legacyDate);
+        QTime legacyTime, time;
+        QVERIFY(legacy.parseTime(m_strings[Time][i], &legacyTime));
+        QVERIFY(KexiCSVValueParser::parseTime(m_views[Time][i], &time));
+        QCOMPARE(time, legacyTime);
+        QDateTime legacyDateTime, dateTime;
+        QVERIFY(legacy.parseDateTime(m_strings[DateTime][i], &legacyDateTime));
+        QVERIFY(parser.parseDateTime(m_views[DateTime][i], &dateTime));
+        QCOMPARE(dateTime, legacyDateTime);
+    }
+    int intValue;
+    QVERIFY(KexiCSVValueParser::parseInt(QStringView(u" -2147483648 "), &intValue));
+    QCOMPARE(intValue, std::numeric_limits<int>::min());
+    QVERIFY(!KexiCSVValueParser::parseInt(QStringView(u"2147483648"), &intValue));
+    QVERIFY(!KexiCSVValueParser::parseInt(QStringView(u"12a"), &intValue));
+    double doubleValue;
+    QVERIFY(parser.parseDouble(QStringView(u"-,5"), &doubleValue));
+    QCOMPARE(doubleValue, -0.5);
+    QVERIFY(parser.parseDouble(QStringView(u"0.1E-2"), &doubleValue));
+    QCOMPARE(doubleValue, 0.001);
+    QVERIFY(parser.parseDouble(QStringView(u"3.14159265358979323846264338327950288"), &doubleValue));
+    QCOMPARE(doubleValue, 3.14159265358979323846264338327950288);
+    QVERIFY(!parser.parseDouble(QStringView(u"1.2.3"), &doubleValue));
+    QDate date;
+    QVERIFY(!parser.parseDate(QStringView(u"13/01/2017"), &date));
+    QTime time;
+    QVERIFY(KexiCSVValueParser::parseTime(QStringView(u"7:05:09.5"), &time));
+    QCOMPARE(time, QTime(7, 5, 9, 500));
+    QVERIFY(!KexiCSVValueParser::parseTime(QStringView(u"24:00"), &time));
+}
+
+void KexiCSVValueParserBenchmark::addKinds()
+{
+    QTest::addColumn<int>("kind");
+    QTest::newRow("integer") << int(Integer);
+    QTest::newRow("double") << int(Double);
+    QTest::newRow("date") << int(Date);
+    QTest::newRow("time") << int(Time);
+    QTest::newRow("date-time") << int(DateTime);
+}
+
+void KexiCSVValueParserBenchmark::benchmarkLegacy_data()
+{
+    addKinds();
+}
+
+void KexiCSVValueParserBenchmark::benchmarkLegacy()
+{
+    QFETCH(int, kind);
+    const LegacyParser parser;
+    int parsed = 0;
+    QBENCHMARK {
+        parsed = 0;
+        for (const QStringView &view : qAsConst(m_views[kind])) {
+            // the dialog had to create a string out of the field first
+            const QString text(view.toString());
+            int intValue;
+            double doubleValue;
+            QDate date;
+            QTime time;
+            QDateTime dateTime;
+            switch (kind) {
+            case Integer: parsed += parser.parseInt(text, &intValue); break;
+            case Double: parsed += parser.parseDouble(text, &doubleValue); break;
+            case Date: parsed += parser.parseDate(text, &date); break;
+            case Time: parsed += parser.parseTime(text, &time); break;
+            default: parsed += parser.parseDateTime(text, &dateTime); break;
+            }
+        }
+    }
+    QCOMPARE(parsed, VALUE_COUNT);
+}
+
+void KexiCSVValueParserBenchmark::benchmarkParser_data()
+{
+    addKinds();
+}
+
+void KexiCSVValueParserBenchmark::benchmarkParser()
+{
+    QFETCH(int, kind);
+    const KexiCSVValueParser parser;
+    int parsed = 0;
+    QBENCHMARK {
+        parsed = 0;
+        for (const QStringView &view : qAsConst(m_views[kind])) {
+            int intValue;
+            double doubleValue;
+            QDate date;
+            QTime time;
+            QDateTime dateTime;
+            switch (kind) {
+            case Integer: parsed += KexiCSVValueParser::parseInt(view, &intValue); break;
+            case Double: parsed += parser.parseDouble(view, &doubleValue); break;
+            case Date: parsed += parser.parseDate(view, &date); break;
+            case Time: parsed += KexiCSVValueParser::parseTime(view, &time); break;
+            default: parsed += parser.parseDateTime(view, &dateTime); break;
+            }
+        }
+    }
+    QCOMPARE(parsed, VALUE_COUNT);
+}
+
+QTEST_GUILESS_MAIN(KexiCSVValueParserBenchmark)
+
+#include "KexiCSVValueParserBenchmark.moc"
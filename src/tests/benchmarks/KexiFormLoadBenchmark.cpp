@@ -0,0 +1,157 @@
+/* This file is part of the KDE project
+   Copyright (C) 2026 Kexi developers <kexi-devel@kde.org>
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public License
+   along with this program; see the file COPYING.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+*/
+
+#include <formeditor/form.h>
+#include <formeditor/formIO.h>
+#include <formeditor/objecttree.h>
+#include <formeditor/utils.h>
+#include <formeditor/widgetlibrary.h>
+
+#include <KActionCollection>
+
+#include <QDomDocument>
+#include <QtTest>
+
+//! Number of widgets of the generated form
+const int WIDGET_COUNT = 1000;
+
+//! Number of columns of widgets in the generated form
+const int COLUMN_COUNT = 10;
+
+//! @return .ui data of a form with WIDGET_COUNT widgets, in the format saved by FormIO
+static QByteArray generateForm()
+{
+    QByteArray ui;
+    ui += "<!DOCTYPE UI>\n<UI stdsetdef=\"1\" version=\"3.1\">\n"
+          " <kfd:customHeader version=\"2\"/>\n"
+          " <pixmapinproject/>\n"
+          " <class>QWidget</class>\n"
+          " <widget class=\"QWidget\">\n"
+          "  <property name=\"name\"><string>form</string></property>\n"
+          "  <property name=\"geometry\"><rect><x>0</x><y>0</y>"
+          "<width>2000</width><height>4000</height></rect></property>\n";
+    QByteArray tabStops;
+    for (int i = 0; i < WIDGET_COUNT; ++i) {
+        const QByteArray name(QByteArray::number(i));
+        const QByteArray geometry("<rect><x>" + QByteArray::number(i % COLUMN_COUNT * 200)
+                                  + "</x><y>" + QByteArray::number(i / COLUMN_COUNT * 30)
+                                  + "</y><width>190</width><height>25</height></rect>");
+        switch (i % 3) {
+        case 0:
+            ui += "  <widget class=\"KexiDBLabel\">\n"
+                  "   <property name=\"name\"><string>label" + name + "</string></property>\n"
+                  "   <property name=\"geometry\">" + geometry + "</property>\n"
+                  "   <property name=\"text\"><string>Field " + name + ":</string></property>\n"
+                  "   <property name=\"alignment\"><set>AlignRight|AlignVCenter</set></property>\n"
+                  "   <property name=\"paletteForegroundColor\"><color><red>0</red>"
+                  "<green>0</green><blue>128</blue></color></property>\n"
+                  "  </widget>\n";
+            tabStops += "  <tabstop>label" + name + "</tabstop>\n";
+            break;
+        case 1:
+            ui += "  <widget class=\"KexiDBLineEdit\">\n"
+                  "   <property name=\"name\"><string>lineEdit" + name + "</string></property>\n"
+                  "   <property name=\"geometry\">" + geometry + "</property>\n"
+                  "   <property name=\"dataSource\"><string>field" + name + "</string></property>\n"
+                  "   <property name=\"font\"><font><family>Sans Serif</family>"
+                  "<pointsize>10</pointsize><weight>75</weight><bold>1</bold></font></property>\n"
+                  "  </widget>\n";
+            tabStops += "  <tabstop>lineEdit" + name + "</tabstop>\n";
+            break;
+        default:
+            ui += "  <widget class=\"KexiDBCheckBox\">\n"
+                  "   <property name=\"name\"><string>checkBox" + name + "</string></property>\n"
+                  "   <property name=\"geometry\">" + geometry + "</property>\n"
+                  "   <property name=\"text\"><string>Option " + name + "</string></property>\n"
+                  "   <property name=\"tristate\"><bool>false</bool></property>\n"
+                  "  </widget>\n";
+            tabStops += "  <tabstop>checkBox" + name + "</tabstop>\n";
+        }
+    }
+    ui += " </widget>\n"
+          " <layoutDefaults spacing=\"6\" margin=\"11\"/>\n"
+          " <tabstops>\n" + tabStops + " </tabstops>\n"
+          "</UI>\n";
+    return ui;
+}
+
+class KexiFormLoadBenchmark : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void initTestCase();
+    //! Loading the form, including creation of widgets
+    void loadForm_data();
+    void loadForm();
+    //! Parsing the form into a DOM document like before the single pass loader was used,
+    //! without creating widgets; for reference
+    void parseFormToDom();
+    void cleanupTestCase();
+
+private:
+    QByteArray m_ui;
+    KFormDesigner::WidgetLibrary *m_library = nullptr;
+};
+
+void KexiFormLoadBenchmark::initTestCase()
+{
+    m_ui = generateForm();
+    m_library = new KFormDesigner::WidgetLibrary(this, QStringList() << "kexi");
+}
+
+void KexiFormLoadBenchmark::loadForm_data()
+{
+    QTest::addColumn<int>("mode");
+    QTest::newRow("data") << int(KFormDesigner::Form::DataMode);
+    QTest::newRow("design") << int(KFormDesigner::Form::DesignMode);
+}
+
+void KexiFormLoadBenchmark::loadForm()
+{
+    QFETCH(int, mode);
+    KActionCollection actionCollection(this);
+    KFormDesigner::ActionGroup actionGroup(this);
+    QBENCHMARK {
+        QWidget container;
+        container.setObjectName("form");
+        KFormDesigner::Form form(m_library, KFormDesigner::Form::Mode(mode),
+                                 actionCollection, actionGroup);
+        form.createToplevel(&container);
+        QVERIFY(KFormDesigner::FormIO::loadFormFromByteArray(&form, &container, m_ui));
+        QCOMPARE(form.objectTree()->children()->count(), WIDGET_COUNT);
+    }
+}
+
+void KexiFormLoadBenchmark::parseFormToDom()
+{
+    QBENCHMARK {
+        QDomDocument doc;
+        QVERIFY(doc.setContent(m_ui));
+    }
+}
+
+void KexiFormLoadBenchmark::cleanupTestCase()
+{
+    delete m_library;
+    m_library = nullptr;
+}
+
+QTEST_MAIN(KexiFormLoadBenchmark)
+
+#include "KexiFormLoadBenchmark.moc"
@@ -31,8 +31,11 @@
 #include <widget/utils/kexirecordnavigator.h>
 
 #include <KDbQueryColumnInfo>
+#include <KDbConnection>
+#include <KDbCursor>
 #include <KDbRecordEditBuffer>
 #include <KDbTableViewColumn>
+#include <KDbTransactionGuard>
 #include <KDbValidator>
 
 #include <KMessageBox>
@@ -46,9 +49,21 @@
 #include <QHeaderView>
 #include <QKeyEvent>
 #include <QScopedValueRollback>
+#include <QRunnable>
+#include <QThread>
+#include <QThreadPool>
 
 #include <limits.h>
 
+//! Minimal number of records to search by find() using multiple threads
+#define PARALLEL_FIND_MIN_RECORDS 20000
+
+//! Number of records searched by a thread at once
+#define PARALLEL_FIND_CHUNK_SIZE 4096
+
+//! Interval in milliseconds for reporting progress of find()
+#define FIND_PROGRESS_INTERVAL 100
+
 using namespace KexiUtils;
 
 KexiDataAwareObjectInterface::KexiDataAwareObjectInterface()
@@ -82,6 +97,7 @@ KexiDataAwareObjectInterface::KexiDataAwareObjectInterface()
     m_verticalScrollBarValueChanged_enabled = true;
     m_scrollbarToolTipsEnabled = true;
     m_recentSearchDirection = KexiSearchAndReplaceViewInterface::Options::DefaultSearchDirection;
+    m_findInProgress = false;
 
     m_lengthExceededMessageVisible = false;
     m_acceptRecordEditing_in_setCursorPosition_enabled = true;
@@ -263,6 +279,13 @@ bool KexiDataAwareObjectInterface::sort()
     if (!m_data || !m_isSortingEnabled)
         return false;
 
+    const tristate sortedInDatabase = sortInDatabase();
+    if (!~sortedInDatabase) // not cancelled, no need to sort in memory
+        return true == sortedInDatabase;
+
+    if (!fetchAllRecords())
+        return false;
+
     if (recordCount() < 2)
         return true;
 
@@ -439,6 +462,7 @@ void KexiDataAwareObjectInterface::selectFirstRecord()
 
 void KexiDataAwareObjectInterface::selectLastRecord()
 {
+    fetchAllRecords();
     selectRecord(recordCount() > 0 ? (recordCount() - 1) : 0);
 }
 
@@ -693,6 +717,7 @@ bool KexiDataAwareObjectInterface::acceptRecordEditing()
     if (m_data->recordEditBuffer()->isEmpty() && !m_newRecordEditing) {
         //qDebug() << "-- NOTHING TO ACCEPT!!!";
     } else {//not empty edit buffer or new row to insert:
+        stopFetchingRecordsInBackground();
         if (m_newRecordEditing) {
             //qDebug() << "-- INSERTING:" << *m_data->recordEditBuffer();
             success = m_data->saveNewRecord(m_currentRecord);
@@ -1135,6 +1160,7 @@ void KexiDataAwareObjectInterface::insertItem(KDbRecordData *data, int pos)
         m_curRecord++;
     }
 
+    stopFetchingRecordsInBackground();
     beginInsertItem(data, pos);
     m_data->insertRecord(data, pos, true /*repaint*/);
 
@@ -1170,6 +1196,8 @@ tristate KexiDataAwareObjectInterface::deleteAllRecords(bool ask, bool repaint)
 {
     if (!hasData())
         return true;
+    if (!fetchAllRecords())
+        return false;
     if (m_data->count() < 1)
         return true;
 
@@ -1362,6 +1390,7 @@ bool KexiDataAwareObjectInterface::deleteItem(KDbRecordData* data)
     if (!data || !beforeDeleteItem(data))
         return false;
 
+    stopFetchingRecordsInBackground();
     const int pos = m_data->indexOf(data);
     beginRemoveItem(data, pos);
     bool result = m_data->deleteRecord(data, true /*repaint*/);
@@ -1467,6 +1496,9 @@ void KexiDataAwareObjectInterface::addNewRecordRequested()
     }
     if (!hasData())
         return;
+    // the new record is appended after the last record
+    if (!fetchAllRecords())
+        return;
     // find first column that is not autoincrement
     int columnToSelect = 0;
     int i = 0;
@@ -1537,6 +1569,9 @@ bool KexiDataAwareObjectInterface::handleKeyPress(QKeyEvent *e, int *currentReco
         //do not accept yet
         e->ignore();
     } else if (k == Qt::Key_End) {
+        if (fullRecordSelection || e->modifiers() == Qt::ControlModifier) {
+            fetchAllRecords();
+        }
         if (fullRecordSelection) {
             //we're in record-selection mode: home key always moves to the last record
             *currentRecord = m_data->count() - 1 + (isInsertingEnabled() ? 1 : 0);//to last the record
@@ -1752,10 +1787,251 @@ static inline bool findInString(const QString& stringValue, int stringLength,
     return false;
 }
 
+namespace {
+
+//! @internal Value to find and options of find(), prepared once for all searched cells
+class FindPattern
+{
+public:
+    FindPattern(const QString &value, const KexiSearchAndReplaceViewInterface::Options &options,
+                bool forward)
+        : caseSensitivity(options.caseSensitive ? Qt::CaseSensitive : Qt::CaseInsensitive)
+        , stringValue(caseSensitivity == Qt::CaseSensitive ? value : value.toLower())
+        , foldedValue(caseSensitivity == Qt::CaseSensitive ? value : value.toCaseFolded())
+        , matchAnyPartOfField(options.textMatching == KexiSearchAndReplaceViewInterface::Options::MatchAnyPartOfField)
+        , matchWholeField(options.textMatching == KexiSearchAndReplaceViewInterface::Options::MatchWholeField)
+        , wholeWordsOnly(options.wholeWordsOnly)
+        , forward(forward)
+    {
+    }
+
+    /*! Looks for the value in the whole @a where string, the same way as findInString()
+     does for a cell that is not the current one. @return true on success and sets
+     @a firstCharacter to position of the value. */
+    bool match(const QString &where, int *firstCharacter) const
+    {
+        if (!matchAnyPartOfField || wholeWordsOnly) {
+            *firstCharacter = -1;
+            return findInString(stringValue, stringValue.length(), where, *firstCharacter,
+                                matchAnyPartOfField, matchWholeField, caseSensitivity,
+                                wholeWordsOnly, forward);
+        }
+        if (where.length() < foldedValue.length()) {
+            return false;
+        }
+        // Simple case folding does not change length so positions found in the folded
+        // string are valid for the original one.
+        const QString haystack(caseSensitivity == Qt::CaseSensitive ? where : where.toCaseFolded());
+        *firstCharacter = forward ? indexOf(haystack) : haystack.lastIndexOf(foldedValue);
+        return *firstCharacter != -1;
+    }
+
+    bool isForward() const { return forward; }
+
+    /*! Replaces all occurrences of the value in @a where by @a replacement.
+     @return true and sets @a result if there is at least one occurrence. */
+    bool replaceAll(const QString &where, const QString &replacement, QString *result) const
+    {
+        const int length = stringValue.length();
+        if (matchWholeField) {
+            if (where.compare(stringValue, caseSensitivity) != 0) {
+                return false;
+            }
+            *result = replacement;
+            return true;
+        }
+        if (!matchAnyPartOfField) { // matchStartOfField
+            if (!where.startsWith(stringValue, caseSensitivity)
+                || (wholeWordsOnly && where.length() > length && where.at(length).isLetterOrNumber()))
+            {
+                return false;
+            }
+            *result = replacement + where.midRef(length);
+            return true;
+        }
+        result->clear();
+        int copied = 0;
+        for (int pos = where.indexOf(stringValue, 0, caseSensitivity); pos != -1;
+             pos = where.indexOf(stringValue, pos + 1, caseSensitivity))
+        {
+            if (pos < copied
+                || (wholeWordsOnly && ((pos > 0 && where.at(pos - 1).isLetterOrNumber())
+                                       || (pos + length < where.length() && where.at(pos + length).isLetterOrNumber()))))
+            {
+                continue;
+            }
+            result->append(where.midRef(copied, pos - copied));
+            result->append(replacement);
+            copied = pos + length;
+        }
+        if (copied == 0) {
+            return false;
+        }
+        result->append(where.midRef(copied));
+        return true;
+    }
+
+private:
+    //! Looks for the first character of the value using fast single-character scan
+    //! of QString, then compares the rest. Faster than generic QString::indexOf().
+    int indexOf(const QString &haystack) const
+    {
+        const QChar first = foldedValue.at(0);
+        const int length = foldedValue.length();
+        const int last = haystack.length() - length;
+        for (int pos = 0; pos <= last; ++pos) {
+            pos = haystack.indexOf(first, pos);
+            if (pos == -1 || pos > last) {
+                break;
+            }
+            if (haystack.midRef(pos, length) == foldedValue) {
+                return pos;
+            }
+        }
+        return -1;
+    }
+
+    const Qt::CaseSensitivity caseSensitivity;
+    const QString stringValue; //!< lower-case if case-insensitive, as used by findInString()
+    const QString foldedValue; //!< case-folded if case-insensitive
+    const bool matchAnyPartOfField;
+    const bool matchWholeField;
+    const bool wholeWordsOnly;
+    const bool forward;
+};
+
+//! @internal Position of a value found by FindInRecordsTask
+struct FoundValue
+{
+    int record = -1;
+    int column = -1;
+    int firstCharacter = -1;
+};
+
+/*! @internal State of a search shared by threads of FindInRecordsTask.
+ Records are searched in chunks. Chunk number i contains records having numbers
+ i * PARALLEL_FIND_CHUNK_SIZE..(i + 1) * PARALLEL_FIND_CHUNK_SIZE - 1 in search order.
+ Each thread takes the next chunk not searched yet so the search order is kept roughly
+ for all threads and the first match in search order is known early. */
+class FindInRecordsState
+{
+public:
+    FindInRecordsState(const KDbTableViewData *data, int firstRecord, int count,
+                       const QVector<int> &columns, const QVector<int> &indices,
+                       const FindPattern &pattern)
+        : data(data), firstRecord(firstRecord), count(count)
+        , chunkCount((count + PARALLEL_FIND_CHUNK_SIZE - 1) / PARALLEL_FIND_CHUNK_SIZE)
+        , columns(columns), indices(indices), pattern(pattern)
+        , results(chunkCount)
+        , nextChunk(0), searchedChunks(0), found(INT_MAX), cancelled(0)
+    {
+    }
+
+    //! Searches chunks until all are searched, a match preceding them is found or searching is cancelled
+    void searchChunks();
+
+    const KDbTableViewData * const data;
+    const int firstRecord;
+    const int count;
+    const int chunkCount;
+    const QVector<int> columns; //!< numbers of searched columns in search order
+    const QVector<int> indices; //!< indices of values for the columns in records
+    const FindPattern &pattern;
+    QVector<FoundValue> results; //!< first match found in every chunk, each written by one thread
+    QAtomicInt nextChunk;
+    QAtomicInt searchedChunks;
+    QAtomicInt found; //!< the smallest number of a record in search order where a match is found
+    QAtomicInt cancelled;
+};
+
+void FindInRecordsState::searchChunks()
+{
+    Q_FOREVER {
+        const int chunk = nextChunk.fetchAndAddRelaxed(1);
+        if (chunk >= chunkCount || cancelled.loadAcquire()) {
+            return;
+        }
+        const int begin = chunk * PARALLEL_FIND_CHUNK_SIZE;
+        const int end = qMin(begin + PARALLEL_FIND_CHUNK_SIZE, count);
+        for (int i = begin; i < end && i < found.loadAcquire() && !cancelled.load(); ++i) {
+            const int record = pattern.isForward() ? (firstRecord + i) : (firstRecord - i);
+            const KDbRecordData *recordData = data->at(record);
+            for (int c = 0; c < columns.count(); ++c) {
+                int firstCharacter;
+                if (!pattern.match(recordData->at(indices[c]).toString(), &firstCharacter)) {
+                    continue;
+                }
+                results[chunk].record = record;
+                results[chunk].column = columns[c];
+                results[chunk].firstCharacter = firstCharacter;
+                int prevFound = found.loadAcquire();
+                while (i < prevFound && !found.testAndSetOrdered(prevFound, i)) {
+                    prevFound = found.loadAcquire();
+                }
+                i = end; // stop searching this chunk
+                break;
+            }
+        }
+        searchedChunks.ref();
+    }
+}
+
+//! @internal A thread of parallel search in records
+class FindInRecordsTask : public QRunnable
+{
+public:
+    explicit FindInRecordsTask(FindInRecordsState *state) : m_state(state) {}
+
+    void run() override {
+        m_state->searchChunks();
+    }
+
+private:
+    FindInRecordsState * const m_state;
+};
+
+} // namespace
+
+/*! Searches @a count records of @a data using multiple threads, starting from @a firstRecord
+ in direction specified by @a pattern. @a columns are numbers of searched columns in search
+ order and @a indices are indices of their values in records.
+ Progress is reported to @a progressHandler if it is not nullptr.
+ @return true and sets @a found to the first match in search order, false if nothing has been
+ found or cancelled if searching has been cancelled by @a progressHandler. */
+static tristate findInRecordsInParallel(const KDbTableViewData *data, int firstRecord, int count,
+    const QVector<int> &columns, const QVector<int> &indices, const FindPattern &pattern,
+    KexiSearchAndReplaceViewInterface::Options::ProgressHandler *progressHandler,
+    FoundValue *found)
+{
+    FindInRecordsState state(data, firstRecord, count, columns, indices, pattern);
+    QThreadPool pool;
+    const int threadCount = qMin(qMax(QThread::idealThreadCount(), 1), state.chunkCount);
+    pool.setMaxThreadCount(threadCount);
+    for (int i = 0; i < threadCount; ++i) {
+        pool.start(new FindInRecordsTask(&state));
+    }
+    while (!pool.waitForDone(FIND_PROGRESS_INTERVAL)) {
+        if (progressHandler && !state.cancelled.load()
+            && !progressHandler->updateProgress(100 * state.searchedChunks.load() / state.chunkCount))
+        {
+            state.cancelled.storeRelease(1);
+        }
+    }
+    if (state.cancelled.loadAcquire()) {
+        return cancelled;
+    }
+    const int foundIndex = state.found.loadAcquire();
+    if (foundIndex == INT_MAX) {
+        return false;
+    }
+    *found = state.results.at(foundIndex / PARALLEL_FIND_CHUNK_SIZE);
+    return true;
+}
+
 tristate KexiDataAwareObjectInterface::find(const QVariant& valueToFind,
         const KexiSearchAndReplaceViewInterface::Options& options, bool next)
 {
-    if (!hasData())
+    if (!hasData() || m_findInProgress)
         return cancelled;
     const QVariant prevSearchedValue(m_recentlySearchedValue);
     m_recentlySearchedValue = valueToFind;
@@ -1766,6 +2042,10 @@ tristate KexiDataAwareObjectInterface::find(const QVariant& valueToFind,
 
     const bool forward = (options.searchDirection == KexiSearchAndReplaceViewInterface::Options::SearchUp)
                          ? !next : next; //direction can be reversed
+    // records preceding the current one are always fetched
+    const bool searchInDatabase = options.searchInDatabase && forward;
+    if (!searchInDatabase && !fetchAllRecords())
+        return false;
 
     if ((!prevSearchedValue.isNull() && prevSearchedValue != valueToFind)
             || (prevSearchDirection != options.searchDirection && options.searchDirection == KexiSearchAndReplaceViewInterface::Options::SearchAllRecords))
@@ -1785,10 +2065,41 @@ tristate KexiDataAwareObjectInterface::find(const QVariant& valueToFind,
         //we're at "insert" record, and searching forward: no chances to find something
         return false;
     }
+    if (searchInDatabase) {
+        const int searchedColumn = (options.columnNumber == KexiSearchAndReplaceViewInterface::Options::CurrentColumn)
+                                   ? m_curColumn : options.columnNumber;
+        QVector<int> columns;
+        if (searchedColumn == KexiSearchAndReplaceViewInterface::Options::AllColumns) {
+            for (int c = 0; c < m_data->columnCount(); ++c) {
+                columns.append(c);
+            }
+        } else if (searchedColumn >= 0) {
+            columns.append(searchedColumn);
+        }
+        QVector<int> indices;
+        for (int c : columns) {
+            indices.append(m_indicesForVisibleValues[c]);
+        }
+        const FindPattern pattern(valueToFind.toString(), options, forward);
+        const tristate res = columns.isEmpty() ? tristate(cancelled) : fetchRecordsForFind(
+            valueToFind.toString(), options, columns,
+            [&pattern, &indices](const KDbRecordData &record) {
+                int firstCharacter;
+                for (int index : indices) {
+                    if (pattern.match(record.at(index).toString(), &firstCharacter)) {
+                        return true;
+                    }
+                }
+                return false;
+            });
+        if (false == res || (~res && !fetchAllRecords())) {
+            return false;
+        }
+    }
     KDbTableViewDataIterator it((startFrom1stRecordAndCol || startFromLastRecordAndCol)
                                    ? m_data->begin() : m_itemIterator /*start from the current cell*/);
     if (startFromLastRecordAndCol)
-        it += (m_data->columnCount() - 1);
+        it += (recordCount() - 1);
     int firstCharacter;
     if (m_positionOfRecentlyFoundValue.exists) {// start after the next/prev char position
         if (forward)
@@ -1843,6 +2154,7 @@ tristate KexiDataAwareObjectInterface::find(const QVariant& valueToFind,
 
     // search
     const int prevRecord = m_curRecord;
+    bool found = false;
     KDbRecordData *data = 0;
     while ((it != m_data->end() && (data = *it))) {
         for (; forward ? column <= lastColumn : column >= lastColumn;
@@ -1852,17 +2164,52 @@ tristate KexiDataAwareObjectInterface::find(const QVariant& valueToFind,
                              matchAnyPartOfField, matchWholeField, caseSensitivity,
                              wholeWordsOnly, forward))
             {
-                setCursorPosition(record, column, ForceSetCursorPosition);
-                if (prevRecord != m_curRecord)
-                    updateRecord(prevRecord);
-                // remember the exact position for the found value
-                m_positionOfRecentlyFoundValue.exists = true;
-                m_positionOfRecentlyFoundValue.firstCharacter = firstCharacter;
-//! @todo for regexp lastCharacter should be computed
-                m_positionOfRecentlyFoundValue.lastCharacter = firstCharacter + stringLength - 1;
-                return true;
+                found = true;
+                break;
             }
         }//for
+        if (found) {
+            break;
+        }
+        // Many remaining records: search them in parallel, the current one could
+        // have been searched from a given character only.
+        const int remainingRecords = forward ? (m_data->count() - record - 1) : record;
+        if (remainingRecords >= PARALLEL_FIND_MIN_RECORDS) {
+            QVector<int> columns;
+            QVector<int> indices;
+            for (int c = firstColumn; forward ? c <= lastColumn : c >= lastColumn; c = forward ? (c + 1) : (c - 1)) {
+                columns.append(c);
+                indices.append(m_indicesForVisibleValues[c]);
+            }
+            // Do not allow changes to the data until searching finishes since
+            // the progress handler processes events.
+            QWidget *thisWidget = dynamic_cast<QWidget*>(this);
+            const bool wasEnabled = thisWidget && thisWidget->isEnabled();
+            if (thisWidget && options.progressHandler) {
+                thisWidget->setEnabled(false);
+            }
+            FoundValue foundValue;
+            tristate res;
+            {
+                QScopedValueRollback<bool> findInProgressRollback(m_findInProgress, true);
+                res = findInRecordsInParallel(m_data, forward ? (record + 1) : (record - 1),
+                                              remainingRecords, columns, indices,
+                                              FindPattern(valueToFind.toString(), options, forward),
+                                              options.progressHandler, &foundValue);
+            }
+            findInRecordsFinished();
+            if (thisWidget && options.progressHandler) {
+                thisWidget->setEnabled(wasEnabled);
+            }
+            if (true != res) {
+                return res;
+            }
+            record = foundValue.record;
+            column = foundValue.column;
+            firstCharacter = foundValue.firstCharacter;
+            found = true;
+            break;
+        }
         if (forward) {
             ++it;
             ++record;
@@ -1876,23 +2223,204 @@ tristate KexiDataAwareObjectInterface::find(const QVariant& valueToFind,
         }
         column = firstColumn;
     }//while
-    return false;
+    if (!found) {
+        return false;
+    }
+    setCursorPosition(record, column, ForceSetCursorPosition);
+    if (prevRecord != m_curRecord)
+        updateRecord(prevRecord);
+    // remember the exact position for the found value
+    m_positionOfRecentlyFoundValue.exists = true;
+    m_positionOfRecentlyFoundValue.firstCharacter = firstCharacter;
+//! @todo for regexp lastCharacter should be computed
+    m_positionOfRecentlyFoundValue.lastCharacter = firstCharacter + stringLength - 1;
+    return true;
+}
+
+bool KexiDataAwareObjectInterface::columnReplaceable(int col)
+{
+    // visible values of lookup columns are not stored in the edited table
+    KDbTableViewColumn *column = m_data->column(col);
+    return columnEditable(col) && m_indicesForVisibleValues[col] == col
+           && column->field() && column->field()->isTextType();
 }
 
 tristate KexiDataAwareObjectInterface::findNextAndReplace(
     const QVariant& valueToFind, const QVariant& replacement,
     const KexiSearchAndReplaceViewInterface::Options& options, bool replaceAll)
 {
-    Q_UNUSED(replacement);
-    Q_UNUSED(options);
-    Q_UNUSED(replaceAll);
-
     if (isReadOnly())
         return cancelled;
     if (valueToFind.isNull() || valueToFind.toString().isEmpty())
         return cancelled;
-    //! @todo implement KexiDataAwareObjectInterface::findAndReplace()
-    return false;
+    if (!hasData() || m_findInProgress)
+        return cancelled;
+    if (!acceptRecordEditing())
+        return cancelled;
+    if (replaceAll)
+        return this->replaceAll(valueToFind.toString(), replacement.toString(), options);
+
+    if (!m_positionOfRecentlyFoundValue.exists || m_recentlySearchedValue != valueToFind) {
+        const tristate res = find(valueToFind, options, true);
+        if (true != res)
+            return res;
+    }
+    // skip values found in columns that cannot be replaced
+    int firstSkippedRecord = -1;
+    int firstSkippedColumn = -1;
+    int firstSkippedCharacter = -1;
+    while (m_currentRecord && !columnReplaceable(m_curColumn)) {
+        if (   m_curRecord == firstSkippedRecord && m_curColumn == firstSkippedColumn
+            && m_positionOfRecentlyFoundValue.firstCharacter == firstSkippedCharacter)
+        {
+            return false; // searching has wrapped around, no value can be replaced
+        }
+        if (firstSkippedRecord == -1) {
+            firstSkippedRecord = m_curRecord;
+            firstSkippedColumn = m_curColumn;
+            firstSkippedCharacter = m_positionOfRecentlyFoundValue.firstCharacter;
+        }
+        const tristate res = find(valueToFind, options, true);
+        if (true != res)
+            return res;
+    }
+    if (!m_currentRecord)
+        return false;
+    // replace the found value in the current cell
+    const QString stringValue(valueToFind.toString());
+    const QString replacementString(replacement.toString());
+    const int firstCharacter = qMax(0, m_positionOfRecentlyFoundValue.firstCharacter);
+    QString newValue(m_currentRecord->at(m_curColumn).toString());
+    if (options.textMatching == KexiSearchAndReplaceViewInterface::Options::MatchWholeField)
+        newValue = replacementString;
+    else
+        newValue.replace(firstCharacter, stringValue.length(), replacementString);
+    m_data->clearRecordEditBuffer();
+    stopFetchingRecordsInBackground();
+    if (!m_data->updateRecordEditBuffer(m_currentRecord, m_curColumn, newValue)
+        || !m_data->saveRecordChanges(m_currentRecord, true))
+    {
+        showErrorMessageForResult(m_data->result());
+        m_data->clearRecordEditBuffer();
+        return false;
+    }
+    m_data->clearRecordEditBuffer();
+    updateRecord(m_curRecord);
+    // continue searching after the replacement
+    m_positionOfRecentlyFoundValue.exists = true;
+    m_positionOfRecentlyFoundValue.firstCharacter = firstCharacter;
+    m_positionOfRecentlyFoundValue.lastCharacter = firstCharacter + replacementString.length() - 1;
+    find(valueToFind, options, true);
+    return true;
+}
+
+tristate KexiDataAwareObjectInterface::replaceAll(const QString &valueToFind,
+    const QString &replacement, const KexiSearchAndReplaceViewInterface::Options &options)
+{
+    if (!fetchAllRecords())
+        return false;
+    const int columnNumber = (options.columnNumber == KexiSearchAndReplaceViewInterface::Options::CurrentColumn)
+                             ? m_curColumn : options.columnNumber;
+    QVector<int> columns;
+    for (int c = 0; c < m_data->columnCount(); ++c) {
+        if ((columnNumber == KexiSearchAndReplaceViewInterface::Options::AllColumns || c == columnNumber)
+            && columnReplaceable(c))
+        {
+            columns.append(c);
+        }
+    }
+    if (columns.isEmpty())
+        return false;
+
+    // compute all replacements first so nothing is changed if there is nothing to replace
+    struct Replacement {
+        KDbRecordData *record;
+        int column;
+        QVariant oldValue;
+        QString newValue;
+    };
+    QVector<Replacement> replacements;
+    {
+        KexiUtils::WaitCursor wait;
+        const FindPattern pattern(valueToFind, options, true);
+        QString newValue;
+        for (KDbRecordData *record : *m_data) {
+            for (int c : columns) {
+                const QVariant oldValue(record->at(c));
+                if (pattern.replaceAll(oldValue.toString(), replacement, &newValue)) {
+                    replacements.append({record, c, oldValue, newValue});
+                }
+            }
+        }
+    }
+    if (replacements.isEmpty())
+        return false;
+    if (options.promptOnReplace
+        && KMessageBox::Continue != KMessageBox::warningContinueCancel(dynamic_cast<QWidget*>(this),
+               xi18ncp("@info", "Do you want to replace value <resource>%2</resource> with "
+                       "<resource>%3</resource> in %1 field? You will not be able to undo this.",
+                       "Do you want to replace value <resource>%2</resource> with "
+                       "<resource>%3</resource> in %1 fields? You will not be able to undo this.",
+                       replacements.count(), valueToFind, replacement),
+               QString(), KGuiItem(xi18nc("@action:button", "&Replace All"))))
+    {
+        return cancelled;
+    }
+
+    KexiUtils::WaitCursor wait;
+    stopFetchingRecordsInBackground();
+    // one transaction for all UPDATEs is much faster than a transaction per record
+    KDbTransactionGuard tg;
+    bool transactionStarted = false;
+    if (m_data->cursor()) {
+        KDbConnection *conn = m_data->cursor()->connection();
+        const KDbTransaction transaction = conn->beginTransaction();
+        if (transaction.isNull()) {
+            qWarning() << "Could not start transaction" << conn->result();
+            KMessageBox::detailedError(dynamic_cast<QWidget*>(this),
+                                       xi18n("Could not replace values."),
+                                       conn->result().message());
+            return false;
+        }
+        tg.setTransaction(transaction);
+        transactionStarted = true;
+    }
+    int saved = 0; // number of replacements saved, values of their records are changed
+    bool ok = true;
+    for (int i = 0; ok && i < replacements.count(); i = saved) {
+        // all replacements of a record are saved by a single UPDATE
+        KDbRecordData *record = replacements.at(i).record;
+        int end = i;
+        m_data->clearRecordEditBuffer();
+        for (; ok && end < replacements.count() && replacements.at(end).record == record; ++end) {
+            ok = m_data->updateRecordEditBuffer(record, replacements.at(end).column,
+                                                replacements.at(end).newValue, false);
+        }
+        ok = ok && m_data->saveRecordChanges(record);
+        if (ok) {
+            saved = end;
+        }
+    }
+    m_data->clearRecordEditBuffer();
+    if (ok && transactionStarted) {
+        ok = tg.commit();
+    }
+    if (!ok) {
+        // the transaction is rolled back, restore values of records as well
+        KDbResultInfo result(m_data->result());
+        result.allowToDiscardChanges = false;
+        if (result.message.isEmpty())
+            result.message = xi18n("Could not replace values.");
+        for (int i = 0; transactionStarted && i < saved; ++i) {
+            (*replacements[i].record)[replacements.at(i).column] = replacements.at(i).oldValue;
+        }
+        updateWidgetContents();
+        showErrorMessageForResult(result);
+        return false;
+    }
+    m_positionOfRecentlyFoundValue.exists = false;
+    updateWidgetContents();
+    return true;
 }
 
 void KexiDataAwareObjectInterface::setRecordEditing(int record)
@@ -38,6 +38,8 @@
 #include <QDebug>
 #include <QIcon>
 
+#include <functional>
+
 class QHeaderView;
 class QScrollBar;
 class QMenu;
@@ -579,7 +581,11 @@ public:
      \return true if value has been found and replaced, false if value
      has not been found and replaced, and cancelled if there is nothing
      to find or there is no data to search in or the data is read only.
-     If \a replaceAll is true, all found values are replaced. */
+     If \a replaceAll is true, all found values are replaced.
+     Otherwise the recently found value is replaced if the cursor is still at it,
+     else the value is found first; then the next value is found.
+     Only values of editable text columns are replaced. All replacements
+     of "replace all" are stored in a single transaction. */
     virtual tristate findNextAndReplace(const QVariant& valueToFind,
                                         const QVariant& replacement,
                                         const KexiSearchAndReplaceViewInterface::Options& options, bool replaceAll);
@@ -714,6 +720,56 @@ protected:
     /*! Updates widget's contents size e.g. using QScrollView::resizeContents(). */
     virtual void updateWidgetContentsSize() = 0;
 
+    /*! Called before operations that need all records of the data set, such as sorting,
+     searching or moving to the last record. Reimplemented by views that fetch records
+     on demand. Default implementation does nothing.
+     @return false on failure. */
+    virtual bool fetchAllRecords() {
+        return true;
+    }
+
+    /*! Called before records are saved, inserted or deleted using the cursor of the data.
+     Reimplemented by views that fetch records using the cursor in background to stop
+     doing so. Default implementation does nothing. */
+    virtual void stopFetchingRecordsInBackground() {
+    }
+
+    /*! Called by find() after records have been searched in parallel. While the search is
+     in progress (m_findInProgress is true) events are processed but records must not be added
+     to the data since the searching threads read it. Reimplemented by views that fetch records
+     in background to add records that have been deferred. Default implementation does nothing. */
+    virtual void findInRecordsFinished() {
+    }
+
+    /*! Called by sort() before records are sorted in memory. Reimplemented by views
+     that fetch records on demand to let the database sort records by the column selected
+     with setSorting() instead of fetching all of them.
+     @return true if records have been sorted, false on failure or cancelled if
+     records should be sorted in memory. Default implementation returns cancelled. */
+    virtual tristate sortInDatabase() {
+        return cancelled;
+    }
+
+    /*! Called by find() instead of fetchAllRecords() when searching forward with
+     the KexiSearchAndReplaceViewInterface::Options::searchInDatabase option set.
+     Reimplemented by views that fetch records on demand to ask the database which records
+     not fetched yet may contain @a valueToFind in @a columns, and to fetch records up to
+     the first of them for which @a matches returns true.
+     @return true if such record has been fetched or there is no such record, false on failure
+     or cancelled if the database cannot be used for @a options and all records should be
+     fetched. Default implementation returns cancelled. */
+    virtual tristate fetchRecordsForFind(const QString &valueToFind,
+                                         const KexiSearchAndReplaceViewInterface::Options &options,
+                                         const QVector<int> &columns,
+                                         const std::function<bool(const KDbRecordData&)> &matches)
+    {
+        Q_UNUSED(valueToFind);
+        Q_UNUSED(options);
+        Q_UNUSED(columns);
+        Q_UNUSED(matches);
+        return cancelled;
+    }
+
     /*! @internal
      Updates record appearance after canceling record edit.
      Used by cancelRecordEdit(). By default just calls updateRecord(m_curRecord).
@@ -976,7 +1032,17 @@ protected:
     //! Setup by updateIndicesForVisibleValues() and used by find()
     QVector<int> m_indicesForVisibleValues;
 
+    //! true while find() waits for records searched in parallel
+    bool m_findInProgress;
+
 private:
+    //! @return true if values of column @a col can be replaced by findNextAndReplace()
+    bool columnReplaceable(int col);
+
+    //! Replaces all values found, used by findNextAndReplace()
+    tristate replaceAll(const QString &valueToFind, const QString &replacement,
+                        const KexiSearchAndReplaceViewInterface::Options &options);
+
     /*! >= 0 if a record is edited */
     int m_recordEditing;
 
@@ -21,12 +21,44 @@
 
 #include "KexiDataTableScrollArea.h"
 #include "KexiDataTableView.h"
+#include "KexiRecordPrefetcher.h"
+#include "KexiTableScrollAreaHeaderModel.h"
+#include <kexiutils/utils.h>
 
 #include <KDbConnection>
 #include <KDbCursor>
+#include <KDbIndexSchema>
+#include <KDbOrderByColumn>
+#include <KDbQueryColumnInfo>
 #include <KDbQuerySchema>
+#include <KDbRecordData>
+#include <KDbTableSchema>
+#include <KDbTableViewColumn>
 
 #include <QDebug>
+#include <QScrollBar>
+#include <QSet>
+
+#include <limits>
+
+//! Number of records fetched when data is set
+#define INITIAL_FETCHED_RECORDS 256
+
+//! Number of records fetched below the last visible record
+#define PREFETCHED_RECORDS 128
+
+//! Maximum number of records fetched in background below the last visible record
+#define MAX_PREFETCHED_RECORDS 20000
+
+//! Time in milliseconds for which records are fetched in background ahead of scrolling
+#define PREFETCH_TIME 1000
+
+//! Maximum number of records found by the database for find(), if there are more
+//! all records are fetched and searched instead
+#define MAX_RECORDS_FOUND_IN_DATABASE 100000
+
+//! Number of records fetched at once while looking for a record with given primary key
+#define RECORDS_FETCHED_FOR_LOCATING 1024
 
 KexiDataTableScrollArea::KexiDataTableScrollArea(QWidget *parent)
         : KexiTableScrollArea(0, parent)
@@ -43,20 +75,58 @@ KexiDataTableScrollArea::KexiDataTableScrollArea(QWidget *parent, KDbCursor *cur
 
 KexiDataTableScrollArea::~KexiDataTableScrollArea()
 {
+    delete m_prefetcher;
+    deleteSortedCursor();
 }
 
 void
 KexiDataTableScrollArea::init()
 {
     m_cursor = 0;
+    m_baseCursor = nullptr;
+    m_sortedCursor = nullptr;
+    m_sortedQuery = nullptr;
+    m_estimatedRecordCount = -1;
+    m_allRecordsFetched = true;
+    m_prefetcher = nullptr;
+    m_recordLimit = 0;
+    m_lastScrollValue = 0;
+    m_scrollSpeed = 0.0;
 }
 
 bool KexiDataTableScrollArea::setData(KDbCursor *cursor)
 {
+    m_baseCursor = cursor;
+    const bool ok = setDataInternal(cursor);
+    deleteSortedCursor();
+    return ok;
+}
+
+void KexiDataTableScrollArea::deleteSortedCursor()
+{
+    if (m_sortedCursor) {
+        m_sortedCursor->connection()->deleteCursor(m_sortedCursor);
+        m_sortedCursor = nullptr;
+    }
+    delete m_sortedQuery;
+    m_sortedQuery = nullptr;
+}
+
+bool KexiDataTableScrollArea::setDataInternal(KDbCursor *cursor)
+{
+    delete m_prefetcher;
+    m_prefetcher = nullptr;
+    m_scrollSpeed = 0.0;
+    if (m_cursor && m_cursor != cursor) {
+        closeCursor(); // records of the previous cursor are not fetched anymore
+    }
     if (!cursor) {
         clearColumns();
         KexiTableScrollArea::setData(nullptr);
         m_cursor = 0;
+        m_estimatedRecordCount = -1;
+        m_allRecordsFetched = true;
+        updateSpaceForUnfetchedRecords();
         return true;
     }
     if (cursor != m_cursor) {
@@ -94,10 +164,497 @@ bool KexiDataTableScrollArea::setData(KDbCursor *cursor)
 
     setWindowTitle(windowTitle);
 
-    //PRIMITIVE!! data setting:
-    tv_data->preloadAllRecords();
+    // Fetch only the first records, the rest is fetched on demand
+    m_allRecordsFetched = false;
+    m_estimatedRecordCount = -1;
+    QList<KDbRecordData*> records;
+    const int initialCount = m_recordLimit > 0
+        ? qMin(m_recordLimit, INITIAL_FETCHED_RECORDS) : INITIAL_FETCHED_RECORDS;
+    const bool ok = (m_cursor->moveFirst() || !m_cursor->result().isError())
+                    && fetchRecords(&records, initialCount);
+    if (!ok) {
+        qWarning() << "Cannot fetch records\n--aborting setData().\n" << m_cursor->result();
+        qDeleteAll(records);
+        delete tv_data;
+        clearColumns();
+        m_allRecordsFetched = true;
+        return false;
+    }
+    for (KDbRecordData *record : records) {
+        tv_data->append(record);
+    }
+    if (m_recordLimit > 0 && records.count() >= m_recordLimit) {
+        m_allRecordsFetched = true;
+    }
+    if (m_allRecordsFetched) {
+        closeCursor();
+    }
+    if (!m_allRecordsFetched && m_recordLimit > 0) {
+        m_estimatedRecordCount = m_recordLimit;
+    } else if (!m_allRecordsFetched) {
+        // counting is much cheaper than fetching all records
+        m_estimatedRecordCount = int(m_cursor->connection()->recordCount(
+            m_cursor->query(), m_cursor->queryParameters()));
+    }
+    if (!m_allRecordsFetched && m_recordLimit <= 0 && KexiRecordPrefetcher::isSupported(m_cursor)) {
+        // the remaining records are read from the same cursor, in background
+        m_prefetcher = new KexiRecordPrefetcher;
+        connect(m_prefetcher, &KexiRecordPrefetcher::recordsAvailable,
+                this, &KexiDataTableScrollArea::slotPrefetchedRecordsAvailable,
+                Qt::QueuedConnection);
+        m_prefetcher->start(m_cursor, records.count());
+    }
 
     KexiTableScrollArea::setData(tv_data);
+    updateSpaceForUnfetchedRecords();
+    fetchVisibleRecords();
+    return true;
+}
+
+bool KexiDataTableScrollArea::fetchRecords(QList<KDbRecordData*> *records, int count)
+{
+    for (int i = 0; i < count && !m_cursor->eof(); ++i) {
+        KDbRecordData *record = m_cursor->storeCurrentRecord();
+        if (!record) {
+            return false;
+        }
+        records->append(record);
+        if (!m_cursor->moveNext() && m_cursor->result().isError()) {
+            return false;
+        }
+    }
+    m_allRecordsFetched = m_cursor->eof();
+    return true;
+}
+
+bool KexiDataTableScrollArea::fetchMoreRecords(int count)
+{
+    if (m_allRecordsFetched || !m_data || !m_cursor) {
+        return true;
+    }
+    if (m_recordLimit > 0) {
+        count = qMin(count, m_recordLimit - m_data->count());
+    }
+    QList<KDbRecordData*> fetched;
+    bool ok;
+    if (m_prefetcher) {
+        m_prefetcher->waitForRecords(count > std::numeric_limits<int>::max() - m_data->count()
+                                     ? std::numeric_limits<int>::max() : m_data->count() + count);
+        fetched = m_prefetcher->takeRecords(&m_allRecordsFetched);
+        ok = !m_prefetcher->hasFailed();
+    } else {
+        ok = fetchRecords(&fetched, count);
+        if (m_recordLimit > 0 && m_data->count() + fetched.count() >= m_recordLimit) {
+            m_allRecordsFetched = true;
+        }
+    }
+    appendRecords(fetched, ok);
+    return ok;
+}
+
+void KexiDataTableScrollArea::appendRecords(const QList<KDbRecordData*> &records, bool ok)
+{
+    if (records.count() > 0) {
+        const int oldCount = m_data->count();
+        KexiTableScrollAreaHeaderModel* model
+                = static_cast<KexiTableScrollAreaHeaderModel*>(headerModel());
+        model->beginInsertRows(QModelIndex(), oldCount, oldCount + records.count() - 1);
+        for (KDbRecordData *record : records) {
+            m_data->append(record);
+        }
+        model->endInsertRows();
+        // appending could invalidate the iterator
+        if (m_curRecord >= 0 && m_curRecord < oldCount) {
+            m_itemIterator = m_data->begin() + m_curRecord;
+        }
+        if (m_navPanel) {
+            m_navPanel->setRecordCount(recordCount());
+        }
+    }
+    if (!ok) {
+        qWarning() << "Cannot fetch records" << m_cursor->result();
+        m_allRecordsFetched = true; // do not try again
+    }
+    if (m_allRecordsFetched) {
+        delete m_prefetcher;
+        m_prefetcher = nullptr;
+        closeCursor();
+    }
+    updateSpaceForUnfetchedRecords();
+}
+
+void KexiDataTableScrollArea::closeCursor()
+{
+    // Partially read cursor can keep resources of the database locked, e.g. an unfinished
+    // statement of SQLite prevents altering or dropping the table. Records are saved
+    // using the connection, so the cursor does not have to be opened for that.
+    if (m_cursor && m_cursor->isOpened() && !m_cursor->close()) {
+        qWarning() << "Cannot close cursor" << m_cursor->result();
+    }
+}
+
+void KexiDataTableScrollArea::slotPrefetchedRecordsAvailable()
+{
+    if (!m_prefetcher || !m_data || m_findInProgress) {
+        return;
+    }
+    bool finished;
+    const QList<KDbRecordData*> records = m_prefetcher->takeRecords(&finished);
+    const bool ok = !m_prefetcher->hasFailed();
+    m_allRecordsFetched = finished;
+    appendRecords(records, ok);
+}
+
+void KexiDataTableScrollArea::stopFetchingRecordsInBackground()
+{
+    if (!m_prefetcher || !m_data) {
+        return;
+    }
+    m_prefetcher->stop();
+    bool finished;
+    const QList<KDbRecordData*> records = m_prefetcher->takeRecords(&finished);
+    const bool ok = !m_prefetcher->hasFailed();
+    delete m_prefetcher;
+    m_prefetcher = nullptr;
+    m_allRecordsFetched = finished || m_cursor->eof();
+    appendRecords(records, ok);
+}
+
+void KexiDataTableScrollArea::findInRecordsFinished()
+{
+    slotPrefetchedRecordsAvailable();
+    fetchVisibleRecords();
+}
+
+bool KexiDataTableScrollArea::fetchAllRecords()
+{
+    if (m_allRecordsFetched) {
+        return true;
+    }
+    KexiUtils::WaitCursor wait;
+    return fetchMoreRecords(std::numeric_limits<int>::max());
+}
+
+//! @return primary key value of @a record, @a pkeyFieldsOrder are indices of its fields
+static QString primaryKey(const KDbRecordData &record, const QVector<int> &pkeyFieldsOrder)
+{
+    QString key;
+    for (int index : pkeyFieldsOrder) {
+        key += record.at(index).toString() + QChar(0x1f);
+    }
+    return key;
+}
+
+//! @return true if @a value could be a part of a number converted to string
+static bool couldBePartOfNumber(const QString &value)
+{
+    for (const QChar &c : value) {
+        if (c.isLetter() && c.toLower() != QLatin1Char('e')) {
+            return false;
+        }
+    }
     return true;
 }
 
+KDbExpression KexiDataTableScrollArea::findCondition(const QString &valueToFind,
+    const KexiSearchAndReplaceViewInterface::Options &options, const QVector<int> &columns,
+    bool *ok) const
+{
+    *ok = false;
+    if (!options.caseSensitive && KexiUtils::hasNonAsciiCasedLetters(valueToFind)) {
+        return KDbExpression();
+    }
+    QString pattern(options.caseSensitive ? valueToFind : valueToFind.toLower());
+    // '%' and '_' in the value are not escaped: they can only make more records match
+    if (options.textMatching != KexiSearchAndReplaceViewInterface::Options::MatchWholeField) {
+        pattern += QLatin1Char('%');
+    }
+    if (options.textMatching == KexiSearchAndReplaceViewInterface::Options::MatchAnyPartOfField) {
+        pattern.prepend(QLatin1Char('%'));
+    }
+    KDbExpression condition;
+    for (int column : columns) {
+        KDbTableViewColumn *viewColumn = m_data->column(column);
+        if (!viewColumn || viewColumn->visibleLookupColumnInfo() || !viewColumn->columnInfo()) {
+            return KDbExpression();
+        }
+        const KDbField *field = viewColumn->columnInfo()->field();
+        if (!field->table() || field->isExpression()) {
+            return KDbExpression();
+        }
+        if (!field->isTextType()) {
+            if (field->isNumericType() && !couldBePartOfNumber(valueToFind)) {
+                continue;
+            }
+            return KDbExpression();
+        }
+        KDbExpression fieldExpr = KDbVariableExpression(field->table()->name() + '.' + field->name());
+        if (!options.caseSensitive) {
+            KDbNArgExpression arguments(KDb::ArgumentListExpression, ',');
+            arguments.append(fieldExpr);
+            fieldExpr = KDbFunctionExpression(QLatin1String("LOWER"), arguments);
+        }
+        const KDbExpression columnCondition = KDbBinaryExpression(fieldExpr, KDbToken::LIKE,
+            KDbConstExpression(KDbToken::CHARACTER_STRING_LITERAL, pattern));
+        condition = condition.isValid()
+            ? KDbExpression(KDbBinaryExpression(condition, KDbToken::OR, columnCondition))
+            : columnCondition;
+    }
+    *ok = true;
+    return condition;
+}
+
+tristate KexiDataTableScrollArea::fetchRecordsForFind(const QString &valueToFind,
+    const KexiSearchAndReplaceViewInterface::Options &options, const QVector<int> &columns,
+    const std::function<bool(const KDbRecordData&)> &matches)
+{
+    if (m_allRecordsFetched || !m_data || !m_cursor) {
+        return true;
+    }
+    KDbConnection *conn = m_cursor->connection();
+    const QVector<int> pkeyFieldsOrder(m_cursor->query()->pkeyFieldsOrder(conn));
+    if (pkeyFieldsOrder.isEmpty() || pkeyFieldsOrder.contains(-1)) {
+        return cancelled;
+    }
+    bool ok;
+    const KDbExpression condition(findCondition(valueToFind, options, columns, &ok));
+    if (!ok) {
+        return cancelled;
+    }
+    if (!condition.isValid()) {
+        return true; // the value cannot be found in any of the columns
+    }
+
+    // WHERE (<existing condition>) AND (<condition>)
+    KDbQuerySchema findQuery(*m_cursor->query(), conn);
+    KDbExpression whereExpr(KDbUnaryExpression('(', condition));
+    if (findQuery.whereExpression().isValid()) {
+        whereExpr = KDbBinaryExpression(KDbUnaryExpression('(', findQuery.whereExpression()),
+                                        KDbToken::AND, whereExpr);
+    }
+    QString errorMessage, errorDescription;
+    if (!findQuery.setWhereExpression(whereExpr, &errorMessage, &errorDescription)) {
+        qWarning() << "Cannot find records, message=" << errorMessage
+                   << "description=" << errorDescription;
+        return cancelled;
+    }
+    KexiUtils::WaitCursor wait;
+    KDbCursor *cursor = conn->executeQuery(&findQuery, m_cursor->queryParameters());
+    if (!cursor) {
+        qWarning() << "Cannot find records" << conn->result();
+        return cancelled;
+    }
+    // Keys of records found; the order of records can differ from the order of the cursor
+    // so keys are collected and records are then fetched until one of them is found.
+    QSet<QString> foundKeys;
+    bool tooMany = false;
+    for (bool valid = cursor->moveFirst(); valid; valid = cursor->moveNext()) {
+        if (foundKeys.count() >= MAX_RECORDS_FOUND_IN_DATABASE) {
+            tooMany = true;
+            break;
+        }
+        QString key;
+        for (int index : pkeyFieldsOrder) {
+            key += cursor->value(index).toString() + QChar(0x1f);
+        }
+        foundKeys.insert(key);
+    }
+    const bool failed = cursor->result().isError();
+    if (failed) {
+        qWarning() << "Cannot find records" << cursor->result();
+    }
+    conn->deleteCursor(cursor);
+    if (failed || tooMany) {
+        return cancelled;
+    }
+    for (const KDbRecordData *record : *m_data) {
+        foundKeys.remove(primaryKey(*record, pkeyFieldsOrder));
+    }
+    while (!foundKeys.isEmpty() && !m_allRecordsFetched) {
+        const int oldCount = m_data->count();
+        if (!fetchMoreRecords(RECORDS_FETCHED_FOR_LOCATING)) {
+            return false;
+        }
+        for (int i = oldCount; i < m_data->count(); ++i) {
+            const KDbRecordData *record = m_data->at(i);
+            if (foundKeys.remove(primaryKey(*record, pkeyFieldsOrder)) && matches(*record)) {
+                return true;
+            }
+        }
+    }
+    return true;
+}
+
+int KexiDataTableScrollArea::locateRecord(const QString &key, const QVector<int> &pkeyFieldsOrder)
+{
+    int from = 0;
+    Q_FOREVER {
+        for (int i = from; i < m_data->count(); ++i) {
+            if (primaryKey(*m_data->at(i), pkeyFieldsOrder) == key) {
+                return i;
+            }
+        }
+        if (m_allRecordsFetched) {
+            return -1;
+        }
+        from = m_data->count();
+        if (!fetchMoreRecords(RECORDS_FETCHED_FOR_LOCATING)) {
+            return -1;
+        }
+    }
+}
+
+tristate KexiDataTableScrollArea::sortInDatabase()
+{
+    if (!m_data || !m_baseCursor) {
+        return cancelled;
+    }
+    const int sortColumn = m_data->sortColumn();
+    const KDbOrderByColumn::SortOrder sortOrder = m_data->sortOrder();
+    if (sortColumn == -1 && !m_sortedCursor) {
+        return true; // records are in the original order
+    }
+    if (m_allRecordsFetched && sortColumn != -1) {
+        return cancelled; // sorting in memory is fast enough
+    }
+    KDbConnection *conn = m_baseCursor->connection();
+    const QVector<int> pkeyFieldsOrder(m_baseCursor->query()->pkeyFieldsOrder(conn));
+    const KDbTableSchema *masterTable = m_baseCursor->query()->masterTable();
+    if (pkeyFieldsOrder.isEmpty() || pkeyFieldsOrder.contains(-1) || !masterTable) {
+        return cancelled;
+    }
+    KDbField *sortField = nullptr;
+    if (sortColumn != -1) {
+        KDbTableViewColumn *viewColumn = m_data->column(sortColumn);
+        sortField = viewColumn->columnInfo() && !viewColumn->visibleLookupColumnInfo()
+                    ? viewColumn->field() : nullptr;
+        if (!sortField || !sortField->table()) {
+            return cancelled;
+        }
+    }
+    if (!acceptRecordEditing()) {
+        return false;
+    }
+
+    // ORDER BY <sorted column>, <primary key>; the primary key makes the order unique
+    KDbQuerySchema *sortedQuery = nullptr;
+    KDbCursor *cursor = m_baseCursor;
+    if (sortField) {
+        sortedQuery = new KDbQuerySchema(*m_baseCursor->query(), conn);
+        KDbOrderByColumnList *orderBy = sortedQuery->orderByColumnList();
+        orderBy->clear();
+        orderBy->appendField(sortField, sortOrder);
+        const KDbIndexSchema *primaryKeyIndex = masterTable->primaryKey();
+        for (int i = 0; i < primaryKeyIndex->fieldCount(); ++i) {
+            orderBy->appendField(primaryKeyIndex->field(i), KDbOrderByColumn::SortOrder::Ascending);
+        }
+        cursor = conn->prepareQuery(sortedQuery);
+        if (!cursor) {
+            qWarning() << "Cannot sort records" << conn->result();
+            delete sortedQuery;
+            return cancelled;
+        }
+    }
+    KexiUtils::WaitCursor wait;
+    const QString currentKey(m_currentRecord && m_currentRecord != m_insertRecord
+                             ? primaryKey(*m_currentRecord, pkeyFieldsOrder) : QString());
+    const int currentColumn = m_curColumn;
+    QVector<int> widths;
+    for (int i = 0; i < columnCount(); ++i) {
+        widths.append(columnWidth(i));
+    }
+
+    KDbCursor *prevSortedCursor = m_sortedCursor;
+    KDbQuerySchema *prevSortedQuery = m_sortedQuery;
+    m_sortedCursor = sortedQuery ? cursor : nullptr;
+    m_sortedQuery = sortedQuery;
+    const bool ok = setDataInternal(cursor);
+    // previous data referring to the previous cursor is deleted now
+    if (prevSortedCursor) {
+        conn->deleteCursor(prevSortedCursor);
+    }
+    delete prevSortedQuery;
+    if (!ok) {
+        return false;
+    }
+    for (int i = 0; i < widths.count() && i < columnCount(); ++i) {
+        setColumnWidth(i, widths.at(i));
+    }
+    m_data->setSorting(sortColumn, sortOrder);
+    setLocalSortOrder(sortColumn, sortOrder);
+    if (!currentKey.isEmpty()) {
+        const int record = locateRecord(currentKey, pkeyFieldsOrder);
+        if (record >= 0) {
+            setCursorPosition(record, currentColumn, ForceSetCursorPosition);
+        }
+    }
+    return true;
+}
+
+int KexiDataTableScrollArea::prefetchMargin() const
+{
+    if (!m_prefetcher || m_scrollSpeed <= 0.0) {
+        return PREFETCHED_RECORDS;
+    }
+    return int(qBound(double(PREFETCHED_RECORDS), m_scrollSpeed * PREFETCH_TIME,
+                      double(MAX_PREFETCHED_RECORDS)));
+}
+
+void KexiDataTableScrollArea::fetchVisibleRecords()
+{
+    if (m_allRecordsFetched || !m_data || recordHeight() <= 0 || m_findInProgress) {
+        return;
+    }
+    const int lastVisible
+        = (verticalScrollBar()->value() + viewport()->height()) / recordHeight();
+    if (m_prefetcher) {
+        // Records arrive in slotPrefetchedRecordsAvailable(); wait only for the visible ones
+        m_prefetcher->setTarget(lastVisible + prefetchMargin());
+        if (lastVisible >= m_data->count()) {
+            KexiUtils::WaitCursor wait;
+            fetchMoreRecords(lastVisible - m_data->count() + 1);
+        }
+        return;
+    }
+    const int needed = lastVisible + PREFETCHED_RECORDS - m_data->count();
+    if (needed > 0) {
+        KexiUtils::WaitCursor wait;
+        fetchMoreRecords(needed);
+    }
+}
+
+void KexiDataTableScrollArea::setRecordLimit(int limit)
+{
+    m_recordLimit = qMax(0, limit);
+}
+
+void KexiDataTableScrollArea::updateSpaceForUnfetchedRecords()
+{
+    const int unfetched = (m_allRecordsFetched || !m_data)
+        ? 0 : qMax(0, m_estimatedRecordCount - m_data->count());
+    setBottomMarginInternal(int(qMin(qint64(unfetched) * recordHeight(), qint64(QWIDGETSIZE_MAX))));
+}
+
+void KexiDataTableScrollArea::verticalScrollBarValueChanged(int v)
+{
+    KexiTableScrollArea::verticalScrollBarValueChanged(v);
+    // Track speed of scrolling, smoothed to ignore single jumps
+    const qint64 elapsed = m_scrollTimer.isValid() ? m_scrollTimer.restart() : -1;
+    if (!m_scrollTimer.isValid()) {
+        m_scrollTimer.start();
+    }
+    if (elapsed > 0 && elapsed < PREFETCH_TIME && recordHeight() > 0) {
+        const double speed = double(v - m_lastScrollValue) / recordHeight() / elapsed;
+        m_scrollSpeed = (m_scrollSpeed + speed) / 2.0;
+    } else {
+        m_scrollSpeed = 0.0;
+    }
+    m_lastScrollValue = v;
+    fetchVisibleRecords();
+}
+
+void KexiDataTableScrollArea::resizeEvent(QResizeEvent *e)
+{
+    KexiTableScrollArea::resizeEvent(e);
+    fetchVisibleRecords();
+}
@@ -24,10 +24,26 @@
 
 #include "KexiTableScrollArea.h"
 
+#include <KDbExpression>
+
+#include <QElapsedTimer>
+
 class KDbCursor;
+class KDbQuerySchema;
+class KDbRecordData;
+class KexiRecordPrefetcher;
 
 /**
  * Database-aware table widget.
+ *
+ * Records are fetched from the cursor on demand: only records needed to fill the viewport
+ * and a prefetch margin below it are fetched when data is set or the view is scrolled.
+ * Remaining records are fetched when an operation such as sorting or searching needs them.
+ * Until then the scrollbar range is estimated using number of records of the query.
+ *
+ * For server databases the remaining records are read from the cursor in a background
+ * thread (see KexiRecordPrefetcher). The number of records fetched ahead follows
+ * the speed of scrolling, so fast scrolling does not stall the GUI.
  */
 class KEXIDATATABLE_EXPORT KexiDataTableScrollArea : public KexiTableScrollArea
 {
@@ -52,7 +68,9 @@ public:
     using KexiTableScrollArea::setData;
 
     /*! Fills table view with data using \a cursor. \return true on success.
-     Cursor \a cursor will not be owned by this object. */
+     Only the first records are fetched, see fetchAllRecords().
+     Cursor \a cursor will not be owned by this object. It is used for fetching remaining
+     records so it should not be closed or deleted before other data is set. */
     bool setData(KDbCursor *cursor);
 
     /*! \return cursor used as data source for this table view,
@@ -73,12 +91,116 @@ public:
 //  virtual void print(KPrinter &printer);
 #endif
 
+    //! @return true if all records have been fetched from the cursor
+    bool allRecordsFetched() const {
+        return m_allRecordsFetched;
+    }
+
+    /*! Sets maximum number of records fetched from the cursor to @a limit.
+     0 means no limit, what is the default. Takes effect on next setData(KDbCursor*). */
+    void setRecordLimit(int limit);
+
+    //! @return maximum number of records fetched from the cursor, 0 if there is no limit
+    int recordLimit() const {
+        return m_recordLimit;
+    }
+
 protected:
     void init();
 
+    //! Reimplemented to fetch records that become visible
+    virtual void verticalScrollBarValueChanged(int v) override;
+
+    //! Reimplemented to fetch records that become visible
+    virtual void resizeEvent(QResizeEvent *e) override;
+
+    //! Fetches all remaining records from the cursor
+    virtual bool fetchAllRecords() override;
+
+    /*! Reimplemented to execute the query again with ORDER BY for the sorted column
+     if not all records are fetched, so backend indexes can be used. The current record
+     is kept by its primary key. The database is not used if the query has no primary key
+     of its master table or the sorted column is not a table field. */
+    virtual tristate sortInDatabase() override;
+
+    /*! Reimplemented to look for records containing @a valueToFind using a WHERE
+     condition added to the cursor's query. Text fields are compared using LIKE.
+     Records are identified by primary key, so the database is not used if the query
+     has no primary key of its master table. */
+    virtual tristate fetchRecordsForFind(const QString &valueToFind,
+                                         const KexiSearchAndReplaceViewInterface::Options &options,
+                                         const QVector<int> &columns,
+                                         const std::function<bool(const KDbRecordData&)> &matches) override;
+
+    //! Reimplemented to append records fetched in background while find() was in progress
+    virtual void findInRecordsFinished() override;
+
+    //! Reimplemented to stop the prefetcher, remaining records are fetched
+    //! in the GUI thread then
+    virtual void stopFetchingRecordsInBackground() override;
+
+private Q_SLOTS:
+    //! Appends records fetched in background to the displayed data.
+    //! Records are left in the prefetcher while find() searches records in parallel.
+    void slotPrefetchedRecordsAvailable();
+
 private:
+    //! Fills the table view with data using @a cursor
+    bool setDataInternal(KDbCursor *cursor);
+
+    //! Deletes cursor and query created by sortInDatabase()
+    void deleteSortedCursor();
+
+    //! @return number of record with primary key @a key, records are fetched if needed.
+    //! -1 is returned if there is no such record.
+    int locateRecord(const QString &key, const QVector<int> &pkeyFieldsOrder);
+
+    //! Fetches at most @a count next records from the cursor and appends them to @a records.
+    //! @return false on failure.
+    bool fetchRecords(QList<KDbRecordData*> *records, int count);
+
+    //! Fetches records, if needed, so that all visible records and a prefetch
+    //! margin below them are available
+    void fetchVisibleRecords();
+
+    //! Appends at most @a count records to the displayed data and updates the view
+    bool fetchMoreRecords(int count);
+
+    //! Closes the cursor if it is opened, called when no more records are fetched from it
+    void closeCursor();
+
+    //! Appends @a records to the displayed data and updates the view.
+    //! @a ok is false if fetching failed.
+    void appendRecords(const QList<KDbRecordData*> &records, bool ok);
+
+    //! @return number of records that should be fetched below the last visible record
+    //! for current speed of scrolling
+    int prefetchMargin() const;
+
+    /*! @return condition for finding @a valueToFind in @a columns according to @a options.
+     The condition can also be true for values that do not match, e.g. for whole words.
+     @a ok is set to false if the condition cannot be built, the condition is invalid
+     if the value cannot be found in any of the columns. */
+    KDbExpression findCondition(const QString &valueToFind,
+                                const KexiSearchAndReplaceViewInterface::Options &options,
+                                const QVector<int> &columns, bool *ok) const;
+
+    //! Reserves space for records that are not fetched yet, so the scrollbar range
+    //! corresponds to the estimated number of records
+    void updateSpaceForUnfetchedRecords();
+
     //db stuff
     KDbCursor *m_cursor;
+    KDbCursor *m_baseCursor; //!< Cursor set using setData()
+    KDbCursor *m_sortedCursor; //!< Owned cursor for records sorted in database, can be nullptr
+    KDbQuerySchema *m_sortedQuery; //!< Owned query of m_sortedCursor
+    int m_estimatedRecordCount; //!< Number of records found using COUNT, -1 if unknown
+    bool m_allRecordsFetched;
+    KexiRecordPrefetcher *m_prefetcher; //!< Fetches records in background, can be nullptr
+    int m_recordLimit; //!< Maximum number of fetched records, 0 for no limit
+    QElapsedTimer m_scrollTimer;
+    int m_lastScrollValue;
+    double m_scrollSpeed; //!< Records per millisecond, negative when scrolling up
 };
 
 #endif
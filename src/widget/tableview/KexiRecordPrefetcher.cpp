@@ -0,0 +1,199 @@
+/* This file is part of the KDE project
+   Copyright (C) 2026 Kexi developers <kexi-devel@kde.org>
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public License
+   along with this program; see the file COPYING.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include "KexiRecordPrefetcher.h"
+
+#include <KDbConnection>
+#include <KDbCursor>
+#include <KDbDriver>
+#include <KDbDriverMetaData>
+#include <KDbRecordData>
+
+#include <QDebug>
+#include <QMutex>
+#include <QThread>
+#include <QWaitCondition>
+
+//! Maximum number of records fetched before they are handed over to the GUI thread
+#define RECORDS_PER_BLOCK 256
+
+class Q_DECL_HIDDEN KexiRecordPrefetcher::Private : public QThread
+{
+public:
+    explicit Private(KexiRecordPrefetcher *prefetcher)
+        : q(prefetcher)
+    {
+    }
+
+    void run() override;
+
+    //! Sets state after fetching a block, @return true if recordsAvailable() should be emitted
+    bool blockFetched(const QList<KDbRecordData*> &block, bool finish, bool fail);
+
+    KexiRecordPrefetcher * const q;
+    KDbCursor *cursor = nullptr; //!< Used by this thread only while it is running
+
+    mutable QMutex mutex;
+    QWaitCondition targetChanged;
+    QWaitCondition recordsFetched;
+    QList<KDbRecordData*> records; //!< Fetched, not yet taken
+    int target = 0;
+    int fetchedCount = 0;
+    bool finished = false;
+    bool failed = false;
+    bool stopped = false;
+    bool notified = false; //!< true if recordsAvailable() has been emitted and records not taken
+};
+
+bool KexiRecordPrefetcher::Private::blockFetched(const QList<KDbRecordData*> &block,
+                                                 bool finish, bool fail)
+{
+    QMutexLocker locker(&mutex);
+    records += block;
+    fetchedCount += block.count();
+    finished = finish || fail;
+    failed = fail;
+    recordsFetched.wakeAll();
+    if (notified || (block.isEmpty() && !finished)) {
+        return false;
+    }
+    notified = true;
+    return true;
+}
+
+void KexiRecordPrefetcher::Private::run()
+{
+    Q_FOREVER {
+        int count;
+        {
+            QMutexLocker locker(&mutex);
+            while (!stopped && fetchedCount >= target) {
+                targetChanged.wait(&mutex);
+            }
+            if (stopped) {
+                break;
+            }
+            count = qMin(target - fetchedCount, RECORDS_PER_BLOCK);
+        }
+        QList<KDbRecordData*> block;
+        bool fail = false;
+        for (int i = 0; i < count && !cursor->eof(); ++i) {
+            KDbRecordData *record = cursor->storeCurrentRecord();
+            if (!record) {
+                fail = true;
+                break;
+            }
+            block.append(record);
+            if (!cursor->moveNext() && cursor->result().isError()) {
+                fail = true;
+                break;
+            }
+        }
+        if (fail) {
+            qWarning() << "Could not fetch records" << cursor->result();
+        }
+        const bool finish = cursor->eof();
+        if (blockFetched(block, finish, fail)) {
+            emit q->recordsAvailable();
+        }
+        if (finish || fail) {
+            break;
+        }
+    }
+}
+
+KexiRecordPrefetcher::KexiRecordPrefetcher(QObject *parent)
+    : QObject(parent)
+    , d(new Private(this))
+{
+}
+
+KexiRecordPrefetcher::~KexiRecordPrefetcher()
+{
+    stop();
+    qDeleteAll(d->records);
+    delete d;
+}
+
+void KexiRecordPrefetcher::stop()
+{
+    {
+        QMutexLocker locker(&d->mutex);
+        d->stopped = true;
+        d->targetChanged.wakeAll();
+    }
+    d->wait();
+}
+
+//static
+bool KexiRecordPrefetcher::isSupported(KDbCursor *cursor)
+{
+    return cursor && cursor->query() && cursor->connection()->driver()
+        && !cursor->connection()->driver()->metaData()->isFileBased();
+}
+
+void KexiRecordPrefetcher::start(KDbCursor *cursor, int fetchedCount)
+{
+    Q_ASSERT(!d->isRunning());
+    Q_ASSERT(cursor->isOpened());
+    d->cursor = cursor;
+    d->fetchedCount = fetchedCount;
+    d->target = fetchedCount;
+    d->finished = cursor->eof();
+    if (!d->finished) {
+        d->start();
+    }
+}
+
+void KexiRecordPrefetcher::setTarget(int count)
+{
+    QMutexLocker locker(&d->mutex);
+    if (count > d->target) {
+        d->target = count;
+        d->targetChanged.wakeAll();
+    }
+}
+
+void KexiRecordPrefetcher::waitForRecords(int count)
+{
+    QMutexLocker locker(&d->mutex);
+    if (count > d->target) {
+        d->target = count;
+        d->targetChanged.wakeAll();
+    }
+    while (!d->finished && d->fetchedCount < count) {
+        d->recordsFetched.wait(&d->mutex);
+    }
+}
+
+QList<KDbRecordData*> KexiRecordPrefetcher::takeRecords(bool *finished)
+{
+    QMutexLocker locker(&d->mutex);
+    QList<KDbRecordData*> result;
+    result.swap(d->records);
+    d->notified = false;
+    *finished = d->finished;
+    return result;
+}
+
+bool KexiRecordPrefetcher::hasFailed() const
+{
+    QMutexLocker locker(&d->mutex);
+    return d->failed;
+}
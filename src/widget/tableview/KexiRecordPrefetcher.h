@@ -0,0 +1,86 @@
+/* This file is part of the KDE project
+   Copyright (C) 2026 Kexi developers <kexi-devel@kde.org>
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public License
+   along with this program; see the file COPYING.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef KEXIRECORDPREFETCHER_H
+#define KEXIRECORDPREFETCHER_H
+
+#include <QObject>
+#include <QList>
+
+class KDbCursor;
+class KDbRecordData;
+
+//! @internal @short Fetches records of an opened cursor in a background thread
+/*! The prefetcher continues reading records from the current position of a cursor,
+ so the query is not executed again. Records are fetched in blocks until the number
+ requested using setTarget() is reached. The GUI thread takes them using takeRecords()
+ after recordsAvailable() is emitted. The cursor must not be used otherwise until
+ the prefetcher is stopped using stop() or deleted, so records have to be fetched
+ before they are saved, inserted or deleted using the cursor.
+
+ It is only used for server databases. Their drivers transfer the whole result set
+ to the client when the cursor is opened, so reading the cursor does not use
+ the connection that is used by the GUI thread at the same time. For file databases
+ records are read from the database file while the cursor is moved. */
+class KexiRecordPrefetcher : public QObject
+{
+    Q_OBJECT
+public:
+    explicit KexiRecordPrefetcher(QObject *parent = nullptr);
+
+    //! Stops fetching and deletes records that have not been taken
+    ~KexiRecordPrefetcher();
+
+    //! Stops fetching and waits until the background thread stops using the cursor.
+    //! Records fetched so far can be taken using takeRecords(). The cursor is positioned
+    //! on the first record not fetched then.
+    void stop();
+
+    //! @return true if records of @a cursor can be fetched in background
+    static bool isSupported(KDbCursor *cursor);
+
+    //! Starts fetching records of opened @a cursor in background, beginning with
+    //! the current record. @a fetchedCount is the number of records fetched before,
+    //! it is included in numbers passed to setTarget() and waitForRecords().
+    void start(KDbCursor *cursor, int fetchedCount);
+
+    //! Requests fetching of records until @a count records are fetched in total
+    void setTarget(int count);
+
+    //! Waits until @a count records are fetched in total or there are no more records
+    void waitForRecords(int count);
+
+    //! Takes records fetched so far, ownership is transferred to the caller.
+    //! @a finished is set to true if there are no more records to fetch.
+    QList<KDbRecordData*> takeRecords(bool *finished);
+
+    //! @return true if fetching failed
+    bool hasFailed() const;
+
+Q_SIGNALS:
+    //! Emitted in the background thread after records are fetched, once until
+    //! takeRecords() is called
+    void recordsAvailable();
+
+private:
+    class Private;
+    Private * const d;
+};
+
+#endif
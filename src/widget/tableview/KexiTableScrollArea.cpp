@@ -66,6 +66,8 @@
 #include <QScrollBar>
 #include <QAction>
 #include <QDebug>
+#include <QRandomGenerator>
+#include <QScopedValueRollback>
 #ifdef KEXI_TABLE_PRINT_SUPPORT
 #include <QPrinter>
 #endif
@@ -74,6 +76,12 @@
 //#define KEXITABLEVIEW_DEBUG_PAINT
 //#define KEXITABLEVIEW_COMBO_DEBUG
 
+//! Data sets having more records are sampled by adjustColumnWidthToContents()
+#define COLUMN_WIDTH_SAMPLE_SIZE 1000
+
+//! Number of recently viewed pages measured by adjustColumnWidthToContents()
+#define RECENTLY_VIEWED_PAGES 8
+
 const int MINIMUM_ROW_HEIGHT = 17;
 
 KexiTableScrollArea::Appearance::Appearance(QWidget *widget)
@@ -308,6 +316,7 @@ void KexiTableScrollArea::updateVerticalHeaderSection(int row)
 
 void KexiTableScrollArea::slotRecordsDeleted(const QList<int> &records)
 {
+    d->cellTextCache.clear(); // deleted records can be reallocated at the same addresses
     viewport()->repaint();
     updateWidgetContentsSize();
     setCursorPosition(qMax(0, (int)m_curRecord - (int)records.count()), -1, ForceSetCursorPosition);
@@ -355,11 +364,18 @@ void KexiTableScrollArea::setData(KDbTableViewData *data, bool owner)
         qDeleteAll(d->editors);
         d->editors.clear();
     }
+    d->valueWidthCache.clear();
+    d->columnsAdjustedToContents.clear();
+    d->recentlyViewedRecords.clear();
+    d->cellTextCache.clear();
     KexiDataAwareObjectInterface::setData(data, owner);
 }
 
 void KexiTableScrollArea::clearColumnsInternal(bool /*repaint*/)
 {
+    d->valueWidthCache.clear();
+    d->columnsAdjustedToContents.clear();
+    d->cellTextCache.clear();
 }
 
 void KexiTableScrollArea::slotUpdate()
@@ -661,6 +677,7 @@ void KexiTableScrollArea::paintCell(QPainter* p, KDbRecordData *data, int record
     int y_offset = 0;
     int align = Qt::TextSingleLine | Qt::AlignVCenter;
     QString txt; //text to draw
+    KexiTableScrollAreaCellText *cellText = 0; //cached text, if available
 
     if (data == m_insertRecord) {
         //qDebug() << "we're at INSERT row...";
@@ -746,10 +763,44 @@ void KexiTableScrollArea::paintCell(QPainter* p, KDbRecordData *data, int record
         //get visible lookup value if available
         getVisibleLookupValue(cellValue, edit, data, tvcol);
 
+        // Texts of cells that are not edited are cached; the value is compared
+        // so a changed value is never painted using outdated text. Editors painting
+        // in setupContents() have to be called every time.
+        if (data != m_currentRecord && data != m_insertRecord && !defaultValueDisplayed
+            && !edit->paintsContents())
+        {
+            const QPair<KDbRecordData*, int> key(data, column);
+            cellText = d->cellTextCache.object(key);
+            if (!cellText || !cellText->matches(cellValue, p->font(), w, h)) {
+                cellText = new KexiTableScrollAreaCellText;
+                cellText->value = cellValue;
+                cellText->font = p->font();
+                cellText->width = w;
+                cellText->height = h;
+                edit->setupContents(p, false, cellValue, txt, align, x, y_offset, w, h);
+                cellText->text = txt;
+                cellText->align = align;
+                cellText->x = x;
+                cellText->y_offset = y_offset;
+                cellText->w = w;
+                cellText->h = h;
+                cellText->staticText.setTextFormat(Qt::PlainText);
+                cellText->staticText.setText(txt);
+                d->cellTextCache.insert(key, cellText);
+            } else {
+                txt = cellText->text;
+                align = cellText->align;
+                x = cellText->x;
+                y_offset = cellText->y_offset;
+                w = cellText->w;
+                h = cellText->h;
+            }
+        } else {
 /*qDebug() << "edit->setupContents()" << (m_currentRecord == record && col == m_curColumn)
         << cellValue << txt << align << x << y_offset << w << h;*/
-        edit->setupContents(p, m_currentRecord == data && column == m_curColumn,
-                            cellValue, txt, align, x, y_offset, w, h);
+            edit->setupContents(p, m_currentRecord == data && column == m_curColumn,
+                                cellValue, txt, align, x, y_offset, w, h);
+        }
     }
     if (!d->appearance.horizontalGridEnabled)
         y_offset++; //correction because we're not drawing cell borders
@@ -817,9 +868,33 @@ void KexiTableScrollArea::paintCell(QPainter* p, KDbRecordData *data, int record
         if (defaultValueDisplayed)
             p->setFont(d->defaultValueDisplayParameters.font);
         p->setPen(defaultPen);
-        p->drawText(x, y_offset,
-                    w - (x + x) - ((align & Qt::AlignLeft) ? 2 : 0)/*right space*/, h,
-                    align, txt);
+        const int textWidth = w - (x + x) - ((align & Qt::AlignLeft) ? 2 : 0)/*right space*/;
+        if (cellText) {
+            const QSizeF size(cellText->staticText.size());
+            qreal textX = x;
+            if (align & Qt::AlignRight) {
+                textX += textWidth - size.width();
+            } else if (align & Qt::AlignHCenter) {
+                textX += (textWidth - size.width()) / 2;
+            }
+            qreal textY = y_offset;
+            if (align & Qt::AlignBottom) {
+                textY += h - size.height();
+            } else if (align & Qt::AlignVCenter) {
+                textY += (h - size.height()) / 2;
+            }
+            if (size.width() > textWidth || size.height() > h) {
+                // clip like drawText() does
+                p->save();
+                p->setClipRect(x, y_offset, textWidth, h, Qt::IntersectClip);
+                p->drawStaticText(QPointF(textX, textY), cellText->staticText);
+                p->restore();
+            } else {
+                p->drawStaticText(QPointF(textX, textY), cellText->staticText);
+            }
+        } else {
+            p->drawText(x, y_offset, textWidth, h, align, txt);
+        }
     }
 #ifdef KEXITABLEVIEW_DEBUG_PAINT
     p->setPen(QPen(QColor(255, 0, 0, 150), 1, Qt::DashLine));
@@ -1547,6 +1622,9 @@ void KexiTableScrollArea::dragLeaveEvent(QDragLeaveEvent *e)
 void KexiTableScrollArea::updateCell(int record, int column)
 {
 //    qDebug() << record << column;
+    if (m_data && record >= 0 && record < m_data->count()) {
+        d->cellTextCache.remove(qMakePair(m_data->at(record), column));
+    }
     d->scrollAreaWidget->update(cellGeometry(record, column));
 }
 
@@ -1560,6 +1638,12 @@ void KexiTableScrollArea::updateRecord(int record)
 //    qDebug()<<record << horizontalScrollBar()->value() << recordPos(row) << viewport()->width() << recordHeight();
     if (record < 0 || record >= (recordCount() + 2/* sometimes we want to refresh the row after last*/))
         return;
+    if (m_data && record < m_data->count()) {
+        KDbRecordData *data = m_data->at(record);
+        for (int column = 0; column < columnCount(); ++column) {
+            d->cellTextCache.remove(qMakePair(data, column));
+        }
+    }
     //qDebug() << horizontalScrollBar()->value() << verticalScrollBar()->value();
     //qDebug() << QRect( columnPos( leftcol ), recordPos(row), viewport()->width(), recordHeight() );
     d->scrollAreaWidget->update(horizontalScrollBar()->value(), recordPos(record),
@@ -1568,8 +1652,9 @@ void KexiTableScrollArea::updateRecord(int record)
 
 void KexiTableScrollArea::slotColumnWidthChanged(int column, int oldSize, int newSize)
 {
-    Q_UNUSED(oldSize);
-    Q_UNUSED(newSize);
+    if (!d->insideAdjustColumnWidth && oldSize != newSize) {
+        d->columnsAdjustedToContents.remove(column); // resized by the user
+    }
     updateScrollAreaWidgetSize();
     d->scrollAreaWidget->update(d->horizontalHeader->offset() + columnPos(column), d->verticalHeader->offset(),
                                 viewport()->width() - columnPos(column), viewport()->height());
@@ -1816,6 +1901,7 @@ void KexiTableScrollArea::updateAfterAcceptRecordEditing()
 {
     KexiDataAwareObjectInterface::updateAfterAcceptRecordEditing();
     m_navPanel->showEditingIndicator(false);
+    widenColumnsToContents(m_currentRecord);
 }
 
 bool KexiTableScrollArea::getVisibleLookupValue(QVariant& cellValue, KexiTableEdit *edit,
@@ -1864,6 +1950,14 @@ void KexiTableScrollArea::verticalScrollBarValueChanged(int v)
     if (record >= 0) {
         setHighlightedRecordNumber(record);
     }
+    // remember viewed records for adjustColumnWidthToContents()
+    const int topRecord = recordNumberAt(v);
+    if (topRecord >= 0 && !d->recentlyViewedRecords.contains(topRecord)) {
+        d->recentlyViewedRecords.prepend(topRecord);
+        if (d->recentlyViewedRecords.count() > RECENTLY_VIEWED_PAGES) {
+            d->recentlyViewedRecords.removeLast();
+        }
+    }
 }
 
 #ifdef KEXI_TABLE_PRINT_SUPPORT
@@ -1934,39 +2028,91 @@ void KexiTableScrollArea::adjustColumnWidthToContents(int column)
 {
     if (!hasData())
         return;
-    if (column == -1) {
-        const int cols = columnCount();
-        for (int i = 0; i < cols; i++)
-            adjustColumnWidthToContents(i);
-        return;
+    const QVector<KDbRecordData*> records(recordsForColumnWidth());
+    const int first = column == -1 ? 0 : column;
+    const int last = column == -1 ? columnCount() - 1 : column;
+    QScopedValueRollback<bool> insideAdjustColumnWidthRollback(d->insideAdjustColumnWidth, true);
+    for (int i = first; i <= last; i++) {
+        const int width = columnWidthForRecords(i, records);
+        if (width < 0)
+            continue;
+        //qDebug() << "setColumnWidth(column=" << i << ", width=" << width << ")";
+        setColumnWidth(i, width);
+        d->columnsAdjustedToContents.insert(i);
+    }
+}
+
+QVector<KDbRecordData*> KexiTableScrollArea::recordsForColumnWidth() const
+{
+    QVector<KDbRecordData*> records;
+    const int count = m_data->count();
+    if (count <= COLUMN_WIDTH_SAMPLE_SIZE) {
+        records.reserve(count);
+        for (KDbTableViewDataConstIterator it(m_data->constBegin()); it != m_data->constEnd(); ++it) {
+            records.append(*it);
+        }
+        return records;
+    }
+    // Measure visible and recently viewed records, and a uniform random sample.
+    // The generator is seeded with the record count so the result is repeatable.
+    QSet<int> numbers;
+    const int perPage = qMax(recordsPerPage(), 1);
+    QList<int> pages(d->recentlyViewedRecords);
+    pages.prepend(qMax(recordNumberAt(verticalScrollBar()->value()), 0));
+    for (int page : pages) {
+        for (int i = page; i < qMin(page + perPage + 1, count); ++i) {
+            numbers.insert(i);
+        }
+    }
+    if (m_curRecord >= 0 && m_curRecord < count) {
+        numbers.insert(m_curRecord);
+    }
+    QRandomGenerator generator(count);
+    for (int i = 0; i < COLUMN_WIDTH_SAMPLE_SIZE; ++i) {
+        numbers.insert(int(generator.bounded(count)));
     }
+    records.reserve(numbers.count());
+    for (int number : numbers) {
+        records.append(m_data->at(number));
+    }
+    return records;
+}
 
+int KexiTableScrollArea::columnWidthForRecords(int column, const QVector<KDbRecordData*> &records)
+{
     int indexOfVisibleColumn = (m_data->column(column) && m_data->column(column)->columnInfo())
                                ? m_data->column(column)->columnInfo()->indexForVisibleLookupValue() : -1;
     if (-1 == indexOfVisibleColumn)
         indexOfVisibleColumn = column;
 
     if (indexOfVisibleColumn < 0)
-        return;
+        return -1;
 
-    QList<KDbRecordData*>::ConstIterator it(m_data->constBegin());
-    if (it != m_data->constEnd() && (*it)->count() <= indexOfVisibleColumn)
-        return;
+    if (!m_data->isEmpty() && m_data->first()->count() <= indexOfVisibleColumn)
+        return -1;
 
     KexiCellEditorFactoryItem *item = KexiCellEditorFactory::item(columnType(indexOfVisibleColumn));
     if (!item)
-        return;
+        return -1;
     int maxw = horizontalHeaderVisible() ? d->horizontalHeader->preferredSectionSize(column) : 0;
-    if (maxw == 0 && m_data->isEmpty())
-        return; //nothing to adjust
-
-//! \todo js: this is NOT EFFECTIVE for big data sets!!!!
+    if (maxw == 0 && records.isEmpty())
+        return -1; //nothing to adjust
 
     KexiTableEdit *ed = tableEditorWidget(column/* not indexOfVisibleColumn*/);
     const QFontMetrics fm(fontMetrics());
     if (ed) {
-        for (it = m_data->constBegin(); it != m_data->constEnd(); ++it) {
-            const int wfw = ed->widthForValue((*it)->at(indexOfVisibleColumn), fm);
+        const QString keyPrefix(QString::number(column) + QLatin1Char(':'));
+        for (KDbRecordData *data : records) {
+            const QVariant value(data->at(indexOfVisibleColumn));
+            const QString key(keyPrefix + value.toString());
+            int *cachedWidth = d->valueWidthCache.object(key);
+            int wfw;
+            if (cachedWidth) {
+                wfw = *cachedWidth;
+            } else {
+                wfw = ed->widthForValue(value, fm);
+                d->valueWidthCache.insert(key, new int(wfw));
+            }
             maxw = qMax(maxw, wfw);
         }
         const bool focused = currentColumn() == column;
@@ -1974,9 +2120,21 @@ void KexiTableScrollArea::adjustColumnWidthToContents(int column)
     }
     if (maxw < KEXITV_MINIMUM_COLUMN_WIDTH)
         maxw = KEXITV_MINIMUM_COLUMN_WIDTH; //not too small
-    //qDebug() << "setColumnWidth(column=" << column
-    //    << ", indexOfVisibleColumn=" << indexOfVisibleColumn << ", width=" << maxw << ")";
-    setColumnWidth(column/* not indexOfVisibleColumn*/, maxw);
+    return maxw;
+}
+
+void KexiTableScrollArea::widenColumnsToContents(KDbRecordData *data)
+{
+    if (!data || !hasData() || d->columnsAdjustedToContents.isEmpty())
+        return;
+    const QVector<KDbRecordData*> records{ data };
+    QScopedValueRollback<bool> insideAdjustColumnWidthRollback(d->insideAdjustColumnWidth, true);
+    for (int column : d->columnsAdjustedToContents) {
+        const int width = columnWidthForRecords(column, records);
+        if (width > columnWidth(column)) {
+            setColumnWidth(column, width);
+        }
+    }
 }
 
 void KexiTableScrollArea::setColumnWidth(int column, int width)
@@ -2278,6 +2436,10 @@ void KexiTableScrollArea::changeEvent(QEvent *e)
         d->horizontalHeader->setSelectionBackgroundColor(palette().color(QPalette::Highlight));
         break;
     }
+    case QEvent::FontChange:
+        d->valueWidthCache.clear();
+        d->cellTextCache.clear();
+        break;
     default:;
     }
     QScrollArea::changeEvent(e);
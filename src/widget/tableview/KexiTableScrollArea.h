@@ -39,6 +39,7 @@
 
 #include <QScrollArea>
 #include <QVariant>
+#include <QVector>
 #include <QFocusEvent>
 #include <QDragLeaveEvent>
 #include <QDragMoveEvent>
@@ -274,7 +275,10 @@ public Q_SLOTS:
     virtual void setSpreadSheetMode(bool set) override;
 
     /*! Adjusts \a column column's width to its (current) contents.
-     If \a column == -1, all columns' width is adjusted. */
+     If \a column == -1, all columns' width is adjusted.
+     For large data sets only a sample of records is measured: visible and recently
+     viewed records and records picked at random. Adjusted columns are widened later
+     when wider values are inserted or edited. */
     void adjustColumnWidthToContents(int column = -1);
 
     //! Sets column width to \a width.
@@ -479,11 +483,13 @@ protected Q_SLOTS:
     //! Handles KDbTableViewData::recordInserted() signal to repaint when needed.
     virtual void slotRecordInserted(KDbRecordData *data, bool repaint) override {
         KexiDataAwareObjectInterface::slotRecordInserted(data, repaint);
+        widenColumnsToContents(data);
     }
 
     //! Like above, not db-aware version
     virtual void slotRecordInserted(KDbRecordData *data, int record, bool repaint) override {
         KexiDataAwareObjectInterface::slotRecordInserted(data, record, repaint);
+        widenColumnsToContents(data);
     }
 
     /*! Handles verticalScrollBar()'s valueChanged(int) signal.
@@ -698,6 +704,16 @@ protected:
 
     virtual void endRemoveItem(int pos) override;
 
+    //! @return records measured by adjustColumnWidthToContents()
+    QVector<KDbRecordData*> recordsForColumnWidth() const;
+
+    /*! @return width needed to display values of \a records in \a column,
+     or -1 if the width cannot be computed. */
+    int columnWidthForRecords(int column, const QVector<KDbRecordData*> &records);
+
+    //! Widens columns adjusted to contents if \a data has wider values
+    void widenColumnsToContents(KDbRecordData *data);
+
     class Private;
     Private * const d;
 
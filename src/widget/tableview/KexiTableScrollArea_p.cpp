@@ -28,6 +28,12 @@
 #include "kexitableedit.h"
 
 
+//! Maximum number of widths of values cached for adjusting column widths
+#define VALUE_WIDTH_CACHE_SIZE 10000
+
+//! Maximum number of cell texts cached for painting
+#define CELL_TEXT_CACHE_SIZE 20000
+
 KexiTableScrollArea::Private::Private(KexiTableScrollArea* t)
         : appearance(t)
 {
@@ -48,6 +54,9 @@ KexiTableScrollArea::Private::Private(KexiTableScrollArea* t)
     insideResizeEvent = false;
     firstShowEvent = true;
     scrollAreaWidget = 0;
+    insideAdjustColumnWidth = false;
+    valueWidthCache.setMaxCost(VALUE_WIDTH_CACHE_SIZE);
+    cellTextCache.setMaxCost(CELL_TEXT_CACHE_SIZE);
 }
 
 KexiTableScrollArea::Private::~Private()
@@ -38,6 +38,9 @@
 #include <QLabel>
 #include <QList>
 #include <QHash>
+#include <QCache>
+#include <QSet>
+#include <QStaticText>
 #include <QRubberBand>
 #include <QToolTip>
 
@@ -45,6 +48,29 @@ class KexiTableScrollAreaWidget;
 class KexiTableEdit;
 class QLabel;
 
+//! @internal Text of a cell prepared by KexiTableEdit::setupContents(), cached by paintCell()
+class KexiTableScrollAreaCellText
+{
+public:
+    //! @return true if the text has been prepared for the same value, font and size
+    bool matches(const QVariant &aValue, const QFont &aFont, int aWidth, int aHeight) const {
+        return width == aWidth && height == aHeight && font == aFont && value == aValue;
+    }
+
+    QVariant value;
+    QFont font;
+    int width;  //!< Width of the cell
+    int height; //!< Height of the cell
+    // results of KexiTableEdit::setupContents()
+    QString text;
+    int align;
+    int x;
+    int y_offset;
+    int w;
+    int h;
+    QStaticText staticText; //!< Text elided to fit the cell
+};
+
 //! @short a dynamic tooltip for table view cells
 /*! @internal */
 /*! @todo KEXI3 KexiTableViewCellToolTip
@@ -153,6 +179,22 @@ public:
 
     //! true if this is the first call of showEvent()
     bool firstShowEvent;
+
+    //! Widths of values computed by editors, key is column number and text of a value.
+    //! Cleared when font or data changes.
+    QCache<QString, int> valueWidthCache;
+
+    //! Columns adjusted to contents, widened when wider values are inserted or edited
+    QSet<int> columnsAdjustedToContents;
+
+    //! Used to distinguish resizing by adjustColumnWidthToContents() from resizing by the user
+    bool insideAdjustColumnWidth;
+
+    //! First visible records of recently viewed pages, most recent first
+    QList<int> recentlyViewedRecords;
+
+    //! Texts of cells prepared for painting, so scrolling does not format values again
+    QCache<QPair<KDbRecordData*, int>, KexiTableScrollAreaCellText> cellTextCache;
 };
 
 #endif
@@ -192,6 +192,11 @@ void KexiBlobTableEdit::paintFocusBorders(QPainter *p, QVariant &, int x, int y,
     p->drawRect(x, y, w, h);
 }
 
+bool KexiBlobTableEdit::paintsContents() const
+{
+    return true;
+}
+
 void
 KexiBlobTableEdit::setupContents(QPainter *p, bool focused, const QVariant& val,
                                  QString &txt, int &align, int &x, int &y_offset, int &w, int &h)
@@ -550,6 +555,11 @@ bool KexiKIconTableEdit::cursorAtEnd()
     return true;
 }
 
+bool KexiKIconTableEdit::paintsContents() const
+{
+    return true;
+}
+
 void KexiKIconTableEdit::setupContents(QPainter *p, bool /*focused*/, const QVariant& val,
                                        QString &/*txt*/, int &/*align*/, int &/*x*/, int &y_offset, int &w, int &h)
 {
@@ -74,6 +74,9 @@ public:
     virtual void setupContents(QPainter *p, bool focused, const QVariant& val,
                                QString &txt, int &align, int &x, int &y_offset, int &w, int &h) override;
 
+    //! Reimplemented, returns true since setupContents() paints the contents
+    virtual bool paintsContents() const override;
+
 protected Q_SLOTS:
     void slotUpdateActionsAvailabilityRequested(bool *valueIsNull, bool *valueIsReadOnly);
 
@@ -149,6 +152,9 @@ public:
     virtual void setupContents(QPainter *p, bool focused, const QVariant& val,
                                QString &txt, int &align, int &x, int &y_offset, int &w, int &h) override;
 
+    //! Reimplemented, returns true since setupContents() paints the contents
+    virtual bool paintsContents() const override;
+
     /*! Handles copy action for value. Does nothing.
      \a visibleValue is unused here. Reimplemented after KexiTableEdit. */
     virtual void handleCopyAction(const QVariant& value, const QVariant& visibleValue) override;
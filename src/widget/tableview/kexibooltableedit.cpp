@@ -80,6 +80,11 @@ bool KexiBoolTableEdit::cursorAtEnd()
     return true;
 }
 
+bool KexiBoolTableEdit::paintsContents() const
+{
+    return true;
+}
+
 void KexiBoolTableEdit::setupContents(QPainter *p, bool focused, const QVariant& val,
                                       QString &txt, int &align, int &x, int &y_offset, int &w, int &h)
 {
@@ -54,6 +54,9 @@ public:
     virtual void setupContents(QPainter *p, bool focused, const QVariant& val,
                                QString &txt, int &align, int &x, int &y_offset, int &w, int &h) override;
 
+    //! Reimplemented, returns true since setupContents() paints the contents
+    virtual bool paintsContents() const override;
+
     virtual void clickedOnContents() override;
 
     /*! Handles action having standard name \a actionName.
@@ -27,6 +27,7 @@
 #include "kexi.h"
 #include "KexiTableScrollAreaWidget.h"
 
+#include <KDbRecordData>
 #include <KDbTableSchema>
 #include <KDbTableViewColumn>
 
@@ -85,25 +86,12 @@ int KexiComboBoxBase::recordToHighlightForLookupTable() const
         return -1;
     if (lookupFieldSchema->boundColumn() == -1)
         return -1; //err
-    bool ok;
-    const int recordUid = origValue().toInt();
-//! @todo for now we're assuming the id is INTEGER
-    KDbTableViewData *tvData = popup()->tableView()->data();
     const int boundColumn = boundColumnIndex();
     if (boundColumn < 0) {
         return -1;
     }
-    int record = -1;
-    for (KDbTableViewDataIterator it(tvData->begin()); it != tvData->end(); ++it) {
-        record++;
-        KDbRecordData* data = *it;
-        if (data->at(boundColumn).toInt(&ok) == recordUid && ok)
-            return record;
-        if (!ok)
-            break;
-    }
-    //item not found: highlight 1st record, if available
-    return -1;
+//! @todo for now we're assuming the id is INTEGER
+    return popup()->recordForIntegerValue(boundColumn, origValue().toInt());
 }
 
 void KexiComboBoxBase::setValueInternal(const QVariant& add_, bool removeOld)
@@ -129,7 +117,9 @@ void KexiComboBoxBase::setValueInternal(const QVariant& add_, bool removeOld)
                 if (!popup())
                     createPopup(false/*!show*/);
             }
+            m_acceptedValue = QVariant();
             if (popup()) {
+                popup()->cancelFilter(); // the value is looked up in all records
                 const int recordToHighlight = recordToHighlightForLookupTable();
                 popup()->tableView()->setHighlightedRecordNumber(recordToHighlight);
 
@@ -137,8 +127,15 @@ void KexiComboBoxBase::setValueInternal(const QVariant& add_, bool removeOld)
                 if (m_setVisibleValueOnSetValueInternal && -1 != visibleColumn) {
                     //only for table views
                     KDbRecordData *data = popup()->tableView()->highlightedRecord();
-                    if (data)
+                    if (data) {
                         valueToSet = data->at(visibleColumn);
+                    } else {
+                        // the record can be not fetched yet or filtered out
+                        KDbRecordData record;
+                        if (popup()->findRecordInDatabase(boundColumnIndex(), origValue(), &record)) {
+                            valueToSet = record.at(visibleColumn);
+                        }
+                    }
                 } else {
                     hasValueToSet = false;
                 }
@@ -185,37 +182,37 @@ KDbRecordData* KexiComboBoxBase::selectRecordForEnteredValueInLookupTable(const
     KDbLookupFieldSchema *lookupFieldSchema = this->lookupFieldSchema();
     if (!popup() || !lookupFieldSchema)
         return 0; //safety
-//-not effective for large sets: please cache it!
+    popup()->flushFilter(); // look in records matching the whole entered text
 //.trimmed() is not generic!
 
     const bool valueIsText = v.type() == QVariant::String || v.type() == QVariant::ByteArray; //most common case
-    const QString txt(valueIsText ? v.toString().trimmed() : QString());
     KDbTableViewData *lookupData = popup()->tableView()->data();
     const int visibleColumn = visibleColumnIndex();
     if (-1 == visibleColumn)
         return 0;
-    KDbTableViewDataConstIterator it(lookupData->constBegin());
-    int record;
-    for (record = 0;it != lookupData->constEnd();++it, record++) {
-        if (valueIsText) {
-            if ((*it)->at(visibleColumn).toString().trimmed().compare(txt, Qt::CaseInsensitive) == 0)
-                break;
-        } else {
-            if ((*it)->at(visibleColumn) == v)
+    int record = popup()->recordForTextFetchingAll(visibleColumn, v.toString());
+    if (!valueIsText && (record < 0 || lookupData->at(record)->at(visibleColumn) != v)) {
+        // the index only compares texts, so look for an equal value
+        record = -1;
+        int r = 0;
+        for (KDbTableViewDataConstIterator it(lookupData->constBegin()); it != lookupData->constEnd(); ++it, r++) {
+            if ((*it)->at(visibleColumn) == v) {
+                record = r;
                 break;
+            }
         }
     }
 
     m_setValueOrTextInInternalEditor_enabled = false; // <-- this is the entered value,
     //     so do not change the internal editor's contents
-    if (it != lookupData->constEnd())
+    if (record >= 0)
         popup()->tableView()->selectRecord(record);
     else
         popup()->tableView()->clearSelection();
 
     m_setValueOrTextInInternalEditor_enabled = true;
 
-    return it != lookupData->constEnd() ? *it : 0;
+    return record >= 0 ? lookupData->at(record) : 0;
 }
 
 QString KexiComboBoxBase::valueForString(const QString& str, int* record,
@@ -226,15 +223,21 @@ QString KexiComboBoxBase::valueForString(const QString& str, int* record,
     if (!relData)
         return QString(); //safety
     //use 'related table data' model
-    //-not effective for large sets: please cache it!
     //.trimmed() is not generic!
 
-    const QString txt(str.trimmed());
-    KDbTableViewDataConstIterator it(relData->constBegin());
-    for (*record = 0;it != relData->constEnd();++it, (*record)++) {
-        const QString s((*it)->at(lookInColumn).toString());
-        if (s.trimmed().compare(txt, Qt::CaseInsensitive) == 0)
-            return s;
+    if (popup() && popup()->tableView()->data() == relData) {
+        // the popup displays related data, use its index
+        *record = popup()->recordForTextFetchingAll(lookInColumn, str);
+        if (*record >= 0)
+            return relData->at(*record)->at(lookInColumn).toString();
+    } else {
+        const QString txt(str.trimmed());
+        KDbTableViewDataConstIterator it(relData->constBegin());
+        for (*record = 0;it != relData->constEnd();++it, (*record)++) {
+            const QString s((*it)->at(lookInColumn).toString());
+            if (s.trimmed().compare(txt, Qt::CaseInsensitive) == 0)
+                return s;
+        }
     }
 
     *record = -1;
@@ -310,6 +313,9 @@ QVariant KexiComboBoxBase::value()
             data = selectRecordForEnteredValueInLookupTable(m_userEnteredValue);
         }
         const int boundColumn = boundColumnIndex();
+        if (!data && !m_internalEditorValueChanged && m_acceptedValue.isValid()) {
+            return m_acceptedValue; // accepted from filtered records
+        }
         return (data && boundColumn >= 0) ? data->at(boundColumn) : QVariant();
     } else if (popup()) {
         //use 'enum hints' model
@@ -498,12 +504,19 @@ void KexiComboBoxBase::createPopup(bool show)
             /*-->*/ m_moveCursorToEndInInternalEditor_enabled = show;
             m_selectAllInInternalEditor_enabled = show;
             m_setValueInInternalEditor_enabled = show;
-            if (recordToHighlight == -1) {
-                recordToHighlight = qMax(popup()->tableView()->highlightedRecordNumber(), 0);
-                setValueInInternalEditor(QVariant());
+            if (recordToHighlight == -1 && lookupFieldSchema && !origValue().isNull()
+                && !popup()->allRecordsDisplayed())
+            {
+                // the record is not fetched yet or filtered out, keep its value displayed
+                popup()->tableView()->clearSelection();
+            } else {
+                if (recordToHighlight == -1) {
+                    recordToHighlight = qMax(popup()->tableView()->highlightedRecordNumber(), 0);
+                    setValueInInternalEditor(QVariant());
+                }
+                popup()->tableView()->selectRecord(recordToHighlight);
+                popup()->tableView()->setHighlightedRecordNumber(recordToHighlight);
             }
-            popup()->tableView()->selectRecord(recordToHighlight);
-            popup()->tableView()->setHighlightedRecordNumber(recordToHighlight);
             popup()->tableView()->ensureCellVisible(-1, 0); // scroll to left as expected
 
             /*-->*/ m_moveCursorToEndInInternalEditor_enabled = true;
@@ -540,6 +553,12 @@ void KexiComboBoxBase::slotRecordAccepted(KDbRecordData* data, int record)
     //..nothing to do?
     updateButton();
     slotRecordSelected(data);
+    if (popup() && popup()->isFiltered() && lookupFieldSchema()) {
+        // display all records again; filtered records are still in use here
+        const int boundColumn = boundColumnIndex();
+        m_acceptedValue = (data && boundColumn >= 0) ? data->at(boundColumn) : QVariant();
+        popup()->cancelFilterLater(boundColumn, m_acceptedValue);
+    }
     /*emit*/acceptRequested();
 }
 
@@ -606,6 +625,9 @@ void KexiComboBoxBase::slotInternalEditorValueChanged(const QVariant& v)
         return;
     m_userEnteredValue = v;
     m_internalEditorValueChanged = true;
+    if (popup() && lookupFieldSchema()) {
+        popup()->setFilterText(v.toString());
+    }
     if (v.toString().isEmpty()) {
         if (popup()) {
             popup()->tableView()->clearSelection();
@@ -695,9 +717,26 @@ void KexiComboBoxBase::undoChanges()
     KDbLookupFieldSchema *lookupFieldSchema = this->lookupFieldSchema();
     if (lookupFieldSchema) {
 //  qDebug() << "m_visibleValue BEFORE=" << m_visibleValue;
-        if (popup())
-            popup()->tableView()->selectRecord(popup()->tableView()->highlightedRecordNumber());
+        m_acceptedValue = QVariant();
+        if (popup()) {
+            // display all records again and select the original value
+            popup()->cancelFilter();
+            const int record = recordToHighlightForLookupTable();
+            popup()->tableView()->setHighlightedRecordNumber(record);
+            if (record >= 0) {
+                popup()->tableView()->selectRecord(record);
+            } else {
+                popup()->tableView()->clearSelection();
+            }
+        }
         m_visibleValue = visibleValueForLookupField();
+        const int visibleColumn = visibleColumnIndex();
+        KDbRecordData lookupRecord;
+        if (m_visibleValue.isNull() && popup() && visibleColumn >= 0
+            && popup()->findRecordInDatabase(boundColumnIndex(), origValue(), &lookupRecord))
+        {
+            m_visibleValue = lookupRecord.at(visibleColumn); // not fetched yet
+        }
 //  qDebug() << "m_visibleValue AFTER=" << m_visibleValue;
         setValueOrTextInInternalEditor(m_visibleValue);
     }
@@ -167,6 +167,10 @@ protected:
 
     QVariant m_visibleValue;
 
+    //! Bound value of the record accepted from filtered records of the popup, used by value()
+    //! if the record is not selected after all records are displayed again
+    QVariant m_acceptedValue;
+
     QVariant m_userEnteredValue; //!< value (usually a text) entered by hand (by the user)
 
     bool m_internalEditorValueChanged; //!< true if user has text or other value inside editor
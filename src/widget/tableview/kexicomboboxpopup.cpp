@@ -23,21 +23,34 @@
 #include "KexiTableScrollArea_p.h"
 #include "kexitableedit.h"
 #include <kexi_global.h>
+#include <kexiutils/utils.h>
 
 #include <KDbConnection>
 #include <KDbCursor>
 #include <KDbExpression>
 #include <KDbLookupFieldSchema>
+#include <KDbQueryColumnInfo>
 #include <KDbQuerySchema>
+#include <KDbRecordData>
 #include <KDbTableViewColumn>
+#include <KDbTableViewData>
 
 #include <QDebug>
 #include <QEvent>
+#include <QHash>
+#include <QTimer>
 #include <QKeyEvent>
 #include <QScrollBar>
+#include <QSignalBlocker>
 #include <QApplication>
 #include <QDesktopWidget>
 
+//! Delay in milliseconds after typing before the popup's records are filtered
+#define FILTER_DELAY 250
+
+//! Maximum number of records fetched for filtered lookup
+#define FILTERED_RECORD_LIMIT 100
+
 /*! @internal
  Helper for KexiComboBoxPopup. */
 class KexiComboBoxPopup_KexiTableView : public KexiDataTableScrollArea
@@ -82,6 +95,18 @@ public:
     bool setData(KDbCursor *cursor) {
         return KexiDataTableScrollArea::setData(cursor);
     }
+    using KexiDataTableScrollArea::fetchAllRecords;
+};
+
+//! @internal Index of a popup's column: value -> first record.
+//! Records are only appended to the popup's data, so records fetched on demand
+//! are indexed when a value is looked up next time.
+template <typename Key>
+class KexiComboBoxPopupIndex
+{
+public:
+    QHash<Key, int> firstRecords;
+    int indexedRecordCount = 0;
 };
 
 //========================================
@@ -92,12 +117,18 @@ class KexiComboBoxPopupPrivate
 public:
     KexiComboBoxPopupPrivate()
             : int_f(0)
-            , privateQuery(0) {
+            , privateQuery(0)
+            , conn(0)
+            , baseCursor(0)
+            , filterField(0)
+            , filterQuery(0)
+            , filterCursor(0) {
         maxRecordCount = KexiComboBoxPopup::defaultMaxRecordCount;
     }
     ~KexiComboBoxPopupPrivate() {
         delete int_f;
         delete privateQuery;
+        delete filterQuery;
     }
 
     KexiComboBoxPopup_KexiTableView *tv;
@@ -108,8 +139,50 @@ public:
     //! Used when query is used as the record source type (KDbLookupFieldSchemaRecordSource::Query).
     //! We're doing this in this case because it's hard to alter the query to remove columns.
     QList<int> visibleColumnsToShow;
+    //! Indexes of columns used by recordForIntegerValue()
+    QHash<int, KexiComboBoxPopupIndex<qint64>> integerIndexes;
+    //! Indexes of columns used by recordForText(), keys are normalized texts
+    QHash<int, KexiComboBoxPopupIndex<QString>> textIndexes;
+
+    // Filtering of large lookup sources, see KexiComboBoxPopup::setFilterText()
+    KDbConnection *conn;
+    KDbCursor *baseCursor; //!< Cursor for unfiltered records
+    KDbField *filterField; //!< Table field of the visible column, 0 if filtering is not available
+    KDbQuerySchema *filterQuery; //!< Copy of base cursor's query with filter added
+    KDbCursor *filterCursor;
+    QString filterText;
+    QTimer filterTimer; //!< Delays filtering while the user types
 };
 
+//! @return text normalized for case-insensitive lookup
+static QString lookupKey(const QString &text)
+{
+    return text.trimmed().toCaseFolded();
+}
+
+//! @return value of @a field in the FILTERED_RECORD_LIMIT-th record of @a query satisfying
+//! @a condition, in order of @a field values; null if there are less records or the value
+//! cannot be found. KDb query schemas have no LIMIT clause, so the SQL is built here;
+//! only queries using a single table without parameters are supported.
+static QVariant filteredRecordLimitValue(KDbConnection *conn, KDbQuerySchema *query,
+                                         const KDbField *field, const KDbExpression &condition)
+{
+    if (query->tables()->count() != 1 || !query->parameters(conn).isEmpty()) {
+        return QVariant();
+    }
+    const QString tableName(conn->escapeIdentifier(field->table()->name()));
+    const QString fieldName(tableName + '.' + conn->escapeIdentifier(field->name()));
+    const KDbEscapedString sql(
+        KDbEscapedString("SELECT %1 FROM %2 WHERE %3 ORDER BY %1 LIMIT 1 OFFSET %4")
+            .arg(fieldName).arg(tableName).arg(condition.toString(conn->driver()))
+            .arg(FILTERED_RECORD_LIMIT - 1));
+    QString value;
+    if (true != conn->querySingleString(sql, &value)) {
+        return QVariant();
+    }
+    return value;
+}
+
 //========================================
 
 const int KexiComboBoxPopup::defaultMaxRecordCount = 8;
@@ -133,6 +206,11 @@ KexiComboBoxPopup::KexiComboBoxPopup(KDbConnection *conn, KDbField *field, QWidg
 
 KexiComboBoxPopup::~KexiComboBoxPopup()
 {
+    if (d->filterCursor) {
+        KDbCursor *noCursor = nullptr;
+        d->tv->setData(noCursor);
+        d->conn->deleteCursor(d->filterCursor);
+    }
     delete d;
 }
 
@@ -161,6 +239,10 @@ void KexiComboBoxPopup::init()
 
     connect(d->tv, SIGNAL(itemDblClicked(KDbRecordData*,int,int)),
             this, SLOT(slotTVItemAccepted(KDbRecordData*,int,int)));
+
+    d->filterTimer.setSingleShot(true);
+    d->filterTimer.setInterval(FILTER_DELAY);
+    connect(&d->filterTimer, SIGNAL(timeout()), this, SLOT(applyFilter()));
 }
 
 void KexiComboBoxPopup::setData(KDbConnection *conn, KDbTableViewColumn *column, KDbField *aField)
@@ -322,8 +404,21 @@ void KexiComboBoxPopup::setData(KDbConnection *conn, KDbTableViewColumn *column,
         if (d->tv->data())
             d->tv->data()->disconnect(this);
         d->tv->setData(cursor);
+        d->conn = conn;
+        d->baseCursor = cursor;
+        if (!multipleLookupColumnJoined && !d->tv->allRecordsFetched()) {
+            // large source: allow filtering by the visible column, see setFilterText()
+            const int filterColumn = d->privateQuery ? 0 : visibleColumns.first();
+            const KDbQueryColumnInfo *columnInfo
+                = cursor->query()->fieldsExpanded(conn).value(filterColumn);
+            if (columnInfo && columnInfo->field() && columnInfo->field()->table()
+                && columnInfo->field()->isTextType())
+            {
+                d->filterField = columnInfo->field();
+            }
+        }
 
-        connect(d->tv, SIGNAL(dataRefreshed()), this, SLOT(slotDataReloadRequested()));
+        connectDataSignals();
         updateSize();
         return;
     }
@@ -353,11 +448,27 @@ void KexiComboBoxPopup::setDataInternal(KDbTableViewData *data, bool owner)
     if (d->tv->data())
         d->tv->data()->disconnect(this);
     d->tv->setData(data, owner);
-    connect(d->tv, SIGNAL(dataRefreshed()), this, SLOT(slotDataReloadRequested()));
+    connectDataSignals();
 
     updateSize();
 }
 
+void KexiComboBoxPopup::connectDataSignals()
+{
+    slotDataChanged();
+    connect(d->tv, SIGNAL(dataRefreshed()), this, SLOT(slotDataReloadRequested()));
+    KDbTableViewData *data = d->tv->data();
+    if (!data) {
+        return;
+    }
+    connect(data, SIGNAL(recordInserted(KDbRecordData*,bool)), this, SLOT(slotDataChanged()));
+    connect(data, SIGNAL(recordInserted(KDbRecordData*,int,bool)), this, SLOT(slotDataChanged()));
+    connect(data, SIGNAL(recordUpdated(KDbRecordData*)), this, SLOT(slotDataChanged()));
+    connect(data, SIGNAL(recordDeleted()), this, SLOT(slotDataChanged()));
+    connect(data, SIGNAL(recordsDeleted(QList<int>)), this, SLOT(slotDataChanged()));
+    connect(data, SIGNAL(reloadRequested()), this, SLOT(slotDataChanged()));
+}
+
 void KexiComboBoxPopup::updateSize(int minWidth)
 {
     const int records = qMin(d->maxRecordCount, d->tv->recordCount());
@@ -475,7 +586,229 @@ bool KexiComboBoxPopup::eventFilter(QObject *o, QEvent *e)
 
 void KexiComboBoxPopup::slotDataReloadRequested()
 {
+    slotDataChanged();
     updateSize();
 }
 
+void KexiComboBoxPopup::slotDataChanged()
+{
+    d->integerIndexes.clear();
+    d->textIndexes.clear();
+}
+
+bool KexiComboBoxPopup::isFilteringAvailable() const
+{
+    return d->filterField;
+}
+
+void KexiComboBoxPopup::setFilterText(const QString &text)
+{
+    if (!d->filterField || text.trimmed() == d->filterText) {
+        return;
+    }
+    d->filterText = text.trimmed();
+    d->filterTimer.start();
+}
+
+void KexiComboBoxPopup::flushFilter()
+{
+    if (d->filterTimer.isActive()) {
+        applyFilter();
+    }
+}
+
+void KexiComboBoxPopup::cancelFilter()
+{
+    d->filterTimer.stop();
+    if (d->filterText.isEmpty()) {
+        return;
+    }
+    d->filterText.clear();
+    applyFilter();
+}
+
+void KexiComboBoxPopup::cancelFilterLater(int column, const QVariant &value)
+{
+    QTimer::singleShot(0, this, [this, column, value]() {
+        cancelFilter();
+        bool ok;
+        const qint64 key = value.toLongLong(&ok);
+        const int record = ok ? recordForIntegerValue(column, key) : -1;
+        // the value is already accepted, do not notify about selection again
+        QSignalBlocker blocker(d->tv);
+        if (record >= 0) {
+            d->tv->selectRecord(record);
+        } else {
+            d->tv->clearSelection();
+        }
+        d->tv->setHighlightedRecordNumber(record);
+    });
+}
+
+bool KexiComboBoxPopup::isFiltered() const
+{
+    return d->filterCursor;
+}
+
+void KexiComboBoxPopup::applyFilter()
+{
+    d->filterTimer.stop();
+    if (!d->filterField) {
+        return;
+    }
+    KDbCursor *prevFilterCursor = d->filterCursor;
+    KDbQuerySchema *prevFilterQuery = d->filterQuery;
+    d->filterCursor = 0;
+    d->filterQuery = 0;
+    if (!d->filterText.isEmpty()) {
+        // WHERE (<existing condition>) AND LOWER(<visible column>) LIKE '<lowercase text>%'
+        // Case-sensitive comparison is used if LOWER() may not work for the text.
+        d->filterQuery = new KDbQuerySchema(*d->baseCursor->query(), d->conn);
+        KDbExpression fieldExpr = KDbVariableExpression(
+            d->filterField->table()->name() + '.' + d->filterField->name());
+        QString pattern(d->filterText);
+        if (!KexiUtils::hasNonAsciiCasedLetters(pattern)) {
+            KDbNArgExpression arguments(KDb::ArgumentListExpression, ',');
+            arguments.append(fieldExpr);
+            fieldExpr = KDbFunctionExpression(QLatin1String("LOWER"), arguments);
+            pattern = pattern.toLower();
+        }
+        KDbExpression expr = KDbBinaryExpression(fieldExpr, KDbToken::LIKE,
+            KDbConstExpression(KDbToken::CHARACTER_STRING_LITERAL, QString(pattern + '%')));
+        const KDbExpression whereExpr(d->filterQuery->whereExpression());
+        if (whereExpr.isValid()) {
+            expr = KDbBinaryExpression(KDbUnaryExpression('(', whereExpr), KDbToken::AND, expr);
+        }
+        // Let the server send only about FILTERED_RECORD_LIMIT records:
+        // AND <visible column> <= <value of the last record>
+        const QVariant lastValue(
+            filteredRecordLimitValue(d->conn, d->filterQuery, d->filterField, expr));
+        if (!lastValue.isNull()) {
+            expr = KDbBinaryExpression(expr, KDbToken::AND, KDbBinaryExpression(
+                KDbVariableExpression(d->filterField->table()->name() + '.' + d->filterField->name()),
+                KDbToken::LESS_OR_EQUAL,
+                KDbConstExpression(KDbToken::CHARACTER_STRING_LITERAL, lastValue)));
+        }
+        QString errorMessage, errorDescription;
+        if (d->filterQuery->setWhereExpression(expr, &errorMessage, &errorDescription)) {
+            d->filterCursor = d->conn->prepareQuery(d->filterQuery);
+        } else {
+            qWarning() << "Cannot filter records, message=" << errorMessage
+                       << "description=" << errorDescription;
+        }
+        if (!d->filterCursor) {
+            // keep displaying current records
+            delete d->filterQuery;
+            d->filterQuery = prevFilterQuery;
+            d->filterCursor = prevFilterCursor;
+            return;
+        }
+    }
+    if (!d->filterCursor && !prevFilterCursor) {
+        return; // unfiltered records are displayed already
+    }
+    if (d->tv->data())
+        d->tv->data()->disconnect(this);
+    d->tv->setRecordLimit(d->filterCursor ? FILTERED_RECORD_LIMIT : 0);
+    d->tv->setData(d->filterCursor ? d->filterCursor : d->baseCursor);
+    slotDataChanged(); // indexed records are not displayed anymore
+    if (prevFilterCursor) {
+        d->conn->deleteCursor(prevFilterCursor);
+    }
+    delete prevFilterQuery;
+    connectDataSignals();
+    d->tv->setHighlightedRecordNumber(0);
+    updateSize();
+}
+
+int KexiComboBoxPopup::recordForIntegerValue(int column, qint64 value)
+{
+    KDbTableViewData *data = d->tv->data();
+    if (!data || column < 0) {
+        return -1;
+    }
+    KexiComboBoxPopupIndex<qint64> &index = d->integerIndexes[column];
+    bool ok;
+    for (int record = index.indexedRecordCount; record < data->count(); ++record) {
+        const qint64 key = data->at(record)->at(column).toLongLong(&ok);
+        if (ok && !index.firstRecords.contains(key)) {
+            index.firstRecords.insert(key, record);
+        }
+    }
+    index.indexedRecordCount = data->count();
+    return index.firstRecords.value(value, -1);
+}
+
+int KexiComboBoxPopup::recordForText(int column, const QString &text)
+{
+    KDbTableViewData *data = d->tv->data();
+    if (!data || column < 0) {
+        return -1;
+    }
+    KexiComboBoxPopupIndex<QString> &index = d->textIndexes[column];
+    for (int record = index.indexedRecordCount; record < data->count(); ++record) {
+        const QString key(lookupKey(data->at(record)->at(column).toString()));
+        if (!index.firstRecords.contains(key)) {
+            index.firstRecords.insert(key, record);
+        }
+    }
+    index.indexedRecordCount = data->count();
+    return index.firstRecords.value(lookupKey(text), -1);
+}
+
+int KexiComboBoxPopup::recordForTextFetchingAll(int column, const QString &text)
+{
+    int record = recordForText(column, text);
+    if (record < 0 && !isFilteringAvailable() && !allRecordsDisplayed()) {
+        KexiUtils::WaitCursor wait;
+        if (d->tv->fetchAllRecords()) {
+            record = recordForText(column, text);
+        }
+    }
+    return record;
+}
+
+bool KexiComboBoxPopup::allRecordsDisplayed() const
+{
+    return !d->filterCursor && d->tv->allRecordsFetched();
+}
+
+bool KexiComboBoxPopup::findRecordInDatabase(int column, const QVariant &value,
+                                             KDbRecordData *record)
+{
+    if (allRecordsDisplayed() || !d->baseCursor || column < 0 || value.isNull()) {
+        return false;
+    }
+    const KDbQueryColumnInfo *columnInfo
+        = d->baseCursor->query()->fieldsExpanded(d->conn).value(column);
+    const KDbField *field = columnInfo ? columnInfo->field() : nullptr;
+    if (!field || !field->table() || field->isExpression()) {
+        return false;
+    }
+    KDbToken valueToken;
+    if (field->isIntegerType()) {
+        valueToken = KDbToken::INTEGER_CONST;
+    } else if (field->isTextType()) {
+        valueToken = KDbToken::CHARACTER_STRING_LITERAL;
+    } else {
+        return false;
+    }
+    // WHERE (<existing condition>) AND <column> = <value>
+    KDbQuerySchema query(*d->baseCursor->query(), d->conn);
+    KDbExpression expr = KDbBinaryExpression(
+        KDbVariableExpression(field->table()->name() + '.' + field->name()), '=',
+        KDbConstExpression(valueToken, value));
+    const KDbExpression whereExpr(query.whereExpression());
+    if (whereExpr.isValid()) {
+        expr = KDbBinaryExpression(KDbUnaryExpression('(', whereExpr), KDbToken::AND, expr);
+    }
+    QString errorMessage, errorDescription;
+    if (!query.setWhereExpression(expr, &errorMessage, &errorDescription)) {
+        qWarning() << "Cannot look up value, message=" << errorMessage
+                   << "description=" << errorDescription;
+        return false;
+    }
+    return true == d->conn->querySingleRecord(&query, record);
+}
+
 #include "kexicomboboxpopup.moc"
@@ -28,6 +28,7 @@ class KDbRecordData;
 class KDbTableViewColumn;
 class KDbTableViewData;
 class KexiComboBoxPopupPrivate;
+class QVariant;
 class KexiTableScrollArea;
 
 //! Internal class for displaying popup table view
@@ -60,6 +61,62 @@ public:
     /*! Default maximum number of records for KexiComboBoxPopup objects. */
     static const int defaultMaxRecordCount;
 
+    /*! \return number of the first record of the popup's data having integer value \a value
+     in column \a column, or -1 if there is no such record.
+     Only records fetched so far are searched, see findRecordInDatabase().
+     An index of the column is built on first use and extended with records fetched later,
+     so lookups do not scan the data. Indexes are invalidated when the data is changed,
+     reloaded or filtered. */
+    int recordForIntegerValue(int column, qint64 value);
+
+    /*! \return number of the first record of the popup's data having text \a text
+     in column \a column, or -1 if there is no such record.
+     Texts are trimmed and compared case-insensitively. @see recordForIntegerValue() */
+    int recordForText(int column, const QString &text);
+
+    //! \return true if all records of the popup's data source are fetched and not filtered
+    bool allRecordsDisplayed() const;
+
+    /*! \return number of the first record having text \a text in column \a column like
+     recordForText() but if the record is not found and filtering is not available,
+     all records are fetched and searched. Use it for values entered by the user, which
+     cannot be looked up using the filter or findRecordInDatabase(). */
+    int recordForTextFetchingAll(int column, const QString &text);
+
+    /*! Looks up the first record having value \a value in column \a column using the database,
+     so records not fetched yet or filtered out are found too. The record is not displayed.
+     Only integer and text columns of database tables are supported.
+     \return true and sets \a record if the record has been found. false is returned without
+     a query if all records are displayed because the record would have been among them. */
+    bool findRecordInDatabase(int column, const QVariant &value, KDbRecordData *record);
+
+    //! \return true if records of the popup can be filtered using setFilterText().
+    //! Filtering is available for lookup sources that are larger than the first fetched records.
+    bool isFilteringAvailable() const;
+
+    /*! Sets text for filtering records of a large lookup source.
+     After a short delay, so typing is not slowed down, the popup displays only records
+     which visible column starts with \a text, compared case-insensitively. They are found
+     by the database and at most 100 are fetched. Empty \a text displays all records again.
+     Does nothing if filtering is not available. */
+    void setFilterText(const QString &text);
+
+    //! Filters records immediately if filtering requested by setFilterText() is pending
+    void flushFilter();
+
+    //! Cancels filtering requested by setFilterText(): pending filtering is stopped
+    //! and all records are displayed again if they are filtered
+    void cancelFilter();
+
+    /*! Cancels filtering like cancelFilter() after returning to the event loop, so it can be
+     called while the displayed records are in use, e.g. when a record is accepted.
+     Then the first record having integer value \a value in column \a column is selected
+     and highlighted if it is fetched. */
+    void cancelFilterLater(int column, const QVariant &value);
+
+    //! \return true if only records found using the filter text are displayed
+    bool isFiltered() const;
+
 Q_SIGNALS:
     void recordAccepted(KDbRecordData *data, int record);
     void cancelled();
@@ -72,6 +129,8 @@ public Q_SLOTS:
 protected Q_SLOTS:
     void slotTVItemAccepted(KDbRecordData *data, int record, int column);
     void slotDataReloadRequested();
+    void slotDataChanged();
+    void applyFilter();
 
 protected:
     void init();
@@ -86,6 +145,9 @@ protected:
     //! used by setData()
     void setDataInternal(KDbTableViewData *data, bool owner = true);   //!< helper
 
+    //! Connects signals of the table view and its data after setting data
+    void connectDataSignals();
+
     KexiComboBoxPopupPrivate * const d;
 
     friend class KexiComboBoxTableEdit;
@@ -206,6 +206,11 @@ void KexiComboBoxTableEdit::paintFocusBorders(QPainter *p, QVariant &, int x, in
     p->drawRect(x, y, w, h);
 }
 
+bool KexiComboBoxTableEdit::paintsContents() const
+{
+    return d->internalEditor && d->internalEditor->paintsContents();
+}
+
 void KexiComboBoxTableEdit::setupContents(QPainter *p, bool focused, const QVariant& val,
         QString &txt, int &align, int &x, int &y_offset, int &w, int &h)
 {
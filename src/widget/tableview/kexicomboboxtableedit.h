@@ -86,6 +86,9 @@ public:
     virtual void setupContents(QPainter *p, bool focused, const QVariant& val,
                                QString &txt, int &align, int &x, int &y_offset, int &w, int &h) override;
 
+    //! Reimplemented, the internal editor can paint the contents
+    virtual bool paintsContents() const override;
+
     /*! Used to handle key press events for the item. */
     virtual bool handleKeyPress(QKeyEvent *ke, bool editorActive) override;
 
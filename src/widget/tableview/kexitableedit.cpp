@@ -126,6 +126,11 @@ bool KexiTableEdit::usesSelectedTextColor() const
     return m_usesSelectedTextColor;
 }
 
+bool KexiTableEdit::paintsContents() const
+{
+    return false;
+}
+
 int KexiTableEdit::leftMargin() const
 {
     return m_leftMargin;
@@ -112,6 +112,12 @@ public:
      setupContents() is called. */
     bool usesSelectedTextColor() const;
 
+    /*! \return true if setupContents() paints contents of the cell, e.g. a check box
+     or an image, instead of only preparing text to paint. Results of setupContents()
+     are reused by KexiTableScrollArea::paintCell() only if this is false.
+     False by default. */
+    virtual bool paintsContents() const;
+
     /*! For reimplementation.
      Paints selection's background using \a p. Most parameters are similar to these from
      setupContents(). */